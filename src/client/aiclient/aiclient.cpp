@@ -40,8 +40,11 @@
 #include "common/operations/Think.h"
 #include "common/globals.h"
 #include "client/ClientPropertyManager.h"
+#include "navigation/TileBuilder.h"
+#include "navigation/TileStore.h"
 
 #include <sys/prctl.h>
+#include <boost/filesystem.hpp>
 #include <rules/python/CyPy_Rules.h>
 
 
@@ -66,6 +69,10 @@ STRING_OPTION(account, "", "aiclient", "account", "Account name to use to authen
 
 STRING_OPTION(password, "", "aiclient", "password", "Password to use to authenticate to the server");
 
+INT_OPTION(navmesh_threads, 2, "aiclient", "navmeshthreads", "Number of threads used for building navmesh tiles in the background. 0 means that tiles are built on the main thread.");
+
+INT_OPTION(navmesh_store_size, 256, "aiclient", "navmeshstoresize", "Max size in megabytes of the file in which built navmesh tiles are stored between restarts. 0 means that tiles aren't stored.");
+
 static void connectToServer(boost::asio::io_context& io_context, AwareMindFactory& mindFactory)
 {
     if (exit_flag_soft || exit_flag) {
@@ -138,6 +145,20 @@ int main(int argc, char** argv)
     boost::asio::io_context io_context;
 
     {
+        //Created first so that it outlives all minds, and thus any Awareness which has jobs queued.
+        std::unique_ptr<TileBuilder> tileBuilder;
+        if (navmesh_threads > 0) {
+            tileBuilder = std::make_unique<TileBuilder>(static_cast<size_t>(navmesh_threads));
+        }
+        std::unique_ptr<TileStore> tileStore;
+        if (navmesh_store_size > 0) {
+            boost::filesystem::path storeDirectory = boost::filesystem::path(var_directory) / "lib" / "cyphesis";
+            boost::system::error_code ec;
+            boost::filesystem::create_directories(storeDirectory, ec);
+            tileStore = std::make_unique<TileStore>((storeDirectory / (instance + "-navmesh.tiles")).string(),
+                                                    static_cast<size_t>(navmesh_store_size) * 1024 * 1024);
+        }
+
         FileSystemObserver file_system_observer(io_context);
 
         ClientPropertyManager propertyManager{};
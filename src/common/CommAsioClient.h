@@ -37,15 +37,26 @@
 #include <sstream>
 #include <deque>
 
+class IoThreads;
+
 template<typename ProtocolT>
 class CommAsioClient : public Atlas::Objects::ObjectsDecoder,
                        public CommSocket,
                        public std::enable_shared_from_this<CommAsioClient<ProtocolT> >
 {
     public:
+        /**
+         * @brief Ctor.
+         * @param name The name of the server.
+         * @param io_context The main io_context.
+         * @param factories Atlas factories.
+         * @param ioThreads An optional pool of IO threads. If supplied, all socket reads and decoding will be done
+         * on one of these threads, while any decoded operations are handled on the main thread.
+         */
         CommAsioClient(std::string name,
                        boost::asio::io_context& io_context,
-                       const Atlas::Objects::Factories& factories);
+                       const Atlas::Objects::Factories& factories,
+                       IoThreads* ioThreads = nullptr);
 
         ~CommAsioClient() override;
 
@@ -64,12 +75,24 @@ class CommAsioClient : public Atlas::Objects::ObjectsDecoder,
 
         int flush() override;
 
+        int writeEncoded(const EncodedOp& op, const std::string& to, double seconds) override;
+
         /**
          * Controls how many ops should be emitted per call to dispatch.
          */
         int mMaxOpsPerDispatch;
 
     protected:
+        /**
+         * The IO threads used, if any.
+         */
+        IoThreads* mIoThreads;
+
+        /**
+         * The io_context which handles the socket. This is either the main io_context or one belonging to an IO thread.
+         */
+        boost::asio::io_context& mSocketContext;
+
         typename ProtocolT::socket mSocket;
 
         boost::asio::streambuf mReadBuffer;
@@ -109,6 +132,11 @@ class CommAsioClient : public Atlas::Objects::ObjectsDecoder,
          */
         bool mShouldSend;
 
+        /**
+         * True if a flush has been deferred until writes are uncorked.
+         */
+        bool mFlushDeferred;
+
         enum
         {
             /**
@@ -119,8 +147,12 @@ class CommAsioClient : public Atlas::Objects::ObjectsDecoder,
 
         /// \brief Queue of operations that have been decoded by not dispatched.
         DispatchQueue m_opQueue;
-        /// \brief Atlas codec that handles encoding and decoding traffic.
-        std::unique_ptr<Atlas::Codec> m_codec;
+        /// \brief Atlas codec that handles decoding of incoming traffic.
+        /// When using IO threads this is only used on the IO thread of the socket.
+        std::unique_ptr<Atlas::Codec> m_decodeCodec;
+        /// \brief Atlas codec that handles encoding of outgoing traffic. This is only used on the main thread.
+        /// Atlas codecs aren't thread safe, which is why encoding and decoding use separate codecs.
+        std::shared_ptr<Atlas::Codec> m_codec;
         /// \brief high level encoder passes data to the codec for transmission.
         std::unique_ptr<Atlas::Objects::ObjectsEncoder> m_encoder;
         /// \brief Atlas negotiator for handling codec negotiation.
@@ -134,10 +166,28 @@ class CommAsioClient : public Atlas::Objects::ObjectsDecoder,
 
         void write();
 
+        void writeCompleted(boost::system::error_code ec, std::size_t length);
+
+        /**
+         * @brief Releases a reference to this instance, making sure it's done on the main thread.
+         *
+         * When using IO threads this must be called by any handler run on an IO thread which doesn't start a new
+         * asynchronous operation, since the reference might be the last one and the instance (and its Link) must
+         * only be destroyed on the main thread. The instance must not be touched after this has been called.
+         */
+        void releaseOnMain(std::shared_ptr<CommAsioClient> self);
+
+        /**
+         * @brief Sets up the link once negotiation is complete. Must be called on the main thread.
+         */
+        void negotiationCompleted();
+
         void dispatch();
 
         void startNegotiation();
 
+        void startNegotiationOnSocketContext();
+
         /// \brief Handle socket data related to codec negotiation.
         int negotiate();
 
@@ -147,6 +197,14 @@ class CommAsioClient : public Atlas::Objects::ObjectsDecoder,
 
         int operation(const Atlas::Objects::Operation::RootOperation&);
 
+        /**
+         * @brief Called when a message has been decoded.
+         *
+         * When using IO threads the message is handed over to the main thread here, before being turned into an
+         * Atlas object, since Atlas objects must only be created and destroyed on the main thread.
+         */
+        void messageArrived(Atlas::Message::MapType msg) override;
+
         void objectArrived(const Atlas::Objects::Root& obj) override;
 };
 
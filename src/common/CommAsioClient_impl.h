@@ -30,6 +30,9 @@
 #include "common/debug.h"
 
 #include "CommAsioClient.h"
+#include "CorkedWrites.h"
+#include "EncodedOp.h"
+#include "IoThreads.h"
 
 #include <Atlas/Objects/Encoder.h>
 #include <Atlas/Objects/RootOperation.h>
@@ -47,18 +50,22 @@ static const bool comm_asio_client_debug_flag = false;
 template<class ProtocolT>
 CommAsioClient<ProtocolT>::CommAsioClient(std::string name,
                                           boost::asio::io_context& io_context,
-                                          const Atlas::Objects::Factories& factories) :
+                                          const Atlas::Objects::Factories& factories,
+                                          IoThreads* ioThreads) :
     ObjectsDecoder(factories),
     CommSocket(io_context),
     mMaxOpsPerDispatch(1),
-    mSocket(io_context),
+    mIoThreads(ioThreads),
+    mSocketContext(ioThreads ? ioThreads->nextContext() : io_context),
+    mSocket(mSocketContext),
     mWriteBuffer(new boost::asio::streambuf()),
     mSendBuffer(new boost::asio::streambuf()),
     mInStream(&mReadBuffer),
     mOutStream(mWriteBuffer.get()),
-    mNegotiateTimer(io_context, std::chrono::seconds(1)),
+    mNegotiateTimer(mSocketContext, std::chrono::seconds(1)),
     mIsSending(false),
     mShouldSend(false),
+    mFlushDeferred(false),
     mName(std::move(name))
 {
 }
@@ -112,17 +119,22 @@ void CommAsioClient<ProtocolT>::do_read()
 {
     auto self(this->shared_from_this());
     mSocket.async_read_some(mReadBuffer.prepare(read_buffer_size),
-                            [this, self](boost::system::error_code ec, std::size_t length) {
+                            [this, self](boost::system::error_code ec, std::size_t length) mutable {
                                 if (!ec) {
                                     mReadBuffer.commit(length);
-                                    m_codec->poll();
-                                    this->dispatch();
+                                    m_decodeCodec->poll();
+                                    //When using IO threads any decoded messages have already been handed over to the main thread.
+                                    if (!mIoThreads) {
+                                        this->dispatch();
+                                    }
                                     if (m_active) {
                                         //By calling do_read again we make sure that the instance
                                         //doesn't go out of scope ("shared_from this"). As soon as that
                                         //doesn't happen, and there's no write in progress, the instance
                                         //will be deleted since there's no more references to it.
                                         this->do_read();
+                                    } else if (mIoThreads) {
+                                        releaseOnMain(std::move(self));
                                     }
                                 } else {
                                     //No need to read if connection has been actively shut down.
@@ -138,6 +150,9 @@ void CommAsioClient<ProtocolT>::do_read()
                                         }
                                         log(level, ss.str());
                                     }
+                                    if (mIoThreads) {
+                                        releaseOnMain(std::move(self));
+                                    }
                                 }
                             });
 }
@@ -162,54 +177,87 @@ void CommAsioClient<ProtocolT>::write()
         mOutStream.rdbuf(mWriteBuffer.get());
         mIsSending = true;
 
-        boost::asio::async_write(mSocket, *mSendBuffer,
-                                 [this, self](boost::system::error_code ec, std::size_t length) {
-                                     mIsSending = false;
-                                     if (!ec) {
-                                         mSendBuffer->consume(length);
-                                         //Is there data queued for transmission which we should send right away?
-                                         if (mShouldSend) {
-                                             this->write();
-                                         }
-                                     } else {
-                                         //No need to write if connection has been actively shut down.
-                                         if (m_active) {
-                                             std::stringstream ss;
-                                             log_level level = WARNING;
-                                             if (ec == boost::asio::error::eof) {
-                                                 ss << String::compose("Connection at '%1' hung up unexpectedly.", socketName(mSocket));
-                                                 level = NOTICE;
-                                             } else {
-                                                 ss << String::compose("Error when reading from socket at '%1': (", socketName(mSocket)) << ec << ") " << ec.message();
-
-                                             }
-                                             log(level, ss.str());
-                                         }
+        if (mIoThreads) {
+            //The socket belongs to an IO thread, so the write must be started there. The send buffer isn't touched
+            //by the main thread until the write has completed, and the completion is handled on the main thread.
+            mSocketContext.post([this, self]() mutable {
+                boost::asio::async_write(mSocket, *mSendBuffer,
+                                         [this, self = std::move(self)](boost::system::error_code ec, std::size_t length) mutable {
+                                             mIoThreads->postToMain([this, self = std::move(self), ec, length]() {
+                                                 writeCompleted(ec, length);
+                                             });
+                                         });
+            });
+        } else {
+            boost::asio::async_write(mSocket, *mSendBuffer,
+                                     [this, self](boost::system::error_code ec, std::size_t length) {
+                                         writeCompleted(ec, length);
+                                     });
+        }
+    }
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::writeCompleted(boost::system::error_code ec, std::size_t length)
+{
+    mIsSending = false;
+    if (!ec) {
+        mSendBuffer->consume(length);
+        //Is there data queued for transmission which we should send right away?
+        if (mShouldSend) {
+            this->write();
+        }
+    } else {
+        //No need to write if connection has been actively shut down.
+        if (m_active) {
+            std::stringstream ss;
+            log_level level = WARNING;
+            if (ec == boost::asio::error::eof) {
+                ss << String::compose("Connection at '%1' hung up unexpectedly.", socketName(mSocket));
+                level = NOTICE;
+            } else {
+                ss << String::compose("Error when reading from socket at '%1': (", socketName(mSocket)) << ec << ") " << ec.message();
+
+            }
+            log(level, ss.str());
+        }
 
-                                     }
-                                 });
     }
 }
 
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::releaseOnMain(std::shared_ptr<CommAsioClient> self)
+{
+    //Once the function has been run on the main thread the reference is released. Note that "this" might already
+    //be deleted when this returns.
+    mIoThreads->postToMain([released = std::move(self)]() {});
+}
+
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::negotiate_read()
 {
     auto self(this->shared_from_this());
     mSocket.async_read_some(mReadBuffer.prepare(read_buffer_size),
-                            [this, self](boost::system::error_code ec, std::size_t length) {
+                            [this, self](boost::system::error_code ec, std::size_t length) mutable {
                                 if (!ec && m_active) {
                                     mReadBuffer.commit(length);
                                     if (length > 0) {
                                         int negotiateResult = this->negotiate();
                                         if (negotiateResult < 0) {
                                             //this should remove any shared references and delete this instance
+                                            if (mIoThreads) {
+                                                releaseOnMain(std::move(self));
+                                            }
                                             return;
                                         }
                                     }
 
                                     //If the m_negotiate instance is removed we're done with negotiation and should start the main loop.
                                     if (m_negotiate == nullptr) {
-                                        this->write();
+                                        //When using IO threads the main thread will write any queued data.
+                                        if (!mIoThreads) {
+                                            this->write();
+                                        }
                                         this->do_read();
                                     } else {
                                         this->negotiate_write();
@@ -219,6 +267,9 @@ void CommAsioClient<ProtocolT>::negotiate_read()
                                     //If connection is shut down, we should consider this as an aborted negotiaton
                                     m_negotiate.reset();
                                     mNegotiateTimer.cancel();
+                                    if (mIoThreads) {
+                                        releaseOnMain(std::move(self));
+                                    }
                                 }
                             });
 }
@@ -226,9 +277,18 @@ void CommAsioClient<ProtocolT>::negotiate_read()
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::negotiate_write()
 {
-    auto self(this->shared_from_this());
-
     if (mWriteBuffer->size() != 0) {
+        if (mIoThreads) {
+            //Negotiation data is small, so it's written right away. This way the main thread never sees the write
+            //buffer while it's being used here.
+            boost::system::error_code ec;
+            auto length = boost::asio::write(mSocket, mWriteBuffer->data(), ec);
+            if (!ec) {
+                mWriteBuffer->consume(length);
+            }
+            return;
+        }
+        auto self(this->shared_from_this());
         boost::asio::async_write(mSocket, mWriteBuffer->data(),
                                  [this, self](boost::system::error_code ec, std::size_t length) {
                                      if (!ec && m_active) {
@@ -262,16 +322,34 @@ void CommAsioClient<ProtocolT>::startConnect(std::unique_ptr<Link> connection)
 
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::startNegotiation()
+{
+    if (mIoThreads) {
+        //From here on the socket is handled by the IO thread, until negotiation is complete.
+        auto self(this->shared_from_this());
+        mSocketContext.post([this, self]() mutable {
+            startNegotiationOnSocketContext();
+            releaseOnMain(std::move(self));
+        });
+    } else {
+        startNegotiationOnSocketContext();
+    }
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::startNegotiationOnSocketContext()
 {
     auto self(this->shared_from_this());
     mNegotiateTimer.expires_from_now(std::chrono::seconds(10));
-    mNegotiateTimer.async_wait([this, self](const boost::system::error_code& ec) {
+    mNegotiateTimer.async_wait([this, self](const boost::system::error_code& ec) mutable {
         //If the negotiator still exists after the deadline it means that the negotiation hasn't
         //completed yet; we'll consider that a "timeout".
         if (m_negotiate != nullptr) {
             log(NOTICE, String::compose("Client at '%1' disconnected because of negotiation timeout.", socketName(mSocket)));
             mSocket.close();
         }
+        if (mIoThreads) {
+            releaseOnMain(std::move(self));
+        }
     });
 
     m_negotiate->poll();
@@ -297,28 +375,47 @@ int CommAsioClient<ProtocolT>::negotiate()
     }
     // Negotiation was successful
 
-    // Get the codec that negotiation established
-    m_codec = m_negotiate->getCodec(*this);
+    // Get the codecs that negotiation established. Decoding might be done on an IO thread while encoding always is
+    // done on the main thread, so they can't share a codec.
+    m_decodeCodec = m_negotiate->getCodec(*this);
+    std::shared_ptr<Atlas::Codec> codec = m_negotiate->getCodec(*this);
 
     // Acceptor is now finished with
     m_negotiate.reset();
 
-    if (m_codec == nullptr) {
+    if (m_decodeCodec == nullptr || codec == nullptr) {
         log(NOTICE, String::compose("Could not create codec during negotiation with '%1'.", socketName(mSocket)));
         return -1;
     }
+
+    if (mIoThreads) {
+        //The link and the encoding codec must only be used from the main thread.
+        auto self(this->shared_from_this());
+        mIoThreads->postToMain([this, self, codec]() {
+            m_codec = codec;
+            negotiationCompleted();
+            write();
+        });
+    } else {
+        m_codec = std::move(codec);
+        negotiationCompleted();
+    }
+
+    return 0;
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::negotiationCompleted()
+{
     // Create a new encoder to send high level objects to the codec
     m_encoder = std::make_unique<Atlas::Objects::ObjectsEncoder>(*m_codec);
 
-    assert(m_link != 0);
-    m_link->setEncoder(m_encoder.get());
-
     // This should always be sent at the beginning of a session
     m_codec->streamBegin();
 
+    assert(m_link != 0);
+    m_link->setEncoder(m_encoder.get());
     m_link->notifyConnectionComplete();
-
-    return 0;
 }
 
 template<class ProtocolT>
@@ -352,6 +449,21 @@ void CommAsioClient<ProtocolT>::dispatch()
     }
 }
 
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::messageArrived(Atlas::Message::MapType msg)
+{
+    if (!mIoThreads) {
+        ObjectsDecoder::messageArrived(std::move(msg));
+        return;
+    }
+    //Atlas objects use shared allocators and non atomic reference counting, so they must only be created on the main thread.
+    auto self(this->shared_from_this());
+    mIoThreads->postToMain([this, self, message = std::move(msg)]() mutable {
+        ObjectsDecoder::messageArrived(std::move(message));
+        this->dispatch();
+    });
+}
+
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::objectArrived(const Atlas::Objects::Root& obj)
 {
@@ -406,18 +518,46 @@ int CommAsioClient<ProtocolT>::send(
     return flush();
 }
 
+template<class ProtocolT>
+int CommAsioClient<ProtocolT>::writeEncoded(const EncodedOp& op, const std::string& to, double seconds)
+{
+    if (!m_codec || !mSocket.is_open()) {
+        return -1;
+    }
+
+    //Data is only moved out of the write buffer when it's flushed, so the difference in size is what was written.
+    auto sizeBefore = mWriteBuffer->size();
+    op.write(*m_codec, to, seconds);
+    mOutStream.flush();
+    return static_cast<int>(mWriteBuffer->size() - sizeBefore);
+}
+
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::disconnect()
 {
     m_active = false;
-    m_negotiate.reset();
-    mNegotiateTimer.cancel();
-    mSocket.cancel();
+    if (mIoThreads) {
+        auto self(this->shared_from_this());
+        mSocketContext.post([this, self]() mutable {
+            m_negotiate.reset();
+            mNegotiateTimer.cancel();
+            mSocket.cancel();
+            releaseOnMain(std::move(self));
+        });
+    } else {
+        m_negotiate.reset();
+        mNegotiateTimer.cancel();
+        mSocket.cancel();
+    }
 }
 
 template<class ProtocolT>
 int CommAsioClient<ProtocolT>::flush()
 {
+    //When corked we only need to make sure that we're flushed when uncorked, unless too much data has been buffered.
+    if (CorkedWrites::hasInstance() && CorkedWrites::instance().deferFlush(this->shared_from_this(), mWriteBuffer->size(), mFlushDeferred)) {
+        return 0;
+    }
     write();
     return 0;
 }
@@ -21,6 +21,10 @@
 
 #include "common/io_context.h"
 
+#include <atomic>
+#include <string>
+
+class EncodedOp;
 
 /// \defgroup ServerSockets Server Socket Classes
 ///
@@ -44,7 +48,8 @@ class CommSocket {
     /// Reference to the main IO service.
     boost::asio::io_context& m_io_context;
 
-    bool m_active;
+    /// Whether the socket is active. This might be read from IO threads.
+    std::atomic<bool> m_active;
 
     /// \brief Destructor.
     virtual ~CommSocket() = default;
@@ -57,6 +62,17 @@ class CommSocket {
 
     /// \brief Flush the socket
     virtual int flush() = 0;
+
+    /// \brief Write an op which has already been encoded, without flushing
+    ///
+    /// @param op The encoded op.
+    /// @param to The recipient of the op.
+    /// @param seconds The time of the op.
+    /// @return The number of bytes written, or -1 if the socket can't
+    /// handle encoded ops, in which case the op needs to be sent normally.
+    virtual int writeEncoded(const EncodedOp & op, const std::string & to, double seconds) {
+        return -1;
+    }
 };
 
 #endif // COMMON_COMM_SOCKET_H
@@ -0,0 +1,306 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "CompactEncoding.h"
+
+#include <cstdint>
+#include <cstring>
+
+using Atlas::Message::Element;
+using Atlas::Message::FloatType;
+using Atlas::Message::IntType;
+using Atlas::Message::ListType;
+using Atlas::Message::MapType;
+
+namespace {
+
+    /**
+     * Type tags. None of these may be zero, since no zero bytes are allowed in the data.
+     */
+    enum Tag : char
+    {
+        TAG_NONE = 0x01,
+        TAG_INT_ZERO = 0x02,
+        TAG_INT = 0x03,
+        TAG_FLOAT_ZERO = 0x04,
+        TAG_FLOAT = 0x05,
+        TAG_STRING = 0x06,
+        TAG_MAP = 0x07,
+        TAG_LIST = 0x08
+    };
+
+    /**
+     * Writes a varint. The last byte of a varint only is zero if the value itself is zero, so callers must
+     * make sure that zero never is written.
+     */
+    void writeVarint(std::uint64_t value, std::string& data)
+    {
+        while (value >= 0x80) {
+            data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        data.push_back(static_cast<char>(value));
+    }
+
+    std::uint64_t reverseBytes(std::uint64_t value)
+    {
+        std::uint64_t result = 0;
+        for (int i = 0; i < 8; ++i) {
+            result = (result << 8) | (value & 0xFF);
+            value >>= 8;
+        }
+        return result;
+    }
+
+    bool writeString(const std::string& string, std::string& data)
+    {
+        if (string.find('\0') != std::string::npos) {
+            return false;
+        }
+        //Sizes are offset by one, so that empty strings don't produce a zero byte.
+        writeVarint(string.size() + 1, data);
+        data.append(string);
+        return true;
+    }
+
+    bool writeElement(const Element& element, std::string& data);
+
+    bool writeMap(const MapType& map, std::string& data)
+    {
+        writeVarint(map.size() + 1, data);
+        for (auto& entry : map) {
+            if (!writeString(entry.first, data) || !writeElement(entry.second, data)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool writeElement(const Element& element, std::string& data)
+    {
+        switch (element.getType()) {
+            case Element::TYPE_NONE:
+                data.push_back(TAG_NONE);
+                return true;
+            case Element::TYPE_INT: {
+                auto value = element.Int();
+                if (value == 0) {
+                    data.push_back(TAG_INT_ZERO);
+                } else {
+                    data.push_back(TAG_INT);
+                    //Zigzag encoding keeps small negative values short.
+                    auto unsignedValue = static_cast<std::uint64_t>(value);
+                    writeVarint((unsignedValue << 1) ^ (value < 0 ? ~std::uint64_t(0) : 0), data);
+                }
+                return true;
+            }
+            case Element::TYPE_FLOAT: {
+                static_assert(sizeof(FloatType) == sizeof(std::uint64_t), "Floats are expected to be 64 bits.");
+                std::uint64_t bits;
+                auto value = element.Float();
+                std::memcpy(&bits, &value, sizeof(bits));
+                if (bits == 0) {
+                    data.push_back(TAG_FLOAT_ZERO);
+                } else {
+                    data.push_back(TAG_FLOAT);
+                    //The sign and exponent are in the high bytes, and the low bytes of the mantissa are often zero.
+                    //Reversing the bytes thus makes the varint shorter for most values.
+                    writeVarint(reverseBytes(bits), data);
+                }
+                return true;
+            }
+            case Element::TYPE_STRING:
+                data.push_back(TAG_STRING);
+                return writeString(element.String(), data);
+            case Element::TYPE_MAP:
+                data.push_back(TAG_MAP);
+                return writeMap(element.Map(), data);
+            case Element::TYPE_LIST: {
+                auto& list = element.List();
+                data.push_back(TAG_LIST);
+                writeVarint(list.size() + 1, data);
+                for (auto& entry : list) {
+                    if (!writeElement(entry, data)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            default:
+                //Pointers can't be persisted.
+                return false;
+        }
+    }
+
+    struct Reader
+    {
+        const char* pos;
+        const char* end;
+
+        bool readVarint(std::uint64_t& value)
+        {
+            value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (pos == end) {
+                    return false;
+                }
+                auto byte = static_cast<unsigned char>(*pos++);
+                value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool readSize(size_t& size)
+        {
+            std::uint64_t value;
+            if (!readVarint(value) || value == 0) {
+                return false;
+            }
+            size = static_cast<size_t>(value - 1);
+            return true;
+        }
+
+        bool readString(std::string& string)
+        {
+            size_t size;
+            if (!readSize(size) || size > static_cast<size_t>(end - pos)) {
+                return false;
+            }
+            string.assign(pos, size);
+            pos += size;
+            return true;
+        }
+
+        bool readMap(MapType& map)
+        {
+            size_t size;
+            if (!readSize(size)) {
+                return false;
+            }
+            for (size_t i = 0; i < size; ++i) {
+                std::string key;
+                if (!readString(key)) {
+                    return false;
+                }
+                if (!readElement(map[key])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool readElement(Element& element)
+        {
+            if (pos == end) {
+                return false;
+            }
+            auto tag = *pos++;
+            switch (tag) {
+                case TAG_NONE:
+                    element = Element();
+                    return true;
+                case TAG_INT_ZERO:
+                    element = IntType(0);
+                    return true;
+                case TAG_INT: {
+                    std::uint64_t value;
+                    if (!readVarint(value)) {
+                        return false;
+                    }
+                    auto decoded = static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+                    element = static_cast<IntType>(decoded);
+                    return true;
+                }
+                case TAG_FLOAT_ZERO:
+                    element = FloatType(0);
+                    return true;
+                case TAG_FLOAT: {
+                    std::uint64_t value;
+                    if (!readVarint(value)) {
+                        return false;
+                    }
+                    auto bits = reverseBytes(value);
+                    FloatType decoded;
+                    std::memcpy(&decoded, &bits, sizeof(decoded));
+                    element = decoded;
+                    return true;
+                }
+                case TAG_STRING: {
+                    std::string string;
+                    if (!readString(string)) {
+                        return false;
+                    }
+                    element = std::move(string);
+                    return true;
+                }
+                case TAG_MAP: {
+                    MapType map;
+                    if (!readMap(map)) {
+                        return false;
+                    }
+                    element = std::move(map);
+                    return true;
+                }
+                case TAG_LIST: {
+                    size_t size;
+                    if (!readSize(size)) {
+                        return false;
+                    }
+                    ListType list;
+                    //Every element takes at least one byte, so a size larger than the remaining data is invalid.
+                    if (size > static_cast<size_t>(end - pos)) {
+                        return false;
+                    }
+                    list.resize(size);
+                    for (auto& entry : list) {
+                        if (!readElement(entry)) {
+                            return false;
+                        }
+                    }
+                    element = std::move(list);
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+    };
+}
+
+namespace CompactEncoding {
+
+    bool encode(const MapType& map, std::string& data)
+    {
+        data.clear();
+        data.push_back(VERSION);
+        return writeMap(map, data);
+    }
+
+    bool decode(const std::string& data, MapType& map)
+    {
+        if (!isCompact(data)) {
+            return false;
+        }
+        Reader reader{data.data() + 1, data.data() + data.size()};
+        map.clear();
+        return reader.readMap(map) && reader.pos == reader.end;
+    }
+}
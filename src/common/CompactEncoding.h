@@ -0,0 +1,72 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_COMPACTENCODING_H
+#define CYPHESIS_COMPACTENCODING_H
+
+#include <Atlas/Message/Element.h>
+
+#include <string>
+
+/**
+ * @brief A compact binary encoding of Atlas messages, used for persisting data in the database.
+ *
+ * The data starts with a version byte, followed by the elements. Each element is a type tag, followed by
+ * the value. Integers, lengths and sizes are written as LEB128 varints. Integers are zigzag encoded, so that
+ * small negative numbers are short too. Floats are written as varints of their byte reversed bit pattern,
+ * which makes common values such as "1.0" or "0.5" only take a couple of bytes.
+ *
+ * The encoding never produces any zero bytes. This allows the data to be read as a C string, which is what
+ * the DatabaseResult interface provides. Strings which themselves contain zero bytes can't be encoded; the
+ * caller should then fall back to the legacy Packed encoding.
+ *
+ * Since the version byte never can appear first in Packed data, both formats can be stored side by side.
+ */
+namespace CompactEncoding {
+
+    /**
+     * The current version, which also is the first byte in all encoded data.
+     */
+    constexpr char VERSION = 0x01;
+
+    /**
+     * @brief Encodes a map.
+     * @param map The map to encode.
+     * @param data The encoded data is written here.
+     * @return True if the map could be encoded; false if it contains values that can't be represented.
+     */
+    bool encode(const Atlas::Message::MapType& map, std::string& data);
+
+    /**
+     * @brief Decodes data previously encoded by encode().
+     * @param data Encoded data, starting with the version byte.
+     * @param map The decoded map is written here.
+     * @return True if successful.
+     */
+    bool decode(const std::string& data, Atlas::Message::MapType& map);
+
+    /**
+     * @brief Checks if the data is in the compact encoding, rather than the legacy one.
+     */
+    inline bool isCompact(const std::string& data)
+    {
+        return !data.empty() && data.front() == VERSION;
+    }
+}
+
+#endif //CYPHESIS_COMPACTENCODING_H
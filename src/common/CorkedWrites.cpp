@@ -0,0 +1,66 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "CorkedWrites.h"
+#include "CommSocket.h"
+
+CorkedWrites::CorkedWrites(size_t byteThreshold)
+        : m_corkedWrites(0),
+          m_writesSaved(0),
+          m_byteThreshold(byteThreshold),
+          m_corked(false)
+{
+}
+
+CorkedWrites::~CorkedWrites() = default;
+
+void CorkedWrites::cork()
+{
+    m_corked = true;
+}
+
+void CorkedWrites::uncork()
+{
+    m_corked = false;
+    //Swap first, since flushing could in theory lead to new sockets being registered.
+    std::vector<std::shared_ptr<CommSocket>> sockets;
+    std::swap(sockets, m_deferredSockets);
+    for (auto& socket : sockets) {
+        socket->flush();
+        m_corkedWrites++;
+    }
+}
+
+bool CorkedWrites::deferFlush(std::shared_ptr<CommSocket> socket, size_t bufferedBytes, bool& flushDeferred)
+{
+    if (!m_corked) {
+        flushDeferred = false;
+        return false;
+    }
+    //Too much data has been buffered, so it should be written now even though we're corked.
+    if (bufferedBytes >= m_byteThreshold) {
+        return false;
+    }
+    if (flushDeferred) {
+        m_writesSaved++;
+    } else {
+        flushDeferred = true;
+        m_deferredSockets.emplace_back(std::move(socket));
+    }
+    return true;
+}
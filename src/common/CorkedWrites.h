@@ -0,0 +1,103 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_CORKEDWRITES_H
+#define CYPHESIS_CORKEDWRITES_H
+
+#include "common/Singleton.h"
+
+#include <memory>
+#include <vector>
+
+class CommSocket;
+
+/**
+ * @brief Coalesces socket writes while the main loop is processing operations.
+ *
+ * Every op sent to a client normally results in a flush of the socket, which means that a burst of ops to the same
+ * client turns into many small writes. While corked, sockets will instead only append data to their write buffers
+ * and register themselves here. When uncorked all registered sockets are flushed, so that each socket is written
+ * to at most once.
+ *
+ * To keep latency and memory usage bounded, a socket will still be flushed right away if its write buffer exceeds a
+ * threshold.
+ */
+class CorkedWrites : public Singleton<CorkedWrites>
+{
+    public:
+        /**
+         * @brief Ctor.
+         * @param byteThreshold If a socket has more than this number of bytes buffered it will be flushed even when corked.
+         */
+        explicit CorkedWrites(size_t byteThreshold);
+
+        ~CorkedWrites() override;
+
+        /**
+         * @brief Starts deferring flushes.
+         */
+        void cork();
+
+        /**
+         * @brief Stops deferring flushes, and flushes all sockets with deferred flushes.
+         */
+        void uncork();
+
+        bool isCorked() const
+        {
+            return m_corked;
+        }
+
+        size_t getByteThreshold() const
+        {
+            return m_byteThreshold;
+        }
+
+        /**
+         * @brief Decides whether a flush of a socket should be deferred until uncorked.
+         *
+         * This should be called by sockets whenever they are asked to flush. The first deferred flush for a socket
+         * registers it to be flushed when uncorked, while any further ones are counted as saved writes.
+         * @param socket The socket.
+         * @param bufferedBytes The number of bytes currently buffered by the socket.
+         * @param flushDeferred A flag kept by the socket, which is set when the socket has been registered and reset when
+         * the socket is flushed while uncorked.
+         * @return True if the flush was deferred, false if the socket should be written to now.
+         */
+        bool deferFlush(std::shared_ptr<CommSocket> socket, size_t bufferedBytes, bool& flushDeferred);
+
+        /**
+         * The number of sockets that have been flushed when uncorked.
+         */
+        int m_corkedWrites;
+
+        /**
+         * The number of writes that have been avoided by deferring flushes.
+         */
+        int m_writesSaved;
+
+    private:
+        size_t m_byteThreshold;
+
+        bool m_corked;
+
+        std::vector<std::shared_ptr<CommSocket>> m_deferredSockets;
+};
+
+
+#endif //CYPHESIS_CORKEDWRITES_H
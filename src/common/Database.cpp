@@ -24,6 +24,7 @@
 #include "globals.h"
 #include "compose.hpp"
 #include "const.h"
+#include "CompactEncoding.h"
 
 #include <Atlas/Codecs/Packed.h>
 
@@ -87,6 +88,15 @@ int Database::decodeMessage(const std::string & data,
         return 0;
     }
 
+    //Data in the compact encoding is stored side by side with data in the legacy Packed encoding.
+    if (CompactEncoding::isCompact(data)) {
+        if (!CompactEncoding::decode(data, o)) {
+            log(WARNING, "Database entry does not appear to be decodable");
+            return -1;
+        }
+        return 0;
+    }
+
     std::stringstream str(data, std::ios::in);
 
     Serialiser codec(str, str, m_d);
@@ -242,6 +252,11 @@ DatabaseResult Database::selectEntities(const std::string & loc)
     return runSimpleSelectQuery(query);
 }
 
+DatabaseResult Database::selectAllEntities()
+{
+    return runSimpleSelectQuery("SELECT id, loc, type, location FROM entities ORDER BY loc, id");
+}
+
 int Database::dropEntity(long id)
 {
     std::string query = compose("DELETE FROM properties WHERE id = '%1'", id);
@@ -286,6 +301,11 @@ DatabaseResult Database::selectProperties(const std::string & id)
     return runSimpleSelectQuery(query);
 }
 
+DatabaseResult Database::selectAllProperties()
+{
+    return runSimpleSelectQuery("SELECT id, name, value FROM properties ORDER BY id");
+}
+
 int Database::updateProperties(const std::string & id,
                                const KeyValues & tuples)
 {
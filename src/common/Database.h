@@ -192,34 +192,43 @@ class Database : public Singleton<Database>
 
         virtual int registerEntityTable(const std::map<std::string, int>& chunks) = 0;
 
-        int insertEntity(const std::string& id,
-                         const std::string& loc,
-                         const std::string& type,
-                         int seq,
-                         const std::string& value);
+        // The default implementations of the entity and property commands build textual queries, which requires any
+        // encoded data to have been escaped by encodeObject().
 
-        int updateEntityWithoutLoc(const std::string& id,
-                                   int seq,
-                                   const std::string& location_data);
+        virtual int insertEntity(const std::string& id,
+                                 const std::string& loc,
+                                 const std::string& type,
+                                 int seq,
+                                 const std::string& value);
 
-        int updateEntity(const std::string& id,
-                         int seq,
-                         const std::string& location_data,
-                         const std::string& location_entity_id);
+        virtual int updateEntityWithoutLoc(const std::string& id,
+                                           int seq,
+                                           const std::string& location_data);
+
+        virtual int updateEntity(const std::string& id,
+                                 int seq,
+                                 const std::string& location_data,
+                                 const std::string& location_entity_id);
 
         DatabaseResult selectEntities(const std::string& loc);
 
-        int dropEntity(long id);
+        /// \brief Selects all entities, ordered by location. The columns are "id", "loc", "type" and "location", in that order.
+        DatabaseResult selectAllEntities();
+
+        virtual int dropEntity(long id);
 
         virtual int registerPropertyTable() = 0;
 
-        int insertProperties(const std::string& id,
-                             const KeyValues& tuples);
+        virtual int insertProperties(const std::string& id,
+                                     const KeyValues& tuples);
 
         DatabaseResult selectProperties(const std::string& loc);
 
-        int updateProperties(const std::string& id,
-                             const KeyValues& tuples);
+        /// \brief Selects all properties, ordered by entity. The columns are "id", "name" and "value", in that order.
+        DatabaseResult selectAllProperties();
+
+        virtual int updateProperties(const std::string& id,
+                                     const KeyValues& tuples);
 
         virtual int registerThoughtsTable() = 0;
 
@@ -28,12 +28,12 @@
 #include "globals.h"
 #include "compose.hpp"
 #include "const.h"
+#include "CompactEncoding.h"
 
 #include <Atlas/Codecs/Packed.h>
 
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/operations.hpp>
-#include <boost/algorithm/string.hpp>
 
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
@@ -49,6 +49,7 @@ static const bool debug_flag = false;
 
 DatabaseSQLite::DatabaseSQLite() :
     Database(),
+    m_commandsInProgress(0),
     m_active(true),
     m_workerThread([&]() { this->poll_tasks(); })
 {
@@ -75,11 +76,14 @@ void DatabaseSQLite::poll_tasks()
     while (true) {
         std::unique_lock<std::mutex> lock(m_pendingQueriesMutex);
         if (!pendingQueries.empty()) {
-            auto command = std::move(pendingQueries.front());
+            //Take all commands queued so far and run them as one batch.
+            //Update the count before taking them, so that they are always accounted for in queryQueueSize().
+            m_commandsInProgress = pendingQueries.size();
+            std::deque<PendingCommand> batch;
+            std::swap(batch, pendingQueries);
             lock.unlock();
-            runCommandQuery(command);
-            lock.lock();
-            pendingQueries.pop_front();
+            runBatch(batch);
+            m_commandsInProgress = 0;
         } else {
             if (m_active) {
                 m_workerCondition.wait(lock);
@@ -90,6 +94,77 @@ void DatabaseSQLite::poll_tasks()
     }
 }
 
+void DatabaseSQLite::runBatch(std::deque<PendingCommand>& batch)
+{
+    std::lock_guard<std::mutex> lock(m_batchMutex);
+    if (!m_database) {
+        log(ERROR, compose("Could not run %1 database commands since there's no database connection.", batch.size()));
+        return;
+    }
+
+    //Running all commands in one transaction means that SQLite only needs to sync to disk once for the whole batch.
+    bool inTransaction = false;
+    for (auto& command : batch) {
+        if (command.outsideTransaction && inTransaction) {
+            if (m_database->execute("COMMIT") != SQLITE_OK) {
+                reportError(m_database->error_msg());
+            }
+            inTransaction = false;
+        } else if (!command.outsideTransaction && !inTransaction) {
+            if (m_database->execute("BEGIN") == SQLITE_OK) {
+                inTransaction = true;
+            } else {
+                reportError(m_database->error_msg());
+            }
+        }
+        runPendingCommand(command);
+    }
+    if (inTransaction && m_database->execute("COMMIT") != SQLITE_OK) {
+        reportError(m_database->error_msg());
+    }
+}
+
+void DatabaseSQLite::runPendingCommand(const PendingCommand& command)
+{
+    if (command.parameters.empty()) {
+        runCommandQuery(command.sql);
+        return;
+    }
+
+    try {
+        auto& statement = m_preparedStatements[command.sql];
+        if (!statement) {
+            statement = std::make_unique<sqlite3pp::command>(*m_database, command.sql.c_str());
+        }
+        int index = 1;
+        for (auto& parameter : command.parameters) {
+            if (parameter.isInt()) {
+                statement->bind(index, static_cast<long long int>(parameter.Int()));
+            } else if (parameter.isString()) {
+                //The parameters outlive the execution, so there's no need to copy.
+                auto& string = parameter.String();
+                if (CompactEncoding::isCompact(string)) {
+                    statement->bind(index, string.data(), static_cast<int>(string.size()), nocopy);
+                } else {
+                    statement->bind(index, string, nocopy);
+                }
+            } else {
+                statement->bind(index, null_type());
+            }
+            ++index;
+        }
+        auto result = statement->execute();
+        statement->reset();
+        if (result != SQLITE_OK) {
+            log(ERROR, compose("runPendingCommand('%1'): Database query error.", command.sql));
+            reportError(m_database->error_msg());
+        }
+    } catch (const database_error& e) {
+        log(ERROR, compose("runPendingCommand('%1'): Database query error.", command.sql));
+        reportError(e.what());
+    }
+}
+
 int DatabaseSQLite::connect(const std::string& context, std::string& error_msg)
 {
     return 0;
@@ -107,17 +182,33 @@ int DatabaseSQLite::initConnection()
         return -1;
     }
 
+    //With a write ahead log, commits only need to append to the log, and readers aren't blocked by writers.
+    //Using "NORMAL" synchronization is safe with WAL; a power loss might lose the last commits, but never corrupts the database.
+    if (m_database->execute("PRAGMA journal_mode=WAL") != SQLITE_OK) {
+        log(WARNING, "Could not enable WAL mode for SQLite database.");
+    } else {
+        m_database->execute("PRAGMA synchronous=NORMAL");
+    }
+
     return 0;
 }
 
 void DatabaseSQLite::shutdownConnection()
 {
+    std::lock_guard<std::mutex> lock(m_batchMutex);
+    //Prepared statements must be finalized before the database is closed.
+    m_preparedStatements.clear();
     m_database.reset(nullptr);
 }
 
 int DatabaseSQLite::encodeObject(const MapType& o,
                                  std::string& data)
 {
+    if (CompactEncoding::encode(o, data)) {
+        return 0;
+    }
+
+    //Fall back to the legacy encoding for data which can't be represented in the compact one.
     std::stringstream str;
 
     Serialiser codec(str, str, m_d);
@@ -129,8 +220,7 @@ int DatabaseSQLite::encodeObject(const MapType& o,
 
     data = str.str();
 
-    //Escape ' characters by doubling them.
-    boost::algorithm::replace_all(data, "'", "''");
+    //No escaping is needed, since encoded data only is used as bound parameters in prepared statements.
 
     return 0;
 }
@@ -353,6 +443,11 @@ int DatabaseSQLite::registerPropertyTable()
     if (runCommandQuery(query) != 0) {
         return -1;
     }
+    //All updates and lookups of properties are done per entity.
+    query = "CREATE INDEX IF NOT EXISTS property_ids on properties (id)";
+    if (runCommandQuery(query) != 0) {
+        return -1;
+    }
     return 0;
 }
 
@@ -374,19 +469,87 @@ int DatabaseSQLite::registerThoughtsTable()
 // General functions for handling queries at the low level.
 
 int DatabaseSQLite::scheduleCommand(const std::string& query)
+{
+    schedulePendingCommand({query, {}, false});
+    return 0;
+}
+
+int DatabaseSQLite::schedulePreparedCommand(std::string sql, std::vector<Atlas::Message::Element> parameters)
+{
+    schedulePendingCommand({std::move(sql), std::move(parameters), false});
+    return 0;
+}
+
+void DatabaseSQLite::schedulePendingCommand(PendingCommand command)
 {
     {
         std::unique_lock<std::mutex> lock(m_pendingQueriesMutex);
-        pendingQueries.push_back(query);
+        pendingQueries.push_back(std::move(command));
     }
     m_workerCondition.notify_all();
+}
+
+int DatabaseSQLite::insertEntity(const std::string& id,
+                                 const std::string& loc,
+                                 const std::string& type,
+                                 int seq,
+                                 const std::string& value)
+{
+    return schedulePreparedCommand("INSERT INTO entities VALUES (?, ?, ?, ?, ?)",
+                                   {integerId(id), integerId(loc), type, seq, value});
+}
+
+int DatabaseSQLite::updateEntity(const std::string& id,
+                                 int seq,
+                                 const std::string& location_data,
+                                 const std::string& location_entity_id)
+{
+    return schedulePreparedCommand("UPDATE entities SET seq = ?, location = ?, loc = ? WHERE id = ?",
+                                   {seq, location_data, integerId(location_entity_id), integerId(id)});
+}
+
+int DatabaseSQLite::updateEntityWithoutLoc(const std::string& id,
+                                           int seq,
+                                           const std::string& location_data)
+{
+    return schedulePreparedCommand("UPDATE entities SET seq = ?, location = ? WHERE id = ?",
+                                   {seq, location_data, integerId(id)});
+}
+
+int DatabaseSQLite::dropEntity(long id)
+{
+    schedulePreparedCommand("DELETE FROM properties WHERE id = ?", {id});
+    schedulePreparedCommand("DELETE FROM entities WHERE id = ?", {id});
+    schedulePreparedCommand("DELETE FROM thoughts WHERE id = ?", {id});
+    return 0;
+}
+
+int DatabaseSQLite::insertProperties(const std::string& id,
+                                     const KeyValues& tuples)
+{
+    //Since all commands are run in a transaction there's no need to combine the rows into one statement.
+    auto intId = integerId(id);
+    for (auto& tuple : tuples) {
+        schedulePreparedCommand("INSERT INTO properties VALUES (?, ?, ?)", {intId, tuple.first, tuple.second});
+    }
+    return 0;
+}
+
+int DatabaseSQLite::updateProperties(const std::string& id,
+                                     const KeyValues& tuples)
+{
+    auto intId = integerId(id);
+    for (auto& tuple : tuples) {
+        schedulePreparedCommand("UPDATE properties SET value = ? WHERE id = ? AND name = ?", {tuple.second, intId, tuple.first});
+    }
     return 0;
 }
 
 
 int DatabaseSQLite::runMaintainance()
 {
-    scheduleCommand("VACUUM");
+    //VACUUM can't be run inside a transaction.
+    schedulePendingCommand({"VACUUM", {}, true});
 
     return 0;
 }
@@ -23,6 +23,8 @@
 #include <thread>
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <map>
 #include "Database.h"
 
 
@@ -36,16 +38,58 @@ class DatabaseSQLite : public Database
 {
     protected:
 
-        std::deque<std::string> pendingQueries;
+        /**
+         * A command waiting to be run by the worker thread.
+         */
+        struct PendingCommand
+        {
+            std::string sql;
+            /**
+             * Parameters to bind to the statement. If there are any the statement is prepared once and then cached.
+             * Only ints, strings and none (null) are supported.
+             */
+            std::vector<Atlas::Message::Element> parameters;
+            /**
+             * True if the command can't be run within a transaction (such as VACUUM).
+             */
+            bool outsideTransaction;
+        };
+
+        std::deque<PendingCommand> pendingQueries;
         std::unique_ptr<sqlite3pp::database> m_database;
 
+        /**
+         * Prepared statements, keyed by their SQL. Only used by the worker thread.
+         */
+        std::map<std::string, std::unique_ptr<sqlite3pp::command>> m_preparedStatements;
+
+        /**
+         * The number of commands taken from the queue by the worker thread which haven't been completed yet.
+         */
+        std::atomic<size_t> m_commandsInProgress;
+
         std::atomic<bool> m_active;
         std::condition_variable m_workerCondition;
         std::mutex m_pendingQueriesMutex;
+        /**
+         * Held by the worker thread while running a batch.
+         */
+        std::mutex m_batchMutex;
         std::thread m_workerThread;
 
         void poll_tasks();
 
+        /**
+         * @brief Runs a batch of commands, all within a single transaction.
+         */
+        void runBatch(std::deque<PendingCommand>& batch);
+
+        void runPendingCommand(const PendingCommand& command);
+
+        void schedulePendingCommand(PendingCommand command);
+
+        int schedulePreparedCommand(std::string sql, std::vector<Atlas::Message::Element> parameters);
+
     public:
 
         DatabaseSQLite();
@@ -64,7 +108,7 @@ class DatabaseSQLite : public Database
 
         size_t queryQueueSize() const override
         {
-            return pendingQueries.size();
+            return pendingQueries.size() + m_commandsInProgress;
         }
 
 
@@ -107,6 +151,29 @@ class DatabaseSQLite : public Database
         int registerSimpleTable(const std::string& name,
                                 const Atlas::Message::MapType& row) override;
 
+        int insertEntity(const std::string& id,
+                         const std::string& loc,
+                         const std::string& type,
+                         int seq,
+                         const std::string& value) override;
+
+        int updateEntityWithoutLoc(const std::string& id,
+                                   int seq,
+                                   const std::string& location_data) override;
+
+        int updateEntity(const std::string& id,
+                         int seq,
+                         const std::string& location_data,
+                         const std::string& location_entity_id) override;
+
+        int dropEntity(long id) override;
+
+        int insertProperties(const std::string& id,
+                             const KeyValues& tuples) override;
+
+        int updateProperties(const std::string& id,
+                             const KeyValues& tuples) override;
+
         int scheduleCommand(const std::string& query) override;
 
         int runMaintainance();
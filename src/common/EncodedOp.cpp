@@ -0,0 +1,273 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "EncodedOp.h"
+
+#include <Atlas/Bridge.h>
+#include <Atlas/Message/Element.h>
+#include <Atlas/Objects/Encoder.h>
+#include <Atlas/Objects/RootOperation.h>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    enum class Tag : char
+    {
+        MapMapItem,
+        MapListItem,
+        MapIntItem,
+        MapFloatItem,
+        MapStringItem,
+        MapNoneItem,
+        MapEnd,
+        ListMapItem,
+        ListListItem,
+        ListIntItem,
+        ListFloatItem,
+        ListStringItem,
+        ListNoneItem,
+        ListEnd
+    };
+
+    template<typename T>
+    void writeValue(std::string& data, T value)
+    {
+        data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void writeString(std::string& data, const std::string& value)
+    {
+        writeValue(data, static_cast<std::uint32_t>(value.size()));
+        data.append(value);
+    }
+
+    template<typename T>
+    T readValue(const std::string& data, size_t& pos)
+    {
+        T value;
+        assert(pos + sizeof(T) <= data.size());
+        std::memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string readString(const std::string& data, size_t& pos)
+    {
+        auto length = readValue<std::uint32_t>(data, pos);
+        assert(pos + length <= data.size());
+        std::string value(data, pos, length);
+        pos += length;
+        return value;
+    }
+}
+
+/**
+ * Records all calls into a buffer, skipping "to" and "seconds" at the top level.
+ */
+class EncodedOp::Recorder : public Atlas::Bridge
+{
+    public:
+        explicit Recorder(std::string& data) : m_data(data), m_depth(0)
+        {}
+
+        void streamBegin() override
+        {}
+
+        void streamMessage() override
+        {
+            m_depth = 1;
+        }
+
+        void streamEnd() override
+        {}
+
+        void mapMapItem(std::string name) override
+        {
+            writeTag(Tag::MapMapItem);
+            writeString(m_data, name);
+            ++m_depth;
+        }
+
+        void mapListItem(std::string name) override
+        {
+            writeTag(Tag::MapListItem);
+            writeString(m_data, name);
+            ++m_depth;
+        }
+
+        void mapIntItem(std::string name, Atlas::Message::IntType value) override
+        {
+            writeTag(Tag::MapIntItem);
+            writeString(m_data, name);
+            writeValue(m_data, value);
+        }
+
+        void mapFloatItem(std::string name, Atlas::Message::FloatType value) override
+        {
+            if (m_depth == 1 && name == "seconds") {
+                return;
+            }
+            writeTag(Tag::MapFloatItem);
+            writeString(m_data, name);
+            writeValue(m_data, value);
+        }
+
+        void mapStringItem(std::string name, std::string value) override
+        {
+            if (m_depth == 1 && name == "to") {
+                return;
+            }
+            writeTag(Tag::MapStringItem);
+            writeString(m_data, name);
+            writeString(m_data, value);
+        }
+
+        void mapNoneItem(std::string name) override
+        {
+            writeTag(Tag::MapNoneItem);
+            writeString(m_data, name);
+        }
+
+        void mapEnd() override
+        {
+            writeTag(Tag::MapEnd);
+            --m_depth;
+        }
+
+        void listMapItem() override
+        {
+            writeTag(Tag::ListMapItem);
+            ++m_depth;
+        }
+
+        void listListItem() override
+        {
+            writeTag(Tag::ListListItem);
+            ++m_depth;
+        }
+
+        void listIntItem(Atlas::Message::IntType value) override
+        {
+            writeTag(Tag::ListIntItem);
+            writeValue(m_data, value);
+        }
+
+        void listFloatItem(Atlas::Message::FloatType value) override
+        {
+            writeTag(Tag::ListFloatItem);
+            writeValue(m_data, value);
+        }
+
+        void listStringItem(std::string value) override
+        {
+            writeTag(Tag::ListStringItem);
+            writeString(m_data, value);
+        }
+
+        void listNoneItem() override
+        {
+            writeTag(Tag::ListNoneItem);
+        }
+
+        void listEnd() override
+        {
+            writeTag(Tag::ListEnd);
+            --m_depth;
+        }
+
+    private:
+        std::string& m_data;
+        int m_depth;
+
+        void writeTag(Tag tag)
+        {
+            m_data.push_back(static_cast<char>(tag));
+        }
+};
+
+EncodedOp::EncodedOp(const Operation& op)
+{
+    Recorder recorder(m_data);
+    Atlas::Objects::ObjectsEncoder encoder(recorder);
+    encoder.streamObjectsMessage(op);
+}
+
+void EncodedOp::write(Atlas::Bridge& bridge, const std::string& to, double seconds) const
+{
+    bridge.streamMessage();
+    //The order of attributes in a map doesn't matter, so we can put the recipient specific ones first.
+    bridge.mapStringItem("to", to);
+    bridge.mapFloatItem("seconds", seconds);
+
+    size_t pos = 0;
+    while (pos < m_data.size()) {
+        auto tag = static_cast<Tag>(m_data[pos++]);
+        switch (tag) {
+            case Tag::MapMapItem:
+                bridge.mapMapItem(readString(m_data, pos));
+                break;
+            case Tag::MapListItem:
+                bridge.mapListItem(readString(m_data, pos));
+                break;
+            case Tag::MapIntItem: {
+                auto name = readString(m_data, pos);
+                bridge.mapIntItem(std::move(name), readValue<Atlas::Message::IntType>(m_data, pos));
+            }
+                break;
+            case Tag::MapFloatItem: {
+                auto name = readString(m_data, pos);
+                bridge.mapFloatItem(std::move(name), readValue<Atlas::Message::FloatType>(m_data, pos));
+            }
+                break;
+            case Tag::MapStringItem: {
+                auto name = readString(m_data, pos);
+                bridge.mapStringItem(std::move(name), readString(m_data, pos));
+            }
+                break;
+            case Tag::MapNoneItem:
+                bridge.mapNoneItem(readString(m_data, pos));
+                break;
+            case Tag::MapEnd:
+                bridge.mapEnd();
+                break;
+            case Tag::ListMapItem:
+                bridge.listMapItem();
+                break;
+            case Tag::ListListItem:
+                bridge.listListItem();
+                break;
+            case Tag::ListIntItem:
+                bridge.listIntItem(readValue<Atlas::Message::IntType>(m_data, pos));
+                break;
+            case Tag::ListFloatItem:
+                bridge.listFloatItem(readValue<Atlas::Message::FloatType>(m_data, pos));
+                break;
+            case Tag::ListStringItem:
+                bridge.listStringItem(readString(m_data, pos));
+                break;
+            case Tag::ListNoneItem:
+                bridge.listNoneItem();
+                break;
+            case Tag::ListEnd:
+                bridge.listEnd();
+                break;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_ENCODEDOP_H
+#define CYPHESIS_ENCODEDOP_H
+
+#include "common/OperationRouter.h"
+
+#include <string>
+
+namespace Atlas {
+    class Bridge;
+}
+
+/**
+ * @brief An op which has been encoded once, and can then be written to multiple codecs.
+ *
+ * The op is walked through once and all calls that would have been made to an Atlas codec are recorded into a
+ * compact buffer. When writing the op to a codec the buffer is replayed, which avoids having to go through all of
+ * the Atlas object attributes again.
+ *
+ * The "to" and "seconds" attributes of the op are not recorded, since these differ between recipients. Instead
+ * they are supplied when writing.
+ */
+class EncodedOp
+{
+    public:
+        /**
+         * @brief Ctor.
+         * @param op The op to encode.
+         */
+        explicit EncodedOp(const Operation& op);
+
+        /**
+         * @brief Writes the op as a complete message to the supplied bridge.
+         * @param bridge A bridge, normally a codec.
+         * @param to The recipient of the op.
+         * @param seconds The time of the op.
+         */
+        void write(Atlas::Bridge& bridge, const std::string& to, double seconds) const;
+
+        /**
+         * @brief Gets the size of the encoded buffer, in bytes.
+         */
+        size_t size() const
+        {
+            return m_data.size();
+        }
+
+    private:
+        class Recorder;
+
+        std::string m_data;
+};
+
+
+#endif //CYPHESIS_ENCODEDOP_H
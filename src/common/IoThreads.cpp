@@ -0,0 +1,122 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "IoThreads.h"
+
+#include "common/log.h"
+#include "common/compose.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+IoThreads::IoThreads(size_t threadCount)
+        : m_nextContext(0)
+{
+    assert(threadCount > 0);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_contexts.emplace_back(new boost::asio::io_context());
+        m_work.emplace_back(new boost::asio::io_context::work(*m_contexts.back()));
+    }
+    for (auto& context : m_contexts) {
+        auto contextPtr = context.get();
+        m_threads.emplace_back([contextPtr]() {
+            while (true) {
+                try {
+                    contextPtr->run();
+                    return;
+                } catch (const std::exception& ex) {
+                    log(ERROR, String::compose("Exception caught in IO thread: %1", ex.what()));
+                }
+            }
+        });
+    }
+}
+
+IoThreads::~IoThreads()
+{
+    shutdown();
+}
+
+boost::asio::io_context& IoThreads::nextContext()
+{
+    auto& context = *m_contexts[m_nextContext];
+    m_nextContext = (m_nextContext + 1) % m_contexts.size();
+    return context;
+}
+
+void IoThreads::postToMain(std::function<void()> function)
+{
+    m_mainQueue.push(std::move(function));
+}
+
+size_t IoThreads::processQueue()
+{
+    size_t processed = 0;
+    std::function<void()> function;
+    while (m_mainQueue.pop(function)) {
+        try {
+            function();
+        } catch (const std::exception& ex) {
+            log(ERROR, String::compose("Exception caught when processing IO thread results: %1", ex.what()));
+        }
+        //Release anything captured right away, since it might hold the last reference to a socket.
+        function = nullptr;
+        ++processed;
+    }
+    return processed;
+}
+
+void IoThreads::shutdown(std::chrono::steady_clock::duration timeout)
+{
+    //Once the work is removed each thread will exit as soon as its io_context has no more pending handlers.
+    m_work.clear();
+    //Sockets which still are negotiating keep their io_context busy until the negotiation times out, so don't wait
+    //for that. Functions queued for the main thread meanwhile are run, since they might release sockets.
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        processQueue();
+        bool allStopped = std::all_of(m_contexts.begin(), m_contexts.end(), [](const std::unique_ptr<boost::asio::io_context>& context) {
+            return context->stopped();
+        });
+        if (allStopped) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (auto& context : m_contexts) {
+        context->stop();
+    }
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+    //Handlers run on the main thread might have posted new work to the contexts, such as writes. Since the threads
+    //are gone, we'll run any that are ready here until everything has settled.
+    while (true) {
+        size_t handled = processQueue();
+        for (auto& context : m_contexts) {
+            context->restart();
+            handled += context->poll();
+        }
+        if (handled == 0) {
+            break;
+        }
+    }
+    //Destroy any abandoned handlers now, on the main thread, since they might hold the last references to sockets.
+    m_contexts.clear();
+}
@@ -0,0 +1,95 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_IOTHREADS_H
+#define CYPHESIS_IOTHREADS_H
+
+#include "common/io_context.h"
+#include "common/MpscQueue.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A pool of threads which handle socket reads and decoding of incoming data, outside of the main thread.
+ *
+ * Each thread runs its own io_context, and sockets are assigned to them in turn. Since each io_context only is run
+ * by one thread all handlers for a single socket are serialized, without the need for any strands.
+ *
+ * Anything that needs to be done on the main thread, such as handling decoded operations, is pushed onto a queue
+ * which is processed by calling processQueue() from the main loop. This way the simulation is still single threaded.
+ */
+class IoThreads
+{
+    public:
+        /**
+         * @brief Ctor.
+         * @param threadCount The number of threads. Must be at least one.
+         */
+        explicit IoThreads(size_t threadCount);
+
+        ~IoThreads();
+
+        /**
+         * @brief Gets an io_context to use for a new socket.
+         *
+         * The contexts are handed out in turn, to spread the sockets evenly over the threads.
+         */
+        boost::asio::io_context& nextContext();
+
+        /**
+         * @brief Queues a function to be run on the main thread. Can be called from any thread.
+         */
+        void postToMain(std::function<void()> function);
+
+        /**
+         * @brief Runs all queued functions. Must be called from the main thread.
+         * @return The number of functions run.
+         */
+        size_t processQueue();
+
+        /**
+         * @brief Waits for all threads to complete their work, and then runs any functions queued by them.
+         *
+         * All sockets should have been closed before this is called. Any work still pending after the timeout,
+         * such as sockets still negotiating, is abandoned and destroyed along with the io_contexts.
+         * No more sockets can be handled once this has been called.
+         * @param timeout The max time to wait for the threads.
+         */
+        void shutdown(std::chrono::steady_clock::duration timeout = std::chrono::seconds(1));
+
+    private:
+        std::vector<std::unique_ptr<boost::asio::io_context>> m_contexts;
+
+        /**
+         * Keeps the contexts from running out of work while there are no sockets.
+         */
+        std::vector<std::unique_ptr<boost::asio::io_context::work>> m_work;
+
+        std::vector<std::thread> m_threads;
+
+        size_t m_nextContext;
+
+        MpscQueue<std::function<void()>> m_mainQueue;
+};
+
+
+#endif //CYPHESIS_IOTHREADS_H
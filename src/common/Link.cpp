@@ -19,6 +19,10 @@
 #include "Link.h"
 
 #include "common/CommSocket.h"
+#include "common/MulticastOps.h"
+#include "common/PerceptionAggregator.h"
+#include "common/PropertyDeltas.h"
+#include "common/operations/Bundle.h"
 #include "common/debug.h"
 
 #include <Atlas/Objects/Encoder.h>
@@ -32,14 +36,26 @@ static const bool debug_flag = false;
 Link::Link(CommSocket & socket, const std::string & id, long iid) :
             Router(id, iid),
             m_encoder(nullptr),
+            m_perceptionBundling(false),
+            m_propertyDeltas(false),
+            m_perceptionsDeferred(false),
             m_commSocket(socket)
 {
 }
 
-Link::~Link() = default;
+Link::~Link()
+{
+    if (m_perceptionsDeferred && PerceptionAggregator::hasInstance()) {
+        PerceptionAggregator::instance().remove(*this);
+    }
+}
 
 void Link::send(const Operation & op) const
 {
+    //Any held back perceptions must be sent first, to keep the order of ops.
+    if (!m_pendingPerceptions.empty()) {
+        flushPerceptions();
+    }
     if (m_encoder) {
         if (debug_flag) {
             std::cerr << "sending: ";
@@ -47,6 +63,20 @@ void Link::send(const Operation & op) const
             std::cerr << std::endl << std::flush;
         }
 
+        //If the same op is sent to multiple recipients we can use an encoding shared between them.
+        if (MulticastOps::hasInstance()) {
+            auto& multicastOps = MulticastOps::instance();
+            auto encodedOp = multicastOps.find(op);
+            if (encodedOp) {
+                auto written = m_commSocket.writeEncoded(*encodedOp, op->getTo(), op->getSeconds());
+                if (written >= 0) {
+                    multicastOps.recordSent(static_cast<size_t>(written));
+                    m_commSocket.flush();
+                    return;
+                }
+            }
+        }
+
         m_encoder->streamObjectsMessage(op);
         m_commSocket.flush();
     }
@@ -54,6 +84,9 @@ void Link::send(const Operation & op) const
 
 void Link::send(const OpVector& opVector) const
 {
+    if (!m_pendingPerceptions.empty()) {
+        flushPerceptions();
+    }
     if (m_encoder) {
         for (const auto& op : opVector) {
             if (debug_flag) {
@@ -68,6 +101,64 @@ void Link::send(const OpVector& opVector) const
     }
 }
 
+void Link::sendPerception(const Operation & op)
+{
+    if (m_propertyDeltas && PropertyDeltas::hasInstance()) {
+        sendPerceptionOp(PropertyDeltas::instance().apply(op));
+    } else {
+        sendPerceptionOp(op);
+    }
+}
+
+void Link::sendPerceptionOp(const Operation & op)
+{
+    if (m_perceptionBundling && m_encoder && PerceptionAggregator::hasInstance()) {
+        auto& perceptionAggregator = PerceptionAggregator::instance();
+        if (perceptionAggregator.isCollecting()) {
+            if (!m_perceptionsDeferred) {
+                m_perceptionsDeferred = true;
+                perceptionAggregator.defer(*this);
+            }
+            //Hold a copy, since the op could be altered by its sender before it's time to send it.
+            m_pendingPerceptions.push_back(op.copy());
+            //Don't hold back too many ops; the link stays registered until the collection ends.
+            if (m_pendingPerceptions.size() >= perceptionAggregator.getMaxBundleSize()) {
+                flushPerceptions();
+            }
+            return;
+        }
+    }
+    send(op);
+}
+
+void Link::flushPerceptions() const
+{
+    //The aggregator stops collecting before telling the registered links to flush.
+    if (m_perceptionsDeferred && (!PerceptionAggregator::hasInstance() || !PerceptionAggregator::instance().isCollecting())) {
+        m_perceptionsDeferred = false;
+    }
+    if (m_pendingPerceptions.empty()) {
+        return;
+    }
+    //Move the ops out first, since sending checks for held back perceptions.
+    std::vector<Operation> perceptions = std::move(m_pendingPerceptions);
+    m_pendingPerceptions.clear();
+    if (perceptions.size() == 1) {
+        //No need for a bundle; this also allows any shared encoding of the op to be used.
+        send(perceptions.front());
+        return;
+    }
+
+    Atlas::Objects::Operation::Bundle bundle;
+    bundle->setSeconds(perceptions.back()->getSeconds());
+    std::vector<Atlas::Objects::Root> args(perceptions.begin(), perceptions.end());
+    bundle->setArgs(args);
+    send(bundle);
+
+    if (PerceptionAggregator::hasInstance()) {
+        PerceptionAggregator::instance().recordBundle(perceptions.size());
+    }
+}
 
 void Link::sendError(const Operation & op,
                      const std::string & errstring,
@@ -21,6 +21,8 @@
 
 #include "common/Router.h"
 
+#include <vector>
+
 class CommSocket;
 
 namespace Atlas {
@@ -34,6 +36,18 @@ class Link : public Router {
   protected:
     /// \brief The Atlas encoder used to send objects over this link
     Atlas::Objects::ObjectsEncoder * m_encoder;
+
+    /// \brief Whether the client can handle perception ops sent as one "bundle" op.
+    bool m_perceptionBundling;
+
+    /// \brief Whether the client can handle property changes sent as deltas.
+    bool m_propertyDeltas;
+
+    /// \brief Perception ops held back until the current collection ends.
+    mutable std::vector<Operation> m_pendingPerceptions;
+
+    /// \brief Whether the link is registered with the PerceptionAggregator.
+    mutable bool m_perceptionsDeferred;
   public:
     CommSocket & m_commSocket;
 
@@ -61,12 +75,48 @@ class Link : public Router {
      */
     void send(const OpVector& opVector) const;
 
+    /**
+     * Sends a perception op, such as a Sight.
+     *
+     * If the client supports bundles and the PerceptionAggregator is collecting,
+     * the op is held back and sent together with all other perception ops for
+     * this client once the collection ends. If the client supports deltas, any
+     * delta registered in PropertyDeltas is sent instead of full values.
+     * @param op A perception op to send.
+     */
+    void sendPerception(const Operation & op);
+
+    /**
+     * Sends any held back perception ops, as one "bundle" op if there are
+     * more than one.
+     */
+    void flushPerceptions() const;
+
+    void setPerceptionBundling(bool enabled) {
+        m_perceptionBundling = enabled;
+    }
+
+    bool isPerceptionBundling() const {
+        return m_perceptionBundling;
+    }
+
+    void setPropertyDeltas(bool enabled) {
+        m_propertyDeltas = enabled;
+    }
+
+    bool isPropertyDeltas() const {
+        return m_propertyDeltas;
+    }
+
     void sendError(const Operation & op,
                    const std::string &,
                    const std::string &) const;
     void disconnect();
 
     virtual void notifyConnectionComplete();
+
+  private:
+    void sendPerceptionOp(const Operation & op);
 };
 
 #endif // COMMON_LINK_H
@@ -20,6 +20,8 @@
 
 #include "globals.h"
 #include "OperationsDispatcher.h"
+#include "CorkedWrites.h"
+#include "PerceptionAggregator.h"
 #include "compose.hpp"
 #include "log.h"
 #include <boost/asio/signal_set.hpp>
@@ -126,6 +128,15 @@ void MainLoop::run(bool daemon,
 
         time += tick_size;
 
+        //Hold back any writes to clients until all operations have been processed, so that each client gets as few writes as possible.
+        if (CorkedWrites::hasInstance()) {
+            CorkedWrites::instance().cork();
+        }
+        //Collect all perceptions sent to each client during this slice, so that they can be sent together.
+        if (PerceptionAggregator::hasInstance()) {
+            PerceptionAggregator::instance().start();
+        }
+
         //Dispatch any incoming messages first
         {
             rmt_ScopedCPUSample(dispatchOperations, 0)
@@ -135,6 +146,20 @@ void MainLoop::run(bool daemon,
             rmt_ScopedCPUSample(processOps, 0)
             operationsHandler.processUntil(time, max_wall_time);
         }
+        if (callbacks.operationsProcessed) {
+            rmt_ScopedCPUSample(operationsProcessed, 0)
+            if (callbacks.operationsProcessed()) {
+                operationsHandler.processUntil(time, max_wall_time);
+            }
+        }
+        if (PerceptionAggregator::hasInstance()) {
+            rmt_ScopedCPUSample(flushPerceptions, 0)
+            PerceptionAggregator::instance().flush();
+        }
+        if (CorkedWrites::hasInstance()) {
+            rmt_ScopedCPUSample(uncorkWrites, 0)
+            CorkedWrites::instance().uncork();
+        }
         {
             rmt_ScopedCPUSample(runIO, 0)
 
@@ -34,6 +34,11 @@ class MainLoop
             std::function<bool()> softExitPoll;
             std::function<void()> softExitTimeout;
             std::function<void()> dispatchOperations;
+            /**
+             * Called after operations have been processed.
+             * Should return true if new operations might have been queued, which then will be processed in the same iteration.
+             */
+            std::function<bool()> operationsProcessed;
         };
 
         static void run(bool daemon,
@@ -0,0 +1,106 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_MPSCQUEUE_H
+#define CYPHESIS_MPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+
+/**
+ * @brief A lock free, unbounded queue with multiple producers and a single consumer.
+ *
+ * Any thread can push values, but only one thread at a time may pop them.
+ *
+ * This is a linked list where producers atomically swap in new nodes at the head, and the consumer follows the links
+ * from the tail. There's always one node in the list, which is a node whose value already has been consumed.
+ * Note that a push that is in progress can temporarily hide values pushed after it; these will be available as
+ * soon as the first push has completed.
+ * @tparam T The value type. Must be default constructible and movable.
+ */
+template<typename T>
+class MpscQueue
+{
+    public:
+        MpscQueue()
+        {
+            auto stub = new Node();
+            m_head.store(stub, std::memory_order_relaxed);
+            m_tail = stub;
+        }
+
+        ~MpscQueue()
+        {
+            T value;
+            while (pop(value)) {
+            }
+            delete m_tail;
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        /**
+         * @brief Pushes a value. Can be called from any thread.
+         */
+        void push(T value)
+        {
+            auto node = new Node();
+            node->value = std::move(value);
+            auto previous = m_head.exchange(node, std::memory_order_acq_rel);
+            previous->next.store(node, std::memory_order_release);
+        }
+
+        /**
+         * @brief Pops a value. Must only be called from the consumer thread.
+         * @param value If there was a value, it's moved into this.
+         * @return True if a value was popped.
+         */
+        bool pop(T& value)
+        {
+            auto next = m_tail->next.load(std::memory_order_acquire);
+            if (!next) {
+                return false;
+            }
+            value = std::move(next->value);
+            //The popped node now becomes the stub.
+            delete m_tail;
+            m_tail = next;
+            return true;
+        }
+
+    private:
+        struct Node
+        {
+            std::atomic<Node*> next{nullptr};
+            T value;
+        };
+
+        /**
+         * The most recently pushed node.
+         */
+        std::atomic<Node*> m_head;
+
+        /**
+         * The node preceding the next one to be popped. Only touched by the consumer.
+         */
+        Node* m_tail;
+};
+
+#endif //CYPHESIS_MPSCQUEUE_H
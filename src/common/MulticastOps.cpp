@@ -0,0 +1,98 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "MulticastOps.h"
+
+#include <cassert>
+
+namespace {
+    /**
+     * How long, in world seconds, an entry is kept. Ops are normally dispatched in the same tick as they are sent,
+     * so this only needs to cover any backlog in the operations queue.
+     */
+    const double ENTRY_LIFETIME = 2.0;
+}
+
+MulticastOps::MulticastOps()
+        : m_encodedCount(0),
+          m_encodedBytes(0),
+          m_sentCount(0),
+          m_sentBytes(0)
+{
+}
+
+MulticastOps::~MulticastOps() = default;
+
+void MulticastOps::add(const Operation& op)
+{
+    assert(op->getArgs().size() == 1);
+    assert(!op->isDefaultSeconds());
+
+    auto seconds = op->getSeconds();
+    while (!m_registrationOrder.empty() && m_registrationOrder.front().second < seconds - ENTRY_LIFETIME) {
+        auto I = m_entries.find(m_registrationOrder.front().first);
+        //The same args could have been registered again later, in which case that entry should be kept.
+        if (I != m_entries.end() && I->second.op->getSeconds() == m_registrationOrder.front().second) {
+            m_entries.erase(I);
+        }
+        m_registrationOrder.pop_front();
+    }
+
+    const void* key = op->getArgs().front().get();
+    m_entries.erase(key);
+    auto result = m_entries.emplace(key, Entry{op, EncodedOp(op)});
+    m_registrationOrder.emplace_back(key, seconds);
+
+    m_encodedCount++;
+    m_encodedBytes += static_cast<int>(result.first->second.encoded.size());
+}
+
+const EncodedOp* MulticastOps::find(const Operation& op) const
+{
+    if (m_entries.empty()) {
+        return nullptr;
+    }
+    auto& args = op->getArgs();
+    if (args.size() != 1) {
+        return nullptr;
+    }
+    auto I = m_entries.find(args.front().get());
+    if (I == m_entries.end()) {
+        return nullptr;
+    }
+    auto& registered = I->second.op;
+    //Only "to" and "seconds" are allowed to differ.
+    if (op->getClassNo() != registered->getClassNo()
+        || op->getParent() != registered->getParent()
+        || op->getFrom() != registered->getFrom()
+        || op->getSerialno() != registered->getSerialno()
+        || op->getRefno() != registered->getRefno()
+        || op->isDefaultFutureSeconds() != registered->isDefaultFutureSeconds()
+        || op->getFutureSeconds() != registered->getFutureSeconds()
+        || op->getId() != registered->getId()
+        || op->getName() != registered->getName()) {
+        return nullptr;
+    }
+    return &I->second.encoded;
+}
+
+void MulticastOps::recordSent(size_t bytes)
+{
+    m_sentCount++;
+    m_sentBytes += static_cast<int>(bytes);
+}
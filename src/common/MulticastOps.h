@@ -0,0 +1,120 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_MULTICASTOPS_H
+#define CYPHESIS_MULTICASTOPS_H
+
+#include "common/Singleton.h"
+#include "common/EncodedOp.h"
+
+#include <Atlas/Objects/RootOperation.h>
+
+#include <deque>
+#include <unordered_map>
+
+/**
+ * @brief Keeps track of ops which are sent to multiple recipients, so that they only need to be encoded once.
+ *
+ * A typical case is when an entity moves and all observers get a Sight of the same Set op. Each recipient still
+ * gets its own op routed through the world, but since they all share the same args object the encoded form can be
+ * shared when the op finally is sent to a client.
+ *
+ * An op registered here is encoded right away. Whenever an op is to be sent to a client the registry is checked,
+ * and if there's an encoded op with the same args, "from" and type that encoding is used instead, with only
+ * "to" and "seconds" written separately.
+ *
+ * Since the args are shared by reference they must not be altered after the op has been registered.
+ *
+ * Entries are kept for a short time only, since they are only of use while the ops are dispatched.
+ */
+class MulticastOps : public Singleton<MulticastOps>
+{
+    public:
+        MulticastOps();
+
+        ~MulticastOps() override;
+
+        /**
+         * @brief Registers an op which will be sent to multiple recipients.
+         * @param op The op, without any "to". It must have exactly one arg, and "seconds" must be set.
+         */
+        void add(const Operation& op);
+
+        /**
+         * @brief Finds a shared encoding for the op, if there is one.
+         * @param op An op about to be sent.
+         * @return A pointer to an encoding, or null if the op needs to be encoded by itself.
+         */
+        const EncodedOp* find(const Operation& op) const;
+
+        /**
+         * @brief Records that a shared encoding has been written to a client.
+         * @param bytes The number of bytes written.
+         */
+        void recordSent(size_t bytes);
+
+        size_t size() const
+        {
+            return m_entries.size();
+        }
+
+        /**
+         * The number of ops that have been encoded.
+         */
+        int m_encodedCount;
+
+        /**
+         * The total size of all encoded ops.
+         */
+        int m_encodedBytes;
+
+        /**
+         * The number of times encoded ops have been written to clients.
+         */
+        int m_sentCount;
+
+        /**
+         * The total size of the data written to clients from encoded ops.
+         */
+        int m_sentBytes;
+
+    private:
+
+        struct Entry
+        {
+            /**
+             * The registered op. This also keeps the args alive, so that the address isn't reused.
+             */
+            Operation op;
+            EncodedOp encoded;
+        };
+
+        /**
+         * Entries keyed by the address of their args.
+         */
+        std::unordered_map<const void*, Entry> m_entries;
+
+        /**
+         * Keys and registration times, in order of registration. Used for expiring entries.
+         */
+        std::deque<std::pair<const void*, double>> m_registrationOrder;
+
+};
+
+
+#endif //CYPHESIS_MULTICASTOPS_H
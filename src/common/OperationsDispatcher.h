@@ -28,6 +28,7 @@
 #include <set>
 #include <queue>
 #include <functional>
+#include <memory>
 #include "modules/Ref.h"
 
 #include <chrono>
@@ -97,6 +98,96 @@ struct OpQueEntry
 
 };
 
+/**
+ * @brief Interface for the ordered queue of future operations.
+ *
+ * Entries are always handed out in (time_for_dispatch, sequence) order, regardless of backend.
+ * The interface mirrors the subset of std::priority_queue which the dispatcher needs.
+ */
+template<typename T>
+struct OpQueue
+{
+    virtual ~OpQueue() = default;
+
+    virtual bool empty() const = 0;
+
+    virtual size_t size() const = 0;
+
+    /**
+     * @brief Gets the entry which should be dispatched next.
+     *
+     * The queue must not be empty.
+     */
+    virtual const OpQueEntry<T>& top() const = 0;
+
+    /**
+     * @brief Removes the entry returned by top().
+     */
+    virtual void pop() = 0;
+
+    virtual void push(OpQueEntry<T>&& entry) = 0;
+
+    virtual void clear() = 0;
+};
+
+/**
+ * @brief The available backends for the operations queue.
+ */
+enum class OpQueueType
+{
+    /**
+     * A binary heap (std::priority_queue). This is the default.
+     */
+    Heap,
+    /**
+     * A hierarchical timing wheel, see TimingWheelOpQueue.
+     */
+    TimingWheel
+};
+
+/**
+ * @brief An operations queue backed by a binary heap.
+ *
+ * Both insertion and removal are O(log n).
+ */
+template<typename T>
+class HeapOpQueue : public OpQueue<T>
+{
+    public:
+        bool empty() const override
+        {
+            return m_queue.empty();
+        }
+
+        size_t size() const override
+        {
+            return m_queue.size();
+        }
+
+        const OpQueEntry<T>& top() const override
+        {
+            return m_queue.top();
+        }
+
+        void pop() override
+        {
+            m_queue.pop();
+        }
+
+        void push(OpQueEntry<T>&& entry) override
+        {
+            m_queue.push(std::move(entry));
+        }
+
+        void clear() override
+        {
+            m_queue = decltype(m_queue)();
+        }
+
+    private:
+        std::priority_queue<OpQueEntry<T>, std::vector<OpQueEntry<T>>, std::greater<OpQueEntry<T>>> m_queue;
+};
+
 struct OperationsHandler
 {
     /// \brief Main world loop function.
@@ -158,6 +249,14 @@ class OperationsDispatcher : public OperationsHandler
         OperationsDispatcher(std::function<void(const Operation&, Ref<T>)> operationProcessor,
                              TimeProviderFnType timeProviderFn);
 
+        /**
+         * @brief Switches the backend used for the queue of future operations.
+         *
+         * Any operations already queued are moved over to the new queue.
+         * @param queueType The new queue backend.
+         */
+        void setQueueType(OpQueueType queueType);
+
         virtual ~OperationsDispatcher();
 
         /// \brief Main world loop function.
@@ -209,14 +308,14 @@ class OperationsDispatcher : public OperationsHandler
          */
         std::chrono::milliseconds m_time_diff_report;
 
-        const std::priority_queue<OpQueEntry<T>, std::vector<OpQueEntry<T>>, std::greater<OpQueEntry<T>>>& getQueue() const
+        const OpQueue<T>& getQueue() const
         {
-            return m_operationQueue;
+            return *m_operationQueue;
         }
 
-        std::priority_queue<OpQueEntry<T>, std::vector<OpQueEntry<T>>, std::greater<OpQueEntry<T>>>& getQueue()
+        OpQueue<T>& getQueue()
         {
-            return m_operationQueue;
+            return *m_operationQueue;
         }
 
         void dispatchNextOp() override;
@@ -229,7 +328,7 @@ class OperationsDispatcher : public OperationsHandler
         const TimeProviderFnType m_timeProviderFn;
 
         /// An ordered queue of operations to be dispatched in the future
-        std::priority_queue<OpQueEntry<T>, std::vector<OpQueEntry<T>>, std::greater<OpQueEntry<T>>> m_operationQueue;
+        std::unique_ptr<OpQueue<T>> m_operationQueue;
         /// Keeps track of if the operation queues are dirty.
         bool m_operation_queues_dirty;
 
@@ -20,6 +20,7 @@
 #define OPERATIONSDISPATCHER_IMPL_H_
 
 #include "OperationsDispatcher.h"
+#include "TimingWheelOpQueue_impl.h"
 #include "rules/LocatedEntity.h"
 #include "const.h"
 #include "debug.h"
@@ -35,7 +36,7 @@ static const bool opdispatcher_debug_flag = false;
 template<typename T>
 OperationsDispatcher<T>::~OperationsDispatcher()
 {
-    m_operationQueue = decltype(m_operationQueue)();
+    m_operationQueue->clear();
 }
 
 
@@ -48,10 +49,10 @@ void OperationsDispatcher<T>::dispatchOperation(OpQueEntry<T>& oqe)
 template<typename T>
 void OperationsDispatcher<T>::dispatchNextOp()
 {
-    if (!m_operationQueue.empty()) {
-        auto opQueueEntry = std::move(m_operationQueue.top());
+    if (!m_operationQueue->empty()) {
+        auto opQueueEntry = std::move(m_operationQueue->top());
         //Pop it before we dispatch it, since dispatching might alter the queue.
-        m_operationQueue.pop();
+        m_operationQueue->pop();
 
         dispatchOperation(opQueueEntry);
     }
@@ -64,12 +65,12 @@ bool OperationsDispatcher<T>::idle(const std::chrono::steady_clock::time_point&
     bool opsAvailableRightNow;
     do {
         auto realtime = getTime();
-        opsAvailableRightNow = !m_operationQueue.empty() && m_operationQueue.top().time_for_dispatch <= realtime;
+        opsAvailableRightNow = !m_operationQueue->empty() && m_operationQueue->top().time_for_dispatch <= realtime;
 
         if (opsAvailableRightNow) {
-            auto opQueueEntry = std::move(m_operationQueue.top());
+            auto opQueueEntry = std::move(m_operationQueue->top());
             //Pop it before we dispatch it, since dispatching might alter the queue.
-            m_operationQueue.pop();
+            m_operationQueue->pop();
 
             if (m_time_diff_report.count() > 0) {
                 //Check if there's too large a difference in time
@@ -77,7 +78,7 @@ bool OperationsDispatcher<T>::idle(const std::chrono::steady_clock::time_point&
                 if (timeDiff > m_time_diff_report) {
                     log(WARNING, String::compose("Op (%1, from %2 to %3) was handled too late. Time diff: %4 seconds. Ops in queue: %5",
                                                  opQueueEntry->getParent(), opQueueEntry.from->describeEntity(),
-                                                 opQueueEntry->getTo(), std::chrono::duration_cast<std::chrono::duration<float>>(timeDiff).count(), m_operationQueue.size()));
+                                                 opQueueEntry->getTo(), std::chrono::duration_cast<std::chrono::duration<float>>(timeDiff).count(), m_operationQueue->size()));
                 }
             }
             dispatchOperation(opQueueEntry);
@@ -89,8 +90,8 @@ bool OperationsDispatcher<T>::idle(const std::chrono::steady_clock::time_point&
     // to tell the server not to sleep when polling clients. This ensures
     // that we keep processing ops at a the maximum rate without leaving
     // clients unattended.
-    Monitors::instance().insert("operations_queue", (Atlas::Message::IntType) m_operationQueue.size());
-    return !m_operationQueue.empty() && m_operationQueue.top().time_for_dispatch <= std::chrono::duration_cast<std::chrono::milliseconds>(getTime());
+    Monitors::instance().insert("operations_queue", (Atlas::Message::IntType) m_operationQueue->size());
+    return !m_operationQueue->empty() && m_operationQueue->top().time_for_dispatch <= std::chrono::duration_cast<std::chrono::milliseconds>(getTime());
 }
 
 template<typename T>
@@ -99,18 +100,18 @@ size_t OperationsDispatcher<T>::processUntil(std::chrono::steady_clock::time_poi
     size_t count = 0;
     auto duration = time_point - std::chrono::steady_clock::time_point{};
 
-    while (!m_operationQueue.empty() && m_operationQueue.top().time_for_dispatch < duration && std::chrono::steady_clock::now() < max_wall_clock) {
+    while (!m_operationQueue->empty() && m_operationQueue->top().time_for_dispatch < duration && std::chrono::steady_clock::now() < max_wall_clock) {
         count++;
-        auto opQueueEntry = std::move(m_operationQueue.top());
+        auto opQueueEntry = std::move(m_operationQueue->top());
         //Pop it before we dispatch it, since dispatching might alter the queue.
-        m_operationQueue.pop();
+        m_operationQueue->pop();
 
         //Set the time of when this op is dispatched. That way, other components in the system can
         //always use the seconds set on the op to know the current time.
         opQueueEntry.op->setSeconds(std::chrono::duration_cast<std::chrono::duration<float>>(time_point.time_since_epoch()).count());
         dispatchOperation(opQueueEntry);
     }
-    Monitors::instance().insert("operations_queue", (Atlas::Message::IntType) m_operationQueue.size());
+    Monitors::instance().insert("operations_queue", (Atlas::Message::IntType) m_operationQueue->size());
     return count;
 }
 
@@ -136,11 +137,11 @@ std::chrono::steady_clock::duration OperationsDispatcher<T>::getTime() const
 template<typename T>
 std::chrono::steady_clock::duration OperationsDispatcher<T>::timeUntilNextOp() const
 {
-    if (m_operationQueue.empty()) {
+    if (m_operationQueue->empty()) {
         //600 is a fairly large number of seconds
         return std::chrono::seconds(600);
     }
-    return std::chrono::steady_clock::time_point(m_operationQueue.top().time_for_dispatch) - std::chrono::steady_clock::now();
+    return std::chrono::steady_clock::time_point(m_operationQueue->top().time_for_dispatch) - std::chrono::steady_clock::now();
 }
 
 
@@ -182,6 +183,7 @@ OperationsDispatcher<T>::OperationsDispatcher(std::function<void(const Operation
         :       m_time_diff_report(0),
                 m_operationProcessor(std::move(operationProcessor)),
                 m_timeProviderFn(std::move(timeProviderFn)),
+                m_operationQueue(new HeapOpQueue<T>()),
                 m_operation_queues_dirty(false),
                 m_sequence(0)
 {
@@ -190,7 +192,28 @@ OperationsDispatcher<T>::OperationsDispatcher(std::function<void(const Operation
 template<typename T>
 void OperationsDispatcher<T>::clearQueues()
 {
-    m_operationQueue = decltype(m_operationQueue)();
+    m_operationQueue->clear();
+}
+
+template<typename T>
+void OperationsDispatcher<T>::setQueueType(OpQueueType queueType)
+{
+    std::unique_ptr<OpQueue<T>> newQueue;
+    switch (queueType) {
+        case OpQueueType::TimingWheel:
+            newQueue.reset(new TimingWheelOpQueue<T>());
+            break;
+        case OpQueueType::Heap:
+        default:
+            newQueue.reset(new HeapOpQueue<T>());
+            break;
+    }
+    while (!m_operationQueue->empty()) {
+        newQueue->push(OpQueEntry<T>(m_operationQueue->top()));
+        m_operationQueue->pop();
+    }
+    m_operationQueue = std::move(newQueue);
+    m_operation_queues_dirty = true;
 }
 
 
@@ -202,8 +225,8 @@ void OperationsDispatcher<T>::addOperationToQueue(Operation op, Ref<T> ent)
 
     //Check the sequence number of the first op at start.
     long topSequenceNr = 0;
-    if (!m_operationQueue.empty()) {
-        topSequenceNr = m_operationQueue.top().sequence;
+    if (!m_operationQueue->empty()) {
+        topSequenceNr = m_operationQueue->top().sequence;
     }
     op->setFrom(ent->getId());
     if (opdispatcher_debug_flag) {
@@ -211,9 +234,9 @@ void OperationsDispatcher<T>::addOperationToQueue(Operation op, Ref<T> ent)
         debug_dump(op, std::cout);
         std::cout << "}" << std::endl << std::flush;
     }
-    m_operationQueue.emplace(std::move(op), std::move(ent), ++m_sequence);
+    m_operationQueue->push(OpQueEntry<T>(std::move(op), std::move(ent), ++m_sequence));
     //Only mark the queue as dirty if the first entry has changed.
-    if (topSequenceNr != m_operationQueue.top().sequence) {
+    if (topSequenceNr != m_operationQueue->top().sequence) {
         m_operation_queues_dirty = true;
     }
 }
@@ -221,7 +244,7 @@ void OperationsDispatcher<T>::addOperationToQueue(Operation op, Ref<T> ent)
 template<typename T>
 size_t OperationsDispatcher<T>::getQueueSize() const
 {
-    return m_operationQueue.size();
+    return m_operationQueue->size();
 }
 
 
@@ -0,0 +1,58 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "PerceptionAggregator.h"
+#include "Link.h"
+
+#include <algorithm>
+
+PerceptionAggregator::PerceptionAggregator(size_t maxBundleSize)
+        : m_bundlesSent(0),
+          m_opsBundled(0),
+          m_maxBundleSize(maxBundleSize),
+          m_collecting(false)
+{
+}
+
+PerceptionAggregator::~PerceptionAggregator() = default;
+
+void PerceptionAggregator::start()
+{
+    m_collecting = true;
+}
+
+void PerceptionAggregator::flush()
+{
+    m_collecting = false;
+    //Swap first, so that the list is left in a valid state even if a link would register itself again while sending.
+    std::vector<Link*> links;
+    std::swap(links, m_deferredLinks);
+    for (auto link : links) {
+        link->flushPerceptions();
+    }
+}
+
+void PerceptionAggregator::defer(Link& link)
+{
+    m_deferredLinks.emplace_back(&link);
+}
+
+void PerceptionAggregator::remove(Link& link)
+{
+    m_deferredLinks.erase(std::remove(m_deferredLinks.begin(), m_deferredLinks.end(), &link), m_deferredLinks.end());
+}
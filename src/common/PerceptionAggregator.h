@@ -0,0 +1,112 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_PERCEPTIONAGGREGATOR_H
+#define CYPHESIS_PERCEPTIONAGGREGATOR_H
+
+#include "common/Singleton.h"
+
+#include <cstddef>
+#include <vector>
+
+class Link;
+
+/**
+ * @brief Collects the perception ops sent to each client while the main loop is processing operations.
+ *
+ * During a single slice a client can be sent many perception ops, such as Sights of movement and property changes.
+ * Links for clients which have declared that they support it hold back these ops while collecting, and register
+ * themselves here. When collection ends each registered link sends all of its ops as one "bundle" op.
+ *
+ * Clients which haven't declared support still get each op by itself.
+ *
+ * To keep latency and memory usage bounded, a link will still send its ops right away once it has collected more
+ * than a maximum number of them.
+ */
+class PerceptionAggregator : public Singleton<PerceptionAggregator>
+{
+    public:
+        /**
+         * @brief Ctor.
+         * @param maxBundleSize The most perception ops a link will hold back before sending them.
+         */
+        explicit PerceptionAggregator(size_t maxBundleSize);
+
+        ~PerceptionAggregator() override;
+
+        /**
+         * @brief Starts collecting perception ops.
+         */
+        void start();
+
+        /**
+         * @brief Stops collecting perception ops, and makes all registered links send the ops they have collected.
+         */
+        void flush();
+
+        bool isCollecting() const
+        {
+            return m_collecting;
+        }
+
+        size_t getMaxBundleSize() const
+        {
+            return m_maxBundleSize;
+        }
+
+        /**
+         * @brief Registers a link which has collected perception ops.
+         *
+         * A link should only register itself once per collection.
+         */
+        void defer(Link& link);
+
+        /**
+         * @brief Removes a link, which must be done if it's destroyed while registered.
+         */
+        void remove(Link& link);
+
+        /**
+         * @brief Records that a number of perception ops have been sent as one bundle.
+         */
+        void recordBundle(size_t opCount)
+        {
+            m_bundlesSent++;
+            m_opsBundled += static_cast<int>(opCount);
+        }
+
+        /**
+         * The number of bundle ops which have been sent.
+         */
+        int m_bundlesSent;
+
+        /**
+         * The number of perception ops which have been sent in bundles.
+         */
+        int m_opsBundled;
+
+    private:
+        size_t m_maxBundleSize;
+
+        bool m_collecting;
+
+        std::vector<Link*> m_deferredLinks;
+};
+
+
+#endif //CYPHESIS_PERCEPTIONAGGREGATOR_H
@@ -0,0 +1,135 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "PropertyDeltas.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <algorithm>
+
+using Atlas::Message::Element;
+using Atlas::Message::ListType;
+using Atlas::Message::MapType;
+
+namespace {
+    /**
+     * How long, in world seconds, an entry is kept. Ops are normally dispatched in the same tick as they are sent,
+     * so this only needs to cover any backlog in the operations queue.
+     */
+    const double ENTRY_LIFETIME = 2.0;
+}
+
+PropertyDeltas::PropertyDeltas()
+        : m_registeredCount(0),
+          m_sentCount(0)
+{
+}
+
+PropertyDeltas::~PropertyDeltas() = default;
+
+bool PropertyDeltas::createDelta(const std::string& name, const Element& previous, const Element& current, MapType& delta)
+{
+    if (previous.isMap() && current.isMap()) {
+        auto& previousMap = previous.Map();
+        auto& currentMap = current.Map();
+        MapType changed;
+        MapType removed;
+        for (auto& entry : currentMap) {
+            auto I = previousMap.find(entry.first);
+            if (I == previousMap.end() || I->second != entry.second) {
+                changed.emplace(entry.first, entry.second);
+            }
+        }
+        //If all entries are in the current map, none can have been removed.
+        if (previousMap.size() + changed.size() > currentMap.size()) {
+            for (auto& entry : previousMap) {
+                if (currentMap.find(entry.first) == currentMap.end()) {
+                    removed.emplace(entry.first, 0);
+                }
+            }
+        }
+        //Only use the delta if it's smaller than the full map.
+        if (changed.size() + removed.size() >= currentMap.size()) {
+            return false;
+        }
+        if (!changed.empty()) {
+            delta.emplace(name + "!append", std::move(changed));
+        }
+        if (!removed.empty()) {
+            delta.emplace(name + "!subtract", std::move(removed));
+        }
+        return true;
+    } else if (previous.isList() && current.isList()) {
+        auto& previousList = previous.List();
+        auto& currentList = current.List();
+        //Only entries added to the end can be described, and only if there were entries before.
+        if (previousList.empty() || previousList.size() >= currentList.size()
+            || !std::equal(previousList.begin(), previousList.end(), currentList.begin())) {
+            return false;
+        }
+        delta.emplace(name + "!append", ListType(currentList.begin() + static_cast<ListType::difference_type>(previousList.size()), currentList.end()));
+        return true;
+    }
+    return false;
+}
+
+void PropertyDeltas::add(const Atlas::Objects::Root& arg, Atlas::Objects::Root deltaArg, double seconds)
+{
+    while (!m_registrationOrder.empty() && m_registrationOrder.front().second < seconds - ENTRY_LIFETIME) {
+        auto I = m_entries.find(m_registrationOrder.front().first);
+        //The same arg could have been registered again later, in which case that entry should be kept.
+        if (I != m_entries.end() && I->second.seconds == m_registrationOrder.front().second) {
+            m_entries.erase(I);
+        }
+        m_registrationOrder.pop_front();
+    }
+
+    const void* key = arg.get();
+    m_entries[key] = Entry{arg, std::move(deltaArg), seconds};
+    m_registrationOrder.emplace_back(key, seconds);
+
+    m_registeredCount++;
+}
+
+Operation PropertyDeltas::apply(const Operation& op)
+{
+    if (m_entries.empty() || op->getClassNo() != Atlas::Objects::Operation::SIGHT_NO) {
+        return op;
+    }
+    auto& args = op->getArgs();
+    if (args.size() != 1) {
+        return op;
+    }
+    auto set = Atlas::Objects::smart_dynamic_cast<Operation>(args.front());
+    if (!set.isValid() || set->getClassNo() != Atlas::Objects::Operation::SET_NO || set->getArgs().size() != 1) {
+        return op;
+    }
+    auto I = m_entries.find(set->getArgs().front().get());
+    if (I == m_entries.end()) {
+        return op;
+    }
+
+    //The copies are shallow, so only the envelopes of the ops are copied.
+    Operation deltaSet = set.copy();
+    deltaSet->setArgs1(I->second.deltaArg);
+    Operation deltaSight = op.copy();
+    deltaSight->setArgs1(deltaSet);
+
+    m_sentCount++;
+    return deltaSight;
+}
@@ -0,0 +1,117 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_PROPERTYDELTAS_H
+#define CYPHESIS_PROPERTYDELTAS_H
+
+#include "common/Singleton.h"
+#include "common/OperationRouter.h"
+
+#include <Atlas/Message/Element.h>
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Allows clients which support it to be sent only what has changed in properties, instead of their full values.
+ *
+ * When an entity sends a Sight of a Set with changed properties it can also register a second version of the Set arg,
+ * in which maps and lists are described by how they have changed. The changes are expressed with the same
+ * modifiers as are used when setting properties, i.e. "<name>!append" and "<name>!subtract".
+ *
+ * Whenever a Sight is sent to a client which has declared support for deltas the registry is checked, and if there's
+ * a delta for the arg of the Set that's sent instead. All other clients get the full values.
+ *
+ * Entries are kept for a short time only, since they are only of use while the ops are dispatched.
+ */
+class PropertyDeltas : public Singleton<PropertyDeltas>
+{
+    public:
+        PropertyDeltas();
+
+        ~PropertyDeltas() override;
+
+        /**
+         * @brief Describes how a map or list value has changed.
+         *
+         * For maps the entries which have been added or replaced are put in "<name>!append", and the keys which have
+         * been removed in "<name>!subtract" (with the values ignored). For lists which only have had entries added
+         * to the end, those entries are put in "<name>!append".
+         *
+         * @param name The name of the property.
+         * @param previous The value last sent.
+         * @param current The current value.
+         * @param delta The changes are added here.
+         * @return True if a delta was added, false if the value can't be described as a delta, or if the delta
+         * wouldn't be smaller than the full value.
+         */
+        static bool createDelta(const std::string& name, const Atlas::Message::Element& previous,
+                                const Atlas::Message::Element& current, Atlas::Message::MapType& delta);
+
+        /**
+         * @brief Registers a delta version of the arg of a Set op.
+         * @param arg The arg of the Set, with the full values. It must not be altered after it has been registered.
+         * @param deltaArg The arg to send instead to clients which support deltas.
+         * @param seconds The time of the Set op.
+         */
+        void add(const Atlas::Objects::Root& arg, Atlas::Objects::Root deltaArg, double seconds);
+
+        /**
+         * @brief Gets the version of a Sight op to send to a client which supports deltas.
+         * @param op An op about to be sent.
+         * @return A copy of the op with the delta as the arg of the Set, if there is one, else the op itself.
+         */
+        Operation apply(const Operation& op);
+
+        size_t size() const
+        {
+            return m_entries.size();
+        }
+
+        /**
+         * The number of deltas that have been registered.
+         */
+        int m_registeredCount;
+
+        /**
+         * The number of times deltas have been sent instead of the full values.
+         */
+        int m_sentCount;
+
+    private:
+        struct Entry
+        {
+            /**
+             * Holding a reference to the arg keeps its address from being reused while registered.
+             */
+            Atlas::Objects::Root arg;
+            Atlas::Objects::Root deltaArg;
+            double seconds;
+        };
+
+        std::unordered_map<const void*, Entry> m_entries;
+
+        /**
+         * The registered entries, in the order they were added, used for expiring old entries.
+         */
+        std::deque<std::pair<const void*, double>> m_registrationOrder;
+};
+
+
+#endif //CYPHESIS_PROPERTYDELTAS_H
@@ -0,0 +1,104 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_PROPERTYIDS_H
+#define CYPHESIS_PROPERTYIDS_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+/**
+ * An interned property name.
+ */
+typedef std::uint32_t PropertyId;
+
+/**
+ * @brief Interns property names into small integer ids, so that properties can be looked up without comparing strings.
+ *
+ * Names of properties with factories are interned when the factories are installed, and any other names when they
+ * are first used on an entity. Ids are never reused or released, so they can be stored indefinitely.
+ *
+ * Since the simulation is single threaded this must only be used from the main thread.
+ */
+class PropertyIds
+{
+    public:
+        /**
+         * @brief Gets the id for a name, assigning a new one if the name hasn't been seen before.
+         */
+        static PropertyId intern(const std::string& name)
+        {
+            auto& registry = instance();
+            auto I = registry.ids.find(name);
+            if (I != registry.ids.end()) {
+                return I->second;
+            }
+            auto id = static_cast<PropertyId>(registry.names.size());
+            registry.names.push_back(name);
+            registry.ids.emplace(name, id);
+            return id;
+        }
+
+        /**
+         * @brief Gets the id of a property class, through its "property_name" trait.
+         *
+         * The name is only interned the first time this is called for each class.
+         */
+        template<class PropertyT>
+        static PropertyId idOf()
+        {
+            static const PropertyId id = intern(PropertyT::property_name);
+            return id;
+        }
+
+        /**
+         * @brief Gets the name for an id. The id must have been returned from intern().
+         */
+        static const std::string& name(PropertyId id)
+        {
+            return instance().names[id];
+        }
+
+        /**
+         * @brief The number of interned names.
+         */
+        static size_t size()
+        {
+            return instance().names.size();
+        }
+
+    private:
+        struct Registry
+        {
+            std::unordered_map<std::string, PropertyId> ids;
+            /**
+             * A deque, so that references to names stay valid as more are added.
+             */
+            std::deque<std::string> names;
+        };
+
+        static Registry& instance()
+        {
+            static Registry registry;
+            return registry;
+        }
+};
+
+#endif //CYPHESIS_PROPERTYIDS_H
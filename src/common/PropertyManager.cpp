@@ -19,6 +19,7 @@
 #include "PropertyManager.h"
 
 #include "PropertyFactory.h"
+#include "PropertyIds.h"
 
 #include <cassert>
 
@@ -41,6 +42,8 @@ PropertyKit * PropertyManager::getPropertyFactory(const std::string & name) cons
 void PropertyManager::installFactory(const std::string & name,
                                      std::unique_ptr<PropertyKit> factory)
 {
+    //Intern the name up front, since properties with factories are the ones most often looked up.
+    PropertyIds::intern(name);
     m_propertyFactories.insert(std::make_pair(name, std::move(factory)));
 }
 
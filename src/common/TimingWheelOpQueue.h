@@ -0,0 +1,139 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef TIMINGWHEELOPQUEUE_H_
+#define TIMINGWHEELOPQUEUE_H_
+
+#include "OperationsDispatcher.h"
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief An operations queue backed by a hierarchical timing wheel.
+ *
+ * There are four wheels with 256 slots each. The first wheel has a resolution of one millisecond,
+ * and each following wheel covers a full revolution of the one below it (i.e. 256 ms, ~65 s and ~4.6 h per slot).
+ * Entries further away than that are kept in an overflow heap.
+ *
+ * Insertion is O(1). When the cursor reaches a slot in a coarser wheel, its entries are "cascaded" down into the finer
+ * wheels, so each entry is moved at most once per wheel. Entries which are due at the current cursor time are kept in a
+ * small "ready" heap, which makes sure that the (time_for_dispatch, sequence) ordering is kept for entries with the
+ * same time.
+ *
+ * The cursor is only ever advanced when entries are popped, never when peeking with top(). Since the dispatcher only
+ * pops entries which are due, any operations added for "now" will end up in the first wheel instead of the ready heap.
+ */
+template<typename T>
+class TimingWheelOpQueue : public OpQueue<T>
+{
+    public:
+        static constexpr unsigned int slot_bits = 8;
+        static constexpr unsigned int slots_per_wheel = 1u << slot_bits;
+        static constexpr unsigned int wheel_count = 4;
+
+        TimingWheelOpQueue();
+
+        ~TimingWheelOpQueue() override = default;
+
+        bool empty() const override;
+
+        size_t size() const override;
+
+        const OpQueEntry<T>& top() const override;
+
+        void pop() override;
+
+        void push(OpQueEntry<T>&& entry) override;
+
+        void clear() override;
+
+        /**
+         * Gets the current cursor time, in milliseconds.
+         * All entries at or before this time are in the ready heap.
+         */
+        std::uint64_t getCurrentTime() const
+        {
+            return m_currentTime;
+        }
+
+    private:
+
+        struct Wheel
+        {
+            std::array<std::vector<OpQueEntry<T>>, slots_per_wheel> slots;
+            /// A bitmap of the slots that contains entries.
+            std::array<std::uint64_t, slots_per_wheel / 64> occupied;
+        };
+
+        /**
+         * Location of the earliest entry in the wheels, as found by top().
+         */
+        struct PeekLocation
+        {
+            bool valid;
+            unsigned int level;
+            unsigned int slot;
+            size_t index;
+        };
+
+        /// Entries that are due at or before the current time, stored as a min heap.
+        std::vector<OpQueEntry<T>> m_ready;
+
+        std::array<Wheel, wheel_count> m_wheels;
+
+        /// Entries too far in the future to fit in the wheels, stored as a min heap.
+        std::vector<OpQueEntry<T>> m_overflow;
+
+        /// The time of the cursor, in milliseconds.
+        std::uint64_t m_currentTime;
+
+        size_t m_size;
+
+        mutable PeekLocation m_peek;
+
+        /**
+         * @brief Places an entry either in the ready heap, in one of the wheels or in the overflow heap.
+         */
+        void insert(OpQueEntry<T>&& entry);
+
+        /**
+         * @brief Advances the cursor until there are entries in the ready heap (or the queue is empty).
+         */
+        void advance();
+
+        /**
+         * @brief Moves all entries in the slot into either the ready heap or finer wheels.
+         */
+        void cascade(unsigned int level, unsigned int slot);
+
+        /**
+         * @brief Finds the first occupied slot at or after the supplied index.
+         * @return The slot index, or slots_per_wheel if there are no occupied slots.
+         */
+        unsigned int findOccupiedSlot(unsigned int level, unsigned int from) const;
+
+        static unsigned int slotIndex(std::uint64_t time, unsigned int level)
+        {
+            return static_cast<unsigned int>((time >> (slot_bits * level)) & (slots_per_wheel - 1));
+        }
+
+};
+
+#endif /* TIMINGWHEELOPQUEUE_H_ */
@@ -0,0 +1,223 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef TIMINGWHEELOPQUEUE_IMPL_H_
+#define TIMINGWHEELOPQUEUE_IMPL_H_
+
+#include "TimingWheelOpQueue.h"
+
+#include <algorithm>
+#include <cassert>
+
+template<typename T>
+TimingWheelOpQueue<T>::TimingWheelOpQueue()
+        : m_currentTime(0),
+          m_size(0),
+          m_peek{false, 0, 0, 0}
+{
+    for (auto& wheel : m_wheels) {
+        wheel.occupied.fill(0);
+    }
+}
+
+template<typename T>
+bool TimingWheelOpQueue<T>::empty() const
+{
+    return m_size == 0;
+}
+
+template<typename T>
+size_t TimingWheelOpQueue<T>::size() const
+{
+    return m_size;
+}
+
+template<typename T>
+const OpQueEntry<T>& TimingWheelOpQueue<T>::top() const
+{
+    assert(m_size > 0);
+    if (!m_ready.empty()) {
+        return m_ready.front();
+    }
+    if (m_peek.valid) {
+        return m_wheels[m_peek.level].slots[m_peek.slot][m_peek.index];
+    }
+
+    //All entries in a wheel are later than any entries in the finer wheels, so the first occupied slot
+    //found after the cursor will contain the earliest entry.
+    for (unsigned int level = 0; level < wheel_count; ++level) {
+        auto slot = findOccupiedSlot(level, slotIndex(m_currentTime, level) + 1);
+        if (slot < slots_per_wheel) {
+            auto& entries = m_wheels[level].slots[slot];
+            size_t best = 0;
+            for (size_t i = 1; i < entries.size(); ++i) {
+                if (entries[i] < entries[best]) {
+                    best = i;
+                }
+            }
+            m_peek = {true, level, slot, best};
+            return entries[best];
+        }
+    }
+
+    //Wheels are empty, so the earliest entry must be in the overflow heap.
+    return m_overflow.front();
+}
+
+template<typename T>
+void TimingWheelOpQueue<T>::pop()
+{
+    assert(m_size > 0);
+    advance();
+    std::pop_heap(m_ready.begin(), m_ready.end(), std::greater<OpQueEntry<T>>());
+    m_ready.pop_back();
+    --m_size;
+}
+
+template<typename T>
+void TimingWheelOpQueue<T>::push(OpQueEntry<T>&& entry)
+{
+    ++m_size;
+    insert(std::move(entry));
+}
+
+template<typename T>
+void TimingWheelOpQueue<T>::clear()
+{
+    m_ready.clear();
+    for (auto& wheel : m_wheels) {
+        for (auto& entries : wheel.slots) {
+            entries.clear();
+        }
+        wheel.occupied.fill(0);
+    }
+    m_overflow.clear();
+    m_currentTime = 0;
+    m_size = 0;
+    m_peek.valid = false;
+}
+
+template<typename T>
+void TimingWheelOpQueue<T>::insert(OpQueEntry<T>&& entry)
+{
+    auto time = entry.time_for_dispatch.count();
+    if (time < 0 || static_cast<std::uint64_t>(time) <= m_currentTime) {
+        m_ready.push_back(std::move(entry));
+        std::push_heap(m_ready.begin(), m_ready.end(), std::greater<OpQueEntry<T>>());
+        return;
+    }
+
+    auto unsignedTime = static_cast<std::uint64_t>(time);
+    auto diff = unsignedTime ^ m_currentTime;
+    //Use the finest wheel in which the entry shares the upper bits with the cursor.
+    for (unsigned int level = 0; level < wheel_count; ++level) {
+        if ((diff >> (slot_bits * (level + 1))) == 0) {
+            auto slot = slotIndex(unsignedTime, level);
+            auto& wheel = m_wheels[level];
+            auto& entries = wheel.slots[slot];
+            entries.push_back(std::move(entry));
+            wheel.occupied[slot / 64] |= (std::uint64_t(1) << (slot % 64));
+            if (m_peek.valid && entries.back() < m_wheels[m_peek.level].slots[m_peek.slot][m_peek.index]) {
+                m_peek = {true, level, slot, entries.size() - 1};
+            }
+            return;
+        }
+    }
+
+    //Anything in the overflow heap is always later than what's in the wheels, so the peek location is still valid.
+    m_overflow.push_back(std::move(entry));
+    std::push_heap(m_overflow.begin(), m_overflow.end(), std::greater<OpQueEntry<T>>());
+}
+
+template<typename T>
+void TimingWheelOpQueue<T>::advance()
+{
+    while (m_ready.empty() && m_size > 0) {
+        m_peek.valid = false;
+
+        bool cascaded = false;
+        for (unsigned int level = 0; level < wheel_count; ++level) {
+            auto slot = findOccupiedSlot(level, slotIndex(m_currentTime, level) + 1);
+            if (slot < slots_per_wheel) {
+                //Move the cursor to the start of the slot, clearing all finer bits.
+                auto spanBits = slot_bits * level;
+                auto blockMask = ~((std::uint64_t(1) << (spanBits + slot_bits)) - 1);
+                m_currentTime = (m_currentTime & blockMask) | (static_cast<std::uint64_t>(slot) << spanBits);
+                cascade(level, slot);
+                cascaded = true;
+                break;
+            }
+        }
+
+        if (!cascaded) {
+            //All wheels are empty; move the cursor to the earliest overflow entry and bring in all entries which now fits in the wheels.
+            assert(!m_overflow.empty());
+            m_currentTime = static_cast<std::uint64_t>(m_overflow.front().time_for_dispatch.count());
+            while (!m_overflow.empty() &&
+                   ((static_cast<std::uint64_t>(m_overflow.front().time_for_dispatch.count()) ^ m_currentTime) >> (slot_bits * wheel_count)) == 0) {
+                std::pop_heap(m_overflow.begin(), m_overflow.end(), std::greater<OpQueEntry<T>>());
+                auto entry = std::move(m_overflow.back());
+                m_overflow.pop_back();
+                insert(std::move(entry));
+            }
+        }
+    }
+}
+
+template<typename T>
+void TimingWheelOpQueue<T>::cascade(unsigned int level, unsigned int slot)
+{
+    auto& wheel = m_wheels[level];
+    wheel.occupied[slot / 64] &= ~(std::uint64_t(1) << (slot % 64));
+
+    //Entries can never be cascaded into the same slot, so we can swap the vector back afterwards to keep its capacity.
+    std::vector<OpQueEntry<T>> entries;
+    entries.swap(wheel.slots[slot]);
+    for (auto& entry : entries) {
+        insert(std::move(entry));
+    }
+    entries.clear();
+    wheel.slots[slot].swap(entries);
+}
+
+template<typename T>
+unsigned int TimingWheelOpQueue<T>::findOccupiedSlot(unsigned int level, unsigned int from) const
+{
+    if (from >= slots_per_wheel) {
+        return slots_per_wheel;
+    }
+    auto& occupied = m_wheels[level].occupied;
+    auto word = from / 64;
+    auto bits = occupied[word] & (~std::uint64_t(0) << (from % 64));
+    while (true) {
+        if (bits != 0) {
+            unsigned int bit = 0;
+            while ((bits & 1u) == 0) {
+                bits >>= 1u;
+                ++bit;
+            }
+            return word * 64 + bit;
+        }
+        if (++word == occupied.size()) {
+            return slots_per_wheel;
+        }
+        bits = occupied[word];
+    }
+}
+
+#endif /* TIMINGWHEELOPQUEUE_IMPL_H_ */
@@ -24,28 +24,154 @@
 #include "compose.hpp"
 #include "log.h"
 
+#include <algorithm>
+#include <cassert>
 #include <set>
+#include <unordered_map>
 
 
 static const bool debug_flag = false;
 
 using Atlas::Message::MapType;
 
+namespace {
+    /**
+     * The numbers available to each tree. This leaves room for a lot of new nodes before the tree needs to be
+     * renumbered, while making sure that the numbers never overflow.
+     */
+    const std::uint64_t hierarchyRange = std::uint64_t(1) << 62;
+
+    size_t countNodes(const TypeNode* node, std::unordered_map<const TypeNode*, size_t>& sizes)
+    {
+        size_t size = 1;
+        for (auto child : node->children()) {
+            size += countNodes(child, sizes);
+        }
+        sizes[node] = size;
+        return size;
+    }
+}
+
 TypeNode::TypeNode(std::string name)
         : m_name(std::move(name)),
-          m_parent(nullptr)
+          m_parent(nullptr),
+          m_hierarchy(std::make_shared<Hierarchy>()),
+          m_first(0),
+          m_last(hierarchyRange - 1),
+          m_nextChild(1)
 {
+    m_hierarchy->types.emplace(m_name, this);
 }
 
 TypeNode::TypeNode(std::string name,
                    const Atlas::Objects::Root& d)
-        : m_name(std::move(name)),
-          m_parent(nullptr)
+        : TypeNode(std::move(name))
 {
     setDescription(d);
 }
 
-TypeNode::~TypeNode() = default;
+TypeNode::~TypeNode()
+{
+    detach();
+    if (m_parent) {
+        auto& siblings = m_parent->m_children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), this));
+    }
+    for (auto child : m_children) {
+        child->m_parent = nullptr;
+        child->renumber();
+    }
+}
+
+void TypeNode::setParent(TypeNode* parent)
+{
+    if (parent == m_parent) {
+        return;
+    }
+    //Making a node a child of one of its descendants would create a cycle.
+    assert(parent == nullptr || !parent->isTypeOf(this));
+
+    if (m_parent) {
+        detach();
+        auto& siblings = m_parent->m_children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), this));
+    }
+    m_parent = parent;
+    if (!parent) {
+        renumber();
+        return;
+    }
+    parent->m_children.push_back(this);
+
+    //A leaf can get an interval from what's left of the parent's, as long as there's room.
+    //We hand out half of what's left, so that there's room for more siblings.
+    auto width = (parent->m_last + 1 - parent->m_nextChild) / 2;
+    if (m_children.empty() && width > 0) {
+        m_hierarchy = parent->m_hierarchy;
+        m_hierarchy->types[m_name] = this;
+        m_first = parent->m_nextChild;
+        m_last = m_first + width - 1;
+        m_nextChild = m_first + 1;
+        parent->m_nextChild += width;
+    } else {
+        auto root = parent;
+        while (root->m_parent) {
+            root = root->m_parent;
+        }
+        root->renumber();
+    }
+}
+
+void TypeNode::detach()
+{
+    std::vector<const TypeNode*> nodes{this};
+    while (!nodes.empty()) {
+        auto node = nodes.back();
+        nodes.pop_back();
+        auto I = m_hierarchy->types.find(node->m_name);
+        if (I != m_hierarchy->types.end() && I->second == node) {
+            m_hierarchy->types.erase(I);
+        }
+        nodes.insert(nodes.end(), node->m_children.begin(), node->m_children.end());
+    }
+}
+
+void TypeNode::renumber()
+{
+    std::unordered_map<const TypeNode*, size_t> sizes;
+    countNodes(this, sizes);
+
+    auto hierarchy = std::make_shared<Hierarchy>();
+    std::vector<std::pair<TypeNode*, std::uint64_t>> nodes{{this, 0}};
+    while (!nodes.empty()) {
+        auto node = nodes.back().first;
+        auto first = nodes.back().second;
+        nodes.pop_back();
+
+        //The parent has already set up the bounds, unless this is the root.
+        node->m_hierarchy = hierarchy;
+        hierarchy->types[node->m_name] = node;
+        node->m_first = first;
+        if (node == this) {
+            node->m_last = hierarchyRange - 1;
+        }
+
+        //Half of the interval is shared out among the current descendants, by the size of each subtree.
+        //The other half is kept for any new children.
+        auto descendants = sizes[node] - 1;
+        auto position = first + 1;
+        if (descendants > 0) {
+            auto unit = (node->m_last - first) / 2 / descendants;
+            for (auto child : node->m_children) {
+                auto width = unit * sizes[child];
+                child->m_last = position + width - 1;
+                nodes.emplace_back(child, position);
+                position += width;
+            }
+        }
+        node->m_nextChild = position;
+    }
+}
 
 
 void TypeNode::setDescription(const Atlas::Objects::Root& description)
@@ -88,6 +214,7 @@ TypeNode::PropertiesUpdate TypeNode::injectProperty(const std::string& name,
         m_defaults.emplace(name, std::move(prop));
         update.newProps.insert(name);
     }
+    indexDefault(name, p);
 
     auto add_attribute_fn = [&](Atlas::Objects::Root& description) {
         Atlas::Message::Element propertiesElement = Atlas::Message::MapType();
@@ -128,6 +255,7 @@ void TypeNode::addProperties(const MapType& attributes, const PropertyManager& p
         p->set(entry.second);
         p->addFlags(prop_flag_class);
         p->install(this, entry.first);
+        indexDefault(entry.first, p.get());
         m_defaults[entry.first] = std::move(p);
     }
 }
@@ -160,6 +288,7 @@ TypeNode::PropertiesUpdate TypeNode::updateProperties(const MapType& attributes,
     for (auto& entry : propertiesUpdate.removedProps) {
         auto M = m_defaults.find(entry);
         m_defaults.erase(M);
+        indexDefault(entry, nullptr);
     }
 
 
@@ -191,6 +320,7 @@ TypeNode::PropertiesUpdate TypeNode::updateProperties(const MapType& attributes,
             if (!p->hasFlags(prop_flag_visibility_non_public)) {
                 propertiesMapPublic[entry.first] = entry.second;
             }
+            indexDefault(entry.first, p.get());
             m_defaults[entry.first] = std::move(p);
         } else {
             Atlas::Message::Element oldVal;
@@ -219,26 +349,16 @@ TypeNode::PropertiesUpdate TypeNode::updateProperties(const MapType& attributes,
 
 bool TypeNode::isTypeOf(const std::string& base_type) const
 {
-    const TypeNode* node = this;
-    do {
-        if (node->name() == base_type) {
-            return true;
-        }
-        node = node->parent();
-    } while (node != nullptr);
-    return false;
+    auto I = m_hierarchy->types.find(base_type);
+    return I != m_hierarchy->types.end() && isTypeOf(I->second);
 }
 
 bool TypeNode::isTypeOf(const TypeNode* base_type) const
 {
-    const TypeNode* node = this;
-    do {
-        if (node == base_type) {
-            return true;
-        }
-        node = node->parent();
-    } while (node != nullptr);
-    return false;
+    return base_type != nullptr
+           && base_type->m_hierarchy == m_hierarchy
+           && base_type->m_first <= m_first
+           && m_last <= base_type->m_last;
 }
 
 Atlas::Objects::Root& TypeNode::description(Visibility visibility)
@@ -21,15 +21,19 @@
 
 #include "Visibility.h"
 #include "PropertyManager.h"
+#include "PropertyIds.h"
 
 #include <Atlas/Objects/Root.h>
 #include <Atlas/Objects/SmartPtr.h>
 
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <set>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 
 /// \brief Entry in the type hierarchy for in-game entity classes.
@@ -43,6 +47,13 @@ class TypeNode
         /// \brief property defaults
         std::map<std::string, std::unique_ptr<PropertyBase>> m_defaults;
 
+        /// \brief property defaults, indexed by interned property id
+        ///
+        /// The defaults already contain those inherited from the parent types,
+        /// so a lookup never needs to walk the hierarchy. Ids without a default
+        /// are null, and the vector is only as long as the highest id needs.
+        std::vector<PropertyBase*> m_defaultsById;
+
         /// \brief type description, complete
         Atlas::Objects::Root m_privateDescription;
         /**
@@ -58,7 +69,56 @@ class TypeNode
         Atlas::Objects::Root m_publicDescription;
 
         /// \brief parent node
-        const TypeNode* m_parent;
+        TypeNode* m_parent;
+
+        /// \brief child nodes
+        std::vector<TypeNode*> m_children;
+
+        /// \brief state shared by all nodes in the same tree
+        struct Hierarchy
+        {
+            /// \brief all nodes in the tree, by name
+            std::unordered_map<std::string, const TypeNode*> types;
+        };
+
+        /// \brief the tree this node belongs to
+        std::shared_ptr<Hierarchy> m_hierarchy;
+
+        /// \brief first number of the interval of this node in a pre-order numbering of its tree
+        ///
+        /// The intervals of all descendants are nested within the interval of a
+        /// node, so checking if a node inherits from another is just a matter of
+        /// comparing the bounds. Only part of the interval is handed out when
+        /// the tree is numbered, so that new leaf nodes can be given intervals
+        /// without renumbering the whole tree.
+        std::uint64_t m_first;
+
+        /// \brief last number of the interval of this node
+        std::uint64_t m_last;
+
+        /// \brief first number not yet handed out to any child
+        std::uint64_t m_nextChild;
+
+        /// \brief number this node and all its descendants as a new tree
+        void renumber();
+
+        /// \brief remove this node and its descendants from the tree they belong to
+        void detach();
+
+        /// \brief update the id index after a default has been set or removed
+        ///
+        /// @param prop the new default, or null if it has been removed
+        void indexDefault(const std::string& name, PropertyBase* prop)
+        {
+            auto id = PropertyIds::intern(name);
+            if (id >= m_defaultsById.size()) {
+                if (prop == nullptr) {
+                    return;
+                }
+                m_defaultsById.resize(id + 1, nullptr);
+            }
+            m_defaultsById[id] = prop;
+        }
     public:
 
         struct PropertiesUpdate
@@ -102,6 +162,14 @@ class TypeNode
             return m_defaults;
         }
 
+        /// \brief const accessor for a property default by interned id
+        ///
+        /// @return the default, or null if there is none
+        const PropertyBase* defaultProperty(PropertyId id) const
+        {
+            return id < m_defaultsById.size() ? m_defaultsById[id] : nullptr;
+        }
+
         void setDescription(const Atlas::Objects::Root& description);
 
         /// \brief accessor for type description
@@ -116,11 +184,17 @@ class TypeNode
             return m_parent;
         }
 
-        /// \brief set the parent node
-        void setParent(const TypeNode* parent)
+        /// \brief const accessor for child nodes
+        const std::vector<TypeNode*>& children() const
         {
-            m_parent = parent;
+            return m_children;
         }
+
+        /// \brief set the parent node
+        ///
+        /// This is cheap if the node has no children, otherwise the whole
+        /// tree it's added to needs to be renumbered.
+        void setParent(TypeNode* parent);
 };
 
 #endif // COMMON_TYPE_NODE_H
@@ -67,6 +67,10 @@ void installCustomOperations(TypeStore & i)
 
     i.addChild(atlasOpDefinition("close_container", "action"));
     Atlas::Objects::Operation::CLOSE_CONTAINER_NO = atlas_factories.addFactory("close_container", &Atlas::Objects::generic_factory, &Atlas::Objects::defaultInstance<Atlas::Objects::RootData>);
+
+    //The bundle operation carries many perception ops to clients which support it.
+    i.addChild(atlasOpDefinition("bundle", "info"));
+    Atlas::Objects::Operation::BUNDLE_NO = atlas_factories.addFactory("bundle", &Atlas::Objects::generic_factory, &Atlas::Objects::defaultInstance<Atlas::Objects::RootData>);
 }
 
 void installCustomEntities(TypeStore & i)
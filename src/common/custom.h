@@ -34,6 +34,7 @@ extern int THINK_NO;
 extern int RELAY_NO;
 extern int POSSESS_NO;
 extern int CLOSE_CONTAINER_NO;
+extern int BUNDLE_NO;
 
 } } }
 
@@ -38,5 +38,6 @@ int THINK_NO = -1;
 int RELAY_NO = -1;
 int POSSESS_NO = -1;
 int CLOSE_CONTAINER_NO = -1;
+int BUNDLE_NO = -1;
 
 } } }
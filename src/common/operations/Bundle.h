@@ -0,0 +1,45 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_BUNDLE_H
+#define CYPHESIS_BUNDLE_H
+
+#include <Atlas/Objects/Generic.h>
+
+namespace Atlas { namespace Objects { namespace Operation {
+
+    extern int BUNDLE_NO;
+
+    /// \brief A number of perception ops sent to a client as one.
+    ///
+    /// Each arg is a complete op, in the order they were generated. Only sent to clients which have
+    /// declared that they can handle it.
+
+    /// \ingroup CustomOperations
+    class Bundle : public Generic
+    {
+        public:
+            Bundle()
+            {
+                (*this)->setType("bundle", BUNDLE_NO);
+            }
+    };
+
+} } }
+
+#endif //CYPHESIS_BUNDLE_H
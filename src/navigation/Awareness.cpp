@@ -57,6 +57,12 @@
 #include "AwarenessUtils.h"
 
 #include "IHeightProvider.h"
+#include "TileBuilder.h"
+#include "TileStore.h"
+#include "PathCache.h"
+#include "TileGraph.h"
+#include "NeighbourGrid.h"
+#include "Crowd.h"
 
 #include "RecastDetour/Detour/Include/DetourNavMesh.h"
 #include "RecastDetour/Detour/Include/DetourNavMeshQuery.h"
@@ -67,6 +73,7 @@
 #include "RecastDetour/Detour/Include/DetourObstacleAvoidance.h"
 
 #include "common/debug.h"
+#include "common/MpscQueue.h"
 
 #include "rules/MemEntity.h"
 
@@ -81,6 +88,7 @@
 #include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 #include <cstring>
@@ -91,10 +99,17 @@ static const bool debug_flag = false;
 #define MAX_PATHPOLY      256 // max number of polygons in a path
 #define MAX_PATHVERT      512 // most verts in a path
 #define MAX_OBSTACLES_CIRCLES 4 // max number of circle obstacles to consider when doing avoidance
+#define OBSTACLE_AVOIDANCE_RANGE 5 // how far away entities are considered when doing avoidance
 
 // This value specifies how many layers (or "floors") each navmesh tile is expected to have.
 static const int EXPECTED_LAYERS_PER_TILE = 1;
 
+/**
+ * Included in the hash of stored tiles. Increase this whenever the way tiles are built changes, so that tiles built
+ * the old way aren't reused.
+ */
+static const std::uint32_t TILE_BUILD_VERSION = 1;
+
 using namespace boost::multi_index;
 
 /**
@@ -139,20 +154,143 @@ struct InputGeometry
     std::vector<WFMath::RotBox<2>> entityAreas;
 };
 
+/**
+ * @brief All of the data needed to build a tile, copied so that the tile can be built on another thread.
+ */
+struct TileSnapshot
+{
+    int tx;
+    int ty;
+    /**
+     * The config of the tile, with the bounds of the tile including the border.
+     */
+    rcConfig cfg;
+    int heightsXMin;
+    int heightsXMax;
+    int heightsYMin;
+    int heightsYMax;
+    /**
+     * Heights with 1 meter interval, covering the area given by the "heights" bounds.
+     */
+    std::vector<float> heights;
+    std::vector<WFMath::RotBox<2>> entityAreas;
+    /**
+     * A hash of all of the above, used for looking up the tile in the TileStore. Only set if there's a store.
+     */
+    std::uint64_t hash = 0;
+};
+
+/**
+ * @brief A 64 bit FNV-1a hash.
+ */
+struct TileHasher
+{
+    std::uint64_t value = 14695981039346656037ULL;
+
+    void add(const void* data, size_t size)
+    {
+        auto bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            value ^= bytes[i];
+            value *= 1099511628211ULL;
+        }
+    }
+
+    template<typename T>
+    void add(const T& data)
+    {
+        add(&data, sizeof(T));
+    }
+};
+
+/**
+ * @brief The compressed layers of a tile which has been built on another thread.
+ *
+ * Any layer data which hasn't been handed over to the tile cache is freed when this is destroyed.
+ */
+struct BuiltTile
+{
+    int tx = 0;
+    int ty = 0;
+    std::uint64_t hash = 0;
+    std::vector<TileCacheData> layers;
+    /**
+     * Messages from the build. Logging isn't thread safe, so these are logged when the tile is installed.
+     */
+    std::vector<std::pair<LogLevel, std::string>> messages;
+
+    BuiltTile() = default;
+
+    BuiltTile(BuiltTile&& rhs) noexcept = default;
+
+    BuiltTile& operator=(BuiltTile&& rhs) noexcept
+    {
+        freeLayers();
+        tx = rhs.tx;
+        ty = rhs.ty;
+        hash = rhs.hash;
+        layers = std::move(rhs.layers);
+        rhs.layers.clear();
+        messages = std::move(rhs.messages);
+        return *this;
+    }
+
+    ~BuiltTile()
+    {
+        freeLayers();
+    }
+
+    void freeLayers()
+    {
+        for (auto& layer : layers) {
+            dtFree(layer.data);
+        }
+        layers.clear();
+    }
+};
+
+/**
+ * @brief Tiles built on other threads, waiting to be installed on the main thread.
+ *
+ * This is shared with the jobs building the tiles, so that it outlives the Awareness if it's destroyed while tiles
+ * are being built.
+ */
+struct BuiltTileQueue
+{
+    MpscQueue<BuiltTile> queue;
+};
+
 class AwarenessContext : public rcContext
 {
+    public:
+        /**
+         * @param messages If set, messages are collected here instead of being logged.
+         */
+        explicit AwarenessContext(std::vector<std::pair<LogLevel, std::string>>* messages = nullptr)
+                : mMessages(messages)
+        {
+        }
+
     protected:
         void doLog(const rcLogCategory category, const char* msg, const int len) override
         {
+            LogLevel level;
             if (category == RC_LOG_PROGRESS) {
-                ::log(INFO, String::compose("Recast: %1", msg));
+                level = INFO;
             } else if (category == RC_LOG_WARNING) {
-                ::log(WARNING, String::compose("Recast: %1", msg));
+                level = WARNING;
+            } else {
+                level = ERROR;
+            }
+            if (mMessages) {
+                mMessages->emplace_back(level, String::compose("Recast: %1", msg));
             } else {
-                ::log(ERROR, String::compose("Recast: %1", msg));
+                ::log(level, String::compose("Recast: %1", msg));
             }
         }
 
+    private:
+        std::vector<std::pair<LogLevel, std::string>>* mMessages;
 };
 
 Awareness::Awareness(const LocatedEntity& domainEntity,
@@ -178,7 +316,12 @@ Awareness::Awareness(const LocatedEntity& domainEntity,
         mNavQuery(dtAllocNavMeshQuery()),
         mFilter(new dtQueryFilter()),
         mActiveTileList(new MRUList<std::pair<int, int>>()),
-        mObserverCount(0)
+        mObserverCount(0),
+        mBuiltTiles(std::make_shared<BuiltTileQueue>()),
+        mPathCache(new PathCache()),
+        mNeighbourGrid(new NeighbourGrid(OBSTACLE_AVOIDANCE_RANGE)),
+        mNeighbourGridTimestamp(-1),
+        mCrowd(new Crowd(*this))
 {
     auto validExtent = extent;
     if (!extent.isValid()) {
@@ -214,6 +357,8 @@ Awareness::Awareness(const LocatedEntity& domainEntity,
         const int tilewidth = (gw + tileSize - 1) / tileSize;
         const int tileheight = (gh + tileSize - 1) / tileSize;
 
+        mTileGraph = std::make_unique<TileGraph>(WFMath::Point<2>(mCfg.bmin[0], mCfg.bmin[2]), tileSize * cellsize, tilewidth, tileheight);
+
         // Max tiles and max polys affect how the tile IDs are caculated.
         // There are 22 bits available for identifying a tile and a polygon.
         int tileBits = rcMin((int) dtIlog2(dtNextPow2(tilewidth * tileheight * EXPECTED_LAYERS_PER_TILE)), 14);
@@ -317,6 +462,9 @@ Awareness::Awareness(const LocatedEntity& domainEntity,
         mTcomp = std::move(tcomp);
         mTmproc = std::move(tmproc);
 
+        EventTileUpdated.connect(sigc::mem_fun(*this, &Awareness::invalidatePaths));
+        EventTileRemoved.connect([this](int tx, int ty, int) { invalidatePaths(tx, ty); });
+
     } catch (const std::exception& e) {
         dtFreeObstacleAvoidanceQuery(mObstacleAvoidanceQuery);
 
@@ -518,9 +666,9 @@ bool Awareness::avoidObstacles(long avatarEntityId,
     struct EntityCollisionEntry
     {
         float distance;
-        const EntityEntry* entity;
         WFMath::Point<2> viewPosition;
         WFMath::Ball<2> viewRadius;
+        WFMath::Vector<2> velocity;
     };
 
     if (nextWayPoint) {
@@ -535,37 +683,56 @@ bool Awareness::avoidObstacles(long avatarEntityId,
     auto comp = [](EntityCollisionEntry& a, EntityCollisionEntry& b) { return a.distance < b.distance; };
     std::priority_queue<EntityCollisionEntry, std::vector<EntityCollisionEntry>, decltype(comp)> nearestEntities(comp);
 
-    WFMath::Ball<2> playerRadius(position, 5);
+    if (mNeighbourGridTimestamp == currentTimestamp) {
+        //Use the snapshot of nearby entities, which already has been projected to the current time.
+        std::vector<size_t> neighbours;
+        mNeighbourGrid->query(position, OBSTACLE_AVOIDANCE_RANGE, neighbours);
+        for (auto index : neighbours) {
+            if (mNeighbourGrid->getEntityId(index) == avatarEntityId) {
+                continue;
+            }
+            auto entityView2dPos = mNeighbourGrid->getPosition(index);
+            nearestEntities.push(EntityCollisionEntry({static_cast<float>(WFMath::Distance(position, entityView2dPos)),
+                                                       entityView2dPos,
+                                                       WFMath::Ball<2>(entityView2dPos, mNeighbourGrid->getRadius(index)),
+                                                       mNeighbourGrid->getVelocity(index)}));
+        }
+    } else {
+        WFMath::Ball<2> playerRadius(position, OBSTACLE_AVOIDANCE_RANGE);
 
-    for (auto& entity : mMovingEntities) {
+        for (auto& entity : mMovingEntities) {
 
-        //All of the entities have the same location as we have, so we don't need to resolve the position in the world.
+            //All of the entities have the same location as we have, so we don't need to resolve the position in the world.
 
-        if (entity->entityId == avatarEntityId) {
-            //Don't avoid ourselves.
-            continue;
-        }
+            if (entity->entityId == avatarEntityId) {
+                //Don't avoid ourselves.
+                continue;
+            }
 
-        double time_diff = currentTimestamp - entity->location.timeStamp();
+            double time_diff = currentTimestamp - entity->location.timeStamp();
 
-        // Update location
-        Point3D pos = entity->location.pos();
-        if (entity->location.velocity().isValid()) {
-            pos += (entity->location.velocity() * time_diff);
-        }
+            // Update location
+            Point3D pos = entity->location.pos();
+            if (entity->location.velocity().isValid()) {
+                pos += (entity->location.velocity() * time_diff);
+            }
 
-        if (!pos.isValid()) {
-            continue;
-        }
+            if (!pos.isValid()) {
+                continue;
+            }
 
-        WFMath::Point<2> entityView2dPos(pos.x(), pos.z());
-        WFMath::Ball<2> entityViewRadius(entityView2dPos, (entity->location.bBox().highCorner().x() - entity->location.bBox().lowCorner().z()) * 0.5);
-        //WFMath::Ball<2> entityViewRadius(entityView2dPos, (entity->location.bBox().highCorner().x() - entity->location.bBox().lowCorner().z()));
+            WFMath::Point<2> entityView2dPos(pos.x(), pos.z());
+            WFMath::Ball<2> entityViewRadius(entityView2dPos, (entity->location.bBox().highCorner().x() - entity->location.bBox().lowCorner().z()) * 0.5);
+            //WFMath::Ball<2> entityViewRadius(entityView2dPos, (entity->location.bBox().highCorner().x() - entity->location.bBox().lowCorner().z()));
 
-        if (WFMath::Intersect(playerRadius, entityViewRadius, false) || WFMath::Contains(playerRadius, entityViewRadius, false)) {
-            nearestEntities.push(EntityCollisionEntry({static_cast<float>(WFMath::Distance(position, entityView2dPos)), entity, entityView2dPos, entityViewRadius}));
-        }
+            if (WFMath::Intersect(playerRadius, entityViewRadius, false) || WFMath::Contains(playerRadius, entityViewRadius, false)) {
+                nearestEntities.push(EntityCollisionEntry({static_cast<float>(WFMath::Distance(position, entityView2dPos)),
+                                                           entityView2dPos,
+                                                           entityViewRadius,
+                                                           WFMath::Vector<2>(entity->location.velocity().x(), entity->location.velocity().z())}));
+            }
 
+        }
     }
 
     if (!nearestEntities.empty()) {
@@ -573,9 +740,8 @@ bool Awareness::avoidObstacles(long avatarEntityId,
         int i = 0;
         while (!nearestEntities.empty() && i < MAX_OBSTACLES_CIRCLES) {
             const EntityCollisionEntry& entry = nearestEntities.top();
-            auto& entity = entry.entity;
             float pos[]{static_cast<float>(entry.viewPosition.x()), 0, static_cast<float>(entry.viewPosition.y())};
-            float vel[]{static_cast<float>(entity->location.velocity().x()), 0, static_cast<float>(entity->location.velocity().z())};
+            float vel[]{static_cast<float>(entry.velocity.x()), 0, static_cast<float>(entry.velocity.y())};
             mObstacleAvoidanceQuery->addCircle(pos, entry.viewRadius.radius(), vel, vel);
             nearestEntities.pop();
             ++i;
@@ -606,6 +772,32 @@ bool Awareness::avoidObstacles(long avatarEntityId,
 
 }
 
+void Awareness::updateNeighbourGrid(double currentTimestamp)
+{
+    mNeighbourGrid->clear();
+    for (auto& entity : mMovingEntities) {
+        Point3D pos = entity->location.pos();
+        if (entity->location.velocity().isValid()) {
+            pos += (entity->location.velocity() * (currentTimestamp - entity->location.timeStamp()));
+        }
+        if (!pos.isValid()) {
+            continue;
+        }
+        auto& velocity = entity->location.velocity();
+        auto& bbox = entity->location.bBox();
+        mNeighbourGrid->add(entity->entityId,
+                            WFMath::Point<2>(pos.x(), pos.z()),
+                            velocity.isValid() ? WFMath::Vector<2>(velocity.x(), velocity.z()) : WFMath::Vector<2>::ZERO(),
+                            (bbox.highCorner().x() - bbox.lowCorner().z()) * 0.5f);
+    }
+    mNeighbourGridTimestamp = currentTimestamp;
+}
+
+Crowd& Awareness::getCrowd()
+{
+    return *mCrowd;
+}
+
 void Awareness::markTilesAsDirty(const WFMath::AxisBox<2>& area)
 {
     int tileMinXIndex, tileMaxXIndex, tileMinYIndex, tileMaxYIndex;
@@ -637,25 +829,108 @@ void Awareness::markTilesAsDirty(int tileMinXIndex, int tileMaxXIndex, int tileM
 
 size_t Awareness::rebuildDirtyTile()
 {
+    if (TileBuilder::hasInstance()) {
+        installBuiltTiles();
+        dispatchTileBuilds(TileBuilder::instance());
+
+        //Tiles which are being built, and which haven't been marked as dirty again, also remain to be built.
+        size_t remaining = mDirtyAwareTiles.size();
+        for (auto& tileIndex : mTilesInProgress) {
+            if (mDirtyAwareTiles.find(tileIndex) == mDirtyAwareTiles.end()) {
+                ++remaining;
+            }
+        }
+        return remaining;
+    }
+
     if (!mDirtyAwareTiles.empty()) {
         debug_print("Rebuilding aware tiles. Number of dirty aware tiles: " << mDirtyAwareTiles.size())
         const auto tileIndexI = mDirtyAwareOrderedTiles.begin();
         const auto& tileIndex = *tileIndexI;
 
-        float tilesize = mCfg.tileSize * mCfg.cs;
-        WFMath::AxisBox<2> adjustedArea(WFMath::Point<2>(mCfg.bmin[0] + (tileIndex.first * tilesize), mCfg.bmin[2] + (tileIndex.second * tilesize)),
-                                        WFMath::Point<2>(mCfg.bmin[0] + ((tileIndex.first + 1) * tilesize), mCfg.bmin[2] + ((tileIndex.second + 1) * tilesize)));
-
-        std::vector<WFMath::RotBox<2>> entityAreas;
-        findEntityAreas(adjustedArea, entityAreas);
-
-        rebuildTile(tileIndex.first, tileIndex.second, entityAreas);
+        rebuildTile(tileIndex.first, tileIndex.second);
         mDirtyAwareTiles.erase(tileIndex);
         mDirtyAwareOrderedTiles.erase(tileIndexI);
     }
     return mDirtyAwareTiles.size();
 }
 
+size_t Awareness::getTileBuildsInProgress() const
+{
+    return mTilesInProgress.size();
+}
+
+void Awareness::dispatchTileBuilds(TileBuilder& tileBuilder)
+{
+    //Keep enough tiles queued to keep all workers busy, but not more, so that the order of the dirty tiles still matters.
+    auto maxTilesInProgress = tileBuilder.getThreadCount() * 2;
+
+    auto I = mDirtyAwareOrderedTiles.begin();
+    while (I != mDirtyAwareOrderedTiles.end() && mTilesInProgress.size() < maxTilesInProgress) {
+        auto tileIndex = *I;
+        //A tile which is marked as dirty while it's being built needs to wait until the first build is done.
+        if (mTilesInProgress.find(tileIndex) != mTilesInProgress.end()) {
+            ++I;
+            continue;
+        }
+        debug_print("Building tile in background. Number of dirty aware tiles: " << mDirtyAwareTiles.size())
+
+        auto snapshot = std::make_shared<TileSnapshot>();
+        snapshotTile(tileIndex.first, tileIndex.second, *snapshot);
+
+        mDirtyAwareTiles.erase(tileIndex);
+        I = mDirtyAwareOrderedTiles.erase(I);
+
+        if (installStoredTile(*snapshot)) {
+            continue;
+        }
+        mTilesInProgress.insert(tileIndex);
+
+        auto builtTiles = mBuiltTiles;
+        tileBuilder.post([snapshot, builtTiles]() {
+            BuiltTile builtTile;
+            builtTile.tx = snapshot->tx;
+            builtTile.ty = snapshot->ty;
+            builtTile.hash = snapshot->hash;
+            //The tile must always be handed back, otherwise it would be considered as being built forever.
+            try {
+                AwarenessContext ctx(&builtTile.messages);
+                TileCacheData tiles[MAX_LAYERS];
+                memset(tiles, 0, sizeof(tiles));
+                int ntiles = rasterizeTileLayers(ctx, *snapshot, tiles, MAX_LAYERS);
+                builtTile.layers.assign(tiles, tiles + ntiles);
+            } catch (const std::exception& ex) {
+                builtTile.messages.emplace_back(ERROR, String::compose("Exception caught when building navmesh tile: %1", ex.what()));
+            } catch (...) {
+                builtTile.messages.emplace_back(ERROR, "Unknown exception caught when building navmesh tile.");
+            }
+            builtTiles->queue.push(std::move(builtTile));
+        });
+    }
+}
+
+void Awareness::installBuiltTiles()
+{
+    BuiltTile builtTile;
+    while (mBuiltTiles->queue.pop(builtTile)) {
+        for (auto& message : builtTile.messages) {
+            ::log(message.first, message.second);
+        }
+        std::pair<int, int> tileIndex(builtTile.tx, builtTile.ty);
+        mTilesInProgress.erase(tileIndex);
+        //Store the tile even if it's discarded below, since it's still valid.
+        storeTile(builtTile.hash, builtTile.layers.data(), static_cast<int>(builtTile.layers.size()));
+        //If the tile no longer is aware it might already have been pruned, so it's instead rebuilt when it's aware again.
+        if (mAwareTiles.find(tileIndex) == mAwareTiles.end()) {
+            mDirtyUnwareTiles.insert(tileIndex);
+            builtTile.freeLayers();
+            continue;
+        }
+        installTile(builtTile.tx, builtTile.ty, builtTile.layers.data(), static_cast<int>(builtTile.layers.size()));
+        builtTile.layers.clear();
+    }
+}
+
 void Awareness::pruneTiles()
 {
     //remove any tiles that aren't used
@@ -746,6 +1021,49 @@ void Awareness::findAffectedTiles(const WFMath::AxisBox<2>& area, int& tileMinXI
 
 int Awareness::findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, float radius, std::vector<WFMath::Point<3>>& path) const
 {
+    bool searched;
+    return findPath(start, end, radius, path, searched);
+}
+
+void Awareness::queuePathRequest(const std::shared_ptr<PathRequest>& request)
+{
+    mPathRequests.emplace_back(request);
+}
+
+size_t Awareness::processPathRequests(size_t maxSearches)
+{
+    size_t searches = 0;
+    //Requests which can be resolved from the cache are cheap, so only full searches count against the budget.
+    while (!mPathRequests.empty() && searches < maxSearches) {
+        auto request = mPathRequests.front().lock();
+        mPathRequests.pop_front();
+        //The requester might have lost interest in the request.
+        if (!request) {
+            continue;
+        }
+        bool searched;
+        request->result = findPath(request->start, request->end, request->radius, request->path, searched);
+        request->isDone = true;
+        if (searched) {
+            searches++;
+        }
+    }
+    return mPathRequests.size();
+}
+
+void Awareness::invalidatePaths(int tx, int ty)
+{
+    //A changed tile might also open up shorter paths through the tiles next to it.
+    for (int x = tx - 1; x <= tx + 1; ++x) {
+        for (int y = ty - 1; y <= ty + 1; ++y) {
+            mPathCache->invalidateTile(x, y);
+        }
+    }
+}
+
+int Awareness::findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, float radius, std::vector<WFMath::Point<3>>& path, bool& searched) const
+{
+    searched = false;
 
     float pStartPos[]{static_cast<float>(start.x()), static_cast<float>(start.y()), static_cast<float>(start.z())};
     float pEndPos[]{static_cast<float>(end.x()), static_cast<float>(end.y()), static_cast<float>(end.z())};
@@ -778,13 +1096,37 @@ int Awareness::findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& e
         return -2;
     } // couldn't find a polygon
 
-    status = mNavQuery->findPath(StartPoly, EndPoly, StartNearest, EndNearest, mFilter.get(), PolyPath, &nPathCount, MAX_PATHPOLY);
-    if ((status & DT_FAILURE)) {
-        return -3;
-    } // couldn't create a path
-    if (nPathCount == 0) {
-        return -4;
-    } // couldn't find a path
+    PathCache::Key cacheKey{StartPoly, EndPoly, radius};
+    auto cachedCorridor = mPathCache->get(cacheKey);
+    if (cachedCorridor) {
+        nPathCount = std::min(static_cast<int>(cachedCorridor->size()), MAX_PATHPOLY);
+        std::copy(cachedCorridor->begin(), cachedCorridor->begin() + nPathCount, PolyPath);
+    } else {
+        searched = true;
+        status = mNavQuery->findPath(StartPoly, EndPoly, StartNearest, EndNearest, mFilter.get(), PolyPath, &nPathCount, MAX_PATHPOLY);
+        if ((status & DT_FAILURE)) {
+            return -3;
+        } // couldn't create a path
+        if (nPathCount == 0) {
+            return -4;
+        } // couldn't find a path
+
+        //Partial paths might be completed by tiles which aren't part of the corridor, so they can't be cached.
+        if (!dtStatusDetail(status, DT_PARTIAL_RESULT)) {
+            std::vector<std::pair<int, int>> tiles;
+            for (int i = 0; i < nPathCount; ++i) {
+                const dtMeshTile* tile;
+                const dtPoly* poly;
+                if (dtStatusSucceed(mNavMesh->getTileAndPolyByRef(PolyPath[i], &tile, &poly))) {
+                    std::pair<int, int> tileIndex(tile->header->x, tile->header->y);
+                    if (std::find(tiles.begin(), tiles.end(), tileIndex) == tiles.end()) {
+                        tiles.push_back(tileIndex);
+                    }
+                }
+            }
+            mPathCache->put(cacheKey, std::vector<dtPolyRef>(PolyPath, PolyPath + nPathCount), std::move(tiles));
+        }
+    }
 
     status = mNavQuery->findStraightPath(StartNearest, EndNearest, PolyPath, nPathCount, StraightPath, nullptr, nullptr, &nVertCount, MAX_PATHVERT);
     if ((status & DT_FAILURE)) {
@@ -901,7 +1243,7 @@ void Awareness::setAwarenessArea(const std::string& areaId, const WFMath::RotBox
                 } else {
                     //The tile wasn't marked as dirty in any set, but it might be that it hasn't been processed before.
                     auto tile = mTileCache->getTileAt(tx, tz, 0);
-                    if (!tile) {
+                    if (!tile && mTilesInProgress.find(index) == mTilesInProgress.end()) {
                         if (focusLine.isValid() && WFMath::Intersect(focusLine, tileBounds, false)) {
                             insertFront = true;
                         } else {
@@ -1000,13 +1342,60 @@ size_t Awareness::unawareTilesInArea(const std::string& areaId) const
 }
 
 
-void Awareness::rebuildTile(int tx, int ty, const std::vector<WFMath::RotBox<2>>& entityAreas)
+void Awareness::rebuildTile(int tx, int ty)
 {
+    TileSnapshot snapshot{};
+    snapshotTile(tx, ty, snapshot);
+
+    if (installStoredTile(snapshot)) {
+        return;
+    }
+
     TileCacheData tiles[MAX_LAYERS];
     memset(tiles, 0, sizeof(tiles));
 
-    int ntiles = rasterizeTileLayers(entityAreas, tx, ty, tiles, MAX_LAYERS);
+    int ntiles = rasterizeTileLayers(*mCtx, snapshot, tiles, MAX_LAYERS);
 
+    storeTile(snapshot.hash, tiles, ntiles);
+    installTile(tx, ty, tiles, ntiles);
+}
+
+bool Awareness::installStoredTile(const TileSnapshot& snapshot)
+{
+    if (!TileStore::hasInstance()) {
+        return false;
+    }
+    std::vector<TileStore::Layer> layers;
+    if (!TileStore::instance().get(snapshot.hash, layers) || layers.size() > MAX_LAYERS) {
+        return false;
+    }
+    debug_print("Installing stored tile at " << snapshot.tx << ":" << snapshot.ty)
+
+    //The tile cache takes ownership of the data, so it needs to be copied.
+    TileCacheData tiles[MAX_LAYERS];
+    for (size_t i = 0; i < layers.size(); ++i) {
+        tiles[i].data = static_cast<unsigned char*>(dtAlloc(layers[i].dataSize, DT_ALLOC_PERM));
+        tiles[i].dataSize = layers[i].dataSize;
+        memcpy(tiles[i].data, layers[i].data, layers[i].dataSize);
+    }
+    installTile(snapshot.tx, snapshot.ty, tiles, static_cast<int>(layers.size()));
+    return true;
+}
+
+void Awareness::storeTile(std::uint64_t hash, const TileCacheData* tiles, int ntiles)
+{
+    if (!TileStore::hasInstance()) {
+        return;
+    }
+    std::vector<TileStore::Layer> layers;
+    for (int i = 0; i < ntiles; ++i) {
+        layers.emplace_back(TileStore::Layer{tiles[i].data, tiles[i].dataSize});
+    }
+    TileStore::instance().put(hash, layers);
+}
+
+void Awareness::installTile(int tx, int ty, TileCacheData* tiles, int ntiles)
+{
     for (int j = 0; j < ntiles; ++j) {
         TileCacheData* tile = &tiles[j];
 
@@ -1027,12 +1416,99 @@ void Awareness::rebuildTile(int tx, int ty, const std::vector<WFMath::RotBox<2>>
     dtStatus status = mTileCache->buildNavMeshTilesAt(tx, ty, mNavMesh);
     if (dtStatusFailed(status)) {
         log(WARNING, String::compose("Failed to build nav mesh tile in awareness. x: %1 y: %2 Reason: %3", tx, ty, status));
+    } else {
+        updateTileGraph(tx, ty);
     }
 
     EventTileUpdated(tx, ty);
 
 }
 
+void Awareness::updateTileGraph(int tx, int ty)
+{
+    const dtMeshTile* meshTiles[MAX_LAYERS];
+    const int ntiles = static_cast<const dtNavMesh*>(mNavMesh)->getTilesAt(tx, ty, meshTiles, MAX_LAYERS);
+
+    //Collect the border edges of all polygons, grouped by which polygons are connected within the tile.
+    std::vector<TileGraph::Portal> edges;
+    int regionCount = 0;
+    for (int i = 0; i < ntiles; ++i) {
+        const dtMeshTile* tile = meshTiles[i];
+        if (!tile->header) {
+            continue;
+        }
+        std::vector<int> regions(tile->header->polyCount, -1);
+        for (int p = 0; p < tile->header->polyCount; ++p) {
+            if (regions[p] != -1 || tile->polys[p].getType() == DT_POLYTYPE_OFFMESH_CONNECTION) {
+                continue;
+            }
+            int region = regionCount++;
+            regions[p] = region;
+            std::vector<int> open{p};
+            while (!open.empty()) {
+                const dtPoly& poly = tile->polys[open.back()];
+                open.pop_back();
+                for (int j = 0; j < poly.vertCount; ++j) {
+                    auto nei = poly.neis[j];
+                    if (nei & DT_EXT_LINK) {
+                        const float* va = &tile->verts[poly.verts[j] * 3];
+                        const float* vb = &tile->verts[poly.verts[(j + 1) % poly.vertCount] * 3];
+                        TileGraph::Side side;
+                        switch (nei & 0xff) {
+                            case 0:
+                                side = TileGraph::POS_X;
+                                break;
+                            case 2:
+                                side = TileGraph::POS_Y;
+                                break;
+                            case 4:
+                                side = TileGraph::NEG_X;
+                                break;
+                            case 6:
+                                side = TileGraph::NEG_Y;
+                                break;
+                            default:
+                                continue;
+                        }
+                        //Openings on the x sides run along z, and vice versa.
+                        int axis = (side == TileGraph::POS_X || side == TileGraph::NEG_X) ? 2 : 0;
+                        edges.push_back({side, std::min(va[axis], vb[axis]), std::max(va[axis], vb[axis]), region});
+                    } else if (nei != 0) {
+                        int neighbour = nei - 1;
+                        if (regions[neighbour] == -1 && tile->polys[neighbour].getType() != DT_POLYTYPE_OFFMESH_CONNECTION) {
+                            regions[neighbour] = region;
+                            open.push_back(neighbour);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //Merge adjacent edges into openings.
+    std::sort(edges.begin(), edges.end(), [](const TileGraph::Portal& lhs, const TileGraph::Portal& rhs) {
+        return std::tie(lhs.region, lhs.side, lhs.min) < std::tie(rhs.region, rhs.side, rhs.min);
+    });
+    std::vector<TileGraph::Portal> portals;
+    for (auto& edge : edges) {
+        if (!portals.empty()) {
+            auto& last = portals.back();
+            if (last.region == edge.region && last.side == edge.side && edge.min <= last.max + mCfg.cs) {
+                last.max = std::max(last.max, edge.max);
+                continue;
+            }
+        }
+        portals.push_back(edge);
+    }
+
+    mTileGraph->setTile(tx, ty, std::move(portals));
+}
+
+bool Awareness::findCoarsePath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, std::vector<WFMath::Point<2>>& waypoints) const
+{
+    return mTileGraph->findPath(WFMath::Point<2>(start.x(), start.z()), WFMath::Point<2>(end.x(), end.z()), waypoints);
+}
+
 WFMath::RotBox<2> Awareness::buildEntityAreas(const EntityEntry& entity)
 {
 
@@ -1092,18 +1568,15 @@ void Awareness::findEntityAreas(const WFMath::AxisBox<2>& extent, std::vector<WF
     }
 }
 
-int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityAreas, int tx, int ty, TileCacheData* tiles, int maxTiles)
+void Awareness::snapshotTile(int tx, int ty, TileSnapshot& snapshot)
 {
-    std::vector<float> vertsVector;
-    std::vector<int> trisVector;
-
-    FastLZCompressor comp;
-    RasterizationContext rc;
+    snapshot.tx = tx;
+    snapshot.ty = ty;
 
 // Tile bounds.
     const float tcs = mCfg.tileSize * mCfg.cs;
 
-    rcConfig tcfg{};
+    rcConfig& tcfg = snapshot.cfg;
     memcpy(&tcfg, &mCfg, sizeof(tcfg));
 
     tcfg.bmin[0] = mCfg.bmin[0] + tx * tcs;
@@ -1112,24 +1585,63 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
     tcfg.bmax[0] = mCfg.bmin[0] + (tx + 1) * tcs;
     tcfg.bmax[1] = mCfg.bmax[1];
     tcfg.bmax[2] = mCfg.bmin[2] + (ty + 1) * tcs;
+
+    WFMath::AxisBox<2> tileArea(WFMath::Point<2>(tcfg.bmin[0], tcfg.bmin[2]), WFMath::Point<2>(tcfg.bmax[0], tcfg.bmax[2]));
+    findEntityAreas(tileArea, snapshot.entityAreas);
+
     tcfg.bmin[0] -= tcfg.borderSize * tcfg.cs;
     tcfg.bmin[2] -= tcfg.borderSize * tcfg.cs;
     tcfg.bmax[0] += tcfg.borderSize * tcfg.cs;
     tcfg.bmax[2] += tcfg.borderSize * tcfg.cs;
 
 //First define all vertices. Get one extra vertex in each direction so that there's no cutoff at the tile's edges.
-    int heightsXMin = static_cast<int>(std::floor(tcfg.bmin[0]) - 1);
-    int heightsXMax = static_cast<int>(std::ceil(tcfg.bmax[0]) + 1);
-    int heightsYMin = static_cast<int>(std::floor(tcfg.bmin[2]) - 1);
-    int heightsYMax = static_cast<int>(std::ceil(tcfg.bmax[2]) + 1);
-    int sizeX = heightsXMax - heightsXMin;
-    int sizeY = heightsYMax - heightsYMin;
+    snapshot.heightsXMin = static_cast<int>(std::floor(tcfg.bmin[0]) - 1);
+    snapshot.heightsXMax = static_cast<int>(std::ceil(tcfg.bmax[0]) + 1);
+    snapshot.heightsYMin = static_cast<int>(std::floor(tcfg.bmin[2]) - 1);
+    snapshot.heightsYMax = static_cast<int>(std::ceil(tcfg.bmax[2]) + 1);
 
 //Blit height values with 1 meter interval
-    std::vector<float> heights(sizeX * sizeY);
-    mHeightProvider.blitHeights(heightsXMin, heightsXMax, heightsYMin, heightsYMax, heights);
+    snapshot.heights.resize((snapshot.heightsXMax - snapshot.heightsXMin) * (snapshot.heightsYMax - snapshot.heightsYMin));
+    mHeightProvider.blitHeights(snapshot.heightsXMin, snapshot.heightsXMax, snapshot.heightsYMin, snapshot.heightsYMax, snapshot.heights);
+
+    if (TileStore::hasInstance()) {
+        //The config contains the agent settings and the bounds of the tile, so the hash also covers these.
+        TileHasher hasher;
+        hasher.add(TILE_BUILD_VERSION);
+        hasher.add(tx);
+        hasher.add(ty);
+        hasher.add(tcfg);
+        hasher.add(snapshot.heights.data(), snapshot.heights.size() * sizeof(float));
+        for (auto& rotbox : snapshot.entityAreas) {
+            for (size_t i = 0; i < 4; ++i) {
+                auto corner = rotbox.getCorner(i);
+                hasher.add(static_cast<float>(corner.x()));
+                hasher.add(static_cast<float>(corner.y()));
+            }
+        }
+        snapshot.hash = hasher.value;
+    }
+}
+
+int Awareness::rasterizeTileLayers(rcContext& ctx, const TileSnapshot& snapshot, TileCacheData* tiles, int maxTiles)
+{
+    std::vector<float> vertsVector;
+    std::vector<int> trisVector;
+
+    FastLZCompressor comp;
+    RasterizationContext rc;
+
+    const rcConfig& tcfg = snapshot.cfg;
+    const int tx = snapshot.tx;
+    const int ty = snapshot.ty;
+    const int heightsXMin = snapshot.heightsXMin;
+    const int heightsXMax = snapshot.heightsXMax;
+    const int heightsYMin = snapshot.heightsYMin;
+    const int heightsYMax = snapshot.heightsYMax;
+    int sizeX = heightsXMax - heightsXMin;
+    int sizeY = heightsYMax - heightsYMin;
 
-    float* heightData = heights.data();
+    const float* heightData = snapshot.heights.data();
     for (int y = heightsYMin; y < heightsYMax; ++y) {
         for (int x = heightsXMin; x < heightsXMax; ++x) {
             vertsVector.push_back(x);
@@ -1162,25 +1674,25 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
 // Allocate voxel heightfield where we rasterize our input data to.
     rc.solid = rcAllocHeightfield();
     if (!rc.solid) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
+        ctx.log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
         return 0;
     }
-    if (!rcCreateHeightfield(mCtx.get(), *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch)) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
+    if (!rcCreateHeightfield(&ctx, *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch)) {
+        ctx.log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
         return 0;
     }
 
 // Allocate array that can hold triangle flags.
     rc.triareas = new unsigned char[ntris];
     if (!rc.triareas) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'm_triareas' (%d).", ntris / 3);
+        ctx.log(RC_LOG_ERROR, "buildNavigation: Out of memory 'm_triareas' (%d).", ntris / 3);
         return 0;
     }
 
     memset(rc.triareas, 0, ntris * sizeof(unsigned char));
-    rcMarkWalkableTriangles(mCtx.get(), tcfg.walkableSlopeAngle, verts, nverts, tris, ntris, rc.triareas);
+    rcMarkWalkableTriangles(&ctx, tcfg.walkableSlopeAngle, verts, nverts, tris, ntris, rc.triareas);
 
-    rcRasterizeTriangles(mCtx.get(), verts, nverts, tris, rc.triareas, ntris, *rc.solid, tcfg.walkableClimb);
+    rcRasterizeTriangles(&ctx, verts, nverts, tris, rc.triareas, ntris, *rc.solid, tcfg.walkableClimb);
 
 // Once all geometry is rasterized, we do initial pass of filtering to
 // remove unwanted overhangs caused by the conservative rasterization
@@ -1194,22 +1706,22 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
 
     rc.chf = rcAllocCompactHeightfield();
     if (!rc.chf) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
+        ctx.log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
         return 0;
     }
-    if (!rcBuildCompactHeightfield(mCtx.get(), tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid, *rc.chf)) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
+    if (!rcBuildCompactHeightfield(&ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid, *rc.chf)) {
+        ctx.log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
         return 0;
     }
 
 // Erode the walkable area by agent radius.
-    if (!rcErodeWalkableArea(mCtx.get(), tcfg.walkableRadius, *rc.chf)) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
+    if (!rcErodeWalkableArea(&ctx, tcfg.walkableRadius, *rc.chf)) {
+        ctx.log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
         return 0;
     }
 
 // Mark areas.
-    for (auto& rotbox : entityAreas) {
+    for (auto& rotbox : snapshot.entityAreas) {
         float areaVerts[3 * 4];
 
         areaVerts[0] = rotbox.getCorner(1).x();
@@ -1228,16 +1740,16 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
         areaVerts[10] = 0;
         areaVerts[11] = rotbox.getCorner(0).y();
 
-        rcMarkConvexPolyArea(mCtx.get(), areaVerts, 4, tcfg.bmin[1], tcfg.bmax[1], DT_TILECACHE_NULL_AREA, *rc.chf);
+        rcMarkConvexPolyArea(&ctx, areaVerts, 4, tcfg.bmin[1], tcfg.bmax[1], DT_TILECACHE_NULL_AREA, *rc.chf);
     }
 
     rc.lset = rcAllocHeightfieldLayerSet();
     if (!rc.lset) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'lset'.");
+        ctx.log(RC_LOG_ERROR, "buildNavigation: Out of memory 'lset'.");
         return 0;
     }
-    if (!rcBuildHeightfieldLayers(mCtx.get(), *rc.chf, tcfg.borderSize, tcfg.walkableHeight, *rc.lset)) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not build heighfield layers.");
+    if (!rcBuildHeightfieldLayers(&ctx, *rc.chf, tcfg.borderSize, tcfg.walkableHeight, *rc.lset)) {
+        ctx.log(RC_LOG_ERROR, "buildNavigation: Could not build heighfield layers.");
         return 0;
     }
 
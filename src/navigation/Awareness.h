@@ -33,11 +33,14 @@
 #include <sigc++/connection.h>
 
 #include <list>
+#include <deque>
 #include <vector>
 #include <set>
 #include <map>
 #include <unordered_map>
 #include <functional>
+#include <memory>
+#include <cstdint>
 
 class MemEntity;
 
@@ -70,6 +73,18 @@ class MRUList;
 
 struct TileCacheData;
 struct InputGeometry;
+struct TileSnapshot;
+struct BuiltTileQueue;
+
+class TileBuilder;
+
+class PathCache;
+
+class TileGraph;
+
+class NeighbourGrid;
+
+class Crowd;
 
 enum PolyAreas
 {
@@ -112,6 +127,27 @@ struct EntityEntry
 };
 
 
+/**
+ * @brief A request for a path, which is resolved when Awareness::processPathRequests() is called.
+ */
+struct PathRequest
+{
+    WFMath::Point<3> start;
+    WFMath::Point<3> end;
+    float radius;
+
+    /**
+     * True when the request has been resolved; result and path are only valid once this is set.
+     */
+    bool isDone;
+
+    /**
+     * The result, as returned by Awareness::findPath().
+     */
+    int result;
+    std::vector<WFMath::Point<3>> path;
+};
+
 /**
  * @brief Handles awareness of the Avatar's surroundings for the purpose of path finding and steering.
  *
@@ -167,10 +203,18 @@ class Awareness
 
         /**
          * @brief Rebuilds a dirty tile if any such exists.
-         * @return The number of dirty tiles remaining.
+         *
+         * If there's a TileBuilder available the tiles are instead built in the background. Any tiles which have
+         * been built since the last call are then installed, and more dirty tiles are handed to the builder.
+         * @return The number of dirty tiles remaining, including those being built in the background.
          */
         size_t rebuildDirtyTile();
 
+        /**
+         * @brief Gets the number of tiles which currently are being built in the background.
+         */
+        size_t getTileBuildsInProgress() const;
+
         /**
          * @brief Finds a path from the start to the finish.
          * @param start A starting position.
@@ -181,6 +225,37 @@ class Awareness
          */
         int findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, float radius, std::vector<WFMath::Point<3>>& path) const;
 
+        /**
+         * @brief Queues a request for a path, to be resolved by processPathRequests().
+         *
+         * Only a weak reference is kept to the request, so a requester which loses interest can just let go of it.
+         * @param request The request.
+         */
+        void queuePathRequest(const std::shared_ptr<PathRequest>& request);
+
+        /**
+         * @brief Resolves queued path requests, in the order they were queued.
+         *
+         * Requests which can use an already found path are cheap, so only those which need a full search count
+         * against the budget.
+         * @param maxSearches The max number of full path searches to do.
+         * @return The number of requests still queued.
+         */
+        size_t processPathRequests(size_t maxSearches);
+
+        /**
+         * @brief Finds a coarse route over the tiles, for destinations too far away for the navmesh.
+         *
+         * The route is planned using what is known of how the tiles connect, including tiles which since have been
+         * pruned. Areas which never have been built are assumed to be walkable. The route should be refined with
+         * findPath() a part at a time.
+         * @param start A starting position.
+         * @param end A finish position.
+         * @param waypoints The horizontal positions of the waypoints will be stored here, not including the start.
+         * @return True if a route was found.
+         */
+        bool findCoarsePath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, std::vector<WFMath::Point<2>>& waypoints) const;
+
         /**
          * @brief Process the tile at the specified index.
          * @param tx X index.
@@ -218,6 +293,19 @@ class Awareness
                 double currentTimestamp,
                 const WFMath::Point<2>* nextWayPoint) const;
 
+        /**
+         * @brief Takes a snapshot of where all moving entities are, to be used by avoidObstacles().
+         *
+         * This lets many avatars avoid obstacles at the same timestamp without each going through all moving entities.
+         * @param currentTimestamp The current timestamp. Calls to avoidObstacles() with other timestamps don't use the snapshot.
+         */
+        void updateNeighbourGrid(double currentTimestamp);
+
+        /**
+         * @brief Gets the crowd which steps all avatars using this awareness together.
+         */
+        Crowd& getCrowd();
+
         /**
          * @brief Prunes a tile if possible and needed.
          *
@@ -454,15 +542,111 @@ class Awareness
          */
         size_t mObserverCount;
 
+        /**
+         * @brief Tiles which currently are being built in the background.
+         */
+        std::set<std::pair<int, int>> mTilesInProgress;
+
+        /**
+         * @brief Tiles which have been built in the background, waiting to be installed.
+         */
+        std::shared_ptr<BuiltTileQueue> mBuiltTiles;
+
+        /**
+         * @brief Corridors of previously found paths.
+         */
+        std::unique_ptr<PathCache> mPathCache;
+
+        /**
+         * @brief Path requests waiting to be resolved.
+         */
+        std::deque<std::weak_ptr<PathRequest>> mPathRequests;
+
+        /**
+         * @brief How the tiles connect, kept for all tiles ever built.
+         */
+        std::unique_ptr<TileGraph> mTileGraph;
+
+        /**
+         * @brief Moving entities, as of mNeighbourGridTimestamp.
+         */
+        std::unique_ptr<NeighbourGrid> mNeighbourGrid;
+
+        double mNeighbourGridTimestamp;
+
+        std::unique_ptr<Crowd> mCrowd;
+
+        /**
+         * @brief Finds a path, using a cached corridor if possible.
+         * @param searched Set to true if a full search was needed.
+         * @see findPath()
+         */
+        int findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, float radius, std::vector<WFMath::Point<3>>& path, bool& searched) const;
+
+        /**
+         * @brief Removes cached paths which might be affected by a changed tile.
+         * @param tx X index.
+         * @param ty Y index.
+         */
+        void invalidatePaths(int tx, int ty);
+
+        /**
+         * @brief Records the openings along the sides of a newly built tile in the tile graph.
+         * @param tx X index.
+         * @param ty Y index.
+         */
+        void updateTileGraph(int tx, int ty);
+
         void processEntityMovementChange(EntityEntry& entry, const LocatedEntity& entity);
 
         /**
          * @brief Rebuild the tile at the specific index.
          * @param tx X index.
          * @param ty Y index.
-         * @param entityAreas A list of entities, projected as 2d rotation boxes, which affects the tile.
          */
-        void rebuildTile(int tx, int ty, const std::vector<WFMath::RotBox<2>>& entityAreas);
+        void rebuildTile(int tx, int ty);
+
+        /**
+         * @brief Adds the layers of a tile to the tile cache, and rebuilds the navmesh for it.
+         * @param tx X index.
+         * @param ty Y index.
+         * @param tiles The tile layers. Ownership of the data is passed to the tile cache.
+         * @param ntiles The number of tile layers.
+         */
+        void installTile(int tx, int ty, TileCacheData* tiles, int ntiles);
+
+        /**
+         * @brief Installs the tile from the TileStore, if there is one and it contains the tile.
+         * @param snapshot The data of the tile.
+         * @return True if the tile was installed.
+         */
+        bool installStoredTile(const TileSnapshot& snapshot);
+
+        /**
+         * @brief Adds the layers of a tile to the TileStore, if there is one.
+         * @param hash The hash of the data the tile was built from.
+         * @param tiles The tile layers. These are copied.
+         * @param ntiles The number of tile layers.
+         */
+        void storeTile(std::uint64_t hash, const TileCacheData* tiles, int ntiles);
+
+        /**
+         * @brief Hands dirty tiles to the builder, as long as it has room for them.
+         */
+        void dispatchTileBuilds(TileBuilder& tileBuilder);
+
+        /**
+         * @brief Installs all tiles which have been built in the background.
+         */
+        void installBuiltTiles();
+
+        /**
+         * @brief Copies all of the data needed to build the tile at the specified index.
+         * @param tx X index.
+         * @param ty Y index.
+         * @param snapshot The snapshot to fill.
+         */
+        void snapshotTile(int tx, int ty, TileSnapshot& snapshot);
 
         /**
          * @brief Calculates the 2d rotbox area of the entity and adds it to the supplied map of areas.
@@ -478,15 +662,16 @@ class Awareness
         void findEntityAreas(const WFMath::AxisBox<2>& extent, std::vector<WFMath::RotBox<2> >& areas);
 
         /**
-         * @brief Rasterizes the tile at the specified index.
-         * @param entityAreas The entity areas that affects the tile.
-         * @param tx X index.
-         * @param ty Y index.
+         * @brief Rasterizes a tile.
+         *
+         * This only uses the supplied data, and can thus be called from any thread.
+         * @param ctx A Recast context.
+         * @param snapshot The data of the tile.
          * @param tiles Out parameter for the tiles.
          * @param maxTiles The maximum number of tile layers to create.
          * @return The number of tile layers that were created.
          */
-        int rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityAreas, int tx, int ty, TileCacheData* tiles, int maxTiles);
+        static int rasterizeTileLayers(rcContext& ctx, const TileSnapshot& snapshot, TileCacheData* tiles, int maxTiles);
 
         /**
          * @brief Applies the supplied processor on the supplied tiles.
@@ -0,0 +1,74 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "Crowd.h"
+#include "Awareness.h"
+
+#include <algorithm>
+#include <limits>
+
+Crowd::Crowd(Awareness& awareness, double updateInterval)
+        : mAwareness(awareness),
+          mUpdateInterval(updateInterval),
+          mLastUpdate(std::numeric_limits<double>::lowest())
+{
+}
+
+void Crowd::addAgent(Steering& steering)
+{
+    mAgents.push_back(Agent{&steering, {}});
+}
+
+void Crowd::removeAgent(Steering& steering)
+{
+    mAgents.erase(std::remove_if(mAgents.begin(), mAgents.end(), [&](const Agent& agent) { return agent.steering == &steering; }),
+                  mAgents.end());
+}
+
+bool Crowd::update(double currentTimestamp)
+{
+    if (currentTimestamp >= mLastUpdate && currentTimestamp < mLastUpdate + mUpdateInterval) {
+        return false;
+    }
+    mLastUpdate = currentTimestamp;
+
+    mAwareness.updateNeighbourGrid(currentTimestamp);
+
+    for (auto& agent : mAgents) {
+        auto result = agent.steering->update(currentTimestamp);
+        if (result.direction.isValid() || !agent.result.direction.isValid()) {
+            agent.result = result;
+        } else {
+            //Steering expects any movement it asked for to be sent, so keep it until it's picked up.
+            agent.result.timeToNextWaypoint = result.timeToNextWaypoint;
+        }
+    }
+    return true;
+}
+
+SteeringResult Crowd::takeResult(Steering& steering)
+{
+    auto I = std::find_if(mAgents.begin(), mAgents.end(), [&](const Agent& agent) { return agent.steering == &steering; });
+    if (I == mAgents.end()) {
+        return {};
+    }
+    auto result = I->result;
+    I->result.direction = WFMath::Vector<3>();
+    I->result.destination = WFMath::Point<3>();
+    return result;
+}
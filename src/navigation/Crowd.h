@@ -0,0 +1,89 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_CROWD_H
+#define CYPHESIS_CROWD_H
+
+#include "Steering.h"
+
+#include <vector>
+
+class Awareness;
+
+/**
+ * @brief Steps all Steering agents sharing an Awareness together.
+ *
+ * Instead of each agent looking for nearby entities on its own whenever its mind gets a move tick, the crowd
+ * builds a neighbour grid once and then updates all agents in one go. The results are kept until each mind
+ * picks up its own through takeResult().
+ *
+ * The crowd is stepped at most once per update interval, however many minds ask for it.
+ */
+class Crowd
+{
+    public:
+        /**
+         * @brief Ctor.
+         * @param awareness The awareness which the agents use.
+         * @param updateInterval The min time between steps, in seconds.
+         */
+        explicit Crowd(Awareness& awareness, double updateInterval = 0.1);
+
+        void addAgent(Steering& steering);
+
+        void removeAgent(Steering& steering);
+
+        size_t getAgentCount() const
+        {
+            return mAgents.size();
+        }
+
+        /**
+         * @brief Steps all agents, unless they already have been stepped within the update interval.
+         * @param currentTimestamp The current server time.
+         * @return True if the agents were stepped.
+         */
+        bool update(double currentTimestamp);
+
+        /**
+         * @brief Gets the result of the last step for an agent.
+         *
+         * Any movement is only handed out once, while the time to the next waypoint is kept until the next step.
+         * @param steering The agent.
+         * @return The result.
+         */
+        SteeringResult takeResult(Steering& steering);
+
+    private:
+        struct Agent
+        {
+            Steering* steering;
+            SteeringResult result;
+        };
+
+        Awareness& mAwareness;
+
+        double mUpdateInterval;
+
+        double mLastUpdate;
+
+        std::vector<Agent> mAgents;
+};
+
+
+#endif //CYPHESIS_CROWD_H
@@ -0,0 +1,101 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "NeighbourGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+NeighbourGrid::NeighbourGrid(float cellSize)
+        : mCellSize(cellSize),
+          mMaxRadius(0)
+{
+}
+
+void NeighbourGrid::clear()
+{
+    mMaxRadius = 0;
+    mEntityIds.clear();
+    mPositionsX.clear();
+    mPositionsY.clear();
+    mVelocitiesX.clear();
+    mVelocitiesY.clear();
+    mRadii.clear();
+    //Keep the cells which were used, as the same ones are likely to be used again, but drop those which weren't,
+    //so that cells which entities have left don't accumulate.
+    for (auto I = mCells.begin(); I != mCells.end();) {
+        if (I->second.empty()) {
+            I = mCells.erase(I);
+        } else {
+            I->second.clear();
+            ++I;
+        }
+    }
+}
+
+int NeighbourGrid::cellIndex(float coord) const
+{
+    return static_cast<int>(std::floor(coord / mCellSize));
+}
+
+int64_t NeighbourGrid::cellKey(int x, int y)
+{
+    return (static_cast<int64_t>(x) << 32) | static_cast<uint32_t>(y);
+}
+
+void NeighbourGrid::add(long entityId, const WFMath::Point<2>& position, const WFMath::Vector<2>& velocity, float radius)
+{
+    auto index = mEntityIds.size();
+    mEntityIds.push_back(entityId);
+    mPositionsX.push_back(position.x());
+    mPositionsY.push_back(position.y());
+    mVelocitiesX.push_back(velocity.isValid() ? velocity.x() : 0);
+    mVelocitiesY.push_back(velocity.isValid() ? velocity.y() : 0);
+    mRadii.push_back(radius);
+    mMaxRadius = std::max(mMaxRadius, radius);
+
+    mCells[cellKey(cellIndex(position.x()), cellIndex(position.y()))].push_back(index);
+}
+
+void NeighbourGrid::query(const WFMath::Point<2>& position, float range, std::vector<size_t>& result) const
+{
+    float x = position.x();
+    float y = position.y();
+    float reach = range + mMaxRadius;
+    int minX = cellIndex(x - reach);
+    int maxX = cellIndex(x + reach);
+    int minY = cellIndex(y - reach);
+    int maxY = cellIndex(y + reach);
+
+    for (int cx = minX; cx <= maxX; ++cx) {
+        for (int cy = minY; cy <= maxY; ++cy) {
+            auto I = mCells.find(cellKey(cx, cy));
+            if (I == mCells.end()) {
+                continue;
+            }
+            for (auto index : I->second) {
+                float dx = mPositionsX[index] - x;
+                float dy = mPositionsY[index] - y;
+                float maxDistance = range + mRadii[index];
+                if (dx * dx + dy * dy <= maxDistance * maxDistance) {
+                    result.push_back(index);
+                }
+            }
+        }
+    }
+}
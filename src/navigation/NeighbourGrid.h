@@ -0,0 +1,120 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_NEIGHBOURGRID_H
+#define CYPHESIS_NEIGHBOURGRID_H
+
+#include <wfmath/point.h>
+#include <wfmath/vector.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief A snapshot of moving entities, bucketed in a grid so that the ones near a position can be found quickly.
+ *
+ * This is built once for all agents being steered at the same time, instead of each agent going through all
+ * moving entities. The entity data is kept in separate arrays, indexed by the values returned from query().
+ */
+class NeighbourGrid
+{
+    public:
+        /**
+         * @brief Ctor.
+         * @param cellSize The size of each grid cell, in world units. Should be about the size of the queries.
+         */
+        explicit NeighbourGrid(float cellSize);
+
+        void clear();
+
+        /**
+         * @brief Adds an entity.
+         * @param entityId The id of the entity.
+         * @param position The horizontal position.
+         * @param velocity The horizontal velocity.
+         * @param radius The horizontal radius.
+         */
+        void add(long entityId, const WFMath::Point<2>& position, const WFMath::Vector<2>& velocity, float radius);
+
+        /**
+         * @brief Finds all entities which touch a circle.
+         * @param position The center of the circle.
+         * @param range The radius of the circle.
+         * @param result The indices of the entities will be added here.
+         */
+        void query(const WFMath::Point<2>& position, float range, std::vector<size_t>& result) const;
+
+        size_t size() const
+        {
+            return mEntityIds.size();
+        }
+
+        /**
+         * @brief Gets the number of allocated cells, including those which are empty.
+         */
+        size_t getCellCount() const
+        {
+            return mCells.size();
+        }
+
+        long getEntityId(size_t index) const
+        {
+            return mEntityIds[index];
+        }
+
+        WFMath::Point<2> getPosition(size_t index) const
+        {
+            return WFMath::Point<2>(mPositionsX[index], mPositionsY[index]);
+        }
+
+        WFMath::Vector<2> getVelocity(size_t index) const
+        {
+            return WFMath::Vector<2>(mVelocitiesX[index], mVelocitiesY[index]);
+        }
+
+        float getRadius(size_t index) const
+        {
+            return mRadii[index];
+        }
+
+    private:
+        float mCellSize;
+
+        /**
+         * The largest radius of any entity, used to widen queries so that large entities in nearby cells are found.
+         */
+        float mMaxRadius;
+
+        std::vector<long> mEntityIds;
+        std::vector<float> mPositionsX;
+        std::vector<float> mPositionsY;
+        std::vector<float> mVelocitiesX;
+        std::vector<float> mVelocitiesY;
+        std::vector<float> mRadii;
+
+        std::unordered_map<int64_t, std::vector<size_t>> mCells;
+
+        int cellIndex(float coord) const;
+
+        static int64_t cellKey(int x, int y);
+};
+
+
+#endif //CYPHESIS_NEIGHBOURGRID_H
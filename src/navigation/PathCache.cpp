@@ -0,0 +1,80 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "PathCache.h"
+
+#include <algorithm>
+
+size_t PathCache::KeyHash::operator()(const Key& key) const
+{
+    size_t hash = std::hash<dtPolyRef>()(key.startRef);
+    hash ^= std::hash<dtPolyRef>()(key.endRef) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<float>()(key.radius) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+PathCache::PathCache(size_t maxEntries)
+        : m_hits(0),
+          m_misses(0),
+          m_maxEntries(maxEntries)
+{
+}
+
+const std::vector<dtPolyRef>* PathCache::get(const Key& key)
+{
+    auto I = m_entries.find(key);
+    if (I == m_entries.end()) {
+        m_misses++;
+        return nullptr;
+    }
+    m_hits++;
+    m_usageOrder.splice(m_usageOrder.begin(), m_usageOrder, I->second.usage);
+    return &I->second.corridor;
+}
+
+void PathCache::put(const Key& key, std::vector<dtPolyRef> corridor, std::vector<std::pair<int, int>> tiles)
+{
+    auto I = m_entries.find(key);
+    if (I != m_entries.end()) {
+        I->second.corridor = std::move(corridor);
+        I->second.tiles = std::move(tiles);
+        m_usageOrder.splice(m_usageOrder.begin(), m_usageOrder, I->second.usage);
+        return;
+    }
+
+    if (m_entries.size() >= m_maxEntries && !m_usageOrder.empty()) {
+        m_entries.erase(m_usageOrder.back());
+        m_usageOrder.pop_back();
+    }
+    m_usageOrder.push_front(key);
+    m_entries.emplace(key, Entry{std::move(corridor), std::move(tiles), m_usageOrder.begin()});
+}
+
+void PathCache::invalidateTile(int tx, int ty)
+{
+    std::pair<int, int> tile(tx, ty);
+    for (auto I = m_entries.begin(); I != m_entries.end();) {
+        auto& tiles = I->second.tiles;
+        if (std::find(tiles.begin(), tiles.end(), tile) != tiles.end()) {
+            m_usageOrder.erase(I->second.usage);
+            I = m_entries.erase(I);
+        } else {
+            ++I;
+        }
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_PATHCACHE_H
+#define CYPHESIS_PATHCACHE_H
+
+#include "RecastDetour/Detour/Include/DetourNavMesh.h"
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Caches the polygon corridors of found paths.
+ *
+ * Many agents in the same area tend to go between the same places, and the corridor of polygons between two polygons
+ * is the same no matter where in the polygons the path starts and ends. Only the corridor is cached; the actual
+ * waypoints are cheap to calculate from it.
+ *
+ * Each corridor is tied to the tiles it passes through, and must be invalidated when any of these change.
+ * When the cache is full the least recently used corridor is removed.
+ */
+class PathCache
+{
+    public:
+        struct Key
+        {
+            dtPolyRef startRef;
+            dtPolyRef endRef;
+            float radius;
+
+            bool operator==(const Key& rhs) const
+            {
+                return startRef == rhs.startRef && endRef == rhs.endRef && radius == rhs.radius;
+            }
+        };
+
+        explicit PathCache(size_t maxEntries = 256);
+
+        /**
+         * @brief Gets a cached corridor.
+         * @param key The key.
+         * @return The corridor, or null if there was none. This is valid until the cache is next altered.
+         */
+        const std::vector<dtPolyRef>* get(const Key& key);
+
+        /**
+         * @brief Adds a corridor.
+         * @param key The key.
+         * @param corridor The polygons of the path, from start to end.
+         * @param tiles The tiles which the corridor passes through.
+         */
+        void put(const Key& key, std::vector<dtPolyRef> corridor, std::vector<std::pair<int, int>> tiles);
+
+        /**
+         * @brief Removes all corridors which pass through the tile.
+         * @param tx X index.
+         * @param ty Y index.
+         */
+        void invalidateTile(int tx, int ty);
+
+        size_t size() const
+        {
+            return m_entries.size();
+        }
+
+        int m_hits;
+
+        int m_misses;
+
+    private:
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Entry
+        {
+            std::vector<dtPolyRef> corridor;
+            std::vector<std::pair<int, int>> tiles;
+            /**
+             * The position in m_usageOrder.
+             */
+            std::list<Key>::iterator usage;
+        };
+
+        size_t m_maxEntries;
+
+        std::unordered_map<Key, Entry, KeyHash> m_entries;
+
+        /**
+         * @brief The keys of all entries, with the most recently used first.
+         */
+        std::list<Key> m_usageOrder;
+};
+
+
+#endif //CYPHESIS_PATHCACHE_H
@@ -33,6 +33,16 @@
 
 static const bool debug_flag = true;
 
+/**
+ * Destinations further away than this, in tiles, are reached by following a coarse route over the tiles.
+ */
+static const float COARSE_ROUTE_MIN_TILES = 4;
+
+/**
+ * How far along the coarse route, in tiles, to find paths to at a time.
+ */
+static const float COARSE_ROUTE_LOOKAHEAD_TILES = 3;
+
 Steering::Steering(MemEntity& avatar) :
         mAwareness(nullptr),
         mAvatar(avatar),
@@ -45,7 +55,8 @@ Steering::Steering(MemEntity& avatar) :
         mDesiredSpeed(0.5),
         mExpectingServerMovement(false),
         mPathResult(0),
-        mAvatarHorizRadius(0)
+        mAvatarHorizRadius(0),
+        mBatchPathRequests(false)
 {
     auto speedGroundProp = avatar.getPropertyType<double>("speed_ground");
     if (speedGroundProp) {
@@ -65,6 +76,7 @@ void Steering::setAwareness(Awareness* awareness)
 {
     mAwareness = awareness;
     mTileListenerConnection.disconnect();
+    mPathRequest.reset();
     if (mAwareness) {
         mTileListenerConnection = mAwareness->EventTileUpdated.connect(sigc::mem_fun(*this, &Steering::Awareness_TileUpdated));
         //setAwarenessArea();
@@ -170,7 +182,9 @@ void Steering::setAwarenessArea(double currentServerTimestamp)
 
 
         if (resolvedPosition.position.isValid()) {
-            WFMath::Point<2> destination2d(resolvedPosition.position.x(), resolvedPosition.position.z());
+            //Only the part of the route up to the route target needs to be known in detail.
+            auto target = updateRouteTarget(mAvatar.m_location.m_pos, resolvedPosition.position);
+            WFMath::Point<2> destination2d(target.x(), target.z());
             WFMath::Point<2> entityPosition2d(mAvatar.m_location.m_pos.x(), mAvatar.m_location.m_pos.z());
 
             WFMath::Vector<2> direction(destination2d - entityPosition2d);
@@ -194,6 +208,46 @@ void Steering::setAwarenessArea(double currentServerTimestamp)
     }
 }
 
+WFMath::Point<3> Steering::updateRouteTarget(const WFMath::Point<3>& avatarPosition, const WFMath::Point<3>& destination)
+{
+    mRouteTarget = WFMath::Point<3>();
+    if (!avatarPosition.isValid()) {
+        return destination;
+    }
+    auto tileSize = mAwareness->getTileSizeInMeters();
+    WFMath::Point<2> avatar2d(avatarPosition.x(), avatarPosition.z());
+    if (WFMath::Distance(avatar2d, WFMath::Point<2>(destination.x(), destination.z())) <= tileSize * COARSE_ROUTE_MIN_TILES) {
+        return destination;
+    }
+
+    std::vector<WFMath::Point<2>> waypoints;
+    if (!mAwareness->findCoarsePath(avatarPosition, destination, waypoints) || waypoints.empty()) {
+        //Fall back to trying to find a path directly.
+        return destination;
+    }
+
+    //Walk along the route until we've gone far enough.
+    WFMath::Point<2> previous = avatar2d;
+    WFMath::Point<2> target = waypoints.back();
+    WFMath::CoordType remaining = tileSize * COARSE_ROUTE_LOOKAHEAD_TILES;
+    for (auto& waypoint : waypoints) {
+        auto distance = WFMath::Distance(previous, waypoint);
+        if (distance >= remaining) {
+            target = previous + ((waypoint - previous) * (remaining / distance));
+            break;
+        }
+        remaining -= distance;
+        previous = waypoint;
+    }
+    mRouteTarget = WFMath::Point<3>(target.x(), avatarPosition.y(), target.y());
+    return mRouteTarget;
+}
+
+WFMath::Point<3> Steering::getPathTarget(const WFMath::Point<3>& destination) const
+{
+    return mRouteTarget.isValid() ? mRouteTarget : destination;
+}
+
 size_t Steering::unawareAreaCount() const
 {
     if (mAwareness) {
@@ -226,20 +280,55 @@ int Steering::updatePath(double currentTimestamp, const WFMath::Point<3>& curren
         mPathResult = -8;
         return mPathResult;
     }
-    mPathResult = mAwareness->findPath(currentAvatarPosition, resolvedPosition.position, mSteeringDestination.distance, mPath);
+    auto target = getPathTarget(resolvedPosition.position);
+    mPathResult = mAwareness->findPath(currentAvatarPosition, target, mSteeringDestination.distance, mPath);
+    handlePathResult(currentAvatarPosition, target);
+    return mPathResult;
+}
+
+void Steering::handlePathResult(const WFMath::Point<3>& start, const WFMath::Point<3>& end)
+{
     if (mPathResult == -1) {
         mAwareness->markTilesAsDirty(WFMath::AxisBox<2>(
-                {currentAvatarPosition.x() - 5, currentAvatarPosition.z() - 5},
-                {currentAvatarPosition.x() + 5, currentAvatarPosition.z() + 5}));
+                {start.x() - 5, start.z() - 5},
+                {start.x() + 5, start.z() + 5}));
     } else if (mPathResult == -2) {
         mAwareness->markTilesAsDirty(WFMath::AxisBox<2>(
-                {resolvedPosition.position.x() - 5, resolvedPosition.position.z() - 5},
-                {resolvedPosition.position.x() + 5, resolvedPosition.position.z() + 5}));
+                {end.x() - 5, end.z() - 5},
+                {end.x() + 5, end.z() + 5}));
     }
     //debug_print("Updating path, size of new path: " << result << ". Pos: " << currentAvatarPosition);
     EventPathUpdated();
     mUpdateNeeded = false;
-    return mPathResult;
+}
+
+void Steering::requestPath(double currentTimestamp, const WFMath::Point<3>& currentAvatarPosition)
+{
+    auto resolvedPosition = resolvePosition(currentTimestamp, mSteeringDestination.location);
+    if (!resolvedPosition.position.isValid()) {
+        //Let updatePath() handle the failure, as it doesn't need any path finding.
+        mPathRequest.reset();
+        updatePath(currentTimestamp, currentAvatarPosition);
+        return;
+    }
+    mPathRequest = std::make_shared<PathRequest>();
+    mPathRequest->start = currentAvatarPosition;
+    mPathRequest->end = getPathTarget(resolvedPosition.position);
+    mPathRequest->radius = static_cast<float>(mSteeringDestination.distance);
+    mPathRequest->isDone = false;
+    mPathRequest->result = 0;
+    mAwareness->queuePathRequest(mPathRequest);
+    mUpdateNeeded = false;
+}
+
+void Steering::setBatchPathRequests(bool batch)
+{
+    mBatchPathRequests = batch;
+}
+
+bool Steering::isPathRequestPending() const
+{
+    return mPathRequest != nullptr;
 }
 
 int Steering::updatePath(double currentTimestamp)
@@ -279,6 +368,8 @@ void Steering::stopSteering()
     mPath.clear();
     mCurrentPathIndex = 0;
     mPathResult = 0;
+    mPathRequest.reset();
+    mRouteTarget = WFMath::Point<3>();
     EventPathUpdated();
 
 }
@@ -389,8 +480,31 @@ SteeringResult Steering::update(double currentTimestamp)
 
         auto currentEntityPos = getCurrentAvatarPosition(currentTimestamp);
 
+        //Until a requested path is resolved we'll keep following the old one.
+        if (mPathRequest && mPathRequest->isDone) {
+            auto request = std::move(mPathRequest);
+            mPath = std::move(request->path);
+            mCurrentPathIndex = 0;
+            mPathResult = request->result;
+            //Keep any need for an update which arose after the path was requested.
+            bool updateNeeded = mUpdateNeeded;
+            handlePathResult(request->start, request->end);
+            mUpdateNeeded = updateNeeded;
+        }
+        //When getting near the route target, move it further along the route.
+        if (mRouteTarget.isValid() && WFMath::Distance(WFMath::Point<2>(currentEntityPos.x(), currentEntityPos.z()), WFMath::Point<2>(mRouteTarget.x(), mRouteTarget.z())) < mAwareness->getTileSizeInMeters()) {
+            setAwarenessArea(currentTimestamp);
+            mUpdateNeeded = true;
+        }
         if (mUpdateNeeded) {
-            updatePath(currentTimestamp, currentEntityPos);
+            if (mBatchPathRequests) {
+                //Wait for any outstanding request, since replacing it would put it at the back of the queue again.
+                if (!mPathRequest) {
+                    requestPath(currentTimestamp, currentEntityPos);
+                }
+            } else {
+                updatePath(currentTimestamp, currentEntityPos);
+            }
         }
         if (!mPath.empty()) {
             //First check if we've arrived at our actual destination.
@@ -419,7 +533,8 @@ SteeringResult Steering::update(double currentTimestamp)
 
                 result.timeToNextWaypoint = distance.mag() / velocityNorm.mag();
 
-                if (mCurrentPathIndex == mPath.size() - 1) {
+                //There's no need to stop at the route target, since the path will be extended before it's reached.
+                if (mCurrentPathIndex == mPath.size() - 1 && !mRouteTarget.isValid()) {
                     //if the next waypoint is the destination we should send a "move to position" update to the server, to make sure that we stop when we've arrived.
                     //otherwise, if there's too much lag, we might end up overshooting our destination and will have to double back
                     destination = nextWaypoint;
@@ -24,6 +24,7 @@
 #include <wfmath/axisbox.h>
 
 #include <vector>
+#include <memory>
 
 #include <sigc++/trackable.h>
 #include <sigc++/signal.h>
@@ -35,6 +36,8 @@
 
 class Awareness;
 
+struct PathRequest;
+
 class MemEntity;
 
 /**
@@ -172,6 +175,21 @@ class Steering : public virtual sigc::trackable
          */
         int updatePath(double currentTimestamp);
 
+        /**
+         * @brief Sets whether paths should be requested from the Awareness, instead of being found right away.
+         *
+         * Requested paths are resolved when Awareness::processPathRequests() is called, which lets the cost of
+         * finding paths for many avatars be spread out.
+         * Until a requested path is resolved the old path is followed.
+         * @param batch True if paths should be requested.
+         */
+        void setBatchPathRequests(bool batch);
+
+        /**
+         * @brief Returns true if a path has been requested, but the new path hasn't been applied yet.
+         */
+        bool isPathRequestPending() const;
+
         /**
          * @brief Requests an update of the path.
          *
@@ -327,6 +345,48 @@ class Steering : public virtual sigc::trackable
          */
         WFMath::Point<3> mAvatarPositionLastUpdate;
 
+        /**
+         * @brief True if paths should be requested from the awareness rather than found right away.
+         */
+        bool mBatchPathRequests;
+
+        /**
+         * @brief The currently outstanding path request, if any.
+         */
+        std::shared_ptr<PathRequest> mPathRequest;
+
+        /**
+         * @brief A point along the coarse route to a far away destination, which the path currently leads to.
+         *
+         * Invalid if the destination is near enough to find a path to it directly.
+         */
+        WFMath::Point<3> mRouteTarget;
+
+        /**
+         * @brief Updates mRouteTarget, using the coarse route from the avatar to the destination if it's far away.
+         * @param avatarPosition The current position of the avatar.
+         * @param destination The final destination.
+         * @return The position which the path should lead to; either the route target or the destination.
+         */
+        WFMath::Point<3> updateRouteTarget(const WFMath::Point<3>& avatarPosition, const WFMath::Point<3>& destination);
+
+        /**
+         * @brief Gets the position which the path should lead to; either the route target or the destination.
+         */
+        WFMath::Point<3> getPathTarget(const WFMath::Point<3>& destination) const;
+
+        /**
+         * @brief Queues a request for a new path with the awareness.
+         */
+        void requestPath(double currentTimestamp, const WFMath::Point<3>& currentAvatarPosition);
+
+        /**
+         * @brief Handles the result of a path search which has been stored in mPathResult.
+         * @param start The position the path was searched from.
+         * @param end The position the path was searched to.
+         */
+        void handlePathResult(const WFMath::Point<3>& start, const WFMath::Point<3>& end);
+
         /**
          * @brief Sets the awareness to be a corridor between where the avatar currently is and our destination.
          *
@@ -0,0 +1,69 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "TileBuilder.h"
+
+TileBuilder::TileBuilder(size_t threadCount)
+        : m_shutdown(false)
+{
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+TileBuilder::~TileBuilder()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_jobsAvailable.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void TileBuilder::post(std::function<void()> job)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_jobs.emplace_back(std::move(job));
+    }
+    m_jobsAvailable.notify_one();
+}
+
+void TileBuilder::workerLoop()
+{
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobsAvailable.wait(lock, [this]() { return m_shutdown || !m_jobs.empty(); });
+            if (m_shutdown) {
+                return;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        //Logging isn't thread safe, so jobs are expected to report their own errors. This only keeps the worker alive.
+        try {
+            job();
+        } catch (...) {
+        }
+    }
+}
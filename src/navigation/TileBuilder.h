@@ -0,0 +1,85 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_TILEBUILDER_H
+#define CYPHESIS_TILEBUILDER_H
+
+#include "common/Singleton.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A pool of worker threads on which navmesh tiles are built.
+ *
+ * Building a tile runs the whole Recast pipeline, which takes long enough to stall the steering of all minds if it's
+ * done on the main thread. Awareness instances instead take a snapshot of all the data needed to build a tile on the
+ * main thread, and let the workers do the building. The results are handed back to the Awareness, which installs them
+ * on the main thread.
+ *
+ * If there's no instance available tiles are built on the main thread.
+ */
+class TileBuilder : public Singleton<TileBuilder>
+{
+    public:
+        /**
+         * @brief Ctor.
+         * @param threadCount The number of worker threads. Must be at least one.
+         */
+        explicit TileBuilder(size_t threadCount);
+
+        /**
+         * @brief Dtor.
+         *
+         * Any jobs which haven't been started yet are discarded.
+         */
+        ~TileBuilder() override;
+
+        /**
+         * @brief Queues a job to be run on one of the workers.
+         *
+         * The job must not touch anything which is used by the main thread. This includes the log, so any errors
+         * should be handed back to the main thread along with the result.
+         */
+        void post(std::function<void()> job);
+
+        size_t getThreadCount() const
+        {
+            return m_threads.size();
+        }
+
+    private:
+
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_mutex;
+        std::condition_variable m_jobsAvailable;
+
+        std::deque<std::function<void()>> m_jobs;
+
+        bool m_shutdown;
+
+        void workerLoop();
+};
+
+
+#endif //CYPHESIS_TILEBUILDER_H
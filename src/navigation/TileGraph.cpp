@@ -0,0 +1,233 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "TileGraph.h"
+
+#include <cmath>
+#include <functional>
+#include <queue>
+
+namespace {
+    /**
+     * The max number of nodes expanded in a search, so that a search for an unreachable destination doesn't
+     * go through the whole world.
+     */
+    const size_t MAX_EXPANDED_NODES = 10000;
+
+    const int NODE_UNKNOWN_TILE = -1;
+    const int NODE_START = -2;
+    const int NODE_END = -3;
+
+    const int SIDE_OFFSETS[4][2] = {{1,  0},
+                                    {0,  1},
+                                    {-1, 0},
+                                    {0,  -1}};
+
+    TileGraph::Side oppositeSide(TileGraph::Side side)
+    {
+        return static_cast<TileGraph::Side>((side + 2) % 4);
+    }
+}
+
+TileGraph::TileGraph(const WFMath::Point<2>& origin, float tileSize, int tilesX, int tilesY)
+        : mOrigin(origin),
+          mTileSize(tileSize),
+          mTilesX(tilesX),
+          mTilesY(tilesY)
+{
+}
+
+void TileGraph::setTile(int tx, int ty, std::vector<Portal> portals)
+{
+    mTiles[std::make_pair(tx, ty)] = std::move(portals);
+}
+
+bool TileGraph::hasTile(int tx, int ty) const
+{
+    return mTiles.find(std::make_pair(tx, ty)) != mTiles.end();
+}
+
+bool TileGraph::isWithinBounds(int tx, int ty) const
+{
+    return tx >= 0 && ty >= 0 && tx < mTilesX && ty < mTilesY;
+}
+
+std::pair<int, int> TileGraph::tileAt(const WFMath::Point<2>& position) const
+{
+    return std::make_pair(static_cast<int>(std::floor((position.x() - mOrigin.x()) / mTileSize)),
+                          static_cast<int>(std::floor((position.y() - mOrigin.y()) / mTileSize)));
+}
+
+WFMath::Point<2> TileGraph::portalPosition(int tx, int ty, const Portal& portal) const
+{
+    float middle = (portal.min + portal.max) * 0.5f;
+    switch (portal.side) {
+        case POS_X:
+            return WFMath::Point<2>(mOrigin.x() + (tx + 1) * mTileSize, middle);
+        case NEG_X:
+            return WFMath::Point<2>(mOrigin.x() + tx * mTileSize, middle);
+        case POS_Y:
+            return WFMath::Point<2>(middle, mOrigin.y() + (ty + 1) * mTileSize);
+        case NEG_Y:
+        default:
+            return WFMath::Point<2>(middle, mOrigin.y() + ty * mTileSize);
+    }
+}
+
+WFMath::Point<2> TileGraph::tileCenter(int tx, int ty) const
+{
+    return WFMath::Point<2>(mOrigin.x() + (tx + 0.5f) * mTileSize, mOrigin.y() + (ty + 0.5f) * mTileSize);
+}
+
+void TileGraph::addTileSuccessors(int tx, int ty, int region,
+                                  const Node& endNode, const WFMath::Point<2>& end,
+                                  std::vector<std::pair<Node, WFMath::Point<2>>>& successors) const
+{
+    if (tx == endNode.tx && ty == endNode.ty) {
+        successors.emplace_back(endNode, end);
+    }
+    auto I = mTiles.find(std::make_pair(tx, ty));
+    if (I == mTiles.end()) {
+        //Nothing is known about the tile, so assume it can be crossed in any direction.
+        for (int side = 0; side < 4; ++side) {
+            addNeighbourSuccessors(tx, ty, static_cast<Side>(side), nullptr, successors);
+        }
+    } else {
+        auto& portals = I->second;
+        for (size_t i = 0; i < portals.size(); ++i) {
+            if (region == -1 || portals[i].region == region) {
+                successors.emplace_back(Node{tx, ty, static_cast<int>(i)}, portalPosition(tx, ty, portals[i]));
+            }
+        }
+    }
+}
+
+void TileGraph::addNeighbourSuccessors(int tx, int ty, Side side, const Portal* portal,
+                                       std::vector<std::pair<Node, WFMath::Point<2>>>& successors) const
+{
+    int nx = tx + SIDE_OFFSETS[side][0];
+    int ny = ty + SIDE_OFFSETS[side][1];
+    if (!isWithinBounds(nx, ny)) {
+        return;
+    }
+    auto I = mTiles.find(std::make_pair(nx, ny));
+    if (I == mTiles.end()) {
+        successors.emplace_back(Node{nx, ny, NODE_UNKNOWN_TILE}, tileCenter(nx, ny));
+    } else {
+        auto facingSide = oppositeSide(side);
+        auto& portals = I->second;
+        for (size_t i = 0; i < portals.size(); ++i) {
+            auto& neighbourPortal = portals[i];
+            if (neighbourPortal.side != facingSide) {
+                continue;
+            }
+            //If we're crossing from a portal the openings must overlap.
+            if (portal && (neighbourPortal.max < portal->min || neighbourPortal.min > portal->max)) {
+                continue;
+            }
+            successors.emplace_back(Node{nx, ny, static_cast<int>(i)}, portalPosition(nx, ny, neighbourPortal));
+        }
+    }
+}
+
+bool TileGraph::findPath(const WFMath::Point<2>& start, const WFMath::Point<2>& end, std::vector<WFMath::Point<2>>& waypoints) const
+{
+    auto startTile = tileAt(start);
+    auto endTile = tileAt(end);
+    if (!isWithinBounds(startTile.first, startTile.second) || !isWithinBounds(endTile.first, endTile.second)) {
+        return false;
+    }
+
+    const Node startNode{startTile.first, startTile.second, NODE_START};
+    const Node endNode{endTile.first, endTile.second, NODE_END};
+
+    struct NodeInfo
+    {
+        WFMath::Point<2> position;
+        float cost;
+        Node parent;
+        bool closed;
+    };
+
+    std::map<Node, NodeInfo> nodes;
+    typedef std::pair<float, Node> OpenEntry;
+    auto openCompare = [](const OpenEntry& lhs, const OpenEntry& rhs) { return lhs.first > rhs.first; };
+    std::priority_queue<OpenEntry, std::vector<OpenEntry>, decltype(openCompare)> open(openCompare);
+
+    nodes.emplace(startNode, NodeInfo{start, 0, startNode, false});
+    open.emplace(WFMath::Distance(start, end), startNode);
+
+    std::vector<std::pair<Node, WFMath::Point<2>>> successors;
+    size_t expanded = 0;
+
+    while (!open.empty()) {
+        auto current = open.top().second;
+        open.pop();
+        auto& currentInfo = nodes[current];
+        if (currentInfo.closed) {
+            continue;
+        }
+        currentInfo.closed = true;
+
+        if (current == endNode) {
+            std::vector<WFMath::Point<2>> reversed;
+            for (auto node = current; !(node == startNode); node = nodes[node].parent) {
+                auto& position = nodes[node].position;
+                //The center of an unknown tile can coincide with the end.
+                if (reversed.empty() || !(reversed.back() == position)) {
+                    reversed.push_back(position);
+                }
+            }
+            waypoints.assign(reversed.rbegin(), reversed.rend());
+            return true;
+        }
+
+        if (++expanded > MAX_EXPANDED_NODES) {
+            return false;
+        }
+
+        successors.clear();
+        if (current.portal == NODE_START || current.portal == NODE_UNKNOWN_TILE) {
+            addTileSuccessors(current.tx, current.ty, -1, endNode, end, successors);
+        } else {
+            auto& portal = mTiles.find(std::make_pair(current.tx, current.ty))->second[current.portal];
+            addTileSuccessors(current.tx, current.ty, portal.region, endNode, end, successors);
+            addNeighbourSuccessors(current.tx, current.ty, portal.side, &portal, successors);
+        }
+
+        auto currentPosition = currentInfo.position;
+        auto currentCost = currentInfo.cost;
+        for (auto& successor : successors) {
+            if (successor.first == current) {
+                continue;
+            }
+            float cost = currentCost + static_cast<float>(WFMath::Distance(currentPosition, successor.second));
+            auto result = nodes.emplace(successor.first, NodeInfo{successor.second, cost, current, false});
+            auto& info = result.first->second;
+            if (!result.second) {
+                if (info.closed || info.cost <= cost) {
+                    continue;
+                }
+                info.cost = cost;
+                info.parent = current;
+            }
+            open.emplace(cost + static_cast<float>(WFMath::Distance(successor.second, end)), successor.first);
+        }
+    }
+    return false;
+}
@@ -0,0 +1,148 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_TILEGRAPH_H
+#define CYPHESIS_TILEGRAPH_H
+
+#include <wfmath/point.h>
+
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A coarse graph of how the navmesh tiles connect, used for planning long routes.
+ *
+ * Only the tiles around aware entities are kept built, so the full navmesh can't be used for finding long paths.
+ * Instead, whenever a tile is built the openings along its sides (the "portals") are recorded here, together with
+ * which of them are connected within the tile. This information is kept even after the tile is pruned.
+ *
+ * Routes are found with A* over the portals, after which only the next part of the route needs to be refined using
+ * the navmesh. Tiles which never have been built are assumed to be fully walkable, so that routes can be planned
+ * through unexplored areas.
+ *
+ * Tile indices are the same as for the navmesh, with y corresponding to the world z axis.
+ */
+class TileGraph
+{
+    public:
+        enum Side
+        {
+            POS_X = 0, POS_Y = 1, NEG_X = 2, NEG_Y = 3
+        };
+
+        struct Portal
+        {
+            Side side;
+            /**
+             * The start of the opening along the side, in world units.
+             */
+            float min;
+            /**
+             * The end of the opening along the side, in world units.
+             */
+            float max;
+            /**
+             * Portals with the same region are connected within the tile.
+             */
+            int region;
+        };
+
+        /**
+         * @brief Ctor.
+         * @param origin The world position of the corner of the first tile.
+         * @param tileSize The size of a tile in world units.
+         * @param tilesX The number of tiles along the x axis.
+         * @param tilesY The number of tiles along the y axis.
+         */
+        TileGraph(const WFMath::Point<2>& origin, float tileSize, int tilesX, int tilesY);
+
+        /**
+         * @brief Sets the portals of a tile, replacing any earlier ones.
+         */
+        void setTile(int tx, int ty, std::vector<Portal> portals);
+
+        bool hasTile(int tx, int ty) const;
+
+        /**
+         * @brief Finds a coarse route.
+         * @param start The start, in world units.
+         * @param end The end, in world units.
+         * @param waypoints Out parameter for the waypoints, not including the start but including the end.
+         * @return True if a route was found.
+         */
+        bool findPath(const WFMath::Point<2>& start, const WFMath::Point<2>& end, std::vector<WFMath::Point<2>>& waypoints) const;
+
+    private:
+
+        /**
+         * @brief A node in the search.
+         *
+         * A portal index of -1 means the center of a tile which hasn't been built. -2 is used for the start and
+         * -3 for the end.
+         */
+        struct Node
+        {
+            int tx;
+            int ty;
+            int portal;
+
+            bool operator<(const Node& rhs) const
+            {
+                return std::tie(tx, ty, portal) < std::tie(rhs.tx, rhs.ty, rhs.portal);
+            }
+
+            bool operator==(const Node& rhs) const
+            {
+                return tx == rhs.tx && ty == rhs.ty && portal == rhs.portal;
+            }
+        };
+
+        WFMath::Point<2> mOrigin;
+        float mTileSize;
+        int mTilesX;
+        int mTilesY;
+
+        std::map<std::pair<int, int>, std::vector<Portal>> mTiles;
+
+        bool isWithinBounds(int tx, int ty) const;
+
+        std::pair<int, int> tileAt(const WFMath::Point<2>& position) const;
+
+        WFMath::Point<2> portalPosition(int tx, int ty, const Portal& portal) const;
+
+        WFMath::Point<2> tileCenter(int tx, int ty) const;
+
+        /**
+         * @brief Adds the nodes which can be reached from within the tile.
+         * @param region Only portals in this region are added, unless it's -1.
+         */
+        void addTileSuccessors(int tx, int ty, int region,
+                               const Node& endNode, const WFMath::Point<2>& end,
+                               std::vector<std::pair<Node, WFMath::Point<2>>>& successors) const;
+
+        /**
+         * @brief Adds the nodes which can be reached by crossing the side of the tile.
+         */
+        void addNeighbourSuccessors(int tx, int ty, Side side, const Portal* portal,
+                                    std::vector<std::pair<Node, WFMath::Point<2>>>& successors) const;
+};
+
+
+#endif //CYPHESIS_TILEGRAPH_H
@@ -0,0 +1,248 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "TileStore.h"
+
+#include "common/log.h"
+#include "common/compose.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+    /**
+     * Starts each record. The last byte is the version of the format, which should be increased whenever it changes.
+     */
+    const std::uint32_t RECORD_MAGIC = ('C' << 24) | ('N' << 16) | ('T' << 8) | 1;
+
+    /**
+     * Guards against reading garbage as a huge number of layers.
+     */
+    const std::uint32_t MAX_RECORD_LAYERS = 256;
+
+    template<typename T>
+    bool readValue(const unsigned char* data, size_t size, size_t& pos, T& value)
+    {
+        if (size - pos < sizeof(T)) {
+            return false;
+        }
+        memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    template<typename T>
+    void writeValue(std::vector<unsigned char>& buffer, const T& value)
+    {
+        auto pos = buffer.size();
+        buffer.resize(pos + sizeof(T));
+        memcpy(buffer.data() + pos, &value, sizeof(T));
+    }
+
+    /**
+     * Appends a record to the buffer.
+     * @return The offsets in the buffer of the data of each layer.
+     */
+    std::vector<size_t> encodeRecord(std::vector<unsigned char>& buffer, std::uint64_t hash, const std::vector<TileStore::Layer>& layers)
+    {
+        writeValue(buffer, RECORD_MAGIC);
+        writeValue(buffer, hash);
+        writeValue(buffer, static_cast<std::uint32_t>(layers.size()));
+        std::vector<size_t> offsets;
+        for (auto& layer : layers) {
+            writeValue(buffer, static_cast<std::uint32_t>(layer.dataSize));
+            offsets.push_back(buffer.size());
+            buffer.insert(buffer.end(), layer.data, layer.data + layer.dataSize);
+        }
+        return offsets;
+    }
+}
+
+TileStore::TileStore(std::string path, size_t maxFileSize)
+        : m_hits(0),
+          m_misses(0),
+          m_path(std::move(path)),
+          m_fd(-1),
+          m_mappedData(nullptr),
+          m_mappedSize(0)
+{
+    load(maxFileSize);
+}
+
+TileStore::~TileStore()
+{
+    log(INFO, String::compose("Navmesh tiles reused from store: %1, built: %2.", m_hits, m_misses));
+    if (m_mappedData) {
+        munmap(m_mappedData, m_mappedSize);
+    }
+    if (m_fd != -1) {
+        close(m_fd);
+    }
+}
+
+void TileStore::load(size_t maxFileSize)
+{
+    m_fd = open(m_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (m_fd == -1) {
+        log(WARNING, String::compose("Could not open navmesh tile store at '%1': %2. Tiles will not be stored.", m_path, strerror(errno)));
+        return;
+    }
+
+    struct stat fileStat{};
+    if (fstat(m_fd, &fileStat) == -1 || fileStat.st_size == 0) {
+        return;
+    }
+
+    auto fileSize = static_cast<size_t>(fileStat.st_size);
+    bool discard = fileSize > maxFileSize;
+    if (!discard) {
+        void* mappedData = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (mappedData == MAP_FAILED) {
+            log(WARNING, String::compose("Could not map navmesh tile store at '%1': %2.", m_path, strerror(errno)));
+            discard = true;
+        } else {
+            m_mappedData = mappedData;
+            m_mappedSize = fileSize;
+            bool truncated = false;
+            auto validSize = parse(truncated);
+            if (validSize != fileSize && truncated) {
+                //Most likely another process is writing the record right now, so it's left alone.
+                log(INFO, String::compose("Navmesh tile store at '%1' ends with an incomplete record, which is ignored.", m_path));
+            } else if (validSize != fileSize) {
+                //Anything appended after invalid data would never be read, so start over with a new file.
+                //Any records already read are kept in the mapping, which stays valid after the file is unlinked.
+                log(WARNING, String::compose("Navmesh tile store at '%1' contains invalid data; it will be recreated.", m_path));
+                discard = true;
+            }
+        }
+    }
+
+    if (discard) {
+        //The file is unlinked rather than truncated, since other processes might have it mapped.
+        close(m_fd);
+        unlink(m_path.c_str());
+        m_fd = open(m_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (m_fd == -1) {
+            log(WARNING, String::compose("Could not recreate navmesh tile store at '%1': %2. Tiles will not be stored.", m_path, strerror(errno)));
+        } else {
+            //put() skips tiles which already are known, so any records which were kept must be written to the new file here.
+            std::vector<unsigned char> buffer;
+            for (auto& entry : m_records) {
+                buffer.clear();
+                encodeRecord(buffer, entry.first, entry.second.layers);
+                if (!writeRecord(buffer)) {
+                    break;
+                }
+            }
+        }
+    }
+
+    log(INFO, String::compose("Loaded %1 navmesh tiles from '%2'.", m_records.size(), m_path));
+}
+
+size_t TileStore::parse(bool& truncated)
+{
+    auto data = static_cast<const unsigned char*>(m_mappedData);
+    size_t pos = 0;
+    truncated = false;
+    while (pos < m_mappedSize) {
+        size_t recordStart = pos;
+        std::uint32_t magic;
+        std::uint64_t hash;
+        std::uint32_t layerCount;
+        //Running out of data means that the record is incomplete, while unexpected values means that it's corrupt.
+        if (!readValue(data, m_mappedSize, pos, magic)) {
+            truncated = true;
+            return recordStart;
+        }
+        if (magic != RECORD_MAGIC) {
+            return recordStart;
+        }
+        if (!readValue(data, m_mappedSize, pos, hash) || !readValue(data, m_mappedSize, pos, layerCount)) {
+            truncated = true;
+            return recordStart;
+        }
+        if (layerCount > MAX_RECORD_LAYERS) {
+            return recordStart;
+        }
+
+        Record record;
+        for (std::uint32_t i = 0; i < layerCount; ++i) {
+            std::uint32_t dataSize;
+            if (!readValue(data, m_mappedSize, pos, dataSize) || m_mappedSize - pos < dataSize) {
+                truncated = true;
+                return recordStart;
+            }
+            record.layers.emplace_back(Layer{data + pos, static_cast<int>(dataSize)});
+            pos += dataSize;
+        }
+        //Later records replace earlier ones with the same hash.
+        m_records[hash] = std::move(record);
+    }
+    return pos;
+}
+
+bool TileStore::get(std::uint64_t hash, std::vector<Layer>& layers)
+{
+    auto I = m_records.find(hash);
+    if (I == m_records.end()) {
+        m_misses++;
+        return false;
+    }
+    m_hits++;
+    layers = I->second.layers;
+    return true;
+}
+
+void TileStore::put(std::uint64_t hash, const std::vector<Layer>& layers)
+{
+    if (m_records.find(hash) != m_records.end()) {
+        return;
+    }
+
+    Record record;
+    auto& buffer = record.ownedData;
+    auto offsets = encodeRecord(buffer, hash, layers);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        record.layers.emplace_back(Layer{buffer.data() + offsets[i], layers[i].dataSize});
+    }
+
+    writeRecord(buffer);
+
+    m_records.emplace(hash, std::move(record));
+}
+
+bool TileStore::writeRecord(const std::vector<unsigned char>& buffer)
+{
+    if (m_fd == -1) {
+        return false;
+    }
+    //Write the whole record at once, so that it isn't interleaved with records from other processes.
+    auto written = write(m_fd, buffer.data(), buffer.size());
+    if (written != static_cast<ssize_t>(buffer.size())) {
+        log(WARNING, String::compose("Could not write to navmesh tile store at '%1'. Tiles will no longer be stored.", m_path));
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    return true;
+}
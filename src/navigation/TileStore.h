@@ -0,0 +1,125 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_TILESTORE_H
+#define CYPHESIS_TILESTORE_H
+
+#include "common/Singleton.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Keeps built navmesh tiles in a file, so that they can be reused after a restart.
+ *
+ * Most of the world, such as the terrain and buildings, doesn't change between restarts, so there's no need to build
+ * all tiles from scratch each time. Tiles are stored by a hash of all the data they were built from, which means that
+ * a tile only is rebuilt if anything that affects it has changed.
+ *
+ * The file is only ever appended to, and is memory mapped when loaded. Since many processes can use the same file
+ * each record is written with a single call, and an incomplete record at the end, which might be in the process of
+ * being written, is ignored. If the file contains corrupt data, or grows too large, it's discarded when loaded.
+ */
+class TileStore : public Singleton<TileStore>
+{
+    public:
+        struct Layer
+        {
+            const unsigned char* data;
+            int dataSize;
+        };
+
+        /**
+         * @brief Ctor.
+         * @param path The path to the file.
+         * @param maxFileSize If the file is larger than this when it's loaded it's discarded.
+         */
+        TileStore(std::string path, size_t maxFileSize);
+
+        ~TileStore() override;
+
+        /**
+         * @brief Gets the stored layers of a tile.
+         * @param hash The hash of the data the tile was built from.
+         * @param layers Out parameter for the layers. These are valid for as long as the store exists.
+         * @return True if the tile was found.
+         */
+        bool get(std::uint64_t hash, std::vector<Layer>& layers);
+
+        /**
+         * @brief Stores the layers of a tile, both in memory and in the file.
+         * @param hash The hash of the data the tile was built from.
+         * @param layers The layers of the tile.
+         */
+        void put(std::uint64_t hash, const std::vector<Layer>& layers);
+
+        size_t size() const
+        {
+            return m_records.size();
+        }
+
+        /**
+         * The number of tiles which could be reused.
+         */
+        int m_hits;
+
+        /**
+         * The number of tiles which had to be built.
+         */
+        int m_misses;
+
+    private:
+
+        struct Record
+        {
+            std::vector<Layer> layers;
+            /**
+             * The data of records which have been added after the file was loaded.
+             */
+            std::vector<unsigned char> ownedData;
+        };
+
+        std::string m_path;
+
+        int m_fd;
+
+        void* m_mappedData;
+        size_t m_mappedSize;
+
+        std::unordered_map<std::uint64_t, Record> m_records;
+
+        void load(size_t maxFileSize);
+
+        /**
+         * @brief Reads all records in the mapped file.
+         * @param truncated Set to true if reading stopped since the last record is incomplete, rather than corrupt.
+         * @return The number of bytes at the start of the file which contain valid records.
+         */
+        size_t parse(bool& truncated);
+
+        /**
+         * @brief Appends an encoded record to the file, if it's open.
+         * @return True if the record was written.
+         */
+        bool writeRecord(const std::vector<unsigned char>& buffer);
+};
+
+
+#endif //CYPHESIS_TILESTORE_H
@@ -123,13 +123,13 @@ class Domain
         virtual void getVisibleEntitiesFor(const LocatedEntity& observingEntity, std::list<LocatedEntity*>& entityList) const = 0;
 
         /**
-         * Fills the supplied list with all entities in the domain that are currently observing the supplied entity.
+         * Adds all entities in the domain that are currently observing the supplied entity to the supplied list.
+         * The list isn't cleared first, which allows the same list to be used for many domains.
          * @param observedEntity The entity which is being observed.
-         * @return A list of entities.
+         * @param entityList A list of entities.
          */
-        virtual std::vector<LocatedEntity*> getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+        virtual void getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
         {
-            return {};
         }
 
         /**
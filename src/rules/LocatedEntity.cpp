@@ -30,6 +30,7 @@
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Anonymous.h>
 
+#include <algorithm>
 #include <memory>
 
 using Atlas::Objects::Operation::Update;
@@ -357,6 +358,18 @@ const PropertyBase* LocatedEntity::getProperty(const std::string& name) const
     return nullptr;
 }
 
+const PropertyBase* LocatedEntity::getProperty(PropertyId id) const
+{
+    auto modifiableProperty = m_properties.find(id);
+    if (modifiableProperty) {
+        return modifiableProperty->property.get();
+    }
+    if (m_type != nullptr) {
+        return m_type->defaultProperty(id);
+    }
+    return nullptr;
+}
+
 PropertyBase* LocatedEntity::modProperty(const std::string& name, const Atlas::Message::Element& def_val)
 {
     auto I = m_properties.find(name);
@@ -491,10 +504,19 @@ void LocatedEntity::changeContainer(const Ref<LocatedEntity>& new_loc)
 
 void LocatedEntity::broadcast(const Atlas::Objects::Operation::RootOperation& op, OpVector& res, Visibility visibility) const
 {
-    std::set<const LocatedEntity*> receivers;
+    //Reuse the same vector for all broadcasts, since this is called very often.
+    static thread_local std::vector<const LocatedEntity*> receivers;
+    receivers.clear();
     collectObservers(receivers);
 
-    for (auto& entity : receivers) {
+    broadcast(op, res, visibility, receivers);
+}
+
+void LocatedEntity::broadcast(const Atlas::Objects::Operation::RootOperation& op, OpVector& res, Visibility visibility,
+                              const std::vector<const LocatedEntity*>& observers) const
+{
+    res.reserve(res.size() + observers.size());
+    for (auto& entity : observers) {
         if (visibility == Visibility::PRIVATE) {
             //Only send private ops to admins
             if (!entity->hasFlags(entity_admin)) {
@@ -507,26 +529,36 @@ void LocatedEntity::broadcast(const Atlas::Objects::Operation::RootOperation& op
                 continue;
             }
         }
+        //The copy is shallow, so the arguments are shared between all copies.
         auto newOp = op.copy();
         newOp->setTo(entity->getId());
         newOp->setFrom(getId());
-        res.push_back(newOp);
+        res.push_back(std::move(newOp));
     }
 }
 
 void LocatedEntity::collectObservers(std::set<const LocatedEntity*>& receivers) const
+{
+    std::vector<const LocatedEntity*> observers;
+    collectObservers(observers);
+    receivers.insert(observers.begin(), observers.end());
+}
+
+void LocatedEntity::collectObservers(std::vector<const LocatedEntity*>& receivers) const
 {
     if (isPerceptive()) {
-        receivers.insert(this);
+        receivers.push_back(this);
     }
     const Domain* domain = getDomain();
     if (domain) {
-        auto observingEntities = domain->getObservingEntitiesFor(*this);
-        receivers.insert(observingEntities.begin(), observingEntities.end());
+        domain->getObservingEntitiesFor(*this, receivers);
     }
     if (m_location.m_parent) {
         m_location.m_parent->collectObserversForChild(*this, receivers);
     }
+    //An entity can observe through more than one domain, so remove duplicates.
+    std::sort(receivers.begin(), receivers.end());
+    receivers.erase(std::unique(receivers.begin(), receivers.end()), receivers.end());
 }
 
 void LocatedEntity::collectObserved(std::set<const LocatedEntity*>& observed) const
@@ -539,17 +571,16 @@ void LocatedEntity::collectObserved(std::set<const LocatedEntity*>& observed) co
     }
 }
 
-void LocatedEntity::collectObserversForChild(const LocatedEntity& child, std::set<const LocatedEntity*>& receivers) const
+void LocatedEntity::collectObserversForChild(const LocatedEntity& child, std::vector<const LocatedEntity*>& receivers) const
 {
     const Domain* domain = getDomain();
 
     if (isPerceptive()) {
-        receivers.insert(this);
+        receivers.push_back(this);
     }
 
     if (domain) {
-        auto observingEntities = domain->getObservingEntitiesFor(child);
-        receivers.insert(observingEntities.begin(), observingEntities.end());
+        domain->getObservingEntitiesFor(child, receivers);
     }
     if (m_location.m_parent) {
         //If this entity have a movement domain, check if the child entity is visible to the parent entity (i.e. it's "exposed outside of the domain"). If not, the broadcast chain stops here.
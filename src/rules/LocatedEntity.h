@@ -22,6 +22,7 @@
 
 #include "Location.h"
 #include "Modifier.h"
+#include "PropertyTable.h"
 #include "modules/Ref.h"
 #include "modules/ReferenceCounted.h"
 #include "modules/Flags.h"
@@ -53,30 +54,6 @@ class TypeNode;
 template<typename T>
 class Property;
 
-/**
- * Stores a property. Since all properties are modifiable we need to handle modifications.
- */
-struct ModifiableProperty
-{
-    /**
-     * The property.
-     */
-    std::unique_ptr<PropertyBase> property;
-
-    /**
-     * An optional base value, in the case of modifiers being applied.
-     * If so, this value is the "base" value set on the property before any modifiers are applied.
-     */
-    Atlas::Message::Element baseValue;
-
-    /**
-     * A list of optionally modifiers to apply.
-     * If the list contains modifiers, they must be applied together with the baseValue whenever the property is set.
-     * If the list is empty, the baseValue can be ignored and the value can be fetched or set directly on the property.
-     */
-    std::vector<std::pair<Modifier*, LocatedEntity*>> modifiers;
-};
-
 typedef std::set<Ref<LocatedEntity>> LocatedEntitySet;
 
 /// \brief Flag indicating entity has been written to permanent store
@@ -178,7 +155,7 @@ class LocatedEntity : public Router, public ReferenceCounted
 
     protected:
         /// Map of properties
-        std::map<std::string, ModifiableProperty> m_properties;
+        PropertyTable m_properties;
 
         std::map<LocatedEntity*, std::set<std::pair<std::string, Modifier*>>> m_activeModifiers;
 
@@ -196,7 +173,7 @@ class LocatedEntity : public Router, public ReferenceCounted
          * @param op
          * @param res
          */
-        void collectObserversForChild(const LocatedEntity& child, std::set<const LocatedEntity*>& receivers) const;
+        void collectObserversForChild(const LocatedEntity& child, std::vector<const LocatedEntity*>& receivers) const;
 
     public:
 
@@ -264,7 +241,7 @@ class LocatedEntity : public Router, public ReferenceCounted
         { return m_type; }
 
         /// \brief Accessor for properties
-        const std::map<std::string, ModifiableProperty>& getProperties() const
+        const PropertyTable& getProperties() const
         { return m_properties; }
 
         const std::map<LocatedEntity*, std::set<std::pair<std::string, Modifier*>>>& getActiveModifiers() const
@@ -320,6 +297,11 @@ class LocatedEntity : public Router, public ReferenceCounted
 
         const PropertyBase* getProperty(const std::string& name) const;
 
+        /// \brief Get the property object for a given interned property name.
+        ///
+        /// This is faster than looking up by name, and should be used in hot paths.
+        const PropertyBase* getProperty(PropertyId id) const;
+
         PropertyBase* modProperty(const std::string& name, const Atlas::Message::Element& def_val = Atlas::Message::Element());
 
         /// \brief Set the property object for a given attribute
@@ -377,6 +359,14 @@ class LocatedEntity : public Router, public ReferenceCounted
          */
         void collectObservers(std::set<const LocatedEntity*>& observers) const;
 
+        /**
+         * Collects all entities that are observing this entity.
+         *
+         * This avoids the allocations of a set, and allows the same vector to be used for many calls.
+         * @param observers A vector to which the observing entities are added. The whole vector is then sorted, and any duplicates removed.
+         */
+        void collectObservers(std::vector<const LocatedEntity*>& observers) const;
+
         void collectObserved(std::set<const LocatedEntity*>& observed) const;
 
         /**
@@ -389,6 +379,18 @@ class LocatedEntity : public Router, public ReferenceCounted
          */
         void broadcast(const Atlas::Objects::Operation::RootOperation& op, OpVector& res, Visibility visibility) const;
 
+        /**
+         * Broadcasts an op to observers which already have been collected.
+         *
+         * This is useful when broadcasting many ops, since the observers only need to be collected once.
+         * @param op
+         * @param res
+         * @param visibility
+         * @param observers Observers, as collected by collectObservers().
+         */
+        void broadcast(const Atlas::Objects::Operation::RootOperation& op, OpVector& res, Visibility visibility,
+                       const std::vector<const LocatedEntity*>& observers) const;
+
         /**
          * Processes appearance and disappearance of this entity for other observing entities. This is done by matching the supplied list of entities that previously
          * observed the entity. When called, a list of entities that are currently observing it will be created, and the two lists will be compared.
@@ -430,13 +432,25 @@ class LocatedEntity : public Router, public ReferenceCounted
             return nullptr;
         }
 
+        /// \brief Get a property that is required to of a given type.
+        template<class PropertyT>
+        const PropertyT* getPropertyClass(PropertyId id) const
+        {
+            const auto* p = getProperty(id);
+            if (p != nullptr) {
+                return dynamic_cast<const PropertyT*>(p);
+            }
+            return nullptr;
+        }
+
         /// \brief Get a property that is required to of a given type.
         ///
-        /// The specified class must present the "property_name" trait.
+        /// The specified class must present the "property_name" trait, which is
+        /// only resolved to an id once.
         template<class PropertyT>
         const PropertyT* getPropertyClassFixed() const
         {
-            return this->getPropertyClass<PropertyT>(PropertyT::property_name);
+            return this->getPropertyClass<PropertyT>(PropertyIds::idOf<PropertyT>());
         }
 
         /// \brief Get a property that is a generic property of a given type
@@ -450,6 +464,17 @@ class LocatedEntity : public Router, public ReferenceCounted
             return nullptr;
         }
 
+        /// \brief Get a property that is a generic property of a given type
+        template<typename T>
+        const Property<T>* getPropertyType(PropertyId id) const
+        {
+            const auto* p = getProperty(id);
+            if (p != nullptr) {
+                return dynamic_cast<const Property<T>*>(p);
+            }
+            return nullptr;
+        }
+
         /// \brief Get a property that is required to of a given type.
         template<class PropertyT>
         PropertyT* modPropertyClass(const std::string& name)
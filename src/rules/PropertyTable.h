@@ -0,0 +1,171 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_PROPERTYTABLE_H
+#define CYPHESIS_PROPERTYTABLE_H
+
+#include "Modifier.h"
+
+#include "common/Property.h"
+#include "common/PropertyIds.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class LocatedEntity;
+
+/**
+ * Stores a property. Since all properties are modifiable we need to handle modifications.
+ */
+struct ModifiableProperty
+{
+    /**
+     * The property.
+     */
+    std::unique_ptr<PropertyBase> property;
+
+    /**
+     * An optional base value, in the case of modifiers being applied.
+     * If so, this value is the "base" value set on the property before any modifiers are applied.
+     */
+    Atlas::Message::Element baseValue;
+
+    /**
+     * A list of optionally modifiers to apply.
+     * If the list contains modifiers, they must be applied together with the baseValue whenever the property is set.
+     * If the list is empty, the baseValue can be ignored and the value can be fetched or set directly on the property.
+     */
+    std::vector<std::pair<Modifier*, LocatedEntity*>> modifiers;
+
+    /**
+     * The map or list value last sent to observers, if changes to the property are sent as deltas.
+     * Deltas for the next update are created against this value.
+     */
+    Atlas::Message::Element sentValue;
+};
+
+/**
+ * @brief The properties of an entity, which can be looked up both by name and by interned id.
+ *
+ * The properties are kept in a map ordered by name, which is what's used when iterating and for lookups by name.
+ * Alongside the map there's a compact table of interned ids and pointers into the map, sorted by id. Looking up
+ * by id is thus a binary search over a handful of integers, rather than a tree walk with string comparisons.
+ *
+ * All changes must go through this class, so that the two are kept in sync.
+ */
+class PropertyTable
+{
+    public:
+        typedef std::map<std::string, ModifiableProperty> Map;
+        typedef Map::iterator iterator;
+        typedef Map::const_iterator const_iterator;
+        typedef Map::value_type value_type;
+
+        iterator begin()
+        { return m_map.begin(); }
+
+        iterator end()
+        { return m_map.end(); }
+
+        const_iterator begin() const
+        { return m_map.begin(); }
+
+        const_iterator end() const
+        { return m_map.end(); }
+
+        size_t size() const
+        { return m_map.size(); }
+
+        bool empty() const
+        { return m_map.empty(); }
+
+        iterator find(const std::string& name)
+        { return m_map.find(name); }
+
+        const_iterator find(const std::string& name) const
+        { return m_map.find(name); }
+
+        /**
+         * @brief Finds a property by id.
+         * @return A pointer to the entry, or null if there's none.
+         */
+        ModifiableProperty* find(PropertyId id)
+        {
+            auto I = lowerBound(id);
+            return (I != m_slots.end() && I->first == id) ? I->second : nullptr;
+        }
+
+        const ModifiableProperty* find(PropertyId id) const
+        {
+            return const_cast<PropertyTable*>(this)->find(id);
+        }
+
+        /**
+         * @brief Gets the entry for a name, inserting an empty one if there's none.
+         */
+        ModifiableProperty& operator[](const std::string& name)
+        {
+            auto result = m_map.emplace(name, ModifiableProperty());
+            if (result.second) {
+                auto id = PropertyIds::intern(name);
+                m_slots.emplace(lowerBound(id), id, &result.first->second);
+            }
+            return result.first->second;
+        }
+
+        iterator erase(const_iterator I)
+        {
+            auto id = PropertyIds::intern(I->first);
+            auto J = lowerBound(id);
+            if (J != m_slots.end() && J->first == id) {
+                m_slots.erase(J);
+            }
+            return m_map.erase(I);
+        }
+
+        size_t erase(const std::string& name)
+        {
+            auto I = m_map.find(name);
+            if (I == m_map.end()) {
+                return 0;
+            }
+            erase(I);
+            return 1;
+        }
+
+    private:
+        typedef std::vector<std::pair<PropertyId, ModifiableProperty*>> Slots;
+
+        Map m_map;
+
+        /**
+         * Pointers to the entries in the map, sorted by id. Pointers to map entries are stable until erased.
+         */
+        Slots m_slots;
+
+        Slots::iterator lowerBound(PropertyId id)
+        {
+            return std::lower_bound(m_slots.begin(), m_slots.end(), id,
+                                    [](const Slots::value_type& entry, PropertyId value) { return entry.first < value; });
+        }
+};
+
+#endif //CYPHESIS_PROPERTYTABLE_H
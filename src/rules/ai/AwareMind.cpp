@@ -28,6 +28,7 @@
 
 #include "navigation/Awareness.h"
 #include "navigation/Steering.h"
+#include "navigation/Crowd.h"
 
 #include "common/operations/Tick.h"
 #include "common/debug.h"
@@ -42,6 +43,11 @@
 
 static const bool debug_flag = false;
 
+/**
+ * The max number of full path searches done each move tick. Any further path requests are handled in later ticks.
+ */
+static const size_t PATH_SEARCHES_PER_TICK = 4;
+
 AwareMind::AwareMind(const std::string& mind_id,
                      std::string entity_id,
                      const PropertyManager& propertyManager,
@@ -65,6 +71,9 @@ AwareMind::~AwareMind()
             }
         }
         mAwareness->removeAwarenessArea(getId());
+        if (mSteering) {
+            mAwareness->getCrowd().removeAgent(*mSteering);
+        }
         mAwareness->removeObserver();
     }
 }
@@ -100,7 +109,8 @@ void AwareMind::processMoveTick(const Operation& op, OpVector& res)
     if (mAwareness) {
         auto remainingDirtyTiles = mAwareness->rebuildDirtyTile();
         if (remainingDirtyTiles > 0) {
-            futureTick = 0;
+            //If tiles are being built in the background there's no need to check right away; poll a bit later instead.
+            futureTick = mAwareness->getTileBuildsInProgress() > 0 ? 0.05 : 0;
         } else {
             if (mAwareness->needsPruning()) {
                 mAwareness->pruneTiles();
@@ -109,10 +119,19 @@ void AwareMind::processMoveTick(const Operation& op, OpVector& res)
                 futureTick = 0;
             }
         }
+        mAwareness->processPathRequests(PATH_SEARCHES_PER_TICK);
     }
 
     if (mSteering) {
-        SteeringResult result = mSteering->update(op->getSeconds());
+        SteeringResult result;
+        if (mAwareness) {
+            //All minds sharing the awareness are stepped together, by whichever mind first gets a tick.
+            auto& crowd = mAwareness->getCrowd();
+            crowd.update(op->getSeconds());
+            result = crowd.takeResult(*mSteering);
+        } else {
+            result = mSteering->update(op->getSeconds());
+        }
         if (result.direction.isValid()) {
             Atlas::Objects::Operation::Move move;
             Atlas::Objects::Entity::Anonymous what;
@@ -146,6 +165,10 @@ void AwareMind::processMoveTick(const Operation& op, OpVector& res)
         if (result.timeToNextWaypoint) {
             futureTick = std::min(*result.timeToNextWaypoint, futureTick);
         }
+        //Check back soon for the requested path.
+        if (mSteering->isPathRequestPending()) {
+            futureTick = std::min(0.05, futureTick);
+        }
     }
 
     Atlas::Objects::Operation::Tick tick;
@@ -215,6 +238,7 @@ void AwareMind::requestAwareness(const MemEntity& entity)
         }
     }
     mSteering->setAwareness(mAwareness.get());
+    mAwareness->getCrowd().addAgent(*mSteering);
 }
 
 void AwareMind::entityUpdated(MemEntity& entity, const Atlas::Objects::Entity::RootEntity& ent, LocatedEntity* oldLocation)
@@ -322,7 +346,16 @@ void AwareMind::setOwnEntity(OpVector& res, Ref<MemEntity> ownEntity)
 {
     BaseMind::setOwnEntity(res, ownEntity);
 
+    if (mAwareness && mSteering) {
+        mAwareness->getCrowd().removeAgent(*mSteering);
+    }
     mSteering = std::make_unique<Steering>(*ownEntity);
+    //Many minds can share the same awareness, so let them queue their path searches rather than all doing them at once.
+    mSteering->setBatchPathRequests(true);
+    if (mAwareness) {
+        mSteering->setAwareness(mAwareness.get());
+        mAwareness->getCrowd().addAgent(*mSteering);
+    }
     mAwarenessStore = &mAwarenessStoreProvider.getStore(ownEntity->getType());
 
     //Start the move ticks
@@ -0,0 +1,148 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "LocationIndex.h"
+
+#include "rules/LocatedEntity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+LocationIndex::LocationIndex(WFMath::CoordType cellSize)
+        : m_cellSize(cellSize)
+{
+}
+
+std::int32_t LocationIndex::cellCoord(WFMath::CoordType coord) const
+{
+    auto cell = std::floor(coord / m_cellSize);
+    if (cell <= std::numeric_limits<std::int32_t>::min()) {
+        return std::numeric_limits<std::int32_t>::min();
+    } else if (cell >= std::numeric_limits<std::int32_t>::max()) {
+        return std::numeric_limits<std::int32_t>::max();
+    }
+    return static_cast<std::int32_t>(cell);
+}
+
+LocationIndex::CellKey LocationIndex::cellKey(std::int32_t x, std::int32_t z)
+{
+    return static_cast<CellKey>((static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(z));
+}
+
+void LocationIndex::update(LocatedEntity& entity)
+{
+    auto parent = entity.m_location.m_parent.get();
+    auto& pos = entity.m_location.pos();
+    auto I = m_placements.find(&entity);
+
+    if (!parent || !pos.isValid() || !std::isfinite(pos.x()) || !std::isfinite(pos.z())) {
+        if (I != m_placements.end()) {
+            removePlacement(entity, I->second);
+            m_placements.erase(I);
+        }
+        return;
+    }
+
+    auto cell = cellKey(cellCoord(pos.x()), cellCoord(pos.z()));
+    if (I != m_placements.end()) {
+        if (I->second.parent == parent && I->second.cell == cell) {
+            return;
+        }
+        removePlacement(entity, I->second);
+        I->second = Placement{parent, cell};
+    } else {
+        m_placements.emplace(&entity, Placement{parent, cell});
+    }
+    m_grids[parent][cell].push_back(&entity);
+}
+
+void LocationIndex::remove(LocatedEntity& entity)
+{
+    auto I = m_placements.find(&entity);
+    if (I != m_placements.end()) {
+        removePlacement(entity, I->second);
+        m_placements.erase(I);
+    }
+}
+
+void LocationIndex::removePlacement(LocatedEntity& entity, const Placement& placement)
+{
+    auto gridI = m_grids.find(placement.parent);
+    if (gridI == m_grids.end()) {
+        return;
+    }
+    auto& grid = gridI->second;
+    auto cellI = grid.find(placement.cell);
+    if (cellI == grid.end()) {
+        return;
+    }
+    auto& entities = cellI->second;
+    auto entityI = std::find(entities.begin(), entities.end(), &entity);
+    if (entityI != entities.end()) {
+        *entityI = entities.back();
+        entities.pop_back();
+    }
+    //Remove empty cells and grids, so that no grid is left for a parent which has been destroyed.
+    if (entities.empty()) {
+        grid.erase(cellI);
+        if (grid.empty()) {
+            m_grids.erase(gridI);
+        }
+    }
+}
+
+void LocationIndex::clear()
+{
+    m_grids.clear();
+    m_placements.clear();
+}
+
+void LocationIndex::findCandidates(const LocatedEntity& parent, const WFMath::Point<3>& pos, WFMath::CoordType radius,
+                                   std::vector<LocatedEntity*>& candidates) const
+{
+    auto gridI = m_grids.find(&parent);
+    if (gridI == m_grids.end()) {
+        return;
+    }
+    auto& grid = gridI->second;
+
+    auto minX = cellCoord(pos.x() - radius);
+    auto maxX = cellCoord(pos.x() + radius);
+    auto minZ = cellCoord(pos.z() - radius);
+    auto maxZ = cellCoord(pos.z() + radius);
+
+    //If the radius covers more cells than there are in the grid it's quicker to look at all of them.
+    auto width = static_cast<std::uint64_t>(static_cast<std::int64_t>(maxX) - minX + 1);
+    auto depth = static_cast<std::uint64_t>(static_cast<std::int64_t>(maxZ) - minZ + 1);
+    if (width >= grid.size() || depth >= grid.size() || width * depth >= grid.size()) {
+        for (auto& entry : grid) {
+            candidates.insert(candidates.end(), entry.second.begin(), entry.second.end());
+        }
+        return;
+    }
+
+    for (std::int64_t x = minX; x <= maxX; ++x) {
+        for (std::int64_t z = minZ; z <= maxZ; ++z) {
+            auto I = grid.find(cellKey(static_cast<std::int32_t>(x), static_cast<std::int32_t>(z)));
+            if (I != grid.end()) {
+                candidates.insert(candidates.end(), I->second.begin(), I->second.end());
+            }
+        }
+    }
+}
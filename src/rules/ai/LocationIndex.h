@@ -0,0 +1,99 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_LOCATIONINDEX_H
+#define CYPHESIS_LOCATIONINDEX_H
+
+#include <wfmath/point.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class LocatedEntity;
+
+/**
+ * @brief Keeps track of where entities are, so that the ones close to a position can be found without looking at all of them.
+ *
+ * The children of each parent entity are kept in a uniform grid of cells along the horizontal plane (i.e. "x" and "z").
+ * Entities without a valid position aren't indexed.
+ *
+ * The index doesn't hold references to the entities, so they must be removed before they are destroyed.
+ */
+class LocationIndex
+{
+    public:
+        explicit LocationIndex(WFMath::CoordType cellSize = 32);
+
+        /**
+         * @brief Updates the index after the parent or position of an entity has changed.
+         */
+        void update(LocatedEntity& entity);
+
+        /**
+         * @brief Removes an entity from the cell it's placed in under its parent.
+         *
+         * Any children of the entity are kept in the index; they must be removed separately.
+         */
+        void remove(LocatedEntity& entity);
+
+        void clear();
+
+        /**
+         * @brief Finds the children of a parent which might be within a radius of a position.
+         *
+         * All children within the radius are found, but so may children just outside of it, as whole cells are searched.
+         * @param parent The parent entity.
+         * @param pos A position relative to the parent.
+         * @param radius The radius.
+         * @param candidates Filled with the children found.
+         */
+        void findCandidates(const LocatedEntity& parent, const WFMath::Point<3>& pos, WFMath::CoordType radius,
+                            std::vector<LocatedEntity*>& candidates) const;
+
+        size_t getEntityCount() const
+        {
+            return m_placements.size();
+        }
+
+    private:
+        typedef std::int64_t CellKey;
+        typedef std::unordered_map<CellKey, std::vector<LocatedEntity*>> Grid;
+
+        struct Placement
+        {
+            const LocatedEntity* parent;
+            CellKey cell;
+        };
+
+        WFMath::CoordType m_cellSize;
+
+        std::unordered_map<const LocatedEntity*, Grid> m_grids;
+
+        std::unordered_map<const LocatedEntity*, Placement> m_placements;
+
+        std::int32_t cellCoord(WFMath::CoordType coord) const;
+
+        static CellKey cellKey(std::int32_t x, std::int32_t z);
+
+        void removePlacement(LocatedEntity& entity, const Placement& placement);
+};
+
+
+#endif //CYPHESIS_LOCATIONINDEX_H
@@ -31,6 +31,8 @@
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Anonymous.h>
 
+#include <algorithm>
+
 static const bool debug_flag = false;
 
 using Atlas::Message::Element;
@@ -82,6 +84,9 @@ void MemMap::readEntity(const Ref<MemEntity>& entity, const RootEntity& ent, dou
     if (has_location_data) {
         entity->m_location.update(timestamp);
     }
+    if (has_location_data || ent->hasAttrFlag(Atlas::Objects::Entity::LOC_FLAG)) {
+        m_locationIndex.update(*entity);
+    }
 
     if (ent->hasAttrFlag(Atlas::Objects::PARENT_FLAG)) {
         auto& parent = ent->getParent();
@@ -208,6 +213,7 @@ Ref<MemEntity> MemMap::del(const std::string& id)
             next = m_checkIterator->first;
         }
         m_entities.erase(I);
+        m_locationIndex.remove(*ent);
 
 
         if (next != -1) {
@@ -381,14 +387,47 @@ EntityVector MemMap::findByType(const std::string& what)
     return res;
 }
 
+template<typename Filter>
+EntityVector MemMap::findInRadius(const EntityLocation& loc, WFMath::CoordType radius, const Filter& filter) const
+{
+    EntityVector res;
+    auto& place = *loc.m_parent;
+    if (place.m_contains == nullptr) {
+        return res;
+    }
+
+    WFMath::CoordType square_range = radius * radius;
+    auto isMatch = [&](LocatedEntity* item) {
+        return item->isVisible() && filter(*item) && squareDistance(loc.pos(), item->m_location.pos()) < square_range;
+    };
+
+    //Only entities with a position are in the index, and without a position to search from all of them need to be looked at.
+    if (loc.pos().isValid()) {
+        m_locationIndex.findCandidates(place, loc.pos(), radius, res);
+        res.erase(std::remove_if(res.begin(), res.end(), [&](LocatedEntity* item) { return !isMatch(item); }), res.end());
+        return res;
+    }
+
+    for (auto& item : *place.m_contains) {
+        assert(item != nullptr);
+        if (!item) {
+            log(ERROR, "Weird entity in memory");
+            continue;
+        }
+        if (isMatch(item.get())) {
+            res.push_back(item.get());
+        }
+    }
+    return res;
+}
+
 EntityVector MemMap::findByLocation(const EntityLocation& loc,
                                     WFMath::CoordType radius,
                                     const std::string& what)
 {
-    EntityVector res;
     auto place = loc.m_parent;
     if (place->m_contains == nullptr) {
-        return res;
+        return {};
     }
 #ifndef NDEBUG
     auto place_by_id = get(place->getId());
@@ -397,29 +436,21 @@ EntityVector MemMap::findByLocation(const EntityLocation& loc,
                            "has LOC %1 which is different in dict (%2)",
                            place->describeEntity(),
                            place_by_id->describeEntity()));
-        return res;
+        return {};
     }
 #endif // NDEBUG
 
-    WFMath::CoordType square_range = radius * radius;
-    for (auto& item : *place->m_contains) {
-        assert(item != nullptr);
-        if (!item) {
-            log(ERROR, "Weird entity in memory");
-            continue;
-        }
-        if (!item->isVisible()) {
-            continue;
-        }
+    //Types are unique by name, so they can be compared by pointer. Entities without a type are always included.
+    auto type = getTypeStore().getType(what);
+    return findInRadius(loc, radius, [type](const LocatedEntity& item) {
+        return !item.getType() || item.getType() == type;
+    });
+}
 
-        if (item->getType() && item->getType()->name() != what) {
-            continue;
-        }
-        if (squareDistance(loc.pos(), item->m_location.pos()) < square_range) {
-            res.push_back(item.get());
-        }
-    }
-    return res;
+EntityVector MemMap::findByLocation(const EntityLocation& loc,
+                                    WFMath::CoordType radius) const
+{
+    return findInRadius(loc, radius, [](const LocatedEntity&) { return true; });
 }
 
 void MemMap::check(const double& time)
@@ -433,6 +464,7 @@ void MemMap::check(const double& time)
         if (me->getType() && !me->isVisible() && (time - me->lastSeen()) > 600 &&
             (me->m_contains == nullptr || me->m_contains->empty())) {
             m_checkIterator = m_entities.erase(m_checkIterator);
+            m_locationIndex.remove(*me);
 
             if (me->m_location.m_parent) {
                 me->m_location.m_parent->removeChild(*me);
@@ -454,6 +486,7 @@ void MemMap::flush()
                                         << " entities and " << m_entityRelatedMemory.size() << " entity memories.")
     m_entities.clear();
     m_entityRelatedMemory.clear();
+    m_locationIndex.clear();
 }
 
 void MemMap::setListener(MapListener* listener)
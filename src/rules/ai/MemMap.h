@@ -19,6 +19,8 @@
 #ifndef RULESETS_MEM_MAP_H
 #define RULESETS_MEM_MAP_H
 
+#include "LocationIndex.h"
+
 #include "common/OperationRouter.h"
 
 #include "rules/MemEntity.h"
@@ -84,6 +86,9 @@ class MemMap
 
         OpVector m_typeResolverOps;
 
+        ///\brief an index of the entities by their location, kept up to date as entities are read and removed
+        LocationIndex m_locationIndex;
+
         void readEntity(const Ref<MemEntity>&, const Atlas::Objects::Entity::RootEntity&, double timestamp);
 
         void updateEntity(const Ref<MemEntity>&, const Atlas::Objects::Entity::RootEntity&, double timestamp);
@@ -97,6 +102,9 @@ class MemMap
 
         void applyTypePropertiesToEntity(const Ref<MemEntity>& entity);
 
+        template<typename Filter>
+        EntityVector findInRadius(const EntityLocation& where, WFMath::CoordType radius, const Filter& filter) const;
+
     public:
 
         explicit MemMap(TypeResolver& typeResolver);
@@ -155,6 +163,10 @@ class MemMap
                                     WFMath::CoordType radius,
                                     const std::string& what);
 
+        ///\brief Find all visible entities within a radius of a location
+        EntityVector findByLocation(const EntityLocation& where,
+                                    WFMath::CoordType radius) const;
+
         void check(const double&);
 
         void flush();
@@ -122,14 +122,25 @@ Py::Object CyPy_BaseMind::matchEntities(const Py::Tuple& args)
     auto& filter = verifyObject<CyPy_Filter>(args.getItem(0));
     auto entities = verifyList(args.getItem(1));
     Py::List list;
+    if (entities.length() == 0) {
+        return list;
+    }
 
+    std::vector<LocatedEntity*> matches;
+    std::map<LocatedEntity*, Py::Object> wrappers;
     for (auto entity : entities) {
-        EntityFilter::QueryContext queryContext = CyPy_MemMap::createFilterContext(verifyObject<CyPy_LocatedEntity>(entity).get(), m_value->getMap());
-        queryContext.actor = m_value->getEntity().get();
+        auto locatedEntity = verifyObject<CyPy_LocatedEntity>(entity).get();
+        matches.push_back(locatedEntity);
+        wrappers.emplace(locatedEntity, entity);
+    }
 
-        if (filter->match(queryContext)) {
-            list.append(entity);
-        }
+    EntityFilter::QueryContext queryContext = CyPy_MemMap::createFilterContext(matches.front(), m_value->getMap());
+    queryContext.actor = m_value->getEntity().get();
+    filter->matchAll(matches, queryContext);
+
+    //Return the same Python objects as were passed in.
+    for (auto entity : matches) {
+        list.append(wrappers.find(entity)->second);
     }
 
     return list;
@@ -190,12 +190,21 @@ Py::Object CyPy_MemMap::find_by_filter(const Py::Tuple& args)
 
     Py::List list;
 
-    for (auto& entry : m_value->getEntities()) {
-        EntityFilter::QueryContext queryContext = createFilterContext(entry.second.get(), m_value);
+    auto& entities = m_value->getEntities();
+    if (entities.empty()) {
+        return list;
+    }
 
-        if (filter->match(queryContext)) {
-            list.append(CyPy_MemEntity::wrap(entry.second.get()));
-        }
+    //Match all entities in one go; the entity of the context is replaced with each one matched.
+    std::vector<LocatedEntity*> matches;
+    matches.reserve(entities.size());
+    for (auto& entry : entities) {
+        matches.push_back(entry.second.get());
+    }
+    filter->matchAll(matches, createFilterContext(matches.front(), m_value));
+
+    for (auto entity : matches) {
+        list.append(CyPy_MemEntity::wrap(static_cast<MemEntity*>(entity)));
     }
     return list;
 }
@@ -213,19 +222,13 @@ Py::Object CyPy_MemMap::find_by_location_query(const Py::Tuple& args)
         throw Py::RuntimeError("Location is incomplete");
     }
 
-    //Create a vector and fill it with entities that match the given filter and are in range
-    float square_range = radius * radius;
-
+    //Look up the entities in range first, and then match them all against the filter.
     Py::List list;
-    if (location.m_parent && location.m_parent->m_contains) {
-        for (const auto& entry : *location.m_parent->m_contains) {
-            EntityFilter::QueryContext queryContext = createFilterContext(entry.get(), m_value);
-
-            if (entry->isVisible() && filter->match(queryContext)) {
-                if (squareDistance(location.pos(), entry->m_location.pos()) < square_range) {
-                    list.append(CyPy_LocatedEntity::wrap(entry));
-                }
-            }
+    auto entities = m_value->findByLocation(location, radius);
+    if (!entities.empty()) {
+        filter->matchAll(entities, createFilterContext(entities.front(), m_value));
+        for (auto entity : entities) {
+            list.append(CyPy_LocatedEntity::wrap(entity));
         }
     }
 
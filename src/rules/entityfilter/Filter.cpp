@@ -1,5 +1,6 @@
 #include "Filter.h"
 #include "ParserDefinitions.h"
+#include "Program.h"
 
 using namespace boost;
 namespace qi = boost::spirit::qi;
@@ -24,16 +25,26 @@ namespace EntityFilter {
             auto parsedPart = what.substr(0, iter_begin - what.begin());
             throw std::invalid_argument(String::compose("Attempted creating entity filter with invalid query. Query was '%1'.\n Parser error was at '%2'", what, parsedPart));
         }
+        m_program = std::make_shared<Program>(*m_predicate);
     }
 
     Filter::~Filter() = default;
 
     bool Filter::match(const QueryContext& context) const
     {
+        return m_program->run(context);
+    }
 
+    bool Filter::matchInterpreted(const QueryContext& context) const
+    {
         return m_predicate->isMatch(context);
     }
 
+    void Filter::matchAll(std::vector<LocatedEntity*>& entities, const QueryContext& context) const
+    {
+        m_program->runAll(entities, context);
+    }
+
     const std::string& Filter::getDeclaration() const
     {
         return m_declaration;
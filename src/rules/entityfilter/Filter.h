@@ -3,6 +3,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 
 class LocatedEntity;
 ///\brief This class is used to perform matches against an entity.
@@ -13,6 +14,8 @@ namespace EntityFilter {
 
     class Predicate;
 
+    class Program;
+
     class Filter
     {
         public:
@@ -26,12 +29,26 @@ namespace EntityFilter {
             ///\brief test given QueryContext for a match
             bool match(const QueryContext& context) const;
 
+            ///\brief test given QueryContext for a match, by evaluating the predicates directly rather than the compiled program
+            ///
+            ///This always gives the same result as match(), but is slower. Mainly useful for tests and benchmarks.
+            bool matchInterpreted(const QueryContext& context) const;
+
+            ///\brief test a collection of entities for matches, removing those which don't match
+            ///
+            ///This is faster than calling match() for each entity, since conditions which all entities must fulfill are checked for all of them at once.
+            ///@param entities the entities to test
+            ///@param context used for all entities, except that its entity and position are ignored
+            void matchAll(std::vector<LocatedEntity*>& entities, const QueryContext& context) const;
+
             const std::string& getDeclaration() const;
 
         private:
             const std::string m_declaration;
             //The top predicate node used for testing
             std::shared_ptr<Predicate> m_predicate;
+            //The predicates compiled into a program, which is what's used when matching
+            std::shared_ptr<Program> m_program;
     };
 }
 #endif
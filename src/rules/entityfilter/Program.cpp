@@ -0,0 +1,648 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "Program.h"
+#include "Providers.h"
+
+#include "common/Property.h"
+#include "common/TypeNode.h"
+
+#include <algorithm>
+#include <limits>
+#include <typeinfo>
+
+using Atlas::Message::Element;
+
+namespace EntityFilter {
+
+    namespace {
+        const Element none;
+
+        bool compareNumbers(ComparePredicate::Comparator comparator, double left, double right)
+        {
+            switch (comparator) {
+                case ComparePredicate::Comparator::LESS:
+                    return left < right;
+                case ComparePredicate::Comparator::LESS_EQUAL:
+                    return left <= right;
+                case ComparePredicate::Comparator::GREATER:
+                    return left > right;
+                case ComparePredicate::Comparator::GREATER_EQUAL:
+                    return left >= right;
+                default:
+                    return false;
+            }
+        }
+
+        bool isNumeric(ComparePredicate::Comparator comparator)
+        {
+            return comparator == ComparePredicate::Comparator::LESS
+                   || comparator == ComparePredicate::Comparator::LESS_EQUAL
+                   || comparator == ComparePredicate::Comparator::GREATER
+                   || comparator == ComparePredicate::Comparator::GREATER_EQUAL;
+        }
+
+        /**
+         * Reads a property directly if it's of one of the numeric classes, to avoid going through an Element.
+         */
+        template<typename T>
+        bool readNumber(const PropertyBase& prop, double& number)
+        {
+            if (typeid(prop) == typeid(Property<T>)) {
+                number = static_cast<double>(static_cast<const Property<T>&>(prop).data());
+                return true;
+            }
+            return false;
+        }
+    }
+
+    Program::Program(const Predicate& predicate)
+            : m_interpretedCount(0),
+              m_guardsEnd(0)
+    {
+        emitFolded(compile(predicate));
+        findGuards();
+    }
+
+    std::uint32_t Program::emit(OpCode opCode, std::uint32_t arg1, std::uint32_t arg2, ComparePredicate::Comparator comparator)
+    {
+        m_instructions.push_back(Instruction{opCode, comparator, arg1, arg2});
+        return static_cast<std::uint32_t>(m_instructions.size() - 1);
+    }
+
+    void Program::emitFolded(Folded folded)
+    {
+        if (folded != Folded::NOT_FOLDED) {
+            emit(OpCode::CONSTANT, folded == Folded::MATCH ? 1 : 0);
+        }
+    }
+
+    Program::Folded Program::interpret(const Predicate& predicate)
+    {
+        m_predicates.push_back(&predicate);
+        emit(OpCode::INTERPRET, static_cast<std::uint32_t>(m_predicates.size() - 1));
+        m_interpretedCount++;
+        return Folded::NOT_FOLDED;
+    }
+
+    Program::Folded Program::compile(const Predicate& predicate)
+    {
+        //Only the exact classes are compiled, since a subclass could behave differently.
+        auto& type = typeid(predicate);
+        if (type == typeid(AndPredicate)) {
+            auto& andPredicate = static_cast<const AndPredicate&>(predicate);
+            return compileLogical(*andPredicate.m_lhs, *andPredicate.m_rhs, true);
+        } else if (type == typeid(OrPredicate)) {
+            auto& orPredicate = static_cast<const OrPredicate&>(predicate);
+            return compileLogical(*orPredicate.m_lhs, *orPredicate.m_rhs, false);
+        } else if (type == typeid(NotPredicate)) {
+            auto folded = compile(*static_cast<const NotPredicate&>(predicate).m_pred);
+            if (folded == Folded::MATCH) {
+                return Folded::NO_MATCH;
+            } else if (folded == Folded::NO_MATCH) {
+                return Folded::MATCH;
+            }
+            emit(OpCode::NOT);
+            return Folded::NOT_FOLDED;
+        } else if (type == typeid(DescribePredicate)) {
+            auto& describePredicate = static_cast<const DescribePredicate&>(predicate);
+            auto folded = compile(*describePredicate.m_predicate);
+            if (folded == Folded::MATCH) {
+                return Folded::MATCH;
+            }
+            //A predicate which never matches still needs to report every time.
+            emitFolded(folded);
+            m_descriptions.push_back(describePredicate.m_description);
+            emit(OpCode::DESCRIBE, static_cast<std::uint32_t>(m_descriptions.size() - 1));
+            return Folded::NOT_FOLDED;
+        } else if (type == typeid(BoolPredicate)) {
+            auto& consumer = static_cast<const BoolPredicate&>(predicate).m_consumer;
+            if (!consumer) {
+                return Folded::NO_MATCH;
+            }
+            auto operand = compileOperand(*consumer);
+            if (m_operands[operand].source == Source::CONSTANT) {
+                auto& value = m_operands[operand].constant;
+                auto result = value.isInt() && value.Int() != 0;
+                m_operands.pop_back();
+                return result ? Folded::MATCH : Folded::NO_MATCH;
+            }
+            emit(OpCode::TEST, operand);
+            return Folded::NOT_FOLDED;
+        } else if (type == typeid(ComparePredicate)) {
+            return compileCompare(static_cast<const ComparePredicate&>(predicate));
+        }
+        return interpret(predicate);
+    }
+
+    Program::Folded Program::compileLogical(const Predicate& lhs, const Predicate& rhs, bool isAnd)
+    {
+        auto shortCircuit = isAnd ? Folded::NO_MATCH : Folded::MATCH;
+        auto left = compile(lhs);
+        if (left == shortCircuit) {
+            return left;
+        } else if (left != Folded::NOT_FOLDED) {
+            return compile(rhs);
+        }
+        auto jump = emit(isAnd ? OpCode::JUMP_IF_FALSE : OpCode::JUMP_IF_TRUE);
+        auto right = compile(rhs);
+        if (right == Folded::NOT_FOLDED) {
+            m_instructions[jump].arg1 = static_cast<std::uint32_t>(m_instructions.size());
+        } else if (right == shortCircuit) {
+            //The result is known, but the left side still needs to run in case it reports anything.
+            m_instructions[jump] = Instruction{OpCode::CONSTANT, ComparePredicate::Comparator::EQUALS, right == Folded::MATCH ? 1u : 0u, 0};
+        } else {
+            //The right side doesn't affect the result.
+            m_instructions.pop_back();
+        }
+        return Folded::NOT_FOLDED;
+    }
+
+    Program::Folded Program::compileCompare(const ComparePredicate& predicate)
+    {
+        if (predicate.m_comparator == ComparePredicate::Comparator::CAN_REACH) {
+            return interpret(predicate);
+        }
+        auto lhs = compileOperand(*predicate.m_lhs);
+        auto rhs = compileOperand(*predicate.m_rhs);
+        if (m_operands[lhs].source == Source::CONSTANT && m_operands[rhs].source == Source::CONSTANT) {
+            auto result = compare(predicate.m_comparator, m_operands[lhs].constant, m_operands[rhs].constant);
+            m_operands.pop_back();
+            m_operands.pop_back();
+            return result ? Folded::MATCH : Folded::NO_MATCH;
+        }
+        emit(isNumeric(predicate.m_comparator) ? OpCode::COMPARE_NUMBER : OpCode::COMPARE, lhs, rhs, predicate.m_comparator);
+        return Folded::NOT_FOLDED;
+    }
+
+    std::uint32_t Program::compileOperand(const Consumer<QueryContext>& consumer)
+    {
+        Operand operand{Source::INTERPRETED, Access::NOTHING, 0, {}, {}, &consumer};
+
+        auto& type = typeid(consumer);
+        const std::shared_ptr<Consumer<LocatedEntity>>* entityConsumer = nullptr;
+        if (type == typeid(FixedElementProvider)) {
+            operand.source = Source::CONSTANT;
+            operand.constant = static_cast<const FixedElementProvider&>(consumer).m_element;
+        } else if (type == typeid(FixedTypeNodeProvider)) {
+            auto& provider = static_cast<const FixedTypeNodeProvider&>(consumer);
+            if (!provider.getConsumer()) {
+                operand.source = Source::CONSTANT;
+                operand.constant = static_cast<Atlas::Message::PtrType>(const_cast<TypeNode*>(&provider.m_type));
+            }
+        } else if (type == typeid(DynamicTypeNodeProvider)) {
+            auto& provider = static_cast<const DynamicTypeNodeProvider&>(consumer);
+            if (!provider.getConsumer()) {
+                operand.source = Source::TYPE_LOOKUP;
+                operand.constant = provider.m_type;
+            }
+        } else if (type == typeid(EntityProvider)) {
+            operand.source = Source::ENTITY;
+            entityConsumer = &static_cast<const EntityProvider&>(consumer).getConsumer();
+        } else if (type == typeid(EntityLocationProvider)) {
+            //Without a consumer this provides the location, which isn't handled here.
+            auto& provider = static_cast<const EntityLocationProvider&>(consumer);
+            if (provider.getConsumer()) {
+                operand.source = Source::ENTITY;
+                entityConsumer = &provider.getConsumer();
+            }
+        } else if (type == typeid(ActorProvider)) {
+            operand.source = Source::ACTOR;
+            entityConsumer = &static_cast<const ActorProvider&>(consumer).getConsumer();
+        } else if (type == typeid(ToolProvider)) {
+            operand.source = Source::TOOL;
+            entityConsumer = &static_cast<const ToolProvider&>(consumer).getConsumer();
+        } else if (type == typeid(ChildProvider)) {
+            operand.source = Source::CHILD;
+            entityConsumer = &static_cast<const ChildProvider&>(consumer).getConsumer();
+        } else if (type == typeid(SelfEntityProvider)) {
+            operand.source = Source::SELF;
+            entityConsumer = &static_cast<const SelfEntityProvider&>(consumer).getConsumer();
+        }
+
+        if (entityConsumer) {
+            auto& entityProvider = *entityConsumer;
+            if (!entityProvider) {
+                operand.access = Access::POINTER;
+            } else {
+                auto& providerType = typeid(*entityProvider);
+                if (providerType == typeid(SoftPropertyProvider)) {
+                    auto& provider = static_cast<const SoftPropertyProvider&>(*entityProvider);
+                    operand.access = Access::PROPERTY;
+                    operand.propertyId = PropertyIds::intern(provider.getAttributeName());
+                    auto next = provider.getConsumer().get();
+                    while (next) {
+                        if (typeid(*next) != typeid(MapProvider)) {
+                            operand.source = Source::INTERPRETED;
+                            break;
+                        }
+                        auto mapProvider = static_cast<const MapProvider*>(next);
+                        operand.path.push_back(mapProvider->getAttributeName());
+                        next = mapProvider->getConsumer().get();
+                    }
+                } else if (providerType == typeid(EntityTypeProvider)) {
+                    auto& typeProvider = static_cast<const EntityTypeProvider&>(*entityProvider).getConsumer();
+                    if (!typeProvider) {
+                        operand.access = Access::TYPE;
+                    } else if (typeid(*typeProvider) == typeid(TypeNodeProvider)) {
+                        auto& attribute = static_cast<const TypeNodeProvider&>(*typeProvider).m_attribute_name;
+                        operand.access = attribute == "name" ? Access::TYPE_NAME : Access::NOTHING;
+                    } else {
+                        operand.source = Source::INTERPRETED;
+                    }
+                } else if (providerType == typeid(EntityIdProvider)) {
+                    operand.access = Access::ID;
+                } else {
+                    operand.source = Source::INTERPRETED;
+                }
+            }
+        }
+
+        if (operand.source == Source::INTERPRETED) {
+            m_interpretedCount++;
+        }
+        m_operands.push_back(std::move(operand));
+        return static_cast<std::uint32_t>(m_operands.size() - 1);
+    }
+
+    const LocatedEntity* Program::sourceEntity(const Operand& operand, const LocatedEntity& matched, const QueryContext& context) const
+    {
+        switch (operand.source) {
+            case Source::ENTITY:
+                return &matched;
+            case Source::ACTOR:
+                return context.actor;
+            case Source::TOOL:
+                return context.tool;
+            case Source::CHILD:
+                return context.child;
+            case Source::SELF:
+                return context.self_entity;
+            default:
+                return nullptr;
+        }
+    }
+
+    const Element& Program::load(const Operand& operand, const LocatedEntity& matched, const QueryContext& context, Element& scratch) const
+    {
+        if (operand.source == Source::CONSTANT) {
+            return operand.constant;
+        } else if (operand.source == Source::TYPE_LOOKUP) {
+            if (!context.type_lookup_fn) {
+                return none;
+            }
+            scratch = static_cast<Atlas::Message::PtrType>(const_cast<TypeNode*>(context.type_lookup_fn(operand.constant.String())));
+            return scratch;
+        } else if (operand.source == Source::INTERPRETED) {
+            scratch = Element();
+            operand.consumer->value(scratch, context);
+            return scratch;
+        }
+
+        auto entity = sourceEntity(operand, matched, context);
+        if (!entity) {
+            //Mirror the providers, where all but the one for "self" provide a null pointer if there's no entity.
+            if (operand.source == Source::SELF) {
+                return none;
+            }
+            scratch = static_cast<Atlas::Message::PtrType>(nullptr);
+            return scratch;
+        }
+
+        switch (operand.access) {
+            case Access::POINTER:
+                scratch = static_cast<Atlas::Message::PtrType>(const_cast<LocatedEntity*>(entity));
+                return scratch;
+            case Access::PROPERTY: {
+                auto prop = entity->getProperty(operand.propertyId);
+                if (!prop) {
+                    return none;
+                }
+                //Soft properties can be read in place.
+                const Element* value;
+                if (typeid(*prop) == typeid(SoftProperty)) {
+                    value = &static_cast<const SoftProperty*>(prop)->data();
+                } else {
+                    scratch = Element();
+                    prop->get(scratch);
+                    value = &scratch;
+                }
+                for (auto& key : operand.path) {
+                    if (!value->isMap()) {
+                        return none;
+                    }
+                    auto I = value->Map().find(key);
+                    if (I == value->Map().end()) {
+                        return none;
+                    }
+                    value = &I->second;
+                }
+                return *value;
+            }
+            case Access::TYPE:
+                if (!entity->getType()) {
+                    return none;
+                }
+                scratch = static_cast<Atlas::Message::PtrType>(const_cast<TypeNode*>(entity->getType()));
+                return scratch;
+            case Access::TYPE_NAME:
+                if (!entity->getType()) {
+                    return none;
+                }
+                scratch = entity->getType()->name();
+                return scratch;
+            case Access::ID:
+                scratch = entity->getIntId();
+                return scratch;
+            default:
+                return none;
+        }
+    }
+
+    bool Program::loadNumber(const Operand& operand, const LocatedEntity& matched, const QueryContext& context, Element& scratch, double& number) const
+    {
+        if (operand.access == Access::PROPERTY && operand.path.empty()
+            && operand.source != Source::CONSTANT && operand.source != Source::INTERPRETED) {
+            auto entity = sourceEntity(operand, matched, context);
+            if (entity) {
+                auto prop = entity->getProperty(operand.propertyId);
+                if (!prop) {
+                    return false;
+                }
+                if (typeid(*prop) == typeid(SoftProperty)) {
+                    auto& value = static_cast<const SoftProperty*>(prop)->data();
+                    if (!value.isNum()) {
+                        return false;
+                    }
+                    number = value.asNum();
+                    return true;
+                }
+                if (readNumber<double>(*prop, number) || readNumber<float>(*prop, number)
+                    || readNumber<long>(*prop, number) || readNumber<int>(*prop, number)) {
+                    return true;
+                }
+            }
+        }
+        auto& value = load(operand, matched, context, scratch);
+        if (!value.isNum()) {
+            return false;
+        }
+        number = value.asNum();
+        return true;
+    }
+
+    bool Program::compare(ComparePredicate::Comparator comparator, const Element& left, const Element& right)
+    {
+        switch (comparator) {
+            case ComparePredicate::Comparator::EQUALS:
+                return left == right;
+            case ComparePredicate::Comparator::NOT_EQUALS:
+                return left != right;
+            case ComparePredicate::Comparator::LESS:
+            case ComparePredicate::Comparator::LESS_EQUAL:
+            case ComparePredicate::Comparator::GREATER:
+            case ComparePredicate::Comparator::GREATER_EQUAL:
+                return left.isNum() && right.isNum() && compareNumbers(comparator, left.asNum(), right.asNum());
+            case ComparePredicate::Comparator::INSTANCE_OF:
+                if (left.isPtr() && left.Ptr() && right.isPtr() && right.Ptr()) {
+                    auto leftType = static_cast<const LocatedEntity*>(left.Ptr())->getType();
+                    return leftType && leftType->isTypeOf(static_cast<const TypeNode*>(right.Ptr()));
+                }
+                return false;
+            case ComparePredicate::Comparator::IN:
+                if (!left.isNone() && right.isList()) {
+                    auto& list = right.List();
+                    return std::find(list.begin(), list.end(), left) != list.end();
+                }
+                return false;
+            case ComparePredicate::Comparator::INCLUDES:
+                if (left.isList() && !right.isNone()) {
+                    auto& list = left.List();
+                    return std::find(list.begin(), list.end(), right) != list.end();
+                }
+                return false;
+            default:
+                return false;
+        }
+    }
+
+    void Program::findGuards()
+    {
+        auto size = static_cast<std::uint32_t>(m_instructions.size());
+        auto isGuard = [&](const Instruction& instruction) {
+            if (instruction.opCode == OpCode::TEST) {
+                return m_operands[instruction.arg1].source != Source::INTERPRETED;
+            }
+            return (instruction.opCode == OpCode::COMPARE || instruction.opCode == OpCode::COMPARE_NUMBER)
+                   && m_operands[instruction.arg1].source != Source::INTERPRETED
+                   && m_operands[instruction.arg2].source != Source::INTERPRETED;
+        };
+        //Where a jump taken on a false result ends up, following any jumps it lands on.
+        auto jumpTarget = [&](std::uint32_t position) {
+            while (position < size && m_instructions[position].opCode == OpCode::JUMP_IF_FALSE) {
+                position = m_instructions[position].arg1;
+            }
+            return position;
+        };
+
+        //A guard is followed either by the end of the program or by a jump to the end if it's false.
+        std::uint32_t position = 0;
+        while (position < size && isGuard(m_instructions[position])) {
+            if (position + 1 == size) {
+                m_guards.push_back(position);
+                position = size;
+            } else if (m_instructions[position + 1].opCode == OpCode::JUMP_IF_FALSE
+                       && jumpTarget(m_instructions[position + 1].arg1) == size) {
+                m_guards.push_back(position);
+                position += 2;
+            } else {
+                break;
+            }
+        }
+        m_guardsEnd = position;
+
+        //Guards have no side effects, so they can be checked in any order. Those which check the type of the entity
+        //are the cheapest and the most likely to rule entities out, followed by comparisons of numbers.
+        auto rank = [&](std::uint32_t guard) {
+            auto& instruction = m_instructions[guard];
+            if (instruction.opCode == OpCode::COMPARE) {
+                auto& lhs = m_operands[instruction.arg1];
+                if (lhs.source == Source::ENTITY && isFixed(m_operands[instruction.arg2])
+                    && (lhs.access == Access::TYPE || instruction.comparator == ComparePredicate::Comparator::INSTANCE_OF)) {
+                    return 0;
+                }
+            } else if (instruction.opCode == OpCode::COMPARE_NUMBER) {
+                return 1;
+            }
+            return 2;
+        };
+        std::stable_sort(m_guards.begin(), m_guards.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+            return rank(lhs) < rank(rhs);
+        });
+    }
+
+    bool Program::isFixed(const Operand& operand) const
+    {
+        return operand.source != Source::ENTITY && operand.source != Source::INTERPRETED;
+    }
+
+    bool Program::evaluate(const Instruction& instruction, const LocatedEntity& entity, const QueryContext& context, Element& left, Element& right) const
+    {
+        switch (instruction.opCode) {
+            case OpCode::COMPARE: {
+                auto& leftValue = load(m_operands[instruction.arg1], entity, context, left);
+                auto& rightValue = load(m_operands[instruction.arg2], entity, context, right);
+                return compare(instruction.comparator, leftValue, rightValue);
+            }
+            case OpCode::COMPARE_NUMBER: {
+                double leftNumber, rightNumber;
+                return loadNumber(m_operands[instruction.arg1], entity, context, left, leftNumber)
+                       && loadNumber(m_operands[instruction.arg2], entity, context, right, rightNumber)
+                       && compareNumbers(instruction.comparator, leftNumber, rightNumber);
+            }
+            case OpCode::TEST: {
+                auto& value = load(m_operands[instruction.arg1], entity, context, left);
+                return value.isInt() && value.Int() != 0;
+            }
+            default:
+                return false;
+        }
+    }
+
+    bool Program::run(const QueryContext& context) const
+    {
+        return execute(0, false, context.entityLoc.entity, context);
+    }
+
+    bool Program::execute(std::uint32_t position, bool result, const LocatedEntity& entity, const QueryContext& context) const
+    {
+        Element left, right;
+        auto size = m_instructions.size();
+        while (position < size) {
+            auto& instruction = m_instructions[position++];
+            switch (instruction.opCode) {
+                case OpCode::CONSTANT:
+                    result = instruction.arg1 != 0;
+                    break;
+                case OpCode::COMPARE:
+                case OpCode::COMPARE_NUMBER:
+                case OpCode::TEST:
+                    result = evaluate(instruction, entity, context, left, right);
+                    break;
+                case OpCode::NOT:
+                    result = !result;
+                    break;
+                case OpCode::JUMP_IF_FALSE:
+                    if (!result) {
+                        position = instruction.arg1;
+                    }
+                    break;
+                case OpCode::JUMP_IF_TRUE:
+                    if (result) {
+                        position = instruction.arg1;
+                    }
+                    break;
+                case OpCode::DESCRIBE:
+                    if (!result && context.report_error_fn) {
+                        context.report_error_fn(m_descriptions[instruction.arg1]);
+                    }
+                    break;
+                case OpCode::INTERPRET:
+                    result = m_predicates[instruction.arg1]->isMatch(context);
+                    break;
+            }
+        }
+        return result;
+    }
+
+    void Program::runAll(std::vector<LocatedEntity*>& entities, const QueryContext& context) const
+    {
+        Element left, right;
+        std::vector<double> numbers;
+        for (auto guard : m_guards) {
+            if (entities.empty()) {
+                return;
+            }
+            auto& instruction = m_instructions[guard];
+            auto& lhs = m_operands[instruction.arg1];
+            auto& rhs = m_operands[instruction.arg2];
+            auto& anyEntity = *entities.front();
+            if (instruction.opCode == OpCode::COMPARE_NUMBER && (isFixed(lhs) || isFixed(rhs))) {
+                //Read the numbers of all entities first, and then compare them all with the fixed one.
+                //Values which aren't numbers are read as NaN, which never compares as true.
+                auto fixedOnLeft = isFixed(lhs);
+                auto& fixed = fixedOnLeft ? lhs : rhs;
+                auto& varying = fixedOnLeft ? rhs : lhs;
+                double fixedNumber;
+                if (!loadNumber(fixed, anyEntity, context, left, fixedNumber)) {
+                    entities.clear();
+                    return;
+                }
+                numbers.resize(entities.size());
+                for (size_t i = 0; i < entities.size(); ++i) {
+                    if (!loadNumber(varying, *entities[i], context, right, numbers[i])) {
+                        numbers[i] = std::numeric_limits<double>::quiet_NaN();
+                    }
+                }
+                size_t kept = 0;
+                for (size_t i = 0; i < entities.size(); ++i) {
+                    if (fixedOnLeft ? compareNumbers(instruction.comparator, fixedNumber, numbers[i])
+                                    : compareNumbers(instruction.comparator, numbers[i], fixedNumber)) {
+                        entities[kept++] = entities[i];
+                    }
+                }
+                entities.resize(kept);
+            } else if (instruction.opCode == OpCode::COMPARE && (isFixed(lhs) || isFixed(rhs))) {
+                //Load the fixed value once, which for types means that they are only looked up once.
+                auto fixedOnLeft = isFixed(lhs);
+                auto& fixedValue = load(fixedOnLeft ? lhs : rhs, anyEntity, context, left);
+                auto& varying = fixedOnLeft ? rhs : lhs;
+                entities.erase(std::remove_if(entities.begin(), entities.end(), [&](const LocatedEntity* entity) {
+                    auto& value = load(varying, *entity, context, right);
+                    return !(fixedOnLeft ? compare(instruction.comparator, fixedValue, value)
+                                         : compare(instruction.comparator, value, fixedValue));
+                }), entities.end());
+            } else {
+                entities.erase(std::remove_if(entities.begin(), entities.end(), [&](const LocatedEntity* entity) {
+                    return !evaluate(instruction, *entity, context, left, right);
+                }), entities.end());
+            }
+        }
+
+        if (m_guardsEnd == m_instructions.size()) {
+            return;
+        }
+        auto result = !m_guards.empty();
+        entities.erase(std::remove_if(entities.begin(), entities.end(), [&](LocatedEntity* entity) {
+            if (m_interpretedCount == 0) {
+                return !execute(m_guardsEnd, result, *entity, context);
+            }
+            //The interpreter gets the entity through the context, so it needs a context of its own.
+            QueryContext entityContext{*entity};
+            entityContext.actor = context.actor;
+            entityContext.tool = context.tool;
+            entityContext.child = context.child;
+            entityContext.memory_lookup_fn = context.memory_lookup_fn;
+            entityContext.self_entity = context.self_entity;
+            entityContext.entity_lookup_fn = context.entity_lookup_fn;
+            entityContext.type_lookup_fn = context.type_lookup_fn;
+            entityContext.report_error_fn = context.report_error_fn;
+            return !execute(m_guardsEnd, result, *entity, entityContext);
+        }), entities.end());
+    }
+}
@@ -0,0 +1,221 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_ENTITYFILTER_PROGRAM_H
+#define CYPHESIS_ENTITYFILTER_PROGRAM_H
+
+#include "Predicates.h"
+
+#include "common/PropertyIds.h"
+
+#include <Atlas/Message/Element.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace EntityFilter {
+
+    /**
+     * @brief A predicate tree compiled into a flat sequence of instructions.
+     *
+     * Evaluating the predicate tree directly means virtual calls through a graph of providers, with each provider
+     * copying values into Element instances. The program instead resolves the common cases when it's compiled:
+     * property names are interned into ids, literals are stored once and compared in place, comparisons between
+     * literals are folded away, and numeric comparisons read the values without copying them. "And", "or" and "not"
+     * are turned into jumps over the instructions.
+     *
+     * Anything the compiler doesn't know about is left to the predicates and providers, so a program always gives
+     * the same result as the tree it was compiled from.
+     *
+     * The program refers to the predicates and providers it was compiled from, which thus must outlive it.
+     *
+     * When the program starts with conditions which all must be true for it to match, and which can be checked without
+     * the interpreter, these are used as "guards" when matching many entities at once. Each guard is checked for all
+     * entities before the next one is, with checks of the type of the entity first and then numeric comparisons.
+     * Only the entities which pass all of the guards are run through the rest of the program.
+     */
+    class Program
+    {
+        public:
+            explicit Program(const Predicate& predicate);
+
+            bool run(const QueryContext& context) const;
+
+            /**
+             * @brief Runs the program for a collection of entities, removing the ones which don't match.
+             *
+             * The order of the remaining entities is kept.
+             * @param entities The entities to match.
+             * @param context A context used for all of the entities, except for the entity itself and its position.
+             */
+            void runAll(std::vector<LocatedEntity*>& entities, const QueryContext& context) const;
+
+            /**
+             * @brief Gets the number of predicates and values which are evaluated by the interpreter.
+             */
+            size_t getInterpretedCount() const
+            {
+                return m_interpretedCount;
+            }
+
+        private:
+
+            enum class OpCode : std::uint8_t
+            {
+                    /**
+                     * Sets the result to a constant.
+                     */
+                    CONSTANT,
+                    /**
+                     * Compares two operands.
+                     */
+                    COMPARE,
+                    /**
+                     * Compares two operands as numbers.
+                     */
+                    COMPARE_NUMBER,
+                    /**
+                     * Checks if an operand is a non zero integer.
+                     */
+                    TEST,
+                    NOT,
+                    JUMP_IF_FALSE,
+                    JUMP_IF_TRUE,
+                    /**
+                     * Reports a description if the result is false.
+                     */
+                    DESCRIBE,
+                    /**
+                     * Evaluates a predicate through the interpreter.
+                     */
+                    INTERPRET
+            };
+
+            struct Instruction
+            {
+                OpCode opCode;
+                ComparePredicate::Comparator comparator;
+                /**
+                 * The constant result, the operand to test, the left hand operand, the target to jump to,
+                 * the description or the predicate, depending on the op code.
+                 */
+                std::uint32_t arg1;
+                /**
+                 * The right hand operand of a comparison.
+                 */
+                std::uint32_t arg2;
+            };
+
+            /**
+             * Where a value comes from.
+             */
+            enum class Source : std::uint8_t
+            {
+                    CONSTANT, ENTITY, ACTOR, TOOL, CHILD, SELF,
+                    /**
+                     * A type looked up by the name held in the constant.
+                     */
+                    TYPE_LOOKUP,
+                    INTERPRETED
+            };
+
+            /**
+             * What is read from the entity, if the value comes from one.
+             */
+            enum class Access : std::uint8_t
+            {
+                    POINTER, PROPERTY, TYPE, TYPE_NAME, ID, NOTHING
+            };
+
+            struct Operand
+            {
+                Source source;
+                Access access;
+                PropertyId propertyId;
+                /**
+                 * Keys to look up in nested maps, after the property value has been read.
+                 */
+                std::vector<std::string> path;
+                Atlas::Message::Element constant;
+                const Consumer<QueryContext>* consumer;
+            };
+
+            /**
+             * Whether a compiled predicate has a constant value, in which case no instructions have been emitted.
+             */
+            enum class Folded
+            {
+                    NOT_FOLDED, MATCH, NO_MATCH
+            };
+
+            std::vector<Instruction> m_instructions;
+            std::vector<Operand> m_operands;
+            std::vector<std::string> m_descriptions;
+            std::vector<const Predicate*> m_predicates;
+            size_t m_interpretedCount;
+
+            /**
+             * The instructions which are guards, in the order they should be checked.
+             */
+            std::vector<std::uint32_t> m_guards;
+            /**
+             * Where to continue running the program once all of the guards have passed.
+             */
+            std::uint32_t m_guardsEnd;
+
+            Folded compile(const Predicate& predicate);
+
+            Folded compileLogical(const Predicate& lhs, const Predicate& rhs, bool isAnd);
+
+            Folded compileCompare(const ComparePredicate& predicate);
+
+            Folded interpret(const Predicate& predicate);
+
+            std::uint32_t compileOperand(const Consumer<QueryContext>& consumer);
+
+            std::uint32_t emit(OpCode opCode, std::uint32_t arg1 = 0, std::uint32_t arg2 = 0,
+                               ComparePredicate::Comparator comparator = ComparePredicate::Comparator::EQUALS);
+
+            void emitFolded(Folded folded);
+
+            void findGuards();
+
+            /**
+             * Checks if an operand has the same value for all entities when running for many entities at once.
+             */
+            bool isFixed(const Operand& operand) const;
+
+            bool execute(std::uint32_t position, bool result, const LocatedEntity& entity, const QueryContext& context) const;
+
+            bool evaluate(const Instruction& instruction, const LocatedEntity& entity, const QueryContext& context,
+                          Atlas::Message::Element& left, Atlas::Message::Element& right) const;
+
+            const LocatedEntity* sourceEntity(const Operand& operand, const LocatedEntity& matched, const QueryContext& context) const;
+
+            const Atlas::Message::Element& load(const Operand& operand, const LocatedEntity& matched, const QueryContext& context,
+                                                Atlas::Message::Element& scratch) const;
+
+            bool loadNumber(const Operand& operand, const LocatedEntity& matched, const QueryContext& context,
+                            Atlas::Message::Element& scratch, double& number) const;
+
+            static bool compare(ComparePredicate::Comparator comparator, const Atlas::Message::Element& left, const Atlas::Message::Element& right);
+    };
+}
+
+#endif //CYPHESIS_ENTITYFILTER_PROGRAM_H
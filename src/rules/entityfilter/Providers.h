@@ -144,6 +144,11 @@ namespace EntityFilter {
 
             virtual ~ProviderBase();
 
+            const std::shared_ptr<Consumer<T>>& getConsumer() const
+            {
+                return m_consumer;
+            }
+
         protected:
             std::shared_ptr<Consumer<T>> m_consumer;
     };
@@ -190,6 +195,11 @@ namespace EntityFilter {
         public:
             NamedAttributeProviderBase(std::shared_ptr<Consumer<T>> consumer, std::string attribute_name);
 
+            const std::string& getAttributeName() const
+            {
+                return m_attribute_name;
+            }
+
         protected:
             const std::string m_attribute_name;
     };
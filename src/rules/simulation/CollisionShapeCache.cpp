@@ -0,0 +1,113 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "CollisionShapeCache.h"
+
+#include <BulletCollision/CollisionShapes/btCollisionShape.h>
+
+#include <algorithm>
+
+namespace {
+    /**
+     * The smallest number of entries at which deleted shapes are purged.
+     */
+    const size_t MIN_PURGE_THRESHOLD = 1024;
+}
+
+size_t CollisionShapeCache::KeyHash::operator()(const Key& key) const
+{
+    size_t hash = std::hash<std::uint64_t>()(key.geometryId);
+    for (auto value : key.bounds) {
+        hash ^= std::hash<float>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+    return hash ^ (key.isStatic ? 1 : 0);
+}
+
+CollisionShapeCache::CollisionShapeCache()
+        : m_hits(0),
+          m_misses(0),
+          m_bytesSaved(0),
+          m_purgeThreshold(MIN_PURGE_THRESHOLD)
+{
+}
+
+CollisionShapeCache::~CollisionShapeCache() = default;
+
+std::shared_ptr<btCollisionShape> CollisionShapeCache::getShape(std::uint64_t geometryId,
+                                                                const WFMath::AxisBox<3>& bbox,
+                                                                float mass,
+                                                                btVector3& centerOfMassOffset,
+                                                                const ShapeCreator& creator)
+{
+    if (!bbox.isValid()) {
+        return creator(centerOfMassOffset);
+    }
+
+    Key key{geometryId,
+            {bbox.lowCorner().x(), bbox.lowCorner().y(), bbox.lowCorner().z(),
+             bbox.highCorner().x(), bbox.highCorner().y(), bbox.highCorner().z()},
+            mass == 0};
+
+    auto I = m_entries.find(key);
+    if (I != m_entries.end()) {
+        auto shape = I->second.shape.lock();
+        if (shape) {
+            centerOfMassOffset = I->second.centerOfMassOffset;
+            m_hits++;
+            m_bytesSaved += I->second.bytes;
+            return shape;
+        }
+    }
+
+    auto shape = creator(centerOfMassOffset);
+    m_misses++;
+    if (!shape) {
+        return shape;
+    }
+    //The serialized size is used as an estimate, since Bullet doesn't provide the size of the shape itself.
+    Entry entry{shape, centerOfMassOffset, shape->calculateSerializeBufferSize()};
+    if (I != m_entries.end()) {
+        I->second = entry;
+    } else {
+        m_entries.emplace(key, entry);
+        if (m_entries.size() >= m_purgeThreshold) {
+            purge();
+        }
+    }
+    return shape;
+}
+
+size_t CollisionShapeCache::size() const
+{
+    return static_cast<size_t>(std::count_if(m_entries.begin(), m_entries.end(), [](const std::pair<const Key, Entry>& entry) {
+        return !entry.second.shape.expired();
+    }));
+}
+
+void CollisionShapeCache::purge()
+{
+    for (auto I = m_entries.begin(); I != m_entries.end();) {
+        if (I->second.shape.expired()) {
+            I = m_entries.erase(I);
+        } else {
+            ++I;
+        }
+    }
+    //Purge again once the number of entries has doubled, so that the cost is spread out over the additions.
+    m_purgeThreshold = std::max(MIN_PURGE_THRESHOLD, m_entries.size() * 2);
+}
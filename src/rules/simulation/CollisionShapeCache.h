@@ -0,0 +1,132 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_COLLISIONSHAPECACHE_H
+#define CYPHESIS_COLLISIONSHAPECACHE_H
+
+#include "common/Singleton.h"
+
+#include <wfmath/axisbox.h>
+#include <LinearMath/btVector3.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+class btCollisionShape;
+
+/**
+ * @brief Shares collision shapes between entities with the same geometry and size.
+ *
+ * Worlds often contain thousands of entities of the same type, such as trees and rocks, which all have the same
+ * geometry and bounding box. Instead of creating a new shape for each of them they can all use the same one.
+ *
+ * Shapes are looked up by the geometry they were created from, the bounding box and whether they are for a static
+ * or a moving body, since mesh geometries use different shapes for these.
+ *
+ * The cache only holds weak references to the shapes, so a shape is deleted as soon as the last entity using it
+ * lets go of it. This means that shapes handed out must never be altered.
+ */
+class CollisionShapeCache : public Singleton<CollisionShapeCache>
+{
+    public:
+        typedef std::function<std::shared_ptr<btCollisionShape>(btVector3& centerOfMassOffset)> ShapeCreator;
+
+        CollisionShapeCache();
+
+        ~CollisionShapeCache() override;
+
+        /**
+         * @brief Gets a shape, creating it if there's none which can be shared.
+         * @param geometryId The id of the geometry to create the shape from, as given by GeometryProperty::getShapeCreatorId(),
+         * or zero for entities without any geometry.
+         * @param bbox The bounding box of the entity.
+         * @param mass The mass of the entity.
+         * @param centerOfMassOffset Out parameter for the center of mass offset.
+         * @param creator Creates a new shape, if needed.
+         * @return A shape, which must not be altered.
+         */
+        std::shared_ptr<btCollisionShape> getShape(std::uint64_t geometryId,
+                                                   const WFMath::AxisBox<3>& bbox,
+                                                   float mass,
+                                                   btVector3& centerOfMassOffset,
+                                                   const ShapeCreator& creator);
+
+        /**
+         * @brief Gets the number of shapes which are in use.
+         */
+        size_t size() const;
+
+        /**
+         * The number of times a shape could be shared.
+         */
+        int m_hits;
+
+        /**
+         * The number of times a new shape had to be created.
+         */
+        int m_misses;
+
+        /**
+         * An estimate of the number of bytes which would have been used by shapes if they hadn't been shared.
+         */
+        int m_bytesSaved;
+
+    private:
+
+        struct Key
+        {
+            std::uint64_t geometryId;
+            std::array<float, 6> bounds;
+            bool isStatic;
+
+            bool operator==(const Key& rhs) const
+            {
+                return geometryId == rhs.geometryId && bounds == rhs.bounds && isStatic == rhs.isStatic;
+            }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Entry
+        {
+            std::weak_ptr<btCollisionShape> shape;
+            btVector3 centerOfMassOffset;
+            /**
+             * The estimated size of the shape.
+             */
+            int bytes;
+        };
+
+        std::unordered_map<Key, Entry, KeyHash> m_entries;
+
+        /**
+         * When there are this many entries the ones with deleted shapes are removed.
+         */
+        size_t m_purgeThreshold;
+
+        void purge();
+};
+
+
+#endif //CYPHESIS_COLLISIONSHAPECACHE_H
@@ -120,22 +120,20 @@ void ContainerDomain::getVisibleEntitiesFor(const LocatedEntity& observingEntity
     }
 }
 
-std::vector<LocatedEntity*> ContainerDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+void ContainerDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
 {
-    std::vector<LocatedEntity*> list;
     for (auto& entry: m_reachingEntities) {
         if (entry.second.observer->hasFlags(entity_admin) || observedEntity.hasFlags(entity_contained_visible)) {
-            list.push_back(entry.second.observer.get());
+            entityList.push_back(entry.second.observer.get());
         } else {
             if (std::find(entry.second.observedEntities.begin(), entry.second.observedEntities.end(), &observedEntity) != entry.second.observedEntities.end()) {
-                list.push_back(entry.second.observer.get());
+                entityList.push_back(entry.second.observer.get());
             }
         }
     }
     if (m_entity.hasFlags(entity_perceptive)) {
-        list.push_back(&m_entity);
+        entityList.push_back(&m_entity);
     }
-    return list;
 }
 
 bool ContainerDomain::isEntityReachable(const LocatedEntity& reachingEntity, float reach, const LocatedEntity& queriedEntity, const WFMath::Point<3>& positionOnQueriedEntity) const
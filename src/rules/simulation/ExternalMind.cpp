@@ -141,7 +141,11 @@ void ExternalMind::operation(const Operation& op, OpVector& res)
         //Only sent ops that inherit from "Info" to the client.
         if (op->instanceOf(Atlas::Objects::Operation::INFO_NO)) {
             op->setSeconds(BaseWorld::instance().getTimeAsSeconds());
-            m_link->send(op);
+            if (op->instanceOf(Atlas::Objects::Operation::PERCEPTION_NO)) {
+                m_link->sendPerception(op);
+            } else {
+                m_link->send(op);
+            }
         }
     }
 }
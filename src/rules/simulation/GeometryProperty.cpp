@@ -51,6 +51,13 @@ auto createBoxFn = [](const WFMath::AxisBox<3>& bbox, const WFMath::Vector<3>& s
     return std::make_shared<btBoxShape>(btSize);
 };
 
+namespace {
+    /**
+     * The last id given to a shape creator. Zero is reserved for entities without any geometry.
+     */
+    std::uint64_t lastShapeCreatorId = 0;
+}
+
 void GeometryProperty::set(const Atlas::Message::Element& data)
 {
     Property<Atlas::Message::MapType>::set(data);
@@ -117,6 +124,8 @@ void GeometryProperty::set(const Atlas::Message::Element& data)
 
 void GeometryProperty::parseData(std::shared_ptr<OgreMeshDeserializer> deserializer)
 {
+    //Any shapes created from the previous data can't be shared with shapes created from the new data.
+    mShapeCreatorId = ++lastShapeCreatorId;
 
     auto sphereCreator = [](float radius, const WFMath::AxisBox<3>& bbox, const WFMath::Vector<3>& size, btVector3& centerOfMassOffset)
             -> std::shared_ptr<btCollisionShape> {
@@ -24,6 +24,7 @@
 #include <wfmath/vector.h>
 #include <bullet/LinearMath/btVector3.h>
 #include <functional>
+#include <cstdint>
 #include <boost/variant.hpp>
 
 class btCollisionShape;
@@ -89,6 +90,16 @@ class GeometryProperty : public Property<Atlas::Message::MapType>
         std::shared_ptr<btCollisionShape> createShape(const WFMath::AxisBox<3>& bbox,
                                                       btVector3& centerOfMassOffset, float mass) const;
 
+        /**
+         * Gets an id which is unique for the way shapes are created by this property.
+         * Shapes created by properties with the same id, and with the same bounding box and mass, are identical.
+         * @return An id, which changes whenever the geometry is changed.
+         */
+        std::uint64_t getShapeCreatorId() const
+        {
+            return mShapeCreatorId;
+        }
+
     private:
 
         /**
@@ -130,6 +141,8 @@ class GeometryProperty : public Property<Atlas::Message::MapType>
                                                         btVector3& centerOfMassOffset,
                                                         float mass)> mShapeCreator;
 
+        std::uint64_t mShapeCreatorId = 0;
+
         void buildMeshCreator(std::shared_ptr<OgreMeshDeserializer> meshDeserializer);
 
         void buildCompoundCreator();
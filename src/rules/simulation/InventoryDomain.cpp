@@ -123,11 +123,9 @@ void InventoryDomain::getVisibleEntitiesFor(const LocatedEntity& observingEntity
     }
 }
 
-std::vector<LocatedEntity*> InventoryDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+void InventoryDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
 {
-    std::vector<LocatedEntity*> list;
-    list.push_back(&m_entity);
-    return list;
+    entityList.push_back(&m_entity);
 }
 
 bool InventoryDomain::isEntityReachable(const LocatedEntity& reachingEntity, float reach, const LocatedEntity& queriedEntity, const WFMath::Point<3>& positionOnQueriedEntity) const
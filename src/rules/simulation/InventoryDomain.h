@@ -39,7 +39,7 @@ class InventoryDomain : public Domain
 
         void getVisibleEntitiesFor(const LocatedEntity& observingEntity, std::list<LocatedEntity*>& entityList) const override;
 
-        std::vector<LocatedEntity*> getObservingEntitiesFor(const LocatedEntity& observedEntity) const override;
+        void getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const override;
 
         void addEntity(LocatedEntity& entity) override;
 
@@ -23,6 +23,7 @@
 #include "PropelProperty.h"
 #include "rules/simulation/GeometryProperty.h"
 #include "rules/simulation/AngularFactorProperty.h"
+#include "CollisionShapeCache.h"
 #include "TerrainModProperty.h"
 #include "PhysicalWorld.h"
 
@@ -39,6 +40,8 @@
 #include "ModeDataProperty.h"
 #include "VisibilityDistanceProperty.h"
 #include "common/Inheritance.h"
+#include "common/MulticastOps.h"
+#include "PhysicalDomainTickExecutor.h"
 #include "Remotery/Remotery.h"
 
 #include <Mercator/Segment.h>
@@ -158,6 +161,10 @@ namespace {
 
 int PhysicalDomain::s_processTimeUs = 0;
 
+PhysicalDomain::VisibilityEngine PhysicalDomain::s_defaultVisibilityEngine = PhysicalDomain::VisibilityEngine::Bullet;
+
+thread_local std::vector<PhysicalDomain::ProjectileCollisionEntry>* PhysicalDomain::s_currentProjectileCollisions = nullptr;
+
 /**
  * The minimum angular resolution of visibility, expressed as degrees.
  *
@@ -198,6 +205,12 @@ const double TICK_SIZE = 1.0 / 15.0;
  */
 const double VIEW_SPHERE_RADIUS = 0.5;
 
+/**
+ * The size of the finest cells in the visibility grid, already scaled with VISIBILITY_SCALING_FACTOR.
+ * This is large enough to fit the smallest visibility spheres.
+ */
+const float VISIBILITY_GRID_CELL_SIZE = 64.0f * VISIBILITY_SCALING_FACTOR;
+
 /**
  * Mask used by visibility checks for observing entries (i.e. creatures etc.).
  */
@@ -244,6 +257,22 @@ const float CCD_SPHERE_FACTOR = 0.2f;
  */
 const int USER_INDEX_WATER_BODY = 1;
 
+/**
+ * Interned names of properties which are looked up while simulating.
+ */
+const PropertyId MASS_PROPERTY_ID = PropertyIds::intern("mass");
+const PropertyId FRICTION_PROPERTY_ID = PropertyIds::intern("friction");
+const PropertyId FRICTION_ROLL_PROPERTY_ID = PropertyIds::intern("friction_roll");
+const PropertyId FRICTION_SPIN_PROPERTY_ID = PropertyIds::intern("friction_spin");
+const PropertyId SPEED_GROUND_PROPERTY_ID = PropertyIds::intern("speed_ground");
+const PropertyId SPEED_WATER_PROPERTY_ID = PropertyIds::intern("speed_water");
+const PropertyId SPEED_FLIGHT_PROPERTY_ID = PropertyIds::intern("speed_flight");
+const PropertyId SPEED_JUMP_PROPERTY_ID = PropertyIds::intern("speed_jump");
+const PropertyId STEP_FACTOR_PROPERTY_ID = PropertyIds::intern("step_factor");
+const PropertyId PLANTED_OFFSET_PROPERTY_ID = PropertyIds::intern("planted_offset");
+const PropertyId PLANTED_SCALED_OFFSET_PROPERTY_ID = PropertyIds::intern("planted_scaled_offset");
+const PropertyId WATER_BODY_PROPERTY_ID = PropertyIds::intern("water_body");
+
 struct PhysicalDomain::PhysicalMotionState : public btMotionState
 {
     BulletEntry& m_bulletEntry;
@@ -434,7 +463,10 @@ struct PhysicalDomain::VisibilityPairCallback : public btOverlappingPairCallback
     {}
 };
 
-std::chrono::steady_clock::duration postDuration;
+/**
+ * Keeps track of time spent in the post tick callback. Since domains can be stepped in parallel this is kept per thread.
+ */
+thread_local std::chrono::steady_clock::duration postDuration;
 
 PhysicalDomain::PhysicalDomain(LocatedEntity& entity) :
         Domain(entity),
@@ -448,23 +480,32 @@ PhysicalDomain::PhysicalDomain(LocatedEntity& entity) :
         // m_broadphase(new btAxisSweep3(Convert::toBullet(entity.m_location.bBox().lowCorner()),
         //                                              Convert::toBullet(entity.m_location.bBox().highCorner()))),
         m_dynamicsWorld(new PhysicalWorld(m_dispatcher.get(), m_broadphase.get(), m_constraintSolver.get(), m_collisionConfiguration.get())),
-        m_visibilityPairCallback(new VisibilityPairCallback()),
-        m_visibilityDispatcher(new btCollisionDispatcher(m_collisionConfiguration.get())),
-        //We'll use a SAP broadphase for the visibility. This is more efficient than a dynamic one.
-        //TODO: how to handle the limit for 16384 entries? Perhaps use the bt32BitAxisSweep3 with a custom max entries setting (to avoid it eating all memory).
-        m_visibilityBroadphase(new btAxisSweep3(Convert::toBullet(entity.m_location.bBox().lowCorner()) * VISIBILITY_SCALING_FACTOR,
-                                                Convert::toBullet(entity.m_location.bBox().highCorner()) * VISIBILITY_SCALING_FACTOR)),
-        m_visibilityWorld(new btCollisionWorld(m_visibilityDispatcher.get(),
-                                               m_visibilityBroadphase.get(),
-                                               m_collisionConfiguration.get())),
         m_visibilityCheckCountdown(0),
+        m_lastStepSize(0),
+        m_lastStepDuration{},
+        m_lastStepPostDuration{},
         mContainingEntityEntry{entity},
         m_terrain(nullptr),
         m_ghostPairCallback(new WaterCollisionCallback())
 {
     m_ghostPairCallback->m_domain = this;
     m_dynamicsWorld->getPairCache()->setInternalGhostPairCallback(m_ghostPairCallback.get());
-    m_visibilityBroadphase->setOverlappingPairUserCallback(m_visibilityPairCallback.get());
+
+    if (s_defaultVisibilityEngine == VisibilityEngine::Grid) {
+        m_visibilityGrid.reset(new VisibilityGrid(VISIBILITY_GRID_CELL_SIZE));
+    } else {
+        m_visibilityPairCallback.reset(new VisibilityPairCallback());
+        m_visibilityDispatcher.reset(new btCollisionDispatcher(m_collisionConfiguration.get()));
+        //We'll use a SAP broadphase for the visibility. This is more efficient than a dynamic one.
+        //TODO: how to handle the limit for 16384 entries? Perhaps use the bt32BitAxisSweep3 with a custom max entries setting (to avoid it eating all memory).
+        m_visibilityBroadphase.reset(new btAxisSweep3(Convert::toBullet(entity.m_location.bBox().lowCorner()) * VISIBILITY_SCALING_FACTOR,
+                                                      Convert::toBullet(entity.m_location.bBox().highCorner()) * VISIBILITY_SCALING_FACTOR));
+        m_visibilityWorld.reset(new btCollisionWorld(m_visibilityDispatcher.get(),
+                                                     m_visibilityBroadphase.get(),
+                                                     m_collisionConfiguration.get()));
+        m_visibilityBroadphase->setOverlappingPairUserCallback(m_visibilityPairCallback.get());
+        m_visibilityWorld->setForceUpdateAllAabbs(false);
+    }
 
     //This is to prevent us from sliding down slopes.
     //m_dynamicsWorld->getDispatchInfo().m_allowedCcdPenetration = 0.0001f;
@@ -472,8 +513,6 @@ PhysicalDomain::PhysicalDomain(LocatedEntity& entity) :
     //By default all collision objects have their aabbs updated each tick; we'll disable it for performance.
     m_dynamicsWorld->setForceUpdateAllAabbs(false);
 
-    m_visibilityWorld->setForceUpdateAllAabbs(false);
-
     auto terrainProperty = m_entity.getPropertyClassFixed<TerrainProperty>();
     if (terrainProperty) {
         m_terrain = &terrainProperty->getData(m_entity);
@@ -594,10 +633,33 @@ PhysicalDomain::PhysicalDomain(LocatedEntity& entity) :
     buildTerrainPages();
 
     m_entity.propertyApplied.connect(sigc::mem_fun(this, &PhysicalDomain::entityPropertyApplied));
+
+    //Projectile collisions are collected into the vector of the domain currently being stepped on this thread.
+    gContactProcessedCallback = [](btManifoldPoint& cp, void* body0, void* body1) -> bool {
+        if (!s_currentProjectileCollisions) {
+            return true;
+        }
+        auto object0 = static_cast<btCollisionObject*>(body0);
+        auto bulletEntry0 = static_cast<BulletEntry*>(object0->getUserPointer());
+        auto object1 = static_cast<btCollisionObject*>(body1);
+        auto bulletEntry1 = static_cast<BulletEntry*>(object1->getUserPointer());
+
+        if (bulletEntry0->mode == ModeProperty::Mode::Projectile) {
+            s_currentProjectileCollisions->emplace_back(ProjectileCollisionEntry{bulletEntry0, bulletEntry1, cp.getPositionWorldOnB()});
+        }
+        if (bulletEntry1->mode == ModeProperty::Mode::Projectile) {
+            s_currentProjectileCollisions->emplace_back(ProjectileCollisionEntry{bulletEntry1, bulletEntry0, cp.getPositionWorldOnA()});
+        }
+        return true;
+    };
 }
 
 PhysicalDomain::~PhysicalDomain()
 {
+    if (PhysicalDomainTickExecutor::hasInstance()) {
+        PhysicalDomainTickExecutor::instance().unregisterDomain(*this);
+    }
+
     for (auto& planeBody : m_borderPlanes) {
         m_dynamicsWorld->removeCollisionObject(planeBody.first.get());
     }
@@ -658,7 +720,12 @@ HandlerResult PhysicalDomain::tick_handler(LocatedEntity* entity, const Operatio
             tickSize = timeNow - elem.Float();
         }
 
-        tick(tickSize, res);
+        //If there's an executor the step is made in parallel with other domains, once all ops for this main loop iteration have been processed.
+        if (PhysicalDomainTickExecutor::hasInstance()) {
+            PhysicalDomainTickExecutor::instance().queueTick(*this, getSimulationTickSize(tickSize));
+        } else {
+            tick(tickSize, res);
+        }
         auto tickOp = scheduleTick(*entity);
         tickOp->setSeconds(timeNow + TICK_SIZE);
         tickOp->setAttr("lastTick", timeNow);
@@ -676,7 +743,7 @@ void PhysicalDomain::buildTerrainPages()
     boost::optional<float> spinningFriction;
 
     {
-        auto frictionProp = m_entity.getPropertyType<double>("friction");
+        auto frictionProp = m_entity.getPropertyType<double>(FRICTION_PROPERTY_ID);
 
         if (frictionProp) {
             friction = (float) frictionProp->data();
@@ -684,7 +751,7 @@ void PhysicalDomain::buildTerrainPages()
     }
 
     {
-        auto frictionProp = m_entity.getPropertyType<double>("friction_roll");
+        auto frictionProp = m_entity.getPropertyType<double>(FRICTION_ROLL_PROPERTY_ID);
 
         if (frictionProp) {
             rollingFriction = (float) frictionProp->data();
@@ -692,7 +759,7 @@ void PhysicalDomain::buildTerrainPages()
     }
 
     {
-        auto frictionProp = m_entity.getPropertyType<double>("friction_spin");
+        auto frictionProp = m_entity.getPropertyType<double>(FRICTION_SPIN_PROPERTY_ID);
 
         if (frictionProp) {
             spinningFriction = (float) frictionProp->data();
@@ -848,10 +915,8 @@ void PhysicalDomain::getVisibleEntitiesFor(const LocatedEntity& observingEntity,
     }
 }
 
-std::vector<LocatedEntity*> PhysicalDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+void PhysicalDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
 {
-    std::vector<LocatedEntity*> entityList;
-
     auto observedI = m_entries.find(observedEntity.getIntId());
     if (observedI != m_entries.end()) {
         auto& bulletEntry = observedI->second;
@@ -859,19 +924,13 @@ std::vector<LocatedEntity*> PhysicalDomain::getObservingEntitiesFor(const Locate
             entityList.push_back(&observingEntry->entity);
         }
     }
-
-    return entityList;
 }
 
 void PhysicalDomain::updateObserverEntry(BulletEntry* bulletEntry, OpVector& res)
 {
     if (bulletEntry->viewSphere) {
         //This entry is an observer; check what it can see after it has moved
-        auto& viewSphere = bulletEntry->viewSphere;
-        if (viewSphere) {
-            viewSphere->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(bulletEntry->entity.m_location.m_pos) * VISIBILITY_SCALING_FACTOR));
-            m_visibilityWorld->updateSingleAabb(viewSphere.get());
-        }
+        updateViewSphere(*bulletEntry);
 
         std::vector<Atlas::Objects::Root> appearArgs;
         std::vector<Atlas::Objects::Root> disappearArgs;
@@ -929,12 +988,7 @@ void PhysicalDomain::updateObservedEntry(BulletEntry* bulletEntry, OpVector& res
 {
     if (bulletEntry->visibilitySphere) {
         //This entry is an observable; check what can see it after it has moved
-
-        auto& visibilitySphere = bulletEntry->visibilitySphere;
-        if (visibilitySphere) {
-            visibilitySphere->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(bulletEntry->entity.m_location.m_pos) * VISIBILITY_SCALING_FACTOR));
-            m_visibilityWorld->updateSingleAabb(visibilitySphere.get());
-        }
+        updateVisibilitySphere(*bulletEntry);
 
         auto disappearFn = [&](BulletEntry* existingObserverEntry) {
             if (generateOps) {
@@ -982,6 +1036,99 @@ void PhysicalDomain::updateObservedEntry(BulletEntry* bulletEntry, OpVector& res
     }
 }
 
+void PhysicalDomain::addVisibilitySphere(BulletEntry& entry)
+{
+    auto& entity = entry.entity;
+    short mask = entity.hasFlags(entity_visibility_protected) || entity.hasFlags(entity_visibility_private) ? VISIBILITY_MASK_OBSERVABLE_PRIVATE : VISIBILITY_MASK_OBSERVABLE;
+    if (m_visibilityGrid) {
+        m_visibilityGridChanges.clear();
+        entry.visibilityGridHandle = m_visibilityGrid->addSphere(&entry, entry.visibilitySphere->getWorldTransform().getOrigin(), entry.visibilityShape->getRadius(),
+                                                                 VISIBILITY_MASK_OBSERVER, mask, m_visibilityGridChanges);
+        recordVisibilityGridChanges(entry, entry.observingThisChanges);
+    } else {
+        m_visibilityWorld->addCollisionObject(entry.visibilitySphere.get(), VISIBILITY_MASK_OBSERVER, mask);
+    }
+}
+
+void PhysicalDomain::addViewSphere(BulletEntry& entry)
+{
+    auto& entity = entry.entity;
+    short group = entity.hasFlags(entity_admin) ? VISIBILITY_MASK_OBSERVABLE | VISIBILITY_MASK_OBSERVABLE_PRIVATE : VISIBILITY_MASK_OBSERVABLE;
+    if (m_visibilityGrid) {
+        m_visibilityGridChanges.clear();
+        entry.viewGridHandle = m_visibilityGrid->addSphere(&entry, entry.viewSphere->getWorldTransform().getOrigin(), VIEW_SPHERE_RADIUS * VISIBILITY_SCALING_FACTOR,
+                                                           group, VISIBILITY_MASK_OBSERVER, m_visibilityGridChanges);
+        recordVisibilityGridChanges(entry, entry.observedByThisChanges);
+    } else {
+        m_visibilityWorld->addCollisionObject(entry.viewSphere.get(), group, VISIBILITY_MASK_OBSERVER);
+    }
+}
+
+void PhysicalDomain::removeVisibilitySphere(BulletEntry& entry)
+{
+    if (m_visibilityGrid) {
+        if (entry.visibilityGridHandle != VisibilityGrid::invalid_handle) {
+            m_visibilityGrid->removeSphere(entry.visibilityGridHandle);
+            entry.visibilityGridHandle = VisibilityGrid::invalid_handle;
+        }
+    } else {
+        m_visibilityWorld->removeCollisionObject(entry.visibilitySphere.get());
+    }
+}
+
+void PhysicalDomain::removeViewSphere(BulletEntry& entry)
+{
+    if (m_visibilityGrid) {
+        if (entry.viewGridHandle != VisibilityGrid::invalid_handle) {
+            m_visibilityGrid->removeSphere(entry.viewGridHandle);
+            entry.viewGridHandle = VisibilityGrid::invalid_handle;
+        }
+    } else {
+        m_visibilityWorld->removeCollisionObject(entry.viewSphere.get());
+    }
+}
+
+void PhysicalDomain::updateVisibilitySphere(BulletEntry& entry)
+{
+    entry.visibilitySphere->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entry.entity.m_location.m_pos) * VISIBILITY_SCALING_FACTOR));
+    if (m_visibilityGrid) {
+        if (entry.visibilityGridHandle != VisibilityGrid::invalid_handle) {
+            m_visibilityGridChanges.clear();
+            m_visibilityGrid->updateSphere(entry.visibilityGridHandle, entry.visibilitySphere->getWorldTransform().getOrigin(), entry.visibilityShape->getRadius(),
+                                           m_visibilityGridChanges);
+            recordVisibilityGridChanges(entry, entry.observingThisChanges);
+        }
+    } else {
+        m_visibilityWorld->updateSingleAabb(entry.visibilitySphere.get());
+    }
+}
+
+void PhysicalDomain::updateViewSphere(BulletEntry& entry)
+{
+    entry.viewSphere->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entry.entity.m_location.m_pos) * VISIBILITY_SCALING_FACTOR));
+    if (m_visibilityGrid) {
+        if (entry.viewGridHandle != VisibilityGrid::invalid_handle) {
+            m_visibilityGridChanges.clear();
+            m_visibilityGrid->updateSphere(entry.viewGridHandle, entry.viewSphere->getWorldTransform().getOrigin(), VIEW_SPHERE_RADIUS * VISIBILITY_SCALING_FACTOR,
+                                           m_visibilityGridChanges);
+            recordVisibilityGridChanges(entry, entry.observedByThisChanges);
+        }
+    } else {
+        m_visibilityWorld->updateSingleAabb(entry.viewSphere.get());
+    }
+}
+
+void PhysicalDomain::recordVisibilityGridChanges(BulletEntry& entry, std::vector<std::pair<BulletEntry*, BulletEntry::VisibilityQueueOperationType>>& queue)
+{
+    //Same as in VisibilityPairCallback; the view and visibility spheres of the same entry will overlap, but should be ignored.
+    for (auto& change : m_visibilityGridChanges) {
+        auto otherEntry = static_cast<BulletEntry*>(change.userPointer);
+        if (otherEntry != &entry) {
+            queue.emplace_back(otherEntry, change.added ? BulletEntry::VisibilityQueueOperationType::Add : BulletEntry::VisibilityQueueOperationType::Remove);
+        }
+    }
+}
+
 void PhysicalDomain::updateVisibilityOfDirtyEntities(OpVector& res)
 {
     rmt_ScopedCPUSample(PhysicalDomain_updateVisibilityOfDirtyEntities, 0)
@@ -1005,7 +1152,7 @@ float PhysicalDomain::getMassForEntity(const LocatedEntity& entity) const
 {
     float mass = 0;
 
-    auto massProp = entity.getPropertyType<double>("mass");
+    auto massProp = entity.getPropertyType<double>(MASS_PROPERTY_ID);
     if (massProp) {
         mass = (float) massProp->data();
     }
@@ -1017,14 +1164,23 @@ std::shared_ptr<btCollisionShape> PhysicalDomain::createCollisionShapeForEntry(L
                                                                                btVector3& centerOfMassOffset)
 {
     auto geometryProp = entity.getPropertyClassFixed<GeometryProperty>();
-    if (geometryProp) {
-        return geometryProp->createShape(bbox, centerOfMassOffset, mass);
-    } else {
-        auto size = bbox.highCorner() - bbox.lowCorner();
-        auto btSize = Convert::toBullet(size * 0.5).absolute();
-        centerOfMassOffset = -Convert::toBullet(bbox.getCenter());
-        return std::make_shared<btBoxShape>(btSize);
+    auto createShape = [&](btVector3& offset) -> std::shared_ptr<btCollisionShape> {
+        if (geometryProp) {
+            return geometryProp->createShape(bbox, offset, mass);
+        } else {
+            auto size = bbox.highCorner() - bbox.lowCorner();
+            auto btSize = Convert::toBullet(size * 0.5).absolute();
+            offset = -Convert::toBullet(bbox.getCenter());
+            return std::make_shared<btBoxShape>(btSize);
+        }
+    };
+
+    //Entities of the same type often have the same geometry and size, and can then share the same shape.
+    if (CollisionShapeCache::hasInstance()) {
+        return CollisionShapeCache::instance().getShape(geometryProp ? geometryProp->getShapeCreatorId() : 0,
+                                                        bbox, mass, centerOfMassOffset, createShape);
     }
+    return createShape(centerOfMassOffset);
 }
 
 void PhysicalDomain::addEntity(LocatedEntity& entity)
@@ -1071,7 +1227,7 @@ void PhysicalDomain::addEntity(LocatedEntity& entity)
     short collisionGroup;
     getCollisionFlagsForEntity(entity, collisionGroup, collisionMask);
 
-    auto waterBodyProp = entity.getPropertyClass<BoolProperty>("water_body");
+    auto waterBodyProp = entity.getPropertyClass<BoolProperty>(WATER_BODY_PROPERTY_ID);
     if (waterBodyProp && waterBodyProp->isTrue()) {
 
         auto ghostObject = std::make_unique<btGhostObject>();
@@ -1117,15 +1273,15 @@ void PhysicalDomain::addEntity(LocatedEntity& entity)
 
             btRigidBody::btRigidBodyConstructionInfo rigidBodyCI(mass, nullptr, entry->collisionShape.get(), inertia);
 
-            auto frictionProp = entity.getPropertyType<double>("friction");
+            auto frictionProp = entity.getPropertyType<double>(FRICTION_PROPERTY_ID);
             if (frictionProp) {
                 rigidBodyCI.m_friction = (btScalar) frictionProp->data();
             }
-            auto frictionRollProp = entity.getPropertyType<double>("friction_roll");
+            auto frictionRollProp = entity.getPropertyType<double>(FRICTION_ROLL_PROPERTY_ID);
             if (frictionRollProp) {
                 rigidBodyCI.m_rollingFriction = (btScalar) frictionRollProp->data();
             }
-            auto frictionSpinProp = entity.getPropertyType<double>("friction_spin");
+            auto frictionSpinProp = entity.getPropertyType<double>(FRICTION_SPIN_PROPERTY_ID);
             if (frictionSpinProp) {
 #if BT_BULLET_VERSION < 285
                 log(WARNING, "Your version of Bullet doesn't support spinning friction.");
@@ -1153,13 +1309,13 @@ void PhysicalDomain::addEntity(LocatedEntity& entity)
             entry->collisionObject->setCcdSweptSphereRadius(minSize * CCD_SPHERE_FACTOR);
 
             //Set up cached speed values
-            auto speedGroundProp = entity.getPropertyType<double>("speed_ground");
+            auto speedGroundProp = entity.getPropertyType<double>(SPEED_GROUND_PROPERTY_ID);
             entry->speedGround = speedGroundProp ? speedGroundProp->data() : 0;
 
-            auto speedWaterProp = entity.getPropertyType<double>("speed_water");
+            auto speedWaterProp = entity.getPropertyType<double>(SPEED_WATER_PROPERTY_ID);
             entry->speedWater = speedWaterProp ? speedWaterProp->data() : 0;
 
-            auto speedFlightProp = entity.getPropertyType<double>("speed_flight");
+            auto speedFlightProp = entity.getPropertyType<double>(SPEED_FLIGHT_PROPERTY_ID);
             entry->speedFlight = speedFlightProp ? speedFlightProp->data() : 0;
 
             //Only add to world if position is valid. Otherwise this will be done when a new valid position is applied in applyNewPositionForEntity
@@ -1175,7 +1331,7 @@ void PhysicalDomain::addEntity(LocatedEntity& entity)
                 applyPropel(*entry, propelProp->data());
             }
 
-            auto stepFactorProp = entity.getPropertyType<double>("step_factor");
+            auto stepFactorProp = entity.getPropertyType<double>(STEP_FACTOR_PROPERTY_ID);
             if (stepFactorProp && stepFactorProp->data() > 0) {
                 m_steppingEntries.emplace(entity.getIntId(), std::make_pair(entry, stepFactorProp->data()));
             }
@@ -1203,9 +1359,7 @@ void PhysicalDomain::addEntity(LocatedEntity& entity)
         entry->visibilityShape = std::move(visSphere);
         if (entity.m_location.m_pos.isValid()) {
             visibilityObjectPtr->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entity.m_location.m_pos) * VISIBILITY_SCALING_FACTOR));
-            m_visibilityWorld->addCollisionObject(visibilityObjectPtr, VISIBILITY_MASK_OBSERVER,
-                                                  entity.hasFlags(entity_visibility_protected) || entity.hasFlags(entity_visibility_private) ? VISIBILITY_MASK_OBSERVABLE_PRIVATE
-                                                                                                                                             : VISIBILITY_MASK_OBSERVABLE);
+            addVisibilitySphere(*entry);
         }
     }
     if (entity.isPerceptive()) {
@@ -1222,8 +1376,7 @@ void PhysicalDomain::addEntity(LocatedEntity& entity)
 
         if (entity.m_location.m_pos.isValid()) {
             viewSpherePtr->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entity.m_location.m_pos) * VISIBILITY_SCALING_FACTOR));
-            m_visibilityWorld->addCollisionObject(viewSpherePtr, entity.hasFlags(entity_admin) ? VISIBILITY_MASK_OBSERVABLE | VISIBILITY_MASK_OBSERVABLE_PRIVATE : VISIBILITY_MASK_OBSERVABLE,
-                                                  VISIBILITY_MASK_OBSERVER);
+            addViewSphere(*entry);
         }
         mContainingEntityEntry.observingThis.insert(entry);
 
@@ -1260,12 +1413,12 @@ void PhysicalDomain::toggleChildPerception(LocatedEntity& entity)
             auto viewSphere = std::make_unique<btCollisionObject>();
             viewSphere->setCollisionShape(viewShape.get());
             viewSphere->setUserPointer(entry.get());
+            entry->viewSphere = std::move(viewSphere);
+            entry->viewShape = std::move(viewShape);
             if (entity.m_location.m_pos.isValid()) {
-                viewSphere->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entity.m_location.m_pos) * VISIBILITY_SCALING_FACTOR));
-                m_visibilityWorld->addCollisionObject(viewSphere.get(), entity.hasFlags(entity_admin) ? VISIBILITY_MASK_OBSERVABLE | VISIBILITY_MASK_OBSERVABLE_PRIVATE : VISIBILITY_MASK_OBSERVABLE,
-                                                      VISIBILITY_MASK_OBSERVER);
+                entry->viewSphere->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entity.m_location.m_pos) * VISIBILITY_SCALING_FACTOR));
+                addViewSphere(*entry);
             }
-            entry->viewSphere = std::move(viewSphere);
 
             //We are observing ourselves, and we are being observed by ourselves.
             entry->observedByThis.insert(entry.get());
@@ -1279,7 +1432,7 @@ void PhysicalDomain::toggleChildPerception(LocatedEntity& entity)
         }
     } else {
         if (entry->viewSphere) {
-            m_visibilityWorld->removeCollisionObject(entry->viewSphere.get());
+            removeViewSphere(*entry);
             entry->viewShape.reset();
             entry->viewSphere.reset();
             mContainingEntityEntry.observingThis.erase(entry.get());
@@ -1313,10 +1466,10 @@ void PhysicalDomain::removeEntity(LocatedEntity& entity)
 
     entry->propertyUpdatedConnection.disconnect();
     if (entry->viewSphere) {
-        m_visibilityWorld->removeCollisionObject(entry->viewSphere.get());
+        removeViewSphere(*entry);
     }
     if (entry->visibilitySphere) {
-        m_visibilityWorld->removeCollisionObject(entry->visibilitySphere.get());
+        removeVisibilitySphere(*entry);
     }
     for (BulletEntry* observer : entry->observingThis) {
         observer->observedByThis.erase(entry.get());
@@ -1329,6 +1482,15 @@ void PhysicalDomain::removeEntity(LocatedEntity& entity)
         removeAndShift(m_visibilityRecalculateQueue, entry.get());
     }
 
+    //If the simulation has been stepped in advance there might be unprocessed collisions referring to the entry.
+    if (!m_projectileCollisions.empty()) {
+        auto removedEntry = entry.get();
+        m_projectileCollisions.erase(std::remove_if(m_projectileCollisions.begin(), m_projectileCollisions.end(),
+                                                    [removedEntry](const ProjectileCollisionEntry& collision) {
+                                                        return collision.projectileEntry == removedEntry || collision.bulletEntry == removedEntry;
+                                                    }), m_projectileCollisions.end());
+    }
+
     mContainingEntityEntry.observingThis.erase(entry.get());
 
     //The entity owning the domain should normally not be perceptive, so we'll check first to optimize a bit.
@@ -1758,7 +1920,7 @@ void PhysicalDomain::getCollisionFlagsForEntity(const LocatedEntity& entity, sho
     //The "mask" defines the other kind of object this body will react with.
 
     //Water bodies behave in a special way, so check for that.
-    auto waterBodyProp = entity.getPropertyClass<BoolProperty>("water_body");
+    auto waterBodyProp = entity.getPropertyClass<BoolProperty>(WATER_BODY_PROPERTY_ID);
     if (waterBodyProp && waterBodyProp->isTrue()) {
         //A body of water should behave like terrain, and interact with both physical and non-physical entities.
         collisionGroup = COLLISION_MASK_TERRAIN;
@@ -2038,11 +2200,11 @@ void PhysicalDomain::calculatePositionForEntity(ModeProperty::Mode mode, Physica
                 pos.y() = h;
             }
 
-            auto plantedOffsetProp = entity.getPropertyType<double>("planted_offset");
+            auto plantedOffsetProp = entity.getPropertyType<double>(PLANTED_OFFSET_PROPERTY_ID);
             if (plantedOffsetProp) {
                 pos.y() += plantedOffsetProp->data();
             }
-            auto plantedScaledOffsetProp = entity.getPropertyType<double>("planted_scaled_offset");
+            auto plantedScaledOffsetProp = entity.getPropertyType<double>(PLANTED_SCALED_OFFSET_PROPERTY_ID);
             if (plantedScaledOffsetProp && entity.m_location.bBox().isValid()) {
                 auto size = entity.m_location.bBox().highCorner() - entity.m_location.bBox().lowCorner();
 
@@ -2097,12 +2259,10 @@ void PhysicalDomain::applyNewPositionForEntity(BulletEntry* entry, const WFMath:
     }
 
     if (entry->viewSphere) {
-        entry->viewSphere->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entity.m_location.m_pos) * VISIBILITY_SCALING_FACTOR));
-        m_visibilityWorld->updateSingleAabb(entry->viewSphere.get());
+        updateViewSphere(*entry);
     }
     if (entry->visibilitySphere) {
-        entry->visibilitySphere->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entity.m_location.m_pos) * VISIBILITY_SCALING_FACTOR));
-        m_visibilityWorld->updateSingleAabb(entry->visibilitySphere.get());
+        updateVisibilitySphere(*entry);
     }
 
     if (!entry->markedForVisibilityRecalculation) {
@@ -2172,7 +2332,7 @@ void PhysicalDomain::applyPropel(BulletEntry& entry, const WFMath::Vector<3>& pr
 
                     //Check if we're trying to jump
                     if (btPropel.m_floats[1] > 0) {
-                        auto jumpSpeedProp = entity.getPropertyType<double>("speed_jump");
+                        auto jumpSpeedProp = entity.getPropertyType<double>(SPEED_JUMP_PROPERTY_ID);
                         if (jumpSpeedProp && jumpSpeedProp->data() > 0) {
 
                             bool isGrounded = false;
@@ -2192,7 +2352,7 @@ void PhysicalDomain::applyPropel(BulletEntry& entry, const WFMath::Vector<3>& pr
 
                     auto K = m_propellingEntries.find(entity.getIntId());
                     if (K == m_propellingEntries.end()) {
-                        const Property<double>* stepFactorProp = entity.getPropertyType<double>("step_factor");
+                        const Property<double>* stepFactorProp = entity.getPropertyType<double>(STEP_FACTOR_PROPERTY_ID);
                         if (stepFactorProp && entity.m_location.bBox().isValid()) {
                             auto height = entity.m_location.bBox().upperBound(1) - entity.m_location.bBox().lowerBound(1);
                             m_propellingEntries.insert(std::make_pair(entity.getIntId(), PropelEntry{rigidBody, &entry, btPropel, (float) (height * stepFactorProp->data())}));
@@ -2213,7 +2373,7 @@ void PhysicalDomain::applyPropel(BulletEntry& entry, const WFMath::Vector<3>& pr
 
                     rigidBody->setLinearVelocity(bodyVelocity);
                     double friction = 1.0; //Default to 1 if no "friction" prop is present.
-                    auto frictionProp = entity.getPropertyType<double>("friction");
+                    auto frictionProp = entity.getPropertyType<double>(FRICTION_PROPERTY_ID);
                     if (frictionProp) {
                         friction = frictionProp->data();
                     }
@@ -2309,14 +2469,10 @@ void PhysicalDomain::applyTransformInternal(LocatedEntity& entity,
                     }
                 }
                 if (entry->viewSphere) {
-                    m_visibilityWorld->addCollisionObject(entry->viewSphere.get(),
-                                                          entity.hasFlags(entity_admin) ? VISIBILITY_MASK_OBSERVABLE | VISIBILITY_MASK_OBSERVABLE_PRIVATE : VISIBILITY_MASK_OBSERVABLE,
-                                                          VISIBILITY_MASK_OBSERVER);
+                    addViewSphere(*entry);
                 }
                 if (entry->visibilitySphere) {
-                    m_visibilityWorld->addCollisionObject(entry->visibilitySphere.get(), VISIBILITY_MASK_OBSERVER,
-                                                          entity.hasFlags(entity_visibility_protected) || entity.hasFlags(entity_visibility_private) ? VISIBILITY_MASK_OBSERVABLE_PRIVATE
-                                                                                                                                                     : VISIBILITY_MASK_OBSERVABLE);
+                    addVisibilitySphere(*entry);
                 }
             }
         }
@@ -2387,17 +2543,17 @@ void PhysicalDomain::processDirtyTerrainAreas()
     m_dirtyTerrainAreas.clear();
 
     boost::optional<float> friction;
-    auto frictionProp = m_entity.getPropertyType<double>("friction");
+    auto frictionProp = m_entity.getPropertyType<double>(FRICTION_PROPERTY_ID);
     if (frictionProp) {
         friction = (float) frictionProp->data();
     }
     boost::optional<float> frictionRolling;
-    auto frictionRollingProp = m_entity.getPropertyType<double>("friction_roll");
+    auto frictionRollingProp = m_entity.getPropertyType<double>(FRICTION_ROLL_PROPERTY_ID);
     if (frictionRollingProp) {
         frictionRolling = (float) frictionRollingProp->data();
     }
     boost::optional<float> frictionSpinning;
-    auto frictionSpinningProp = m_entity.getPropertyType<double>("friction_spin");
+    auto frictionSpinningProp = m_entity.getPropertyType<double>(FRICTION_SPIN_PROPERTY_ID);
     if (frictionSpinningProp) {
         frictionSpinning = (float) frictionSpinningProp->data();
     }
@@ -2525,6 +2681,15 @@ void PhysicalDomain::sendMoveSight(BulletEntry& entry, bool posChange, bool velo
             double seconds = BaseWorld::instance().getTimeAsSeconds();
             setOp->setSeconds(seconds);
 
+            //All observers get the same Sight apart from "to", so it only needs to be encoded once.
+            if (entry.observingThis.size() > 1 && MulticastOps::hasInstance()) {
+                Sight sight;
+                sight->setArgs1(setOp);
+                sight->setFrom(entity.getId());
+                sight->setSeconds(seconds);
+                MulticastOps::instance().add(sight);
+            }
+
             for (BulletEntry* observer : entry.observingThis) {
                 Sight s;
                 s->setArgs1(setOp);
@@ -2653,68 +2818,67 @@ void PhysicalDomain::processMovedEntity(BulletEntry& bulletEntry, double timeSin
 
 void PhysicalDomain::tick(double tickSize, OpVector& res)
 {
-//    CProfileManager::Reset();
-//    CProfileManager::Increment_Frame_Counter();
-    rmt_ScopedCPUSample(PhysicalDomain_tick, 0);
-
-    auto start = std::chrono::steady_clock::now();
-    /**
-     * An entry of a projectile hitting another entry.
-     */
-    struct BulletCollisionEntry
-    {
-        /**
-         * The entry that was hit.
-         */
-        BulletEntry* bulletEntry;
-        /**
-         * The position in the world where the hit occurred.
-         */
-        btVector3 pos;
-    };
-
-    //  static std::map<BulletEntry*, BulletCollisionEntry> projectileCollisions;
-    static std::vector<std::pair<BulletEntry*, BulletCollisionEntry>> projectileCollisions;
-
-    gContactProcessedCallback = [](btManifoldPoint& cp, void* body0, void* body1) -> bool {
-        auto object0 = static_cast<btCollisionObject*>(body0);
-        auto bulletEntry0 = static_cast<BulletEntry*>(object0->getUserPointer());
-        auto object1 = static_cast<btCollisionObject*>(body1);
-        auto bulletEntry1 = static_cast<BulletEntry*>(object1->getUserPointer());
-
-        if (bulletEntry0->mode == ModeProperty::Mode::Projectile) {
-            projectileCollisions.emplace_back(bulletEntry0, BulletCollisionEntry{bulletEntry1, cp.getPositionWorldOnB()});
-        }
-        if (bulletEntry1->mode == ModeProperty::Mode::Projectile) {
-            projectileCollisions.emplace_back(bulletEntry1, BulletCollisionEntry{bulletEntry0, cp.getPositionWorldOnA()});
-        }
-        return true;
-    };
+    stepSimulation(getSimulationTickSize(tickSize));
+    processStep(res);
+}
 
+double PhysicalDomain::getSimulationTickSize(double tickSize) const
+{
     auto simulationSpeedProp = m_entity.getPropertyClassFixed<SimulationSpeedProperty>();
     if (simulationSpeedProp) {
-        tickSize *= simulationSpeedProp->data();
+        return tickSize * simulationSpeedProp->data();
+    }
+    return tickSize;
+}
+
+void PhysicalDomain::processQueuedStep()
+{
+    OpVector res;
+    processStep(res);
+    for (auto& op : res) {
+        m_entity.sendWorld(std::move(op));
     }
+}
 
-    projectileCollisions.clear();
+void PhysicalDomain::stepSimulation(double tickSize)
+{
+//    CProfileManager::Reset();
+//    CProfileManager::Increment_Frame_Counter();
+    rmt_ScopedCPUSample(PhysicalDomain_stepSimulation, 0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    m_projectileCollisions.clear();
+    s_currentProjectileCollisions = &m_projectileCollisions;
 
     postDuration = {};
     //Step simulations with 60 hz.
     m_dynamicsWorld->stepSimulation((float) tickSize, static_cast<int>(60 * tickSize));
-    auto interim = std::chrono::steady_clock::now() - start;
+
+    s_currentProjectileCollisions = nullptr;
+    m_lastStepSize = tickSize;
+    m_lastStepPostDuration = postDuration;
+    m_lastStepDuration = std::chrono::steady_clock::now() - start;
+}
+
+void PhysicalDomain::processStep(OpVector& res)
+{
+    rmt_ScopedCPUSample(PhysicalDomain_processStep, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    double tickSize = m_lastStepSize;
 
     //CProfileManager::dumpAll();
 
     //The list of projectilecollisions will contain duplicates, so we need to keep track of the last
     //processed and check that it does not repeat.
     BulletEntry* lastCollisionEntry = nullptr;
-    for (const auto& entry : projectileCollisions) {
-        auto projectileEntry = entry.first;
+    for (const auto& collisionEntry : m_projectileCollisions) {
+        auto projectileEntry = collisionEntry.projectileEntry;
         if (lastCollisionEntry == projectileEntry) {
             continue;
         }
         lastCollisionEntry = projectileEntry;
-        auto& collisionEntry = entry.second;
         const auto modeDataProperty = projectileEntry->entity.getPropertyClassFixed<ModeDataProperty>();
         Atlas::Objects::Entity::Anonymous ent;
         //If the projectile data contained information on which entity caused the projectile to fly away, copy that.
@@ -2804,17 +2968,17 @@ void PhysicalDomain::tick(double tickSize, OpVector& res)
 
     processDirtyTerrainAreas();
 
-    auto duration = std::chrono::steady_clock::now() - start;
+    auto duration = std::chrono::steady_clock::now() - start + m_lastStepDuration;
     auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
     if (debug_flag) {
         log(microseconds > 3000 ? WARNING : INFO,
             String::compose("Physics took %1 μs (just stepSimulation %2 μs, visibility %3 μs, tick size %4 μs, visibility queue: %5, postTick: %6 μs, moving count: %7).",
                             microseconds,
-                            std::chrono::duration_cast<std::chrono::microseconds>(interim).count(),
+                            std::chrono::duration_cast<std::chrono::microseconds>(m_lastStepDuration).count(),
                             std::chrono::duration_cast<std::chrono::microseconds>(visDuration).count(),
                             static_cast<long>(tickSize * 1000000),
                             m_visibilityRecalculateQueue.size(),
-                            std::chrono::duration_cast<std::chrono::microseconds>(postDuration).count(),
+                            std::chrono::duration_cast<std::chrono::microseconds>(m_lastStepPostDuration).count(),
                             movingSize)
         );
     }
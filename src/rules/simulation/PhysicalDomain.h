@@ -21,6 +21,7 @@
 #include "rules/Domain.h"
 #include "rules/Location.h"
 #include "ModeProperty.h"
+#include "VisibilityGrid.h"
 
 #include <sigc++/connection.h>
 
@@ -33,6 +34,8 @@
 #include <array>
 #include <set>
 #include <unordered_set>
+#include <chrono>
+#include <boost/optional.hpp>
 
 namespace Mercator {
     class Segment;
@@ -73,8 +76,28 @@ class btAxisSweep3;
 class PhysicalDomain : public Domain
 {
     public:
+        /**
+         * The engine used for calculating which entities are observed by which.
+         */
+        enum class VisibilityEngine
+        {
+                /**
+                 * A separate Bullet collision world, with a SAP broadphase.
+                 */
+                Bullet,
+                /**
+                 * A VisibilityGrid instance.
+                 */
+                Grid
+        };
+
         static int s_processTimeUs;
 
+        /**
+         * The visibility engine used by new domains.
+         */
+        static VisibilityEngine s_defaultVisibilityEngine;
+
         explicit PhysicalDomain(LocatedEntity& entity);
 
         ~PhysicalDomain() override;
@@ -83,7 +106,7 @@ class PhysicalDomain : public Domain
 
         void getVisibleEntitiesFor(const LocatedEntity& observingEntity, std::list<LocatedEntity*>& entityList) const override;
 
-        std::vector<LocatedEntity*> getObservingEntitiesFor(const LocatedEntity& observedEntity) const override;
+        void getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const override;
 
         void addEntity(LocatedEntity& entity) override;
 
@@ -104,6 +127,35 @@ class PhysicalDomain : public Domain
 
         void tick(double t, OpVector& res);
 
+        /**
+         * @brief Steps the Bullet simulation, without generating any ops.
+         *
+         * This only touches state owned by this domain, and can thus be run in parallel with other domains.
+         * It must be followed by a call to processStep() on the main thread.
+         * @param tickSize The size of the step in seconds, already adjusted with getSimulationTickSize().
+         */
+        void stepSimulation(double tickSize);
+
+        /**
+         * @brief Processes the results of the last call to stepSimulation().
+         *
+         * This is where ops are generated for moved entities, visibility is updated and so on.
+         * @param res
+         */
+        void processStep(OpVector& res);
+
+        /**
+         * @brief Adjusts the tick size with the simulation speed of the domain.
+         * @param tickSize A tick size in seconds.
+         * @return The tick size to use when stepping the simulation.
+         */
+        double getSimulationTickSize(double tickSize) const;
+
+        /**
+         * @brief Processes the results of a step queued with PhysicalDomainTickExecutor, sending any resulting ops to the world.
+         */
+        void processQueuedStep();
+
         std::vector<CollisionEntry> queryCollision(const WFMath::Ball<3>& sphere) const override;
 
         boost::optional<std::function<void()>> observeCloseness(LocatedEntity& entity1, LocatedEntity& entity2, double reach, std::function<void()> callback) override;
@@ -120,6 +172,27 @@ class PhysicalDomain : public Domain
 
         struct ClosenessObserverEntry;
 
+        struct BulletEntry;
+
+        /**
+         * An entry of a projectile hitting another entry.
+         */
+        struct ProjectileCollisionEntry
+        {
+            /**
+             * The projectile.
+             */
+            BulletEntry* projectileEntry;
+            /**
+             * The entry that was hit.
+             */
+            BulletEntry* bulletEntry;
+            /**
+             * The position in the world where the hit occurred.
+             */
+            btVector3 pos;
+        };
+
         struct BulletEntry
         {
             enum class VisibilityQueueOperationType
@@ -128,6 +201,9 @@ class PhysicalDomain : public Domain
                     Remove
             };
             LocatedEntity& entity;
+            /**
+             * The shape of the entity. This might be shared with other entities.
+             */
             std::shared_ptr<btCollisionShape> collisionShape;
             std::unique_ptr<btCollisionObject> collisionObject;
             sigc::connection propertyUpdatedConnection;
@@ -139,6 +215,12 @@ class PhysicalDomain : public Domain
             std::unique_ptr<btCollisionObject> viewSphere;
             std::unique_ptr<btSphereShape> viewShape;
 
+            /**
+             * Handles of the visibility and view spheres, if a VisibilityGrid is used.
+             */
+            size_t visibilityGridHandle = VisibilityGrid::invalid_handle;
+            size_t viewGridHandle = VisibilityGrid::invalid_handle;
+
             /**
              * Set of entries which are observing by this.
              */
@@ -319,10 +401,45 @@ class PhysicalDomain : public Domain
         std::unique_ptr<btAxisSweep3> m_visibilityBroadphase;
         std::unique_ptr<btCollisionWorld> m_visibilityWorld;
 
+        /**
+         * Used instead of m_visibilityWorld if the VisibilityEngine::Grid engine is used.
+         */
+        std::unique_ptr<VisibilityGrid> m_visibilityGrid;
+
+        /**
+         * Scratch buffer for changes reported by m_visibilityGrid.
+         */
+        std::vector<VisibilityGrid::OverlapChange> m_visibilityGridChanges;
+
         sigc::connection m_propertyAppliedConnection;
 
         double m_visibilityCheckCountdown;
 
+        /**
+         * Projectile collisions registered during the last step of the simulation.
+         */
+        std::vector<ProjectileCollisionEntry> m_projectileCollisions;
+
+        /**
+         * Points to m_projectileCollisions of the domain currently being stepped on this thread.
+         */
+        static thread_local std::vector<ProjectileCollisionEntry>* s_currentProjectileCollisions;
+
+        /**
+         * The size of the last step of the simulation, in seconds.
+         */
+        double m_lastStepSize;
+
+        /**
+         * The duration of the last step, for debug output.
+         */
+        std::chrono::steady_clock::duration m_lastStepDuration;
+
+        /**
+         * The time spent in the post tick callback during the last step, for debug output.
+         */
+        std::chrono::steady_clock::duration m_lastStepPostDuration;
+
         BulletEntry mContainingEntityEntry;
 
         Mercator::Terrain* m_terrain;
@@ -395,6 +512,39 @@ class PhysicalDomain : public Domain
 
         void updateObserverEntry(BulletEntry* bulletEntry, OpVector& res);
 
+        /**
+         * @brief Adds the visibility sphere of the entry to the visibility engine.
+         *
+         * The transform of the sphere must already be set.
+         */
+        void addVisibilitySphere(BulletEntry& entry);
+
+        /**
+         * @brief Adds the view sphere of the entry to the visibility engine.
+         *
+         * The transform of the sphere must already be set.
+         */
+        void addViewSphere(BulletEntry& entry);
+
+        void removeVisibilitySphere(BulletEntry& entry);
+
+        void removeViewSphere(BulletEntry& entry);
+
+        /**
+         * @brief Moves the visibility sphere to the position of the entity, recording any changes in observers.
+         */
+        void updateVisibilitySphere(BulletEntry& entry);
+
+        /**
+         * @brief Moves the view sphere to the position of the entity, recording any changes in observed entities.
+         */
+        void updateViewSphere(BulletEntry& entry);
+
+        /**
+         * @brief Copies the changes reported by m_visibilityGrid into the supplied queue.
+         */
+        void recordVisibilityGridChanges(BulletEntry& entry, std::vector<std::pair<BulletEntry*, BulletEntry::VisibilityQueueOperationType>>& queue);
+
         void applyNewPositionForEntity(BulletEntry* entry, const WFMath::Point<3>& pos, bool calculatePosition = true);
 
         bool getTerrainHeight(float x, float y, float& height) const;
@@ -412,6 +562,9 @@ class PhysicalDomain : public Domain
          */
         void processWaterBodies();
 
+        /**
+         * Creates a collision shape for an entity. The shape might be shared with other entities, and must not be altered.
+         */
         std::shared_ptr<btCollisionShape> createCollisionShapeForEntry(LocatedEntity& entity,
                                                                        const WFMath::AxisBox<3>& bbox, float mass,
                                                                        btVector3& centerOfMassOffse);
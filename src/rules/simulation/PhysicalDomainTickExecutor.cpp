@@ -0,0 +1,177 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "PhysicalDomainTickExecutor.h"
+#include "PhysicalDomain.h"
+
+#include "common/log.h"
+#include "common/compose.hpp"
+
+#include "Remotery/Remotery.h"
+
+#include <algorithm>
+
+PhysicalDomainTickExecutor::PhysicalDomainTickExecutor(size_t threadCount)
+        : m_unfinishedJobs(0),
+          m_shutdown(false)
+{
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+PhysicalDomainTickExecutor::~PhysicalDomainTickExecutor()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_jobsAvailable.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void PhysicalDomainTickExecutor::queueTick(PhysicalDomain& domain, double tickSize)
+{
+    auto I = std::find_if(m_queuedTicks.begin(), m_queuedTicks.end(), [&](const QueuedTick& entry) { return entry.domain == &domain; });
+    if (I != m_queuedTicks.end()) {
+        //The number of sub steps is based on the step size, so one larger step simulates the same as the two separate ones.
+        I->tickSize += tickSize;
+        return;
+    }
+    m_queuedTicks.emplace_back(QueuedTick{&domain, tickSize});
+}
+
+void PhysicalDomainTickExecutor::unregisterDomain(PhysicalDomain& domain)
+{
+    m_queuedTicks.erase(std::remove_if(m_queuedTicks.begin(), m_queuedTicks.end(), [&](const QueuedTick& entry) { return entry.domain == &domain; }),
+                        m_queuedTicks.end());
+}
+
+bool PhysicalDomainTickExecutor::runQueuedTicks()
+{
+    if (m_queuedTicks.empty()) {
+        return false;
+    }
+    rmt_ScopedCPUSample(PhysicalDomainTickExecutor_runQueuedTicks, 0)
+
+    auto queuedTicks = std::move(m_queuedTicks);
+    m_queuedTicks.clear();
+
+    //There's no point in involving the workers if there's only one domain to step.
+    if (queuedTicks.size() == 1) {
+        auto& entry = queuedTicks.front();
+        runJob([&]() { entry.domain->stepSimulation(entry.tickSize); });
+    } else {
+        std::vector<std::function<void()>> jobs;
+        jobs.reserve(queuedTicks.size());
+        for (auto& entry : queuedTicks) {
+            jobs.emplace_back([entry]() { entry.domain->stepSimulation(entry.tickSize); });
+        }
+        runJobs(std::move(jobs));
+    }
+
+    for (auto& entry : queuedTicks) {
+        entry.domain->processQueuedStep();
+    }
+    return true;
+}
+
+void PhysicalDomainTickExecutor::tick(const std::vector<PhysicalDomain*>& domains, double tickSize, OpVector& res)
+{
+    std::vector<std::function<void()>> jobs;
+    jobs.reserve(domains.size());
+    for (auto domain : domains) {
+        auto simulationTickSize = domain->getSimulationTickSize(tickSize);
+        jobs.emplace_back([domain, simulationTickSize]() { domain->stepSimulation(simulationTickSize); });
+    }
+    runJobs(std::move(jobs));
+
+    for (auto domain : domains) {
+        domain->processStep(res);
+    }
+}
+
+void PhysicalDomainTickExecutor::runJobs(std::vector<std::function<void()>> jobs)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_unfinishedJobs += jobs.size();
+        for (auto& job : jobs) {
+            m_jobs.emplace_back(std::move(job));
+        }
+    }
+    m_jobsAvailable.notify_all();
+
+    //Help out with the jobs instead of just waiting.
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_jobs.empty()) {
+                break;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        runJob(job);
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            --m_unfinishedJobs;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobsDone.wait(lock, [this]() { return m_unfinishedJobs == 0; });
+}
+
+void PhysicalDomainTickExecutor::workerLoop()
+{
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobsAvailable.wait(lock, [this]() { return m_shutdown || !m_jobs.empty(); });
+            if (m_shutdown) {
+                return;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        runJob(job);
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            --m_unfinishedJobs;
+            if (m_unfinishedJobs == 0) {
+                m_jobsDone.notify_all();
+            }
+        }
+    }
+}
+
+void PhysicalDomainTickExecutor::runJob(const std::function<void()>& job)
+{
+    try {
+        job();
+    } catch (const std::exception& ex) {
+        log(ERROR, String::compose("Exception caught when stepping physical domain: %1", ex.what()));
+    } catch (...) {
+        log(ERROR, "Unknown exception caught when stepping physical domain.");
+    }
+}
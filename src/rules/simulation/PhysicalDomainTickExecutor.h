@@ -0,0 +1,144 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_PHYSICALDOMAINTICKEXECUTOR_H
+#define CYPHESIS_PHYSICALDOMAINTICKEXECUTOR_H
+
+#include "common/Singleton.h"
+#include "common/OperationRouter.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class PhysicalDomain;
+
+/**
+ * @brief Steps the Bullet worlds of multiple physical domains in parallel.
+ *
+ * Each PhysicalDomain owns its own Bullet worlds, so stepping them only touches state owned by that domain.
+ * This allows the stepping to be done on a pool of worker threads, while all op generation (and thus all
+ * interaction with the rest of the simulation) still is done on the main thread.
+ *
+ * When a domain processes its Tick op it queues its step with the executor instead of stepping right away.
+ * After all operations for a main loop iteration have been processed runQueuedTicks() should be called. All queued
+ * domains are then stepped in parallel, after which each domain does the "commit" phase in the order they were queued,
+ * i.e. generate ops for moved entities, update visibility and so on.
+ * Since the steps are made after all operations for the iteration have been processed, any changes made by those
+ * operations (such as new velocities) are part of the step, just as when stepping serially. The only difference is
+ * that operations processed after the Tick op in the same iteration also are part of the step.
+ */
+class PhysicalDomainTickExecutor : public Singleton<PhysicalDomainTickExecutor>
+{
+    public:
+        /**
+         * @brief Ctor.
+         * @param threadCount The number of worker threads. The main thread will also perform work while waiting
+         * for the workers, so a value of 0 means that all stepping is done serially on the main thread.
+         */
+        explicit PhysicalDomainTickExecutor(size_t threadCount);
+
+        ~PhysicalDomainTickExecutor() override;
+
+        /**
+         * @brief Queues a step of a domain, to be made in the next call to runQueuedTicks().
+         *
+         * If the domain already has a step queued the new step is merged into it, so that steps are never made out of order.
+         * @param domain The domain.
+         * @param tickSize The size of the step in seconds, already adjusted with PhysicalDomain::getSimulationTickSize().
+         */
+        void queueTick(PhysicalDomain& domain, double tickSize);
+
+        /**
+         * @brief Removes any queued step for a domain. Must be called when a domain is destroyed.
+         * @param domain The domain.
+         */
+        void unregisterDomain(PhysicalDomain& domain);
+
+        /**
+         * @brief Steps all queued domains in parallel, and then processes the results of each one in the order they were queued.
+         *
+         * Any resulting ops are sent to the world.
+         * @return True if any domain was stepped.
+         */
+        bool runQueuedTicks();
+
+        /**
+         * @brief Ticks the supplied domains, stepping them in parallel and then processing the results in order.
+         *
+         * Since the results are processed in the order of the supplied domains the resulting ops are deterministic.
+         * @param domains The domains to tick.
+         * @param tickSize The size of the tick, in seconds.
+         * @param res Any resulting ops.
+         */
+        void tick(const std::vector<PhysicalDomain*>& domains, double tickSize, OpVector& res);
+
+        size_t getThreadCount() const
+        {
+            return m_threads.size();
+        }
+
+    private:
+
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_mutex;
+        std::condition_variable m_jobsAvailable;
+        std::condition_variable m_jobsDone;
+
+        /**
+         * Jobs waiting to be picked up by either a worker or the main thread.
+         */
+        std::deque<std::function<void()>> m_jobs;
+
+        /**
+         * The number of jobs that have been queued but not yet completed.
+         */
+        size_t m_unfinishedJobs;
+
+        bool m_shutdown;
+
+        struct QueuedTick
+        {
+            PhysicalDomain* domain;
+            double tickSize;
+        };
+
+        /**
+         * Steps queued through queueTick(), kept in the order they were queued.
+         */
+        std::vector<QueuedTick> m_queuedTicks;
+
+        void workerLoop();
+
+        /**
+         * @brief Runs all the jobs, returning when they all have been completed.
+         *
+         * The calling thread will also work on the jobs.
+         */
+        void runJobs(std::vector<std::function<void()>> jobs);
+
+        static void runJob(const std::function<void()>& job);
+
+};
+
+
+#endif //CYPHESIS_PHYSICALDOMAINTICKEXECUTOR_H
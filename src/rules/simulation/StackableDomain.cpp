@@ -247,9 +247,8 @@ void StackableDomain::getVisibleEntitiesFor(const LocatedEntity& observingEntity
     }
 }
 
-std::vector<LocatedEntity*> StackableDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+void StackableDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
 {
-    return {};
 }
 
 bool StackableDomain::isEntityReachable(const LocatedEntity& reachingEntity, float reach, const LocatedEntity& queriedEntity, const WFMath::Point<3>& positionOnQueriedEntity) const
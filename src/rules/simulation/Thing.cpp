@@ -26,6 +26,7 @@
 
 #include "common/operations/Update.h"
 #include "common/TypeNode.h"
+#include "common/PropertyDeltas.h"
 #include "EntityProperty.h"
 #include "ModeProperty.h"
 #include "ModeDataProperty.h"
@@ -54,6 +55,65 @@ using Atlas::Objects::Entity::RootEntity;
 
 static const bool debug_flag = false;
 
+namespace {
+    /**
+     * The changed properties with the same visibility, to be sent in one Sight of a Set.
+     */
+    struct PropertyChanges
+    {
+        Anonymous arg;
+        bool hadChanges = false;
+
+        /**
+         * The same changes, but with maps and lists described as deltas when possible.
+         */
+        MapType deltaAttrs;
+        bool hasDeltas = false;
+        /**
+         * Set if a property couldn't be added to the deltas, in which case only the full values are sent.
+         */
+        bool deltasFailed = false;
+
+        /**
+         * Adds a property, which already has been added to "arg", to the deltas.
+         */
+        void addDelta(const std::string& name, ModifiableProperty& entry)
+        {
+            Element value;
+            if (arg->copyAttr(name, value) != 0) {
+                deltasFailed = true;
+                return;
+            }
+            if (value.isMap() || value.isList()) {
+                if (PropertyDeltas::createDelta(name, entry.sentValue, value, deltaAttrs)) {
+                    hasDeltas = true;
+                } else {
+                    deltaAttrs.emplace(name, value);
+                }
+                entry.sentValue = std::move(value);
+            } else {
+                entry.sentValue = Element();
+                deltaAttrs.emplace(name, std::move(value));
+            }
+        }
+    };
+
+    /**
+     * Adds a property to the arg of a Sight of the entity.
+     *
+     * If the property has changes which haven't been sent yet, and those will be sent as a delta, the value last sent
+     * is used instead. That way the delta can be applied on top of it.
+     */
+    void addSeenProperty(const std::string& name, const ModifiableProperty& entry, const Anonymous& arg)
+    {
+        if (!entry.sentValue.isNone() && entry.property->hasFlags(prop_flag_unsent)) {
+            arg->setAttr(name, entry.sentValue);
+        } else {
+            entry.property->add(name, arg);
+        }
+    }
+}
+
 /// \brief Constructor for physical or tangible entities.
 Thing::Thing(const std::string& id, long intId) :
         Entity(id, intId)
@@ -313,41 +373,45 @@ void Thing::updateProperties(const Operation& op, OpVector& res)
 {
     debug_print("Generating property update")
 
-    Anonymous set_arg;
-    Anonymous set_arg_protected;
-    Anonymous set_arg_private;
+    PropertyChanges publicChanges;
+    PropertyChanges protectedChanges;
+    PropertyChanges privateChanges;
 
     bool hadChanges = false;
-    bool hadPublicChanges = false;
-    bool hadProtectedChanges = false;
-    bool hadPrivateChanges = false;
+    //If enabled, a version of the changes with deltas is also created, for clients which support it.
+    bool createDeltas = PropertyDeltas::hasInstance();
 
-    for (const auto& entry : m_properties) {
+    for (auto& entry : m_properties) {
         auto& prop = entry.second.property;
         if (prop && prop->hasFlags(prop_flag_unsent)) {
             debug(std::cout << "UPDATE:  " << prop_flag_unsent << " " << entry.first
                             << std::endl << std::flush;);
+            PropertyChanges* changes;
             if (prop->hasFlags(prop_flag_visibility_private)) {
-                prop->add(entry.first, set_arg_private);
-                hadPrivateChanges = true;
+                changes = &privateChanges;
             } else if (prop->hasFlags(prop_flag_visibility_protected)) {
-                prop->add(entry.first, set_arg_protected);
-                hadProtectedChanges = true;
+                changes = &protectedChanges;
             } else {
-                prop->add(entry.first, set_arg);
-                hadPublicChanges = true;
+                changes = &publicChanges;
+            }
+            prop->add(entry.first, changes->arg);
+            changes->hadChanges = true;
+            if (createDeltas) {
+                changes->addDelta(entry.first, entry.second);
             }
             prop->removeFlags(prop_flag_unsent | prop_flag_persistence_clean);
             hadChanges = true;
         }
     }
 
-    //TODO: only send changed location properties
-    if (m_flags.hasFlags(entity_dirty_location)) {
-        m_location.addToEntity(set_arg);
+    //The location is only marked as dirty when the entity has moved to a new parent. Since all of the location
+    //values are relative to the parent they must all be sent then.
+    bool locationChanged = m_flags.hasFlags(entity_dirty_location);
+    if (locationChanged) {
+        m_location.addToEntity(publicChanges.arg);
         removeFlags(entity_dirty_location);
         hadChanges = true;
-        hadPublicChanges = true;
+        publicChanges.hadChanges = true;
     }
 
     if (hadChanges) {
@@ -355,47 +419,49 @@ void Thing::updateProperties(const Operation& op, OpVector& res)
         removeFlags(entity_clean);
     }
 
-    if (hadPublicChanges) {
-
-        set_arg->setId(getId());
-
-        Set set;
-        set->setTo(getId());
-        set->setFrom(getId());
-        set->setSeconds(op->getSeconds());
-        set->setArgs1(set_arg);
-
-        Sight sight;
-        sight->setArgs1(set);
-        broadcast(sight, res, Visibility::PUBLIC);
+    //Collect the observers only once, even if there are changes with different visibility.
+    static thread_local std::vector<const LocatedEntity*> observers;
+    observers.clear();
+    if (hadChanges) {
+        collectObservers(observers);
     }
 
-    if (hadProtectedChanges) {
-        set_arg_protected->setId(getId());
+    auto sendChanges = [&](PropertyChanges& changes, Visibility visibility) {
+        changes.arg->setId(getId());
+
+        if (createDeltas && changes.hasDeltas && !changes.deltasFailed) {
+            Anonymous delta_arg;
+            delta_arg->setId(getId());
+            for (auto& entry : changes.deltaAttrs) {
+                delta_arg->setAttr(entry.first, std::move(entry.second));
+            }
+            if (visibility == Visibility::PUBLIC && locationChanged) {
+                m_location.addToEntity(delta_arg);
+            }
+            PropertyDeltas::instance().add(changes.arg, delta_arg, op->getSeconds());
+        }
 
         Set set;
         set->setTo(getId());
         set->setFrom(getId());
         set->setSeconds(op->getSeconds());
-        set->setArgs1(set_arg_protected);
+        set->setArgs1(changes.arg);
 
         Sight sight;
         sight->setArgs1(set);
-        broadcast(sight, res, Visibility::PROTECTED);
-    }
+        broadcast(sight, res, visibility, observers);
+    };
 
-    if (hadPrivateChanges) {
-        set_arg_private->setId(getId());
+    if (publicChanges.hadChanges) {
+        sendChanges(publicChanges, Visibility::PUBLIC);
+    }
 
-        Set set;
-        set->setTo(getId());
-        set->setFrom(getId());
-        set->setSeconds(op->getSeconds());
-        set->setArgs1(set_arg_private);
+    if (protectedChanges.hadChanges) {
+        sendChanges(protectedChanges, Visibility::PROTECTED);
+    }
 
-        Sight sight;
-        sight->setArgs1(set);
-        broadcast(sight, res, Visibility::PRIVATE);
+    if (privateChanges.hadChanges) {
+        sendChanges(privateChanges, Visibility::PRIVATE);
     }
 
     //Only change sequence number and call onUpdated if something actually changed.
@@ -441,20 +507,20 @@ void Thing::generateSightOp(const LocatedEntity& observingEntity, const Operatio
     //Admin entities can see all properties
     if (observingEntity.hasFlags(entity_admin)) {
         for (auto& entry : m_properties) {
-            entry.second.property->add(entry.first, sarg);
+            addSeenProperty(entry.first, entry.second, sarg);
         }
     } else if (observingEntity.getIntId() == getIntId()) {
         //Our own entity can see both public and protected, but not private properties.
         for (auto& entry : m_properties) {
             if (!entry.second.property->hasFlags(prop_flag_visibility_private)) {
-                entry.second.property->add(entry.first, sarg);
+                addSeenProperty(entry.first, entry.second, sarg);
             }
         }
     } else {
         //Other entities can only see public properties.
         for (auto& entry : m_properties) {
             if (!entry.second.property->hasFlags(prop_flag_visibility_non_public)) {
-                entry.second.property->add(entry.first, sarg);
+                addSeenProperty(entry.first, entry.second, sarg);
             }
         }
     }
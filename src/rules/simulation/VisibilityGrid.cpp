@@ -0,0 +1,262 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "VisibilityGrid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+    /**
+     * Upper limit of levels, to guard against degenerate radii.
+     */
+    const unsigned int MAX_LEVELS = 32;
+}
+
+VisibilityGrid::VisibilityGrid(float cellSize)
+        : m_cellSize(cellSize)
+{
+    assert(cellSize > 0);
+}
+
+size_t VisibilityGrid::addSphere(void* userPointer, const btVector3& position, float radius, short group, short mask, std::vector<OverlapChange>& changes)
+{
+    size_t handle;
+    if (!m_freeHandles.empty()) {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    } else {
+        handle = m_spheres.size();
+        m_spheres.emplace_back();
+    }
+
+    auto& sphere = m_spheres[handle];
+    sphere.userPointer = userPointer;
+    sphere.x = position.x();
+    sphere.y = position.y();
+    sphere.z = position.z();
+    sphere.radius = radius;
+    sphere.group = group;
+    sphere.mask = mask;
+    sphere.inUse = true;
+
+    //The sphere isn't in any cell yet, so it won't report itself.
+    collectChanges(handle, false, position, radius, changes);
+
+    sphere.level = levelForRadius(radius);
+    insertIntoCell(handle);
+    return handle;
+}
+
+void VisibilityGrid::updateSphere(size_t handle, const btVector3& position, float radius, std::vector<OverlapChange>& changes)
+{
+    assert(handle < m_spheres.size() && m_spheres[handle].inUse);
+
+    collectChanges(handle, true, position, radius, changes);
+
+    auto& sphere = m_spheres[handle];
+    auto newLevel = levelForRadius(radius);
+    auto cellSize = m_levels[newLevel].cellSize;
+    auto newCellKey = cellKey(static_cast<int>(std::floor(position.x() / cellSize)), static_cast<int>(std::floor(position.z() / cellSize)));
+
+    if (newLevel != sphere.level || newCellKey != sphere.cellKey) {
+        removeFromCell(handle);
+        sphere.x = position.x();
+        sphere.y = position.y();
+        sphere.z = position.z();
+        sphere.radius = radius;
+        sphere.level = newLevel;
+        insertIntoCell(handle);
+    } else {
+        sphere.x = position.x();
+        sphere.y = position.y();
+        sphere.z = position.z();
+        sphere.radius = radius;
+        auto& cell = m_levels[sphere.level].cells[sphere.cellKey];
+        cell.x[sphere.indexInCell] = sphere.x;
+        cell.y[sphere.indexInCell] = sphere.y;
+        cell.z[sphere.indexInCell] = sphere.z;
+        cell.radius[sphere.indexInCell] = sphere.radius;
+    }
+}
+
+void VisibilityGrid::removeSphere(size_t handle)
+{
+    assert(handle < m_spheres.size() && m_spheres[handle].inUse);
+    removeFromCell(handle);
+    m_spheres[handle].inUse = false;
+    m_spheres[handle].userPointer = nullptr;
+    m_freeHandles.push_back(handle);
+}
+
+unsigned int VisibilityGrid::levelForRadius(float radius)
+{
+    unsigned int level = 0;
+    float cellSize = m_cellSize;
+    while (radius * 2.0f > cellSize && level < MAX_LEVELS - 1) {
+        cellSize *= 2.0f;
+        ++level;
+    }
+    //Make sure the level exists, since this is called before inserting.
+    while (m_levels.size() <= level) {
+        m_levels.push_back(Level{m_cellSize * std::pow(2.0f, static_cast<float>(m_levels.size())), {}, 0});
+    }
+    return level;
+}
+
+std::uint64_t VisibilityGrid::cellKey(int x, int z)
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32u) | static_cast<std::uint32_t>(z);
+}
+
+void VisibilityGrid::insertIntoCell(size_t handle)
+{
+    auto& sphere = m_spheres[handle];
+    auto& level = m_levels[sphere.level];
+    sphere.cellKey = cellKey(static_cast<int>(std::floor(sphere.x / level.cellSize)), static_cast<int>(std::floor(sphere.z / level.cellSize)));
+    auto& cell = level.cells[sphere.cellKey];
+    sphere.indexInCell = cell.handle.size();
+    cell.x.push_back(sphere.x);
+    cell.y.push_back(sphere.y);
+    cell.z.push_back(sphere.z);
+    cell.radius.push_back(sphere.radius);
+    cell.group.push_back(sphere.group);
+    cell.mask.push_back(sphere.mask);
+    cell.handle.push_back(handle);
+    level.count++;
+}
+
+void VisibilityGrid::removeFromCell(size_t handle)
+{
+    auto& sphere = m_spheres[handle];
+    auto& level = m_levels[sphere.level];
+    auto I = level.cells.find(sphere.cellKey);
+    assert(I != level.cells.end());
+    auto& cell = I->second;
+    auto index = sphere.indexInCell;
+    auto last = cell.handle.size() - 1;
+    //Move the last sphere into the removed slot, to keep the arrays packed.
+    if (index != last) {
+        cell.x[index] = cell.x[last];
+        cell.y[index] = cell.y[last];
+        cell.z[index] = cell.z[last];
+        cell.radius[index] = cell.radius[last];
+        cell.group[index] = cell.group[last];
+        cell.mask[index] = cell.mask[last];
+        cell.handle[index] = cell.handle[last];
+        m_spheres[cell.handle[index]].indexInCell = index;
+    }
+    cell.x.pop_back();
+    cell.y.pop_back();
+    cell.z.pop_back();
+    cell.radius.pop_back();
+    cell.group.pop_back();
+    cell.mask.pop_back();
+    cell.handle.pop_back();
+    level.count--;
+    if (cell.handle.empty()) {
+        level.cells.erase(I);
+    }
+}
+
+void VisibilityGrid::collectChanges(size_t handle, bool hadOldState, const btVector3& position, float radius, std::vector<OverlapChange>& changes)
+{
+    const auto& sphere = m_spheres[handle];
+    for (auto& level : m_levels) {
+        if (level.count == 0) {
+            continue;
+        }
+        //No sphere in this level has a radius larger than half a cell size.
+        auto halfCell = level.cellSize * 0.5f;
+        auto minX = position.x() - radius - halfCell;
+        auto maxX = position.x() + radius + halfCell;
+        auto minZ = position.z() - radius - halfCell;
+        auto maxZ = position.z() + radius + halfCell;
+        if (hadOldState) {
+            minX = std::min(minX, sphere.x - sphere.radius - halfCell);
+            maxX = std::max(maxX, sphere.x + sphere.radius + halfCell);
+            minZ = std::min(minZ, sphere.z - sphere.radius - halfCell);
+            maxZ = std::max(maxZ, sphere.z + sphere.radius + halfCell);
+        }
+        auto cellMinX = static_cast<int>(std::floor(minX / level.cellSize));
+        auto cellMaxX = static_cast<int>(std::floor(maxX / level.cellSize));
+        auto cellMinZ = static_cast<int>(std::floor(minZ / level.cellSize));
+        auto cellMaxZ = static_cast<int>(std::floor(maxZ / level.cellSize));
+
+        auto cellsInRange = (static_cast<std::uint64_t>(cellMaxX - cellMinX) + 1) * (static_cast<std::uint64_t>(cellMaxZ - cellMinZ) + 1);
+        if (cellsInRange > level.cells.size()) {
+            //Large spheres on fine levels would need a lot of lookups; it's then cheaper to just check all occupied cells.
+            for (auto& entry : level.cells) {
+                collectChangesInCell(entry.second, handle, hadOldState, position, radius, changes);
+            }
+        } else {
+            for (auto x = cellMinX; x <= cellMaxX; ++x) {
+                for (auto z = cellMinZ; z <= cellMaxZ; ++z) {
+                    auto I = level.cells.find(cellKey(x, z));
+                    if (I != level.cells.end()) {
+                        collectChangesInCell(I->second, handle, hadOldState, position, radius, changes);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void VisibilityGrid::collectChangesInCell(const Cell& cell, size_t handle, bool hadOldState, const btVector3& position, float radius, std::vector<OverlapChange>& changes)
+{
+    const auto& sphere = m_spheres[handle];
+    auto count = cell.handle.size();
+    m_overlapFlags.resize(count);
+
+    const float* xs = cell.x.data();
+    const float* ys = cell.y.data();
+    const float* zs = cell.z.data();
+    const float* radii = cell.radius.data();
+    const short* groups = cell.group.data();
+    const short* masks = cell.mask.data();
+    std::uint8_t* flags = m_overlapFlags.data();
+
+    const float oldX = sphere.x, oldY = sphere.y, oldZ = sphere.z, oldRadius = sphere.radius;
+    const float newX = position.x(), newY = position.y(), newZ = position.z();
+    const short queryGroup = sphere.group, queryMask = sphere.mask;
+    const std::uint8_t oldFlag = hadOldState ? 1 : 0;
+
+    //Branch free, so that it can be vectorized. Bit 0 is set if it overlapped before, and bit 1 if it overlaps now.
+    for (size_t i = 0; i < count; ++i) {
+        float oldDx = xs[i] - oldX;
+        float oldDy = ys[i] - oldY;
+        float oldDz = zs[i] - oldZ;
+        float oldReach = radii[i] + oldRadius;
+        float newDx = xs[i] - newX;
+        float newDy = ys[i] - newY;
+        float newDz = zs[i] - newZ;
+        float newReach = radii[i] + radius;
+        auto wasOverlapping = static_cast<std::uint8_t>(oldDx * oldDx + oldDy * oldDy + oldDz * oldDz <= oldReach * oldReach) & oldFlag;
+        auto isOverlapping = static_cast<std::uint8_t>(newDx * newDx + newDy * newDy + newDz * newDz <= newReach * newReach) << 1u;
+        auto collides = static_cast<std::uint8_t>((groups[i] & queryMask) != 0) & static_cast<std::uint8_t>((queryGroup & masks[i]) != 0);
+        flags[i] = static_cast<std::uint8_t>((wasOverlapping | isOverlapping) * collides);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        //A value of 1 means that it stopped overlapping, and 2 that it started. 0 or 3 means no change.
+        if ((flags[i] == 1 || flags[i] == 2) && cell.handle[i] != handle) {
+            changes.push_back(OverlapChange{m_spheres[cell.handle[i]].userPointer, flags[i] == 2});
+        }
+    }
+}
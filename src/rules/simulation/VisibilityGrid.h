@@ -0,0 +1,186 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_VISIBILITYGRID_H
+#define CYPHESIS_VISIBILITYGRID_H
+
+#include <LinearMath/btVector3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Keeps track of overlapping spheres, for use with visibility calculations.
+ *
+ * This is meant as a lightweight replacement for a Bullet collision world when all that's needed is to know when
+ * spheres start and stop overlapping.
+ *
+ * Spheres are stored in a spatial hash over the horizontal (x and z) plane. There are multiple levels, each with twice
+ * the cell size of the level below it, and each sphere is placed in the first level where its diameter fits in a cell.
+ * This means that when looking for overlaps at a level we only need to look in the cells within the query sphere's
+ * radius plus half a cell.
+ *
+ * Within each cell the spheres are kept as separate arrays for each component, so that the distance checks can be
+ * vectorized by the compiler.
+ *
+ * Just as with Bullet, each sphere has a collision group and a collision mask, and two spheres are only considered
+ * to overlap if the group of each matches the mask of the other.
+ */
+class VisibilityGrid
+{
+    public:
+        static constexpr size_t invalid_handle = std::numeric_limits<size_t>::max();
+
+        /**
+         * A change in overlap between a moved sphere and another sphere.
+         */
+        struct OverlapChange
+        {
+            /**
+             * The user pointer of the other sphere.
+             */
+            void* userPointer;
+            /**
+             * True if the spheres started overlapping, false if they stopped.
+             */
+            bool added;
+        };
+
+        /**
+         * @brief Ctor.
+         * @param cellSize The size of the cells at the finest level.
+         */
+        explicit VisibilityGrid(float cellSize);
+
+        /**
+         * @brief Adds a new sphere.
+         * @param userPointer A pointer which will be returned in any overlap changes involving this sphere.
+         * @param position The center of the sphere.
+         * @param radius The radius of the sphere.
+         * @param group The collision group.
+         * @param mask The collision mask.
+         * @param changes Any spheres which now overlap the new sphere are added here.
+         * @return A handle to the sphere.
+         */
+        size_t addSphere(void* userPointer, const btVector3& position, float radius, short group, short mask, std::vector<OverlapChange>& changes);
+
+        /**
+         * @brief Moves and/or resizes a sphere.
+         * @param handle A handle to the sphere.
+         * @param position The new center of the sphere.
+         * @param radius The new radius of the sphere.
+         * @param changes Any spheres which started or stopped overlapping the sphere are added here.
+         */
+        void updateSphere(size_t handle, const btVector3& position, float radius, std::vector<OverlapChange>& changes);
+
+        /**
+         * @brief Removes a sphere.
+         *
+         * No overlap changes are reported, just as with Bullet.
+         * @param handle A handle to the sphere.
+         */
+        void removeSphere(size_t handle);
+
+        /**
+         * @brief Gets the number of spheres.
+         */
+        size_t size() const
+        {
+            return m_spheres.size() - m_freeHandles.size();
+        }
+
+    private:
+
+        struct Sphere
+        {
+            void* userPointer;
+            float x;
+            float y;
+            float z;
+            float radius;
+            short group;
+            short mask;
+            unsigned int level;
+            std::uint64_t cellKey;
+            /**
+             * The index of the sphere in the cell's arrays.
+             */
+            size_t indexInCell;
+            bool inUse;
+        };
+
+        /**
+         * A cell, with the spheres stored as separate arrays for each component.
+         */
+        struct Cell
+        {
+            std::vector<float> x;
+            std::vector<float> y;
+            std::vector<float> z;
+            std::vector<float> radius;
+            std::vector<short> group;
+            std::vector<short> mask;
+            std::vector<size_t> handle;
+        };
+
+        struct Level
+        {
+            float cellSize;
+            std::unordered_map<std::uint64_t, Cell> cells;
+            size_t count;
+        };
+
+        float m_cellSize;
+
+        std::vector<Sphere> m_spheres;
+
+        std::vector<size_t> m_freeHandles;
+
+        std::vector<Level> m_levels;
+
+        /**
+         * Scratch buffer used when checking overlaps within a cell.
+         */
+        std::vector<std::uint8_t> m_overlapFlags;
+
+        unsigned int levelForRadius(float radius);
+
+        static std::uint64_t cellKey(int x, int z);
+
+        void insertIntoCell(size_t handle);
+
+        void removeFromCell(size_t handle);
+
+        /**
+         * @brief Finds all spheres for which the overlap with the supplied sphere differs between its old and new state.
+         * @param handle The sphere being checked. Its Sphere struct should contain the old state.
+         * @param hadOldState False if the sphere is new, in which case no old overlaps are considered.
+         * @param position The new center.
+         * @param radius The new radius.
+         * @param changes Changes are added here.
+         */
+        void collectChanges(size_t handle, bool hadOldState, const btVector3& position, float radius, std::vector<OverlapChange>& changes);
+
+        void collectChangesInCell(const Cell& cell, size_t handle, bool hadOldState, const btVector3& position, float radius, std::vector<OverlapChange>& changes);
+};
+
+
+#endif //CYPHESIS_VISIBILITYGRID_H
@@ -42,6 +42,7 @@ void CyPy_World::init_type()
 
     PYCXX_ADD_VARARGS_METHOD(get_entity, get_entity, "Gets the entity with the supplied id.");
     PYCXX_ADD_VARARGS_METHOD(match_entity, match_entity, "Matches a filter against an entity.");
+    PYCXX_ADD_VARARGS_METHOD(match_entities, match_entities, "Matches a filter against a list of entities, returning those which match.");
 
     PYCXX_ADD_NOARGS_METHOD(get_time, get_time, "");
 
@@ -79,3 +80,32 @@ Py::Object CyPy_World::match_entity(const Py::Tuple& args)
     return Py::Boolean(filter->match(queryContext));
 }
 
+Py::Object CyPy_World::match_entities(const Py::Tuple& args)
+{
+    args.verify_length(2);
+    auto& filter = verifyObject<CyPy_Filter>(args.front());
+    auto entities = verifyList(args[1]);
+
+    Py::List list;
+    if (entities.length() == 0) {
+        return list;
+    }
+
+    std::vector<LocatedEntity*> matches;
+    std::map<LocatedEntity*, Py::Object> wrappers;
+    for (auto entity : entities) {
+        auto locatedEntity = verifyObject<CyPy_LocatedEntity>(entity).get();
+        matches.push_back(locatedEntity);
+        wrappers.emplace(locatedEntity, entity);
+    }
+
+    EntityFilter::QueryContext queryContext{*matches.front()};
+    queryContext.entity_lookup_fn = [&](const std::string& id) { return m_value->getEntity(id); };
+    queryContext.type_lookup_fn = [](const std::string& id) { return Inheritance::instance().getType(id); };
+    filter->matchAll(matches, queryContext);
+
+    for (auto entity : matches) {
+        list.append(wrappers.find(entity)->second);
+    }
+    return list;
+}
@@ -46,6 +46,10 @@ class CyPy_World : public WrapperBase<BaseWorld*, CyPy_World>
 
         PYCXX_VARARGS_METHOD_DECL(CyPy_World, match_entity);
 
+        Py::Object match_entities(const Py::Tuple& args);
+
+        PYCXX_VARARGS_METHOD_DECL(CyPy_World, match_entities);
+
 };
 
 
@@ -174,6 +174,23 @@ int Connection::verifyCredentials(const Account& account,
     return check_password(passwd, account.password());
 }
 
+void Connection::readCapabilities(const Root& arg)
+{
+    Element capabilities_attr;
+    if (arg->copyAttr("capabilities", capabilities_attr) != 0 || !capabilities_attr.isList()) {
+        return;
+    }
+    for (auto& capability : capabilities_attr.List()) {
+        if (capability.isString()) {
+            if (capability.String() == "perception_bundle") {
+                setPerceptionBundling(true);
+            } else if (capability.String() == "property_delta") {
+                setPropertyDeltas(true);
+            }
+        }
+    }
+}
+
 size_t Connection::dispatch(size_t numberOfOps)
 {
     size_t processed = 0;
@@ -317,6 +334,7 @@ void Connection::LoginOperation(const Operation& op, OpVector& res)
         clientError(op, "This account is already logged in", res);
         return;
     }
+    readCapabilities(arg);
     // Connect everything up
     addConnectableRouter(account);
     m_server.getLobby().addAccount(account);
@@ -383,6 +401,7 @@ void Connection::CreateOperation(const Operation& op, OpVector& res)
         clientError(op, "Account creation failed", res);
         return;
     }
+    readCapabilities(arg);
     Info info;
     Anonymous info_arg;
     account->addToEntity(info_arg);
@@ -86,6 +86,11 @@ class Connection : public Link, virtual public sigc::trackable
         virtual int verifyCredentials(const Account&,
                                       const Atlas::Objects::Root&) const;
 
+        /**
+         * Reads the optional protocol features the client supports from the "capabilities" list of a Login or Create.
+         */
+        void readCapabilities(const Atlas::Objects::Root& arg);
+
     public:
         ServerRouting& m_server;
 
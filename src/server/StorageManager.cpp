@@ -39,6 +39,8 @@
 
 #include <sigc++/adaptors/bind.h>
 
+#include <chrono>
+#include <algorithm>
 #include <unordered_set>
 #include "Remotery/Remotery.h"
 
@@ -51,16 +53,35 @@ typedef Database::KeyValues KeyValues;
 
 static const bool debug_flag = false;
 
-StorageManager::StorageManager(WorldRouter& world, Database& db, EntityBuilder& entityBuilder) :
+namespace {
+    long millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::size_t hashLocation(const std::string& location, const std::string& parentId)
+    {
+        std::hash<std::string> hasher;
+        return hasher(location) ^ (hasher(parentId) * 31u);
+    }
+}
+
+StorageManager::StorageManager(WorldRouter& world, Database& db, EntityBuilder& entityBuilder,
+                               std::chrono::steady_clock::duration writeBehind,
+                               std::chrono::steady_clock::duration locationWriteInterval) :
         m_world(world),
         m_db(db), m_entityBuilder(entityBuilder),
+        m_writeBehind(writeBehind),
+        m_locationWriteInterval(locationWriteInterval),
         m_insertEntityCount(0), m_updateEntityCount(0),
         m_insertPropertyCount(0), m_updatePropertyCount(0),
         m_insertQps(0), m_updateQps(0),
         m_insertQpsNow(0), m_updateQpsNow(0),
         m_insertQpsAvg(0), m_updateQpsAvg(0),
         m_insertQpsIndex(0), m_updateQpsIndex(0),
-        m_insertQpsRing(), m_updateQpsRing()
+        m_insertQpsRing(), m_updateQpsRing(),
+        m_coalescedUpdateCount(0), m_unchangedPropertyCount(0),
+        m_unchangedLocationCount(0), m_deferredLocationCount(0)
 {
 
     world.inserted.connect(sigc::mem_fun(this,
@@ -85,6 +106,15 @@ StorageManager::StorageManager(WorldRouter& world, Database& db, EntityBuilder&
     Monitors::instance().watch(R"(storage_qps{qtype="updates",t="32"})",
                                new Variable<int>(m_updateQpsAvg));
 
+    Monitors::instance().watch(R"(storage_writes_avoided{reason="coalesced"})",
+                               new Variable<int>(m_coalescedUpdateCount));
+    Monitors::instance().watch(R"(storage_writes_avoided{reason="unchanged_property"})",
+                               new Variable<int>(m_unchangedPropertyCount));
+    Monitors::instance().watch(R"(storage_writes_avoided{reason="unchanged_location"})",
+                               new Variable<int>(m_unchangedLocationCount));
+    Monitors::instance().watch("storage_location_writes_deferred",
+                               new Variable<int>(m_deferredLocationCount));
+
     for (int i = 0; i < 32; ++i) {
         m_insertQpsRing[i] = 0;
         m_updateQpsRing[i] = 0;
@@ -120,16 +150,33 @@ void StorageManager::entityUpdated(LocatedEntity* ent)
 {
     if (ent->isDestroyed()) {
         m_destroyedEntities.push_back(ent->getIntId());
+        m_writtenStates.erase(ent->getIntId());
         return;
     }
-    // Is it already in the dirty Entities queue?
+    // Is it already in the dirty Entities queue? If so this update will be written along with the queued one.
     // Perhaps we need to modify the semantics of the updated signal
     // so it is only emitted if the entity was not marked as dirty.
     if (ent->hasFlags(entity_queued)) {
         // std::cout << "Already queued " << ent->getId() << std::endl << std::flush;
+        //A postponed location write mustn't hold back changed properties for longer than the write behind time.
+        auto I = m_writtenStates.find(ent->getIntId());
+        if (I != m_writtenStates.end() && I->second.deferredLocationWrite != std::chrono::steady_clock::time_point() && hasDirtyProperties(ent)) {
+            auto deferredTime = I->second.deferredLocationWrite;
+            I->second.deferredLocationWrite = {};
+            auto range = m_dirtyEntities.equal_range(deferredTime);
+            for (auto J = range.first; J != range.second; ++J) {
+                if (J->second.get() == ent) {
+                    m_dirtyEntities.erase(J);
+                    break;
+                }
+            }
+            m_dirtyEntities.emplace(std::min(deferredTime, std::chrono::steady_clock::now() + m_writeBehind), Ref<LocatedEntity>(ent));
+            return;
+        }
+        ++m_coalescedUpdateCount;
         return;
     }
-    m_dirtyEntities.emplace_back(Ref<LocatedEntity>(ent));
+    m_dirtyEntities.emplace(std::chrono::steady_clock::now() + m_writeBehind, Ref<LocatedEntity>(ent));
     // std::cout << "Updated fired " << ent->getId() << std::endl << std::flush;
     ent->addFlags(entity_queued);
 }
@@ -147,31 +194,98 @@ void StorageManager::encodeElement(const Atlas::Message::Element& element, std::
     m_db.encodeObject(map, store);
 }
 
-void StorageManager::restorePropertiesRecursively(LocatedEntity* ent)
+void StorageManager::encodeLocation(LocatedEntity* ent, std::string& store)
+{
+    Atlas::Message::MapType map;
+    if (ent->m_location.pos().isValid()) {
+        map["pos"] = ent->m_location.pos().toAtlas();
+    }
+    if (ent->m_location.orientation().isValid()) {
+        map["orientation"] = ent->m_location.orientation().toAtlas();
+    }
+    m_db.encodeObject(map, store);
+}
+
+bool StorageManager::hasDirtyProperties(LocatedEntity* ent) const
+{
+    for (auto& entry : ent->getProperties()) {
+        auto& prop = entry.second.property;
+        if (prop && !prop->hasFlags(prop_flag_persistence_mask)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void StorageManager::restorePropertiesRecursively(LocatedEntity* ent, const std::unordered_map<long, PropertyRows>* bulkProperties)
 {
-    DatabaseResult res = m_db.selectProperties(ent->getId());
+    if (bulkProperties) {
+        auto I = bulkProperties->find(ent->getIntId());
+        if (I != bulkProperties->end()) {
+            restoreProperties(ent, I->second);
+        } else {
+            restoreProperties(ent, {});
+        }
+    } else {
+        DatabaseResult res = m_db.selectProperties(ent->getId());
+
+        PropertyRows rows;
+        auto I = res.begin();
+        auto Iend = res.end();
+        for (; I != Iend; ++I) {
+            const std::string name = I.column("name");
+            if (name.empty()) {
+                log(ERROR, compose("No name column in property row for %1",
+                                   ent->describeEntity()));
+                continue;
+            }
+            const std::string val_string = I.column("value");
+            if (name.empty()) {
+                log(ERROR, compose("No value column in property row for %1,%2",
+                                   ent->describeEntity(), name));
+                continue;
+            }
+            rows.emplace_back(name, val_string);
+        }
+        restoreProperties(ent, rows);
+    }
+
+    //Now restore all properties of the child entities.
+    if (ent->m_contains) {
+        //It might be that the contains field gets altered by restoring of children, so we need to operate on a copy.
+        auto contains = *ent->m_contains;
+        for (auto& childEntity : contains) {
+            restorePropertiesRecursively(childEntity.get(), bulkProperties);
+        }
+    }
 
+//    //We should also send a sight op to the parent entity which owns the entity.
+//    //TODO: should this really be necessary or should we rely on other Sight functionality?
+//    if (ent->m_location.m_parent) {
+//        Atlas::Objects::Operation::Sight sight;
+//        sight->setTo(ent->m_location.m_parent->getId());
+//        Atlas::Objects::Entity::Anonymous args;
+//        ent->addToEntity(args);
+//        sight->setArgs1(args);
+//        ent->m_location.m_parent->sendWorld(sight);
+//    }
+
+}
+
+void StorageManager::restoreProperties(LocatedEntity* ent, const PropertyRows& rows)
+{
     //Keep track of those properties that have been set on the instance, so we'll know what
     //type properties we should ignore.
     std::unordered_set<std::string> instanceProperties;
 
-    auto I = res.begin();
-    auto Iend = res.end();
-    for (; I != Iend; ++I) {
-        const std::string name = I.column("name");
-        if (name.empty()) {
-            log(ERROR, compose("No name column in property row for %1",
-                               ent->describeEntity()));
-            continue;
-        }
-        const std::string val_string = I.column("value");
-        if (name.empty()) {
-            log(ERROR, compose("No value column in property row for %1,%2",
-                               ent->describeEntity(), name));
-            continue;
-        }
+    auto& propertyHashes = m_writtenStates[ent->getIntId()].propertyHashes;
+    std::hash<std::string> hasher;
+
+    for (auto& row : rows) {
+        auto& name = row.first;
+        propertyHashes[name] = hasher(row.second);
         MapType prop_data;
-        m_db.decodeMessage(val_string, prop_data);
+        m_db.decodeMessage(row.second, prop_data);
         auto J = prop_data.find("val");
         if (J == prop_data.end()) {
             log(ERROR, compose("No property value data for %1:%2",
@@ -226,41 +340,17 @@ void StorageManager::restorePropertiesRecursively(LocatedEntity* ent)
             domain->addEntity(*ent);
         }
     }
-
-
-    //Now restore all properties of the child entities.
-    if (ent->m_contains) {
-        //It might be that the contains field gets altered by restoring of children, so we need to operate on a copy.
-        auto contains = *ent->m_contains;
-        for (auto& childEntity : contains) {
-            restorePropertiesRecursively(childEntity.get());
-        }
-    }
-
-//    //We should also send a sight op to the parent entity which owns the entity.
-//    //TODO: should this really be necessary or should we rely on other Sight functionality?
-//    if (ent->m_location.m_parent) {
-//        Atlas::Objects::Operation::Sight sight;
-//        sight->setTo(ent->m_location.m_parent->getId());
-//        Atlas::Objects::Entity::Anonymous args;
-//        ent->addToEntity(args);
-//        sight->setArgs1(args);
-//        ent->m_location.m_parent->sendWorld(sight);
-//    }
-
 }
 
 void StorageManager::insertEntity(LocatedEntity* ent)
 {
     std::string location;
-    Atlas::Message::MapType map;
-    if (ent->m_location.pos().isValid()) {
-        map["pos"] = ent->m_location.pos().toAtlas();
-    }
-    if (ent->m_location.orientation().isValid()) {
-        map["orientation"] = ent->m_location.orientation().toAtlas();
-    }
-    m_db.encodeObject(map, location);
+    encodeLocation(ent, location);
+
+    auto& writtenState = m_writtenStates[ent->getIntId()];
+    writtenState.locationHash = hashLocation(location, ent->m_location.m_parent->getId());
+    writtenState.lastLocationWrite = std::chrono::steady_clock::now();
+    std::hash<std::string> hasher;
 
     m_db.insertEntity(ent->getId(),
                       ent->m_location.m_parent->getId(),
@@ -279,11 +369,13 @@ void StorageManager::insertEntity(LocatedEntity* ent)
         if (prop->hasFlags(prop_flag_persistence_ephem)) {
             continue;
         }
+        auto& encoded = property_tuples[entry.first];
         if (entry.second.modifiers.empty()) {
-            encodeProperty(prop.get(), property_tuples[entry.first]);
+            encodeProperty(prop.get(), encoded);
         } else {
-            encodeElement(entry.second.baseValue, property_tuples[entry.first]);
+            encodeElement(entry.second.baseValue, encoded);
         }
+        writtenState.propertyHashes[entry.first] = hasher(encoded);
         prop->addFlags(prop_flag_persistence_clean | prop_flag_persistence_seen);
     }
     if (!property_tuples.empty()) {
@@ -299,27 +391,31 @@ void StorageManager::insertEntity(LocatedEntity* ent)
 void StorageManager::updateEntity(LocatedEntity* ent)
 {
     std::string location;
-    Atlas::Message::MapType map;
-    if (ent->m_location.pos().isValid()) {
-        map["pos"] = ent->m_location.pos().toAtlas();
-    }
-    if (ent->m_location.orientation().isValid()) {
-        map["orientation"] = ent->m_location.orientation().toAtlas();
-    }
-    m_db.encodeObject(map, location);
-
-    //Under normal circumstances only the top world won't have a location.
-    if (ent->m_location.m_parent) {
-        m_db.updateEntity(ent->getId(),
-                          ent->getSeq(),
-                          location,
-                          ent->m_location.m_parent->getId());
+    encodeLocation(ent, location);
+
+    auto& writtenState = m_writtenStates[ent->getIntId()];
+    std::hash<std::string> hasher;
+
+    //Moving entities often are updated without having moved far enough to alter the encoded location.
+    auto locationHash = hashLocation(location, ent->m_location.m_parent ? ent->m_location.m_parent->getId() : "");
+    if (locationHash != writtenState.locationHash) {
+        //Under normal circumstances only the top world won't have a location.
+        if (ent->m_location.m_parent) {
+            m_db.updateEntity(ent->getId(),
+                              ent->getSeq(),
+                              location,
+                              ent->m_location.m_parent->getId());
+        } else {
+            m_db.updateEntityWithoutLoc(ent->getId(),
+                                        ent->getSeq(),
+                                        location);
+        }
+        writtenState.locationHash = locationHash;
+        writtenState.lastLocationWrite = std::chrono::steady_clock::now();
+        ++m_updateEntityCount;
     } else {
-        m_db.updateEntityWithoutLoc(ent->getId(),
-                                    ent->getSeq(),
-                                    location);
+        ++m_unchangedLocationCount;
     }
-    ++m_updateEntityCount;
     KeyValues new_property_tuples;
     KeyValues upd_property_tuples;
     auto& properties = ent->getProperties();
@@ -332,35 +428,33 @@ void StorageManager::updateEntity(LocatedEntity* ent)
         if (prop->hasFlags(prop_flag_persistence_mask)) {
             continue;
         }
-        KeyValues& active_store = prop->hasFlags(prop_flag_persistence_seen) ? upd_property_tuples : new_property_tuples;
+        std::string encoded;
+        //TODO: Add code for deleting a database row when the value is none.
         if (property.second.modifiers.empty()) {
             Atlas::Message::Element element;
             prop->get(element);
-            if (element.isNone()) {
-                //TODO: Add code for deleting a database row when the value is none.
-                Atlas::Message::MapType propMap{{"val", std::move(element)}};
-                m_db.encodeObject(propMap, active_store[property.first]);
-            } else {
-                Atlas::Message::MapType propMap{{"val", std::move(element)}};
-                m_db.encodeObject(propMap, active_store[property.first]);
-            }
+            Atlas::Message::MapType propMap{{"val", std::move(element)}};
+            m_db.encodeObject(propMap, encoded);
         } else {
-            auto& element = property.second.baseValue;
-            if (element.isNone()) {
-                //TODO: Add code for deleting a database row when the value is none.
-                Atlas::Message::MapType propMap{{"val", element}};
-                m_db.encodeObject(propMap, active_store[property.first]);
-            } else {
-                Atlas::Message::MapType propMap{{"val", element}};
-                m_db.encodeObject(propMap, active_store[property.first]);
-            }
+            Atlas::Message::MapType propMap{{"val", property.second.baseValue}};
+            m_db.encodeObject(propMap, encoded);
         }
 
-        // FIXME check if this is new or just modded.
-        if (prop->hasFlags(prop_flag_persistence_seen)) {
-            ++m_updatePropertyCount;
+        auto hash = hasher(encoded);
+        auto hashI = writtenState.propertyHashes.find(property.first);
+        if (hashI != writtenState.propertyHashes.end() && hashI->second == hash) {
+            //The property has been altered, but the stored value is still the same.
+            ++m_unchangedPropertyCount;
         } else {
-            ++m_insertPropertyCount;
+            //A row might exist even if the property hasn't been seen, if it was restored with a default value.
+            if (prop->hasFlags(prop_flag_persistence_seen) || hashI != writtenState.propertyHashes.end()) {
+                upd_property_tuples[property.first] = std::move(encoded);
+                ++m_updatePropertyCount;
+            } else {
+                new_property_tuples[property.first] = std::move(encoded);
+                ++m_insertPropertyCount;
+            }
+            writtenState.propertyHashes[property.first] = hash;
         }
         prop->addFlags(prop_flag_persistence_clean | prop_flag_persistence_seen);
     }
@@ -385,33 +479,111 @@ size_t StorageManager::restoreChildren(LocatedEntity* parent)
     auto I = res.begin();
     auto Iend = res.end();
     for (; I != Iend; ++I) {
-        const std::string id = I.column("id");
-        const long int_id = forceIntegerId(id);
-        const std::string type = I.column("type");
-        //By sending an empty attributes pointer we're telling the builder not to apply any default
-        //attributes. We will instead apply all attributes ourselves when we later on restore attributes.
-        Atlas::Objects::SmartPtr<Atlas::Objects::Entity::RootEntityData> attrs(nullptr);
-        auto child = m_entityBuilder.newEntity(id, int_id, type, attrs);
-        if (!child) {
-            log(ERROR, compose("Could not restore entity with id %1 of type %2"
-                               ", most likely caused by this type missing.",
-                               id, type));
-            continue;
+        auto child = restoreEntity(parent, {I.column("id"), I.column("type"), I.column("location")});
+        if (child) {
+            childCount++;
+            childCount += restoreChildren(child.get());
         }
-        childCount++;
+    }
+    return childCount;
+}
 
-        const std::string location_string = I.column("location");
-        MapType loc_data;
-        m_db.decodeMessage(location_string, loc_data);
-        child->m_location.readFromMessage(loc_data);
-        child->addFlags(entity_clean | entity_pos_clean | entity_orient_clean);
-        m_world.addEntity(child, parent);
-        childCount += restoreChildren(child.get());
+size_t StorageManager::restoreChildrenBulk(LocatedEntity* parent, const std::unordered_map<long, std::vector<EntityRow>>& rowsByLocation)
+{
+    auto I = rowsByLocation.find(parent->getIntId());
+    if (I == rowsByLocation.end()) {
+        return 0;
+    }
+    size_t childCount = 0;
+    for (auto& row : I->second) {
+        auto child = restoreEntity(parent, row);
+        if (child) {
+            childCount++;
+            childCount += restoreChildrenBulk(child.get(), rowsByLocation);
+        }
     }
     return childCount;
 }
 
-void StorageManager::tick()
+Ref<LocatedEntity> StorageManager::restoreEntity(LocatedEntity* parent, const EntityRow& row)
+{
+    const long int_id = forceIntegerId(row.id);
+    //By sending an empty attributes pointer we're telling the builder not to apply any default
+    //attributes. We will instead apply all attributes ourselves when we later on restore attributes.
+    Atlas::Objects::SmartPtr<Atlas::Objects::Entity::RootEntityData> attrs(nullptr);
+    auto child = m_entityBuilder.newEntity(row.id, int_id, row.type, attrs);
+    if (!child) {
+        log(ERROR, compose("Could not restore entity with id %1 of type %2"
+                           ", most likely caused by this type missing.",
+                           row.id, row.type));
+        return child;
+    }
+
+    m_writtenStates[int_id].locationHash = hashLocation(row.location, parent->getId());
+
+    MapType loc_data;
+    m_db.decodeMessage(row.location, loc_data);
+    child->m_location.readFromMessage(loc_data);
+    child->addFlags(entity_clean | entity_pos_clean | entity_orient_clean);
+    m_world.addEntity(child, parent);
+    return child;
+}
+
+int StorageManager::writeDirtyEntities(bool flush)
+{
+    int updates = 0;
+    auto now = std::chrono::steady_clock::now();
+
+    while (!m_dirtyEntities.empty()) {
+        auto I = m_dirtyEntities.begin();
+        if (!flush) {
+            if (I->first > now) {
+                break;
+            }
+            if (m_db.queryQueueSize() > 200) {
+                debug_print("Too many")
+                break;
+            }
+        }
+        auto ent = std::move(I->second);
+        m_dirtyEntities.erase(I);
+        if (ent) {
+            //An entity destroyed within the write behind time has already been dropped from the database.
+            if (ent->isDestroyed()) {
+                ent->removeFlags(entity_queued);
+                continue;
+            }
+            if ((ent->flags().m_flags & entity_clean_mask) != entity_clean_mask) {
+                auto& writtenState = m_writtenStates[ent->getIntId()];
+                writtenState.deferredLocationWrite = {};
+                //Entities which only have moved are written less often, as they otherwise could be written every tick.
+                //If a property changes meanwhile the entity is queued again with the normal write behind time (see entityUpdated()).
+                if (!flush && m_locationWriteInterval != std::chrono::steady_clock::duration::zero() && !hasDirtyProperties(ent.get())) {
+                    auto earliest = writtenState.lastLocationWrite + m_locationWriteInterval;
+                    if (earliest > now) {
+                        ++m_deferredLocationCount;
+                        writtenState.deferredLocationWrite = earliest;
+                        m_dirtyEntities.emplace(earliest, std::move(ent));
+                        continue;
+                    }
+                }
+                debug(std::cout << "updating " << ent->getId() << std::endl << std::flush;)
+                updateEntity(ent.get());
+                ++updates;
+            }
+            if (ent->hasFlags(entity_dirty_thoughts)) {
+                debug(std::cout << "updating thoughts " << ent->getId() << std::endl << std::flush;)
+                ++updates;
+            }
+            ent->removeFlags(entity_queued);
+        } else {
+            debug(std::cout << "deleted" << std::endl << std::flush;)
+        }
+    }
+    return updates;
+}
+
+void StorageManager::tick(bool flush)
 {
     rmt_ScopedCPUSample(StorageManager_tick, 0)
     int inserts = 0, updates = 0;
@@ -436,28 +608,7 @@ void StorageManager::tick()
         m_unstoredEntities.pop_front();
     }
 
-    while (!m_dirtyEntities.empty()) {
-        if (m_db.queryQueueSize() > 200) {
-            debug_print("Too many")
-            break;
-        }
-        auto& ent = m_dirtyEntities.front();
-        if (ent) {
-            if ((ent->flags().m_flags & entity_clean_mask) != entity_clean_mask) {
-                debug(std::cout << "updating " << ent->getId() << std::endl << std::flush;)
-                updateEntity(ent.get());
-                ++updates;
-            }
-            if (ent->hasFlags(entity_dirty_thoughts)) {
-                debug(std::cout << "updating thoughts " << ent->getId() << std::endl << std::flush;)
-                ++updates;
-            }
-            ent->removeFlags(entity_queued);
-        } else {
-            debug(std::cout << "deleted" << std::endl << std::flush;)
-        }
-        m_dirtyEntities.pop_front();
-    }
+    updates += writeDirtyEntities(flush);
 
     if (inserts > 0 || updates > 0) {
         debug(std::cout << "I: " << inserts << " U: " << updates
@@ -506,30 +657,101 @@ int StorageManager::initWorld(const Ref<LocatedEntity>& ent)
     return 0;
 }
 
-int StorageManager::restoreWorld(const Ref<LocatedEntity>& ent)
+int StorageManager::restoreWorld(const Ref<LocatedEntity>& ent, bool bulk)
 {
     log(INFO, "Starting restoring world from storage.");
+    auto start = std::chrono::steady_clock::now();
 
     //The order here is important. We want to restore the children before we restore the properties.
     //The reason for this is that some properties (such as "attached_*") refer to child entities; if
     //the child isn't present when the property is installed there will be issues.
     //We do this by first restoring the children, without any properties, and the assigning the properties to
     //all entities in order.
-    auto childCount = restoreChildren(ent.get());
-
-    restorePropertiesRecursively(ent.get());
+    auto childCount = bulk ? restoreWorldBulk(ent.get()) : restoreWorldPerEntity(ent.get());
 
     if (childCount > 0) {
-        log(INFO, "Completed restoring world from storage.");
+        log(INFO, compose("Completed restoring world from storage, with %1 entities, in %2 ms.", childCount, millisecondsSince(start)));
     } else {
         log(INFO, "No existing world found in storage.");
     }
     return 0;
 }
 
+size_t StorageManager::restoreWorldBulk(LocatedEntity* world)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::unordered_map<long, std::vector<EntityRow>> entityRowsByLocation;
+    size_t entityRowCount = 0;
+    {
+        DatabaseResult res = m_db.selectAllEntities();
+        auto Iend = res.end();
+        for (auto I = res.begin(); I != Iend; ++I) {
+            auto id = I.column(0);
+            auto loc = I.column(1);
+            //The world entity has no location.
+            if (!id || !loc || *loc == '\0') {
+                continue;
+            }
+            auto type = I.column(2);
+            auto location = I.column(3);
+            entityRowsByLocation[integerId(loc)].push_back({id, type ? type : "", location ? location : ""});
+            ++entityRowCount;
+        }
+    }
+    log(INFO, compose("Read %1 entities from storage in %2 ms.", entityRowCount, millisecondsSince(start)));
+
+    start = std::chrono::steady_clock::now();
+    auto childCount = restoreChildrenBulk(world, entityRowsByLocation);
+    log(INFO, compose("Created %1 entities in %2 ms.", childCount, millisecondsSince(start)));
+    if (childCount < entityRowCount) {
+        log(WARNING, compose("%1 entities in storage could not be restored, either because their type is missing or because they aren't contained in the world.",
+                             entityRowCount - childCount));
+    }
+    entityRowsByLocation.clear();
+
+    start = std::chrono::steady_clock::now();
+    std::unordered_map<long, PropertyRows> propertiesByEntity;
+    size_t propertyRowCount = 0;
+    {
+        DatabaseResult res = m_db.selectAllProperties();
+        auto Iend = res.end();
+        for (auto I = res.begin(); I != Iend; ++I) {
+            auto id = I.column(0);
+            auto name = I.column(1);
+            auto value = I.column(2);
+            if (!id || !name || *name == '\0') {
+                log(ERROR, compose("No name column in property row for %1", id ? id : "<unknown>"));
+                continue;
+            }
+            propertiesByEntity[integerId(id)].emplace_back(name, value ? value : "");
+            ++propertyRowCount;
+        }
+    }
+    log(INFO, compose("Read %1 properties from storage in %2 ms.", propertyRowCount, millisecondsSince(start)));
+
+    start = std::chrono::steady_clock::now();
+    restorePropertiesRecursively(world, &propertiesByEntity);
+    log(INFO, compose("Assigned properties in %1 ms.", millisecondsSince(start)));
+
+    return childCount;
+}
+
+size_t StorageManager::restoreWorldPerEntity(LocatedEntity* world)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto childCount = restoreChildren(world);
+    log(INFO, compose("Created %1 entities in %2 ms.", childCount, millisecondsSince(start)));
+
+    start = std::chrono::steady_clock::now();
+    restorePropertiesRecursively(world);
+    log(INFO, compose("Assigned properties in %1 ms.", millisecondsSince(start)));
+
+    return childCount;
+}
+
 int StorageManager::shutdown(bool& exit_flag_ref, const std::map<long, Ref<LocatedEntity>>& entites)
 {
-    tick();
+    tick(true);
     while (m_db.queryQueueSize()) {
         //Allow for any user to abort the process.
         if (exit_flag_ref) {
@@ -25,10 +25,13 @@
 
 #include <sigc++/trackable.h>
 
+#include <chrono>
 #include <deque>
 #include <string>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <vector>
 #include <Atlas/Message/Element.h>
 
 class Entity;
@@ -45,6 +48,46 @@ class StorageManager : public sigc::trackable
     protected:
         typedef std::deque<Ref<LocatedEntity>> Entitystore;
         typedef std::deque<long> Idstore;
+        /**
+         * Entities keyed by the time when they should be written.
+         */
+        typedef std::multimap<std::chrono::steady_clock::time_point, Ref<LocatedEntity>> ScheduledEntitystore;
+
+        /**
+         * What was last written to the database for an entity, used to skip writes of unchanged data.
+         */
+        struct WrittenState
+        {
+            /**
+             * Hash of the encoded location and the id of the parent.
+             */
+            std::size_t locationHash = 0;
+            std::chrono::steady_clock::time_point lastLocationWrite;
+            /**
+             * If the entity is queued for a location only write which has been postponed by the rate limit, this is
+             * the time it's queued for. Otherwise it's the epoch.
+             */
+            std::chrono::steady_clock::time_point deferredLocationWrite;
+            /**
+             * Hashes of the encoded property values, keyed by property name.
+             */
+            std::unordered_map<std::string, std::size_t> propertyHashes;
+        };
+
+        /**
+         * A persisted entity, as read from the database when restoring.
+         */
+        struct EntityRow
+        {
+            std::string id;
+            std::string type;
+            std::string location;
+        };
+
+        /**
+         * Persisted properties of an entity, as pairs of names and encoded values.
+         */
+        typedef std::vector<std::pair<std::string, std::string>> PropertyRows;
 
         WorldRouter& m_world;
         Database& m_db;
@@ -54,7 +97,19 @@ class StorageManager : public sigc::trackable
         Entitystore m_unstoredEntities;
 
         /// \brief Queue of references to entities with modifications.
-        Entitystore m_dirtyEntities;
+        ///
+        /// An entity is kept here for a while before being written, so that multiple updates can be coalesced
+        /// into a single write.
+        ScheduledEntitystore m_dirtyEntities;
+
+        /// \brief Hashes of what has been written for each persisted entity, keyed by entity id.
+        std::unordered_map<long, WrittenState> m_writtenStates;
+
+        /// \brief How long an updated entity is kept in the queue before it's written.
+        std::chrono::steady_clock::duration m_writeBehind;
+
+        /// \brief The minimal time between writes of an entity where only the location has changed.
+        std::chrono::steady_clock::duration m_locationWriteInterval;
 
         /// \brief Queue of IDs of entities that are destroyed
         Idstore m_destroyedEntities;
@@ -80,6 +135,15 @@ class StorageManager : public sigc::trackable
         std::array<int, 32> m_insertQpsRing;
         std::array<int, 32> m_updateQpsRing;
 
+        /// \brief Number of updates merged with an already queued update of the same entity.
+        int m_coalescedUpdateCount;
+        /// \brief Number of property writes skipped since the encoded value was unchanged.
+        int m_unchangedPropertyCount;
+        /// \brief Number of entity row writes skipped since the encoded location was unchanged.
+        int m_unchangedLocationCount;
+        /// \brief Number of location only writes postponed by the rate limit.
+        int m_deferredLocationCount;
+
         void entityInserted(LocatedEntity*);
 
         void entityUpdated(LocatedEntity*);
@@ -88,7 +152,29 @@ class StorageManager : public sigc::trackable
 
         void encodeElement(const Atlas::Message::Element& element, std::string& store);
 
-        void restorePropertiesRecursively(LocatedEntity*);
+        void encodeLocation(LocatedEntity* ent, std::string& store);
+
+        /**
+         * @brief Checks if any persisted property of the entity has changed since it was last written.
+         */
+        bool hasDirtyProperties(LocatedEntity* ent) const;
+
+        /**
+         * @brief Writes all dirty entities that are due.
+         * @param flush If true, all entities are written regardless of when they are due.
+         * @return The number of written entities.
+         */
+        int writeDirtyEntities(bool flush);
+
+        /**
+         * @brief Restores the properties of the entity and all of its children.
+         * @param ent The entity.
+         * @param bulkProperties If set, properties are taken from this, keyed by entity id. Otherwise the database
+         * is queried for each entity.
+         */
+        void restorePropertiesRecursively(LocatedEntity* ent, const std::unordered_map<long, PropertyRows>* bulkProperties = nullptr);
+
+        void restoreProperties(LocatedEntity* ent, const PropertyRows& rows);
 
         void insertEntity(LocatedEntity*);
 
@@ -96,16 +182,57 @@ class StorageManager : public sigc::trackable
 
         size_t restoreChildren(LocatedEntity*);
 
+        /**
+         * @brief Restores all children of the entity, recursively, from rows already read from the database.
+         * @param parent The parent entity.
+         * @param rowsByLocation All persisted entities, keyed by the id of their parent.
+         * @return The number of restored entities.
+         */
+        size_t restoreChildrenBulk(LocatedEntity* parent, const std::unordered_map<long, std::vector<EntityRow>>& rowsByLocation);
+
+        Ref<LocatedEntity> restoreEntity(LocatedEntity* parent, const EntityRow& row);
+
+        /**
+         * @brief Restores the world by reading each of the entities and properties tables in one go.
+         * @return The number of restored entities.
+         */
+        size_t restoreWorldBulk(LocatedEntity* world);
+
+        /**
+         * @brief Restores the world by querying the database for the children and properties of each entity in turn.
+         * @return The number of restored entities.
+         */
+        size_t restoreWorldPerEntity(LocatedEntity* world);
+
     public:
-        explicit StorageManager(WorldRouter& world, Database& db, EntityBuilder& entityBuilder);
+        /**
+         * @brief Ctor.
+         * @param writeBehind How long an updated entity is held before being written. Any further updates during
+         * this time are coalesced into the same write.
+         * @param locationWriteInterval The minimal time between writes of entities for which only the location has
+         * changed. This prevents moving entities from being written constantly.
+         */
+        explicit StorageManager(WorldRouter& world, Database& db, EntityBuilder& entityBuilder,
+                                std::chrono::steady_clock::duration writeBehind = std::chrono::steady_clock::duration::zero(),
+                                std::chrono::steady_clock::duration locationWriteInterval = std::chrono::steady_clock::duration::zero());
 
         virtual ~StorageManager();
 
-        void tick();
+        /**
+         * @brief Writes pending changes to the database.
+         * @param flush If true, all changes are written at once, without regard for the write behind window or
+         * location rate limit. Used when shutting down.
+         */
+        void tick(bool flush = false);
 
         int initWorld(const Ref<LocatedEntity>& ent);
 
-        int restoreWorld(const Ref<LocatedEntity>& ent);
+        /**
+         * @brief Restores the world from storage.
+         * @param ent The world entity.
+         * @param bulk True if whole tables should be read at once, which is much faster than querying for each entity.
+         */
+        int restoreWorld(const Ref<LocatedEntity>& ent, bool bulk = true);
 
         /// \brief Called when shutting down.
         ///
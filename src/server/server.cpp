@@ -72,6 +72,12 @@
 #include <common/DatabaseSQLite.h>
 #include <common/RepeatedTask.h>
 #include <common/MainLoop.h>
+#include <common/MulticastOps.h>
+#include <common/CorkedWrites.h>
+#include <common/PerceptionAggregator.h>
+#include <common/PropertyDeltas.h>
+#include <rules/simulation/CollisionShapeCache.h>
+#include <common/IoThreads.h>
 #include <rules/simulation/python/CyPy_Server.h>
 #include <rules/python/CyPy_Physics.h>
 #include <rules/entityfilter/python/CyPy_EntityFilter.h>
@@ -79,6 +85,7 @@
 #include <rules/python/CyPy_Common.h>
 #include <rules/python/CyPy_Rules.h>
 #include <rules/simulation/ExternalMind.h>
+#include <rules/simulation/PhysicalDomainTickExecutor.h>
 
 #include <Atlas/Objects/RootEntity.h>
 
@@ -111,6 +118,43 @@ namespace {
     INT_OPTION(ai_clients, 1, CYPHESIS, "aiclients",
                "Number of AI clients to spawn.")
 
+    INT_OPTION(physics_threads, 0, CYPHESIS, "physicsthreads",
+               "Number of worker threads used for stepping physical domains in parallel. 0 means that all domains are stepped on the main thread.")
+
+    STRING_OPTION(operations_queue, "heap", CYPHESIS, "opqueue",
+                  "Backend used for queueing future operations. Either \"heap\" or \"wheel\" (hierarchical timing wheel).")
+
+    STRING_OPTION(visibility_engine, "bullet", CYPHESIS, "visibilityengine",
+                  "Engine used for calculating visibility in physical domains. Either \"bullet\" or \"grid\" (spatial hash).")
+
+    INT_OPTION(cork_threshold, 65536, CYPHESIS, "corkthreshold",
+               "Writes to clients are held back while operations are processed, unless more than this number of bytes are buffered. 0 disables this.")
+
+    INT_OPTION(perception_bundle_size, 256, CYPHESIS, "perceptionbundlesize",
+               "Perception ops sent to a client while operations are processed are sent as one bundle, if the client supports it, with at most this many ops in each. 0 disables this.")
+
+    INT_OPTION(io_threads, 0, CYPHESIS, "iothreads",
+               "Number of threads used for reading from and decoding data from client sockets. 0 means that all sockets are handled on the main thread.")
+
+    BOOL_OPTION(bulk_restore, true, CYPHESIS, "bulkrestore",
+                "Flag to control whether the world is restored by reading all entities and properties from storage at once, instead of querying for each entity.")
+
+    BOOL_OPTION(multicast_encoding, true, CYPHESIS, "multicastencoding",
+                "Flag to control whether ops sent to many clients, such as movement updates, are encoded only once.")
+
+    BOOL_OPTION(property_deltas, false, CYPHESIS, "propertydeltas",
+                "Flag to control whether changes to map and list properties are sent as deltas to clients which support it. "
+                "Off by default, since creating the deltas has a cost even when no connected client asks for them.")
+
+    BOOL_OPTION(collision_shape_cache, true, CYPHESIS, "collisionshapecache",
+                "Flag to control whether entities with the same geometry and size share the same collision shape.")
+
+    INT_OPTION(storage_write_behind, 2000, CYPHESIS, "storagewritebehind",
+               "Milliseconds an updated entity is held before being written to storage. Any further updates during this time are written together with the first one.")
+
+    INT_OPTION(storage_location_interval, 10000, CYPHESIS, "storagelocationinterval",
+               "Minimum milliseconds between writes to storage of an entity where only the location has changed. 0 disables this.")
+
     /**
      * Wraps either a Postgres server connection along with a vacuum socket, or a SQLite connection along with a vacuum task.
      */
@@ -233,13 +277,17 @@ namespace {
         std::unique_ptr<CommAsioListener<ip::tcp, CommHttpClient>> httpListener;
     };
 
-    SocketListeners createListeners(io_context& io_context, ServerRouting& serverRouting, Atlas::Objects::Factories& atlasFactories, HttpRequestProcessor& httpRequestProcessor)
+    SocketListeners createListeners(io_context& io_context,
+                                    ServerRouting& serverRouting,
+                                    Atlas::Objects::Factories& atlasFactories,
+                                    HttpRequestProcessor& httpRequestProcessor,
+                                    IoThreads* ioThreads)
     {
 
         SocketListeners socketListeners;
 
         auto tcpAtlasCreator = [&]() -> std::shared_ptr<CommAsioClient<ip::tcp>> {
-            return std::make_shared<CommAsioClient<ip::tcp>>(serverRouting.getName(), io_context, atlasFactories);
+            return std::make_shared<CommAsioClient<ip::tcp>>(serverRouting.getName(), io_context, atlasFactories, ioThreads);
         };
 
         std::function<void(CommAsioClient<ip::tcp>&)> tcpAtlasStarter = [&](CommAsioClient<ip::tcp>& client) {
@@ -312,7 +360,7 @@ namespace {
 
         remove(client_socket_name.c_str());
         auto localCreator = [&]() -> std::shared_ptr<CommAsioClient<local::stream_protocol>> {
-            return std::make_shared<CommAsioClient<local::stream_protocol>>(serverRouting.getName(), io_context, atlasFactories);
+            return std::make_shared<CommAsioClient<local::stream_protocol>>(serverRouting.getName(), io_context, atlasFactories, ioThreads);
         };
         auto localStarter = [&](CommAsioClient<local::stream_protocol>& client) {
             std::string connection_id;
@@ -401,6 +449,13 @@ namespace {
         }
 
 
+        //The IO threads must outlive all client sockets, since these use the io_contexts owned by the threads.
+        std::unique_ptr<IoThreads> ioThreads;
+        if (io_threads > 0) {
+            log(INFO, String::compose("Using %1 threads for handling client sockets.", io_threads));
+            ioThreads = std::make_unique<IoThreads>(static_cast<size_t>(io_threads));
+        }
+
         auto io_context = std::make_unique<boost::asio::io_context>();
 
         {
@@ -475,7 +530,65 @@ namespace {
             std::chrono::steady_clock::time_point time{};
             auto timeProviderFn = [&]() -> std::chrono::steady_clock::duration { return time - std::chrono::steady_clock::time_point{}; };
 
+            //Created before the world, so that it outlives all domains, which remove their queued steps when destroyed.
+            std::unique_ptr<PhysicalDomainTickExecutor> physicalDomainTickExecutor;
+            if (physics_threads > 0) {
+                log(INFO, String::compose("Using %1 threads for stepping physical domains.", physics_threads));
+                physicalDomainTickExecutor.reset(new PhysicalDomainTickExecutor(static_cast<size_t>(physics_threads)));
+            }
+
+            if (visibility_engine == "grid") {
+                log(INFO, "Using a spatial hash grid for visibility calculations.");
+                PhysicalDomain::s_defaultVisibilityEngine = PhysicalDomain::VisibilityEngine::Grid;
+            } else if (visibility_engine != "bullet") {
+                log(WARNING, String::compose("Unknown visibility engine '%1', using the default Bullet engine.", visibility_engine));
+            }
+
+            std::unique_ptr<CorkedWrites> corkedWrites;
+            if (cork_threshold > 0) {
+                corkedWrites = std::make_unique<CorkedWrites>(static_cast<size_t>(cork_threshold));
+                monitors.watch("corked_writes", new Variable<int>(corkedWrites->m_corkedWrites));
+                monitors.watch("corked_writes_saved", new Variable<int>(corkedWrites->m_writesSaved));
+            }
+
+            std::unique_ptr<PerceptionAggregator> perceptionAggregator;
+            if (perception_bundle_size > 0) {
+                perceptionAggregator = std::make_unique<PerceptionAggregator>(static_cast<size_t>(perception_bundle_size));
+                monitors.watch("perception_bundles_sent", new Variable<int>(perceptionAggregator->m_bundlesSent));
+                monitors.watch("perception_ops_bundled", new Variable<int>(perceptionAggregator->m_opsBundled));
+            }
+
+            std::unique_ptr<MulticastOps> multicastOps;
+            if (multicast_encoding) {
+                multicastOps = std::make_unique<MulticastOps>();
+                monitors.watch("multicast_encoded_count", new Variable<int>(multicastOps->m_encodedCount));
+                monitors.watch("multicast_encoded_bytes", new Variable<int>(multicastOps->m_encodedBytes));
+                monitors.watch("multicast_sent_count", new Variable<int>(multicastOps->m_sentCount));
+                monitors.watch("multicast_sent_bytes", new Variable<int>(multicastOps->m_sentBytes));
+            }
+
+            std::unique_ptr<PropertyDeltas> propertyDeltas;
+            if (property_deltas) {
+                propertyDeltas = std::make_unique<PropertyDeltas>();
+                monitors.watch("property_deltas_registered", new Variable<int>(propertyDeltas->m_registeredCount));
+                monitors.watch("property_deltas_sent", new Variable<int>(propertyDeltas->m_sentCount));
+            }
+
+            std::unique_ptr<CollisionShapeCache> collisionShapeCache;
+            if (collision_shape_cache) {
+                collisionShapeCache = std::make_unique<CollisionShapeCache>();
+                monitors.watch("collision_shape_cache_hits", new Variable<int>(collisionShapeCache->m_hits));
+                monitors.watch("collision_shape_cache_misses", new Variable<int>(collisionShapeCache->m_misses));
+                monitors.watch("collision_shape_cache_bytes_saved", new Variable<int>(collisionShapeCache->m_bytesSaved));
+            }
+
             WorldRouter world(baseEntity, entityBuilder, timeProviderFn);
+            if (operations_queue == "wheel") {
+                log(INFO, "Using a timing wheel for the operations queue.");
+                world.getOperationsHandler().setQueueType(OpQueueType::TimingWheel);
+            } else if (operations_queue != "heap") {
+                log(WARNING, String::compose("Unknown operations queue type '%1', using the default heap.", operations_queue));
+            }
 
             std::map<int, int> operationsMap;
             monitors.watch("operations_processed", new Variable<int>(world.m_operationsCount));
@@ -494,7 +607,9 @@ namespace {
             PossessionAuthenticator possessionAuthenticator;
 
             ExternalMindsManager externalMindsManager;
-            StorageManager store(world, serverDatabase->database(), entityBuilder);
+            StorageManager store(world, serverDatabase->database(), entityBuilder,
+                                 std::chrono::milliseconds(storage_write_behind),
+                                 std::chrono::milliseconds(storage_location_interval));
 
             //Instantiate at startup
             HttpCache httpCache(monitors);
@@ -526,7 +641,7 @@ namespace {
 
             log(INFO, "Restoring world from database...");
 
-            store.restoreWorld(baseEntity);
+            store.restoreWorld(baseEntity, bulk_restore);
             // Read the world entity if any from the database, or set it up.
             // If it was there, make sure it did not get any of the wrong
             // position or orientation data.
@@ -612,18 +727,32 @@ namespace {
             };
 
             auto dispatchOperationsFn = [&]() {
+                if (ioThreads) {
+                    ioThreads->processQueue();
+                }
                 serverRouting.dispatch(2);
             };
 
+            std::function<bool()> operationsProcessedFn;
+            if (physicalDomainTickExecutor) {
+                //Physical domains are stepped once all ops have been processed, so that any changes made by them are included.
+                operationsProcessedFn = [&]() {
+                    return physicalDomainTickExecutor->runQueuedTicks();
+                };
+            }
+
 
             //Initially there are a couple of pent up operations we need to run to get up to speed. 10 seconds is a suitable large number.
             world.getOperationsHandler().idle(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+            if (physicalDomainTickExecutor) {
+                physicalDomainTickExecutor->runQueuedTicks();
+            }
             //Report to log when time diff between when an operation should have been handled and when it actually was
             world.getOperationsHandler().m_time_diff_report = std::chrono::milliseconds(200);
 
             //Inner loop, where listeners are active.
             {
-                auto socketListeners = createListeners(*io_context, serverRouting, atlasFactories, httpCache);
+                auto socketListeners = createListeners(*io_context, serverRouting, atlasFactories, httpCache, ioThreads.get());
 
                 auto metaClient = createMetaClient(*io_context);
                 auto mdnsClient = createMDNSClient(*io_context, serverRouting);
@@ -631,7 +760,7 @@ namespace {
                 IdleConnector storage_idle(*io_context);
                 storage_idle.idling.connect([&store]() { store.tick(); });
 
-                MainLoop::run(daemon_flag, *io_context, world.getOperationsHandler(), {softExitStart, softExitPoll, softExitTimeout, dispatchOperationsFn}, time);
+                MainLoop::run(daemon_flag, *io_context, world.getOperationsHandler(), {softExitStart, softExitPoll, softExitTimeout, dispatchOperationsFn, operationsProcessedFn}, time);
                 if (metaClient) {
                     metaClient->metaserverTerminate();
                 }
@@ -658,6 +787,10 @@ namespace {
 
 
             serverRouting.disconnectAllConnections();
+            //Wait for the IO threads to be done with the disconnected sockets.
+            if (ioThreads) {
+                ioThreads->shutdown();
+            }
 
             //Clear out reference
             baseEntity.reset();
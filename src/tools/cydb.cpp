@@ -33,6 +33,7 @@
 #include "common/globals.h"
 #include "common/system.h"
 #include "common/Storage.h"
+#include "common/CompactEncoding.h"
 
 #include <varconf/config.h>
 
@@ -46,6 +47,7 @@
 #include <readline/readline.h>
 
 #include <cstring>
+#include <vector>
 #include <common/DatabaseSQLite.h>
 
 namespace {
@@ -100,6 +102,103 @@ namespace {
         return 0;
     }
 
+    /// \brief Converts legacy encoded data to a compact encoding SQL blob literal.
+    ///
+    /// @return False if the data already is compact, or can't be converted.
+    static bool convert_to_compact(const std::string& data, std::string& literal)
+    {
+        if (data.empty() || CompactEncoding::isCompact(data)) {
+            return false;
+        }
+        Atlas::Message::MapType map;
+        std::string encoded;
+        if (Database::instance().decodeMessage(data, map) != 0 || !CompactEncoding::encode(map, encoded)) {
+            return false;
+        }
+        static const char hex[] = "0123456789ABCDEF";
+        literal = "X'";
+        for (auto c : encoded) {
+            literal += hex[(static_cast<unsigned char>(c) >> 4) & 0xF];
+            literal += hex[static_cast<unsigned char>(c) & 0xF];
+        }
+        literal += "'";
+        return true;
+    }
+
+    static int world_migrate(Storage& ab, struct dbsys* system,
+                             int argc, char** argv)
+    {
+        auto& database = Database::instance();
+        // All updates are collected before any is run, so that the tables aren't altered while being read.
+        std::vector<std::string> updates;
+        size_t legacyCount = 0;
+
+        {
+            DatabaseResult res = database.runSimpleSelectQuery("SELECT id, location FROM entities");
+            for (auto I = res.begin(); I != res.end(); ++I) {
+                auto location = I.column("location");
+                if (location == nullptr || *location == 0) {
+                    continue;
+                }
+                std::string literal;
+                if (convert_to_compact(location, literal)) {
+                    updates.emplace_back(String::compose("UPDATE entities SET location = %1 WHERE id = %2",
+                                                         literal, I.column("id")));
+                } else if (!CompactEncoding::isCompact(location)) {
+                    ++legacyCount;
+                }
+            }
+        }
+
+        {
+            DatabaseResult res = database.runSimpleSelectQuery("SELECT id, name, value FROM properties");
+            for (auto I = res.begin(); I != res.end(); ++I) {
+                auto value = I.column("value");
+                if (value == nullptr || *value == 0) {
+                    continue;
+                }
+                std::string literal;
+                if (convert_to_compact(value, literal)) {
+                    std::string name = I.column("name");
+                    // Property names are escaped, even though they normally never contain quotes.
+                    for (size_t pos = name.find('\''); pos != std::string::npos; pos = name.find('\'', pos + 2)) {
+                        name.insert(pos, 1, '\'');
+                    }
+                    updates.emplace_back(String::compose("UPDATE properties SET value = %1 WHERE id = %2 AND name = '%3'",
+                                                         literal, I.column("id"), name));
+                } else if (!CompactEncoding::isCompact(value)) {
+                    ++legacyCount;
+                }
+            }
+        }
+
+        if (database.runCommandQuery("BEGIN") != 0) {
+            std::cout << "Migration fail" << std::endl << std::flush;
+            return 1;
+        }
+        for (auto& update : updates) {
+            if (database.runCommandQuery(update) != 0) {
+                database.runCommandQuery("ROLLBACK");
+                std::cout << "Migration fail, no data was changed" << std::endl << std::flush;
+                return 1;
+            }
+        }
+        if (database.runCommandQuery("COMMIT") != 0) {
+            std::cout << "Migration fail" << std::endl << std::flush;
+            return 1;
+        }
+        // Reclaim the space freed by the smaller encoding.
+        database.runCommandQuery("VACUUM");
+
+        std::cout << "Migrated " << updates.size() << " entries to the compact encoding." << std::endl;
+        if (legacyCount != 0) {
+            std::cout << legacyCount << " entries could not be converted and were kept in the legacy encoding."
+                      << std::endl;
+        }
+        std::cout << std::flush;
+        return 0;
+    }
+
     static int users_purge(Storage& ab, struct dbsys* system,
                            int argc, char** argv)
     {
@@ -263,8 +362,9 @@ namespace {
     }
 
     struct dbsys world_cmds[] = {
-        {"purge", "Purge world data", &world_purge, 0},
-        {"help",  "Show world help",  &dbs_help,    &world_cmds[0]},
+        {"purge",   "Purge world data",                                 &world_purge,   0},
+        {"migrate", "Convert world data to the compact storage encoding", &world_migrate, 0},
+        {"help",    "Show world help",                                  &dbs_help,      &world_cmds[0]},
         {nullptr, "Guard",}
     };
 
@@ -156,6 +156,15 @@ const PropertyBase * LocatedEntity::getProperty(const std::string & name) const
     return 0;
 }
 
+const PropertyBase * LocatedEntity::getProperty(PropertyId id) const
+{
+    auto modifiableProperty = m_properties.find(id);
+    if (modifiableProperty) {
+        return modifiableProperty->property.get();
+    }
+    return 0;
+}
+
 #include "stubs/rules/simulation/stubEntity.h"
 
 
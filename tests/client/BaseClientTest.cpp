@@ -116,6 +116,7 @@ RootOperation ClientConnection::pop()
 #include "../stubs/client/cyclient/stubClientConnection.h"
 #include "../stubs/client/cyclient/stubCharacterClient.h"
 #include "../stubs/rules/ai/stubMemMap.h"
+#include "../stubs/rules/ai/stubLocationIndex.h"
 #include "../stubs/common/stubAtlasStreamClient.h"
 #include "../stubs/common/stublog.h"
 #include "../stubs/common/stubProperty.h"
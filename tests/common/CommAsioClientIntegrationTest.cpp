@@ -0,0 +1,173 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+
+#include "common/CommAsioClient_impl.h"
+#include "common/IoThreads.h"
+#include "common/Link.h"
+
+#include <Atlas/Objects/Factories.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <boost/asio/local/connect_pair.hpp>
+
+using boost::asio::local::stream_protocol;
+
+class TestLink : public Link
+{
+    public:
+        explicit TestLink(CommSocket& socket) : Link(socket, "1", 1), connected(false)
+        {}
+
+        void externalOperation(const Operation& op, Link&) override
+        {
+            receivedSerialnos.push_back(op->getSerialno());
+        }
+
+        void operation(const Operation&, OpVector&) override
+        {}
+
+        void notifyConnectionComplete() override
+        {
+            connected = true;
+        }
+
+        bool connected;
+        std::vector<long> receivedSerialnos;
+};
+
+struct TestContext
+{
+    Atlas::Objects::Factories factories;
+    boost::asio::io_context io_context;
+    IoThreads ioThreads{1};
+
+    /**
+     * Runs the main thread parts until the condition is met, or a deadline is reached.
+     */
+    bool runUntil(const std::function<bool()>& condition)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            io_context.poll();
+            ioThreads.processQueue();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_sendAndReceive)
+        ADD_TEST(test_shutdownWhileNegotiating)
+    }
+
+    /**
+     * Sends ops both ways at the same time, so that the server side encodes on the main thread while decoding on its IO thread.
+     */
+    void test_sendAndReceive(TestContext& context)
+    {
+        auto server = std::make_shared<CommAsioClient<stream_protocol>>("server", context.io_context, context.factories, &context.ioThreads);
+        auto client = std::make_shared<CommAsioClient<stream_protocol>>("client", context.io_context, context.factories, nullptr);
+        boost::asio::local::connect_pair(server->getSocket(), client->getSocket());
+
+        auto serverLink = new TestLink(*server);
+        auto clientLink = new TestLink(*client);
+        server->startAccept(std::unique_ptr<Link>(serverLink));
+        client->startConnect(std::unique_ptr<Link>(clientLink));
+
+        ASSERT_TRUE(context.runUntil([&]() { return serverLink->connected && clientLink->connected; }))
+
+        const long opCount = 2000;
+        for (long i = 1; i <= opCount; ++i) {
+            Atlas::Objects::Operation::Talk toServer;
+            toServer->setSerialno(i);
+            toServer->setAttr("say", std::string(i % 100, 'a'));
+            clientLink->send(toServer);
+
+            Atlas::Objects::Operation::Talk toClient;
+            toClient->setSerialno(i);
+            toClient->setAttr("say", std::string(i % 100, 'b'));
+            serverLink->send(toClient);
+
+            context.io_context.poll();
+            context.ioThreads.processQueue();
+        }
+
+        ASSERT_TRUE(context.runUntil([&]() {
+            return serverLink->receivedSerialnos.size() == opCount && clientLink->receivedSerialnos.size() == opCount;
+        }))
+
+        //All ops should have arrived intact and in order.
+        for (long i = 0; i < opCount; ++i) {
+            ASSERT_EQUAL(i + 1, serverLink->receivedSerialnos[i])
+            ASSERT_EQUAL(i + 1, clientLink->receivedSerialnos[i])
+        }
+
+        server->disconnect();
+        client->disconnect();
+        std::weak_ptr<CommAsioClient<stream_protocol>> serverRef = server;
+        server.reset();
+        client.reset();
+
+        context.ioThreads.shutdown();
+        context.io_context.poll();
+        ASSERT_TRUE(serverRef.expired())
+    }
+
+    /**
+     * A socket which never completes negotiation should not hold up shutdown until the negotiation times out.
+     */
+    void test_shutdownWhileNegotiating(TestContext& context)
+    {
+        auto server = std::make_shared<CommAsioClient<stream_protocol>>("server", context.io_context, context.factories, &context.ioThreads);
+        stream_protocol::socket peer(context.io_context);
+        boost::asio::local::connect_pair(server->getSocket(), peer);
+
+        server->startAccept(std::unique_ptr<Link>(new TestLink(*server)));
+        std::weak_ptr<CommAsioClient<stream_protocol>> serverRef = server;
+        server.reset();
+
+        auto start = std::chrono::steady_clock::now();
+        context.ioThreads.shutdown(std::chrono::milliseconds(100));
+        ASSERT_TRUE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+        //The abandoned socket should have been released.
+        ASSERT_TRUE(serverRef.expired())
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
@@ -0,0 +1,128 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+
+#include "common/CompactEncoding.h"
+
+#include <cmath>
+#include <limits>
+
+using Atlas::Message::Element;
+using Atlas::Message::ListType;
+using Atlas::Message::MapType;
+
+struct TestContext
+{
+    MapType createMap()
+    {
+        return MapType{
+            {"none",     Element()},
+            {"zero",     0},
+            {"int",      12345},
+            {"negative", -1},
+            {"max",      std::numeric_limits<Atlas::Message::IntType>::max()},
+            {"min",      std::numeric_limits<Atlas::Message::IntType>::min()},
+            {"float",    1.5},
+            {"fzero",    0.0},
+            {"nzero",    -0.0},
+            {"small",    1e-300},
+            {"string",   "hello"},
+            {"empty",    ""},
+            {"",         "empty key"},
+            {"list",     ListType{1.0, 2.0, ListType{}, MapType{}}},
+            {"map",      MapType{{"pos", ListType{-3.25, 0.0, 100.0}}, {"mode", "free"}}}
+        };
+    }
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_roundtrip)
+        ADD_TEST(test_no_zero_bytes)
+        ADD_TEST(test_embedded_zero)
+        ADD_TEST(test_invalid)
+    }
+
+    void test_roundtrip(TestContext& context)
+    {
+        auto map = context.createMap();
+        std::string data;
+        ASSERT_TRUE(CompactEncoding::encode(map, data))
+        ASSERT_TRUE(CompactEncoding::isCompact(data))
+
+        MapType decoded;
+        ASSERT_TRUE(CompactEncoding::decode(data, decoded))
+        ASSERT_EQUAL(map, decoded)
+        ASSERT_TRUE(std::signbit(decoded["nzero"].Float()))
+
+        //Common values should be short; here five bytes of header, key and tag, and three bytes for the float.
+        ASSERT_TRUE(CompactEncoding::encode(MapType{{"a", 1.0}}, data))
+        ASSERT_EQUAL(8u, data.size())
+    }
+
+    void test_no_zero_bytes(TestContext& context)
+    {
+        std::string data;
+        ASSERT_TRUE(CompactEncoding::encode(context.createMap(), data))
+        ASSERT_EQUAL(std::string::npos, data.find('\0'))
+
+        //The data should survive being passed around as a C string.
+        MapType decoded;
+        ASSERT_TRUE(CompactEncoding::decode(std::string(data.c_str()), decoded))
+        ASSERT_EQUAL(context.createMap(), decoded)
+    }
+
+    void test_embedded_zero(TestContext& context)
+    {
+        std::string data;
+        ASSERT_FALSE(CompactEncoding::encode(MapType{{"a", std::string("b\0c", 3)}}, data))
+    }
+
+    void test_invalid(TestContext& context)
+    {
+        MapType decoded;
+        //Legacy Packed data.
+        ASSERT_FALSE(CompactEncoding::isCompact("[attr=$1@@]"))
+        ASSERT_FALSE(CompactEncoding::decode("[attr=$1@@]", decoded))
+        ASSERT_FALSE(CompactEncoding::isCompact(""))
+
+        std::string data;
+        ASSERT_TRUE(CompactEncoding::encode(context.createMap(), data))
+        for (size_t i = 1; i < data.size(); ++i) {
+            ASSERT_FALSE(CompactEncoding::decode(data.substr(0, i), decoded))
+        }
+        ASSERT_FALSE(CompactEncoding::decode(data + "x", decoded))
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
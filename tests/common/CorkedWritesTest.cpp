@@ -0,0 +1,177 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+
+#include "common/CorkedWrites.h"
+#include "common/CommSocket.h"
+
+/**
+ * A socket which, like CommAsioClient, asks CorkedWrites whether each flush should be deferred.
+ */
+class TestCommSocket : public CommSocket, public std::enable_shared_from_this<TestCommSocket>
+{
+    public:
+        explicit TestCommSocket(boost::asio::io_context& io_context) : CommSocket(io_context), writes(0), bufferedBytes(0), flushDeferred(false)
+        {}
+
+        void disconnect() override
+        {}
+
+        int flush() override
+        {
+            if (CorkedWrites::instance().deferFlush(shared_from_this(), bufferedBytes, flushDeferred)) {
+                return 0;
+            }
+            writes++;
+            bufferedBytes = 0;
+            return 0;
+        }
+
+        int writes;
+        size_t bufferedBytes;
+        bool flushDeferred;
+};
+
+struct TestContext
+{
+    boost::asio::io_context io_context;
+    CorkedWrites corkedWrites{1024};
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_uncorked)
+        ADD_TEST(test_corked)
+        ADD_TEST(test_deferFlush)
+        ADD_TEST(test_threshold)
+    }
+
+    void test_uncorked(TestContext& context)
+    {
+        auto socket = std::make_shared<TestCommSocket>(context.io_context);
+        socket->flush();
+        socket->flush();
+        ASSERT_EQUAL(2, socket->writes)
+        context.corkedWrites.uncork();
+        ASSERT_EQUAL(2, socket->writes)
+        ASSERT_EQUAL(0, context.corkedWrites.m_corkedWrites)
+    }
+
+    void test_corked(TestContext& context)
+    {
+        auto socket1 = std::make_shared<TestCommSocket>(context.io_context);
+        auto socket2 = std::make_shared<TestCommSocket>(context.io_context);
+
+        context.corkedWrites.cork();
+        ASSERT_TRUE(context.corkedWrites.isCorked())
+        socket1->flush();
+        socket1->flush();
+        socket1->flush();
+        socket2->flush();
+        ASSERT_EQUAL(0, socket1->writes)
+        ASSERT_EQUAL(0, socket2->writes)
+
+        context.corkedWrites.uncork();
+        ASSERT_FALSE(context.corkedWrites.isCorked())
+        ASSERT_EQUAL(1, socket1->writes)
+        ASSERT_EQUAL(1, socket2->writes)
+        ASSERT_EQUAL(2, context.corkedWrites.m_corkedWrites)
+        ASSERT_EQUAL(2, context.corkedWrites.m_writesSaved)
+
+        //The sockets should be released once flushed.
+        ASSERT_EQUAL(1, socket1.use_count())
+        ASSERT_EQUAL(1, socket2.use_count())
+    }
+
+    void test_deferFlush(TestContext& context)
+    {
+        auto socket = std::make_shared<TestCommSocket>(context.io_context);
+        bool flushDeferred = false;
+
+        //Nothing is deferred when not corked.
+        ASSERT_FALSE(context.corkedWrites.deferFlush(socket, 10, flushDeferred))
+        ASSERT_FALSE(flushDeferred)
+
+        context.corkedWrites.cork();
+        //The first flush registers the socket.
+        ASSERT_TRUE(context.corkedWrites.deferFlush(socket, 10, flushDeferred))
+        ASSERT_TRUE(flushDeferred)
+        ASSERT_EQUAL(0, context.corkedWrites.m_writesSaved)
+        ASSERT_EQUAL(2, socket.use_count())
+
+        //Any further ones are counted as saved, without registering the socket again.
+        ASSERT_TRUE(context.corkedWrites.deferFlush(socket, 20, flushDeferred))
+        ASSERT_TRUE(flushDeferred)
+        ASSERT_EQUAL(1, context.corkedWrites.m_writesSaved)
+        ASSERT_EQUAL(2, socket.use_count())
+
+        //When uncorked the socket is flushed, which resets the flag.
+        context.corkedWrites.uncork();
+        ASSERT_EQUAL(1, socket->writes)
+        ASSERT_FALSE(socket->flushDeferred)
+        ASSERT_EQUAL(1, context.corkedWrites.m_corkedWrites)
+
+        //The flag kept by the caller is reset when asked while uncorked.
+        ASSERT_FALSE(context.corkedWrites.deferFlush(socket, 10, flushDeferred))
+        ASSERT_FALSE(flushDeferred)
+    }
+
+    void test_threshold(TestContext& context)
+    {
+        auto socket = std::make_shared<TestCommSocket>(context.io_context);
+
+        context.corkedWrites.cork();
+        socket->bufferedBytes = 100;
+        socket->flush();
+        ASSERT_EQUAL(0, socket->writes)
+        ASSERT_TRUE(socket->flushDeferred)
+
+        //Once the threshold is reached the socket should be written to even though corked.
+        socket->bufferedBytes = context.corkedWrites.getByteThreshold();
+        socket->flush();
+        ASSERT_EQUAL(1, socket->writes)
+        ASSERT_EQUAL(0, context.corkedWrites.m_writesSaved)
+
+        //Further flushes are deferred again, and the socket is still registered from before.
+        socket->bufferedBytes = 100;
+        socket->flush();
+        ASSERT_EQUAL(1, socket->writes)
+        ASSERT_EQUAL(1, context.corkedWrites.m_writesSaved)
+
+        context.corkedWrites.uncork();
+        ASSERT_EQUAL(2, socket->writes)
+        ASSERT_EQUAL(1, context.corkedWrites.m_corkedWrites)
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
@@ -0,0 +1,178 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+
+#include "common/DatabaseSQLite.h"
+#include "common/globals.h"
+#include "common/log.h"
+#include "common/compose.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#include <chrono>
+#include <thread>
+
+namespace {
+    const int entityCount = 1000;
+    const int propertiesPerEntity = 10;
+    /**
+     * The unbatched path syncs to disk for every command, so fewer rounds are run with it.
+     */
+    const int unbatchedUpdateRounds = 1;
+    const int batchedUpdateRounds = 5;
+
+    std::string propertyName(int index)
+    {
+        return String::compose("prop%1", index);
+    }
+
+    std::string propertyValue(int round, int entity)
+    {
+        return String::compose("value updated %1 times for entity %2", round, entity);
+    }
+}
+
+struct TestContext
+{
+    boost::filesystem::path directory;
+    std::unique_ptr<DatabaseSQLite> database;
+
+    TestContext()
+    {
+        directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        var_directory = directory.string();
+        database = std::make_unique<DatabaseSQLite>();
+        database->initConnection();
+        database->registerEntityTable({{"location", 0}});
+        database->registerPropertyTable();
+
+        for (int entity = 1; entity <= entityCount; ++entity) {
+            auto id = std::to_string(entity);
+            database->insertEntity(id, "0", "thing", 0, "");
+            Database::KeyValues properties;
+            for (int i = 0; i < propertiesPerEntity; ++i) {
+                properties.emplace(propertyName(i), propertyValue(0, entity));
+            }
+            database->insertProperties(id, properties);
+        }
+        waitForQueue();
+    }
+
+    ~TestContext()
+    {
+        database.reset();
+        boost::filesystem::remove_all(directory);
+    }
+
+    void waitForQueue()
+    {
+        while (database->queryQueueSize() != 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::string selectValue(int entity, int property)
+    {
+        auto result = database->runSimpleSelectQuery(String::compose("SELECT value FROM properties WHERE id = %1 AND name = '%2'",
+                                                                     entity, propertyName(property)));
+        auto I = result.begin();
+        if (I == result.end()) {
+            return "";
+        }
+        return I.column(0);
+    }
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_unbatched)
+        ADD_TEST(test_batched)
+    }
+
+    /**
+     * Updates properties the way it was done before batching was introduced: one textual command at a time, each in
+     * its own implicit transaction, with the default journal.
+     */
+    void test_unbatched(TestContext& context)
+    {
+        auto& database = *context.database;
+        database.runCommandQuery("PRAGMA journal_mode=DELETE");
+        database.runCommandQuery("PRAGMA synchronous=FULL");
+
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 1; round <= unbatchedUpdateRounds; ++round) {
+            for (int entity = 1; entity <= entityCount; ++entity) {
+                for (int i = 0; i < propertiesPerEntity; ++i) {
+                    database.runCommandQuery(String::compose("UPDATE properties SET value = '%3' WHERE id=%1 AND name='%2'",
+                                                             entity, propertyName(i), propertyValue(round, entity)));
+                }
+            }
+        }
+        report("unbatched", unbatchedUpdateRounds, start);
+
+        ASSERT_EQUAL(propertyValue(unbatchedUpdateRounds, 1), context.selectValue(1, 0))
+        ASSERT_EQUAL(propertyValue(unbatchedUpdateRounds, entityCount), context.selectValue(entityCount, propertiesPerEntity - 1))
+    }
+
+    void test_batched(TestContext& context)
+    {
+        auto& database = *context.database;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 1; round <= batchedUpdateRounds; ++round) {
+            for (int entity = 1; entity <= entityCount; ++entity) {
+                Database::KeyValues properties;
+                for (int i = 0; i < propertiesPerEntity; ++i) {
+                    properties.emplace(propertyName(i), propertyValue(round, entity));
+                }
+                database.updateProperties(std::to_string(entity), properties);
+            }
+        }
+        context.waitForQueue();
+        report("batched", batchedUpdateRounds, start);
+
+        ASSERT_EQUAL(propertyValue(batchedUpdateRounds, 1), context.selectValue(1, 0))
+        ASSERT_EQUAL(propertyValue(batchedUpdateRounds, entityCount), context.selectValue(entityCount, propertiesPerEntity - 1))
+    }
+
+    void report(const std::string& name, int rounds, std::chrono::steady_clock::time_point start)
+    {
+        auto updates = rounds * entityCount * propertiesPerEntity;
+        long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        log(INFO, String::compose("Persisting %1 property updates %2 took %3 ms (%4 updates per second).", updates, name, milliseconds,
+                                  milliseconds > 0 ? (updates * 1000L) / milliseconds : updates * 1000L));
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
@@ -275,6 +275,7 @@ void EntityExerciser::flushOperations(OpVector & ops)
 TypeNode::PropertiesUpdate TypeNode::injectProperty(const std::string& name,
                               std::unique_ptr<PropertyBase> p)
 {
+    indexDefault(name, p.get());
     m_defaults[name] = std::move(p);
     return {};
 }
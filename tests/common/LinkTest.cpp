@@ -28,8 +28,10 @@
 
 #include "common/CommSocket.h"
 #include "common/Link.h"
+#include "common/PerceptionAggregator.h"
 
 #include <Atlas/Objects/Encoder.h>
+#include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/RootOperation.h>
 #include <Atlas/Objects/SmartPtr.h>
 
@@ -90,6 +92,7 @@ class Linktest : public Cyphesis::TestBase
     Atlas::Objects::ObjectsEncoder * m_encoder;
 
     static bool CommSocket_flush_called;
+    static int CommSocket_flush_count;
     static bool CommSocket_disconnect_called;
   public:
     Linktest();
@@ -102,6 +105,9 @@ class Linktest : public Cyphesis::TestBase
     void test_sendError();
     void test_sendError_connected();
     void test_disconnect();
+    void test_sendPerception();
+    void test_sendPerception_bundled();
+    void test_sendPerception_maxBundleSize();
 
     static void set_CommSocket_flush_called();
     static void set_CommSocket_disconnect_called();
@@ -119,11 +125,13 @@ int TestCommSocket::flush()
 }
 
 bool Linktest::CommSocket_flush_called = false;
+int Linktest::CommSocket_flush_count = 0;
 bool Linktest::CommSocket_disconnect_called = false;
 
 void Linktest::set_CommSocket_flush_called()
 {
     CommSocket_flush_called = true;
+    CommSocket_flush_count++;
 }
 
 void Linktest::set_CommSocket_disconnect_called()
@@ -138,6 +146,9 @@ Linktest::Linktest()
     ADD_TEST(Linktest::test_sendError);
     ADD_TEST(Linktest::test_sendError_connected);
     ADD_TEST(Linktest::test_disconnect);
+    ADD_TEST(Linktest::test_sendPerception);
+    ADD_TEST(Linktest::test_sendPerception_bundled);
+    ADD_TEST(Linktest::test_sendPerception_maxBundleSize);
 }
 
 void Linktest::setup()
@@ -215,6 +226,87 @@ void Linktest::test_disconnect()
     ASSERT_TRUE(CommSocket_disconnect_called);
 }
 
+void Linktest::test_sendPerception()
+{
+    CommSocket_flush_count = 0;
+
+    PerceptionAggregator perceptionAggregator(10);
+    m_encoder = new Atlas::Objects::ObjectsEncoder(*m_bridge);
+    m_link->setEncoder(m_encoder);
+
+    //The client hasn't declared support for bundles, so each op is sent right away.
+    perceptionAggregator.start();
+    m_link->sendPerception(Atlas::Objects::Operation::Sight());
+    m_link->sendPerception(Atlas::Objects::Operation::Sight());
+    ASSERT_EQUAL(2, CommSocket_flush_count);
+
+    perceptionAggregator.flush();
+    ASSERT_EQUAL(2, CommSocket_flush_count);
+    ASSERT_EQUAL(0, perceptionAggregator.m_bundlesSent);
+}
+
+void Linktest::test_sendPerception_bundled()
+{
+    CommSocket_flush_count = 0;
+
+    PerceptionAggregator perceptionAggregator(10);
+    m_encoder = new Atlas::Objects::ObjectsEncoder(*m_bridge);
+    m_link->setEncoder(m_encoder);
+    m_link->setPerceptionBundling(true);
+
+    //Ops are sent right away when not collecting.
+    m_link->sendPerception(Atlas::Objects::Operation::Sight());
+    ASSERT_EQUAL(1, CommSocket_flush_count);
+
+    perceptionAggregator.start();
+    m_link->sendPerception(Atlas::Objects::Operation::Sight());
+    m_link->sendPerception(Atlas::Objects::Operation::Sight());
+    m_link->sendPerception(Atlas::Objects::Operation::Sight());
+    ASSERT_EQUAL(1, CommSocket_flush_count);
+
+    perceptionAggregator.flush();
+    ASSERT_EQUAL(2, CommSocket_flush_count);
+    ASSERT_EQUAL(1, perceptionAggregator.m_bundlesSent);
+    ASSERT_EQUAL(3, perceptionAggregator.m_opsBundled);
+
+    //Any other op sent to the client must come after the held back perceptions.
+    perceptionAggregator.start();
+    m_link->sendPerception(Atlas::Objects::Operation::Sight());
+    m_link->sendPerception(Atlas::Objects::Operation::Sight());
+    m_link->send(Atlas::Objects::Operation::Info());
+    ASSERT_EQUAL(4, CommSocket_flush_count);
+    ASSERT_EQUAL(2, perceptionAggregator.m_bundlesSent);
+
+    perceptionAggregator.flush();
+    ASSERT_EQUAL(4, CommSocket_flush_count);
+    ASSERT_EQUAL(2, perceptionAggregator.m_bundlesSent);
+    ASSERT_EQUAL(5, perceptionAggregator.m_opsBundled);
+}
+
+void Linktest::test_sendPerception_maxBundleSize()
+{
+    CommSocket_flush_count = 0;
+
+    PerceptionAggregator perceptionAggregator(2);
+    m_encoder = new Atlas::Objects::ObjectsEncoder(*m_bridge);
+    m_link->setEncoder(m_encoder);
+    m_link->setPerceptionBundling(true);
+
+    perceptionAggregator.start();
+    m_link->sendPerception(Atlas::Objects::Operation::Sight());
+    m_link->sendPerception(Atlas::Objects::Operation::Sight());
+    ASSERT_EQUAL(1, CommSocket_flush_count);
+    ASSERT_EQUAL(1, perceptionAggregator.m_bundlesSent);
+
+    m_link->sendPerception(Atlas::Objects::Operation::Sight());
+    ASSERT_EQUAL(1, CommSocket_flush_count);
+
+    //A single op isn't bundled.
+    perceptionAggregator.flush();
+    ASSERT_EQUAL(2, CommSocket_flush_count);
+    ASSERT_EQUAL(1, perceptionAggregator.m_bundlesSent);
+}
+
 int main()
 {
     Linktest t;
@@ -231,3 +323,7 @@ int CommSocket::flush()
 {
     return 0;
 }
+
+namespace Atlas { namespace Objects { namespace Operation {
+int BUNDLE_NO = -1;
+} } }
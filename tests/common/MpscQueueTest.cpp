@@ -0,0 +1,123 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+
+#include "common/MpscQueue.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct TestContext
+{
+    MpscQueue<int> queue;
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_order)
+        ADD_TEST(test_move_only)
+        ADD_TEST(test_producers)
+    }
+
+    void test_order(TestContext& context)
+    {
+        int value;
+        ASSERT_FALSE(context.queue.pop(value))
+
+        context.queue.push(1);
+        context.queue.push(2);
+        ASSERT_TRUE(context.queue.pop(value))
+        ASSERT_EQUAL(1, value)
+        context.queue.push(3);
+        ASSERT_TRUE(context.queue.pop(value))
+        ASSERT_EQUAL(2, value)
+        ASSERT_TRUE(context.queue.pop(value))
+        ASSERT_EQUAL(3, value)
+        ASSERT_FALSE(context.queue.pop(value))
+    }
+
+    void test_move_only(TestContext&)
+    {
+        MpscQueue<std::unique_ptr<int>> queue;
+        queue.push(std::make_unique<int>(1));
+        //Values left in the queue should be destroyed along with it.
+        queue.push(std::make_unique<int>(2));
+
+        std::unique_ptr<int> value;
+        ASSERT_TRUE(queue.pop(value))
+        ASSERT_EQUAL(1, *value)
+    }
+
+    void test_producers(TestContext& context)
+    {
+        const int producerCount = 4;
+        const int valuesPerProducer = 10000;
+
+        std::vector<std::thread> producers;
+        for (int producer = 0; producer < producerCount; ++producer) {
+            producers.emplace_back([&context, producer]() {
+                for (int i = 0; i < valuesPerProducer; ++i) {
+                    context.queue.push(producer * valuesPerProducer + i);
+                }
+            });
+        }
+
+        //Values from each producer should arrive in the order they were pushed.
+        std::vector<int> lastValues(producerCount, -1);
+        int received = 0;
+        while (received < producerCount * valuesPerProducer) {
+            int value;
+            if (context.queue.pop(value)) {
+                int producer = value / valuesPerProducer;
+                ASSERT_TRUE(value % valuesPerProducer > lastValues[producer])
+                lastValues[producer] = value % valuesPerProducer;
+                ++received;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        for (auto& thread : producers) {
+            thread.join();
+        }
+        for (auto lastValue : lastValues) {
+            ASSERT_EQUAL(valuesPerProducer - 1, lastValue)
+        }
+        int value;
+        ASSERT_FALSE(context.queue.pop(value))
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
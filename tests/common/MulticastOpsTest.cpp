@@ -0,0 +1,150 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+
+#include "common/MulticastOps.h"
+
+#include <Atlas/Message/QueuedDecoder.h>
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+using Atlas::Message::MapType;
+using Atlas::Objects::Entity::Anonymous;
+using Atlas::Objects::Operation::Set;
+using Atlas::Objects::Operation::Sight;
+
+struct TestContext
+{
+    MulticastOps multicastOps;
+
+    Set setOp;
+
+    TestContext()
+    {
+        Anonymous arg;
+        arg->setId("1");
+        arg->setAttr("pos", Atlas::Message::ListType{1.0, 2.0, 3.0});
+        arg->setAttr("mode", "free");
+        setOp->setArgs1(arg);
+        setOp->setFrom("1");
+        setOp->setTo("1");
+        setOp->setSeconds(10);
+    }
+
+    Sight createSight(const std::string& to, double seconds)
+    {
+        Sight sight;
+        sight->setArgs1(setOp);
+        sight->setFrom("1");
+        if (!to.empty()) {
+            sight->setTo(to);
+        }
+        sight->setSeconds(seconds);
+        return sight;
+    }
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_write)
+        ADD_TEST(test_find)
+        ADD_TEST(test_expire)
+    }
+
+    void test_write(TestContext& context)
+    {
+        EncodedOp encodedOp(context.createSight("", 10));
+
+        Atlas::Message::QueuedDecoder decoder;
+        encodedOp.write(decoder, "2", 11);
+        ASSERT_EQUAL(1u, decoder.queueSize())
+        MapType message = decoder.popMessage();
+
+        MapType expected = context.createSight("2", 11)->asMessage();
+        ASSERT_EQUAL(expected, message)
+    }
+
+    void test_find(TestContext& context)
+    {
+        auto& multicastOps = context.multicastOps;
+        ASSERT_NULL(multicastOps.find(context.createSight("2", 10)))
+
+        multicastOps.add(context.createSight("", 10));
+        ASSERT_EQUAL(1u, multicastOps.size())
+        ASSERT_EQUAL(1, multicastOps.m_encodedCount)
+        ASSERT_TRUE(multicastOps.m_encodedBytes > 0)
+
+        //Only "to" and "seconds" may differ.
+        ASSERT_NOT_NULL(multicastOps.find(context.createSight("2", 10)))
+        ASSERT_NOT_NULL(multicastOps.find(context.createSight("3", 11)))
+
+        auto otherFrom = context.createSight("2", 10);
+        otherFrom->setFrom("2");
+        ASSERT_NULL(multicastOps.find(otherFrom))
+
+        auto withRefno = context.createSight("2", 10);
+        withRefno->setRefno(1);
+        ASSERT_NULL(multicastOps.find(withRefno))
+
+        Atlas::Objects::Operation::Appearance otherType;
+        otherType->setArgs1(context.setOp);
+        otherType->setFrom("1");
+        ASSERT_NULL(multicastOps.find(otherType))
+
+        //An equal, but not the same, arg shouldn't match.
+        Sight copiedArgs;
+        copiedArgs->setArgs1(context.setOp.copy());
+        copiedArgs->setFrom("1");
+        ASSERT_NULL(multicastOps.find(copiedArgs))
+    }
+
+    void test_expire(TestContext& context)
+    {
+        auto& multicastOps = context.multicastOps;
+        multicastOps.add(context.createSight("", 10));
+
+        //Registering another op a long time after should remove the first one.
+        Set otherSetOp;
+        Sight otherSight;
+        otherSight->setArgs1(otherSetOp);
+        otherSight->setFrom("1");
+        otherSight->setSeconds(20);
+        multicastOps.add(otherSight);
+
+        ASSERT_EQUAL(1u, multicastOps.size())
+        ASSERT_NULL(multicastOps.find(context.createSight("2", 20)))
+        ASSERT_NOT_NULL(multicastOps.find(otherSight))
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
@@ -0,0 +1,129 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "../TestBaseWithContext.h"
+
+#include "common/OperationsDispatcher_impl.h"
+#include "common/Monitors.h"
+#include "common/log.h"
+#include "common/compose.hpp"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <modules/ReferenceCounted.h>
+
+#include <chrono>
+#include <random>
+#include <sstream>
+
+struct TestContext
+{
+};
+
+struct TestEntity : ReferenceCounted
+{
+    std::string describeEntity() const
+    {
+        return "";
+    }
+
+    std::string getId() const
+    {
+        return "1";
+    }
+};
+
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_throughputHeap)
+        ADD_TEST(test_throughputTimingWheel)
+    }
+
+    void test_throughputHeap(TestContext& context)
+    {
+        throughput(OpQueueType::Heap, "heap");
+    }
+
+    void test_throughputTimingWheel(TestContext& context)
+    {
+        throughput(OpQueueType::TimingWheel, "timing wheel");
+    }
+
+    /**
+     * Simulates a world with a large amount of entities, each with a Tick op which reschedules itself.
+     */
+    void throughput(OpQueueType queueType, const std::string& name)
+    {
+        const size_t numberOfTicks = 300000;
+        const auto sliceSize = std::chrono::milliseconds(15);
+        const size_t numberOfSlices = 20 * 60; //Twenty seconds worth of slices.
+
+        std::mt19937 random(1);
+        std::uniform_int_distribution<int> tickInterval(50, 5000);
+
+        std::chrono::milliseconds time(0);
+        auto timeProviderFn = [&time]() -> std::chrono::steady_clock::duration { return time; };
+        OperationsDispatcher<TestEntity>* dispatcherPtr = nullptr;
+        size_t dispatched = 0;
+        auto processorFn = [&](const Operation& op, Ref<TestEntity> from) {
+            dispatched++;
+            Operation tick;
+            tick->setSeconds(std::chrono::duration_cast<std::chrono::duration<double>>(time + std::chrono::milliseconds(tickInterval(random))).count());
+            dispatcherPtr->addOperationToQueue(tick, std::move(from));
+        };
+
+        OperationsDispatcher<TestEntity> dispatcher(processorFn, timeProviderFn);
+        dispatcherPtr = &dispatcher;
+        dispatcher.setQueueType(queueType);
+
+        Ref<TestEntity> entity(new TestEntity);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < numberOfTicks; ++i) {
+            Operation tick;
+            tick->setSeconds(tickInterval(random) / 1000.0);
+            dispatcher.addOperationToQueue(tick, entity);
+        }
+        long insertMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+        start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < numberOfSlices; ++i) {
+            time += sliceSize;
+            dispatcher.processUntil(std::chrono::steady_clock::time_point(time), std::chrono::steady_clock::time_point::max());
+        }
+        long processMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+        ASSERT_EQUAL(numberOfTicks, dispatcher.getQueueSize())
+
+        log(INFO, String::compose("Inserting %1 ops with %2 took %3 ms.", numberOfTicks, name, insertMilliseconds));
+        log(INFO, String::compose("Dispatching %1 ops with %2 took %3 ms (%4 ops per ms).", dispatched, name, processMilliseconds,
+                                  processMilliseconds > 0 ? dispatched / processMilliseconds : dispatched));
+    }
+
+};
+
+int main()
+{
+    Tested t;
+    Monitors m;
+
+    return t.run();
+}
@@ -58,10 +58,90 @@ struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
     Tested()
     {
         ADD_TEST(test_dispatchInOrder)
+        ADD_TEST(test_dispatchInOrderTimingWheel)
+        ADD_TEST(test_timingWheelCascade)
+        ADD_TEST(test_switchQueueType)
 
     }
 
     void test_dispatchInOrder(TestContext& context)
+    {
+        dispatchInOrder(OpQueueType::Heap);
+    }
+
+    void test_dispatchInOrderTimingWheel(TestContext& context)
+    {
+        dispatchInOrder(OpQueueType::TimingWheel);
+    }
+
+    void test_timingWheelCascade(TestContext& context)
+    {
+        std::chrono::milliseconds time(0);
+        std::vector<long> dispatched;
+        auto processorFn = [&](const Operation& op, Ref<TestEntity>) { dispatched.push_back(op->getRefno()); };
+        auto timeProviderFn = [&time]() -> std::chrono::steady_clock::duration { return time; };
+
+        OperationsDispatcher<TestEntity> dispatcher(processorFn, timeProviderFn);
+        dispatcher.setQueueType(OpQueueType::TimingWheel);
+
+        Ref<TestEntity> entity(new TestEntity);
+
+        //Spread the ops out so that they end up in all wheels as well as in the overflow.
+        //Add them in reverse, and with duplicated times, to check the ordering.
+        std::vector<double> seconds{0.001, 0.002, 0.255, 0.256, 0.257, 1.0, 65.535, 65.536, 100.0, 20000.0, 5000000.0, 5000000.0};
+        for (size_t i = seconds.size(); i > 0; --i) {
+            Operation op;
+            op->setSeconds(seconds[i - 1]);
+            op->setRefno(static_cast<long>(i));
+            dispatcher.addOperationToQueue(op, entity);
+        }
+        ASSERT_EQUAL(seconds.size(), dispatcher.getQueueSize())
+
+        //An op with the same time as an already queued one should be dispatched after it.
+        {
+            Operation op;
+            op->setSeconds(0.256);
+            op->setRefno(100);
+            dispatcher.addOperationToQueue(op, entity);
+        }
+
+        auto processed = dispatcher.processUntil(std::chrono::steady_clock::time_point(std::chrono::seconds(6000000)),
+                                                 std::chrono::steady_clock::time_point::max());
+        ASSERT_EQUAL(seconds.size() + 1, processed)
+        ASSERT_TRUE(dispatcher.getQueue().empty())
+
+        std::vector<long> expected{1, 2, 3, 4, 100, 5, 6, 7, 8, 9, 10, 12, 11};
+        ASSERT_TRUE(expected == dispatched)
+    }
+
+    void test_switchQueueType(TestContext& context)
+    {
+        std::chrono::milliseconds time(0);
+        auto processorFn = [](const Operation&, Ref<TestEntity>) {};
+        auto timeProviderFn = [&time]() -> std::chrono::steady_clock::duration { return time; };
+
+        OperationsDispatcher<TestEntity> dispatcher(processorFn, timeProviderFn);
+
+        Ref<TestEntity> entity(new TestEntity);
+        for (long i = 3; i > 0; --i) {
+            Operation op;
+            op->setSeconds(i);
+            op->setRefno(i);
+            dispatcher.addOperationToQueue(op, entity);
+        }
+
+        dispatcher.setQueueType(OpQueueType::TimingWheel);
+        auto& queue = dispatcher.getQueue();
+        ASSERT_EQUAL(3u, queue.size())
+        ASSERT_EQUAL(queue.top().op->getRefno(), 1)
+        queue.pop();
+        ASSERT_EQUAL(queue.top().op->getRefno(), 2)
+        queue.pop();
+        ASSERT_EQUAL(queue.top().op->getRefno(), 3)
+        queue.pop();
+    }
+
+    void dispatchInOrder(OpQueueType queueType)
     {
 
         std::chrono::milliseconds time(0);
@@ -69,6 +149,7 @@ struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
         auto timeProviderFn = [&time]() -> std::chrono::steady_clock::duration { return time; };
 
         OperationsDispatcher<TestEntity> dispatcher(processorFn, timeProviderFn);
+        dispatcher.setQueueType(queueType);
         auto& queue = dispatcher.getQueue();
 
         Ref<TestEntity> entity(new TestEntity);
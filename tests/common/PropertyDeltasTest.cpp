@@ -0,0 +1,195 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+
+#include "common/PropertyDeltas.h"
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+using Atlas::Message::Element;
+using Atlas::Message::ListType;
+using Atlas::Message::MapType;
+using Atlas::Objects::Entity::Anonymous;
+using Atlas::Objects::Operation::Set;
+using Atlas::Objects::Operation::Sight;
+
+struct TestContext
+{
+    PropertyDeltas propertyDeltas;
+
+    Anonymous arg;
+    Set setOp;
+
+    TestContext()
+    {
+        arg->setId("1");
+        arg->setAttr("inventory", MapType{{"a", 1}, {"b", 2}, {"c", 3}});
+        setOp->setArgs1(arg);
+        setOp->setFrom("1");
+        setOp->setTo("1");
+        setOp->setSeconds(10);
+    }
+
+    Sight createSight(const std::string& to)
+    {
+        Sight sight;
+        sight->setArgs1(setOp);
+        sight->setTo(to);
+        return sight;
+    }
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_createDelta_map)
+        ADD_TEST(test_createDelta_list)
+        ADD_TEST(test_createDelta_other)
+        ADD_TEST(test_apply)
+        ADD_TEST(test_expire)
+    }
+
+    void test_createDelta_map(TestContext& context)
+    {
+        MapType previous{{"a", 1}, {"b", 2}, {"c", 3}, {"d", 4}};
+        {
+            MapType delta;
+            ASSERT_TRUE(PropertyDeltas::createDelta("inventory", previous, MapType{{"a", 1}, {"b", 5}, {"c", 3}, {"d", 4}, {"e", 6}}, delta))
+            ASSERT_EQUAL(1u, delta.size())
+            ASSERT_EQUAL(Element(MapType{{"b", 5}, {"e", 6}}), delta["inventory!append"])
+        }
+        {
+            MapType delta;
+            ASSERT_TRUE(PropertyDeltas::createDelta("inventory", previous, MapType{{"a", 1}, {"c", 3}, {"d", 4}}, delta))
+            ASSERT_EQUAL(1u, delta.size())
+            ASSERT_EQUAL(1u, delta["inventory!subtract"].Map().size())
+            ASSERT_EQUAL(1u, delta["inventory!subtract"].Map().count("b"))
+        }
+        {
+            //Nothing has changed.
+            MapType delta;
+            ASSERT_TRUE(PropertyDeltas::createDelta("inventory", previous, previous, delta))
+            ASSERT_TRUE(delta.empty())
+        }
+        {
+            //Everything has changed, so the full value should be sent.
+            MapType delta;
+            ASSERT_FALSE(PropertyDeltas::createDelta("inventory", previous, MapType{{"a", 2}, {"e", 3}}, delta))
+            ASSERT_TRUE(delta.empty())
+        }
+    }
+
+    void test_createDelta_list(TestContext& context)
+    {
+        ListType previous{1, 2, 3};
+        {
+            MapType delta;
+            ASSERT_TRUE(PropertyDeltas::createDelta("tasks", previous, ListType{1, 2, 3, 4}, delta))
+            ASSERT_EQUAL(1u, delta.size())
+            ASSERT_EQUAL(Element(ListType{4}), delta["tasks!append"])
+        }
+        {
+            //Only additions to the end can be described.
+            MapType delta;
+            ASSERT_FALSE(PropertyDeltas::createDelta("tasks", previous, ListType{0, 1, 2, 3}, delta))
+            ASSERT_FALSE(PropertyDeltas::createDelta("tasks", previous, ListType{1, 2}, delta))
+            ASSERT_FALSE(PropertyDeltas::createDelta("tasks", previous, ListType{1, 5, 3, 4}, delta))
+            ASSERT_FALSE(PropertyDeltas::createDelta("tasks", ListType{}, ListType{1}, delta))
+            ASSERT_TRUE(delta.empty())
+        }
+    }
+
+    void test_createDelta_other(TestContext& context)
+    {
+        MapType delta;
+        ASSERT_FALSE(PropertyDeltas::createDelta("mass", 1.0, 2.0, delta))
+        ASSERT_FALSE(PropertyDeltas::createDelta("mass", Element(), MapType{{"a", 1}}, delta))
+        ASSERT_FALSE(PropertyDeltas::createDelta("mass", ListType{1}, MapType{{"a", 1}}, delta))
+        ASSERT_TRUE(delta.empty())
+    }
+
+    void test_apply(TestContext& context)
+    {
+        auto& propertyDeltas = context.propertyDeltas;
+        auto sight = context.createSight("2");
+        ASSERT_EQUAL(sight.get(), propertyDeltas.apply(sight).get())
+
+        Anonymous deltaArg;
+        deltaArg->setId("1");
+        deltaArg->setAttr("inventory!append", MapType{{"c", 3}});
+        propertyDeltas.add(context.arg, deltaArg, 10);
+        ASSERT_EQUAL(1u, propertyDeltas.size())
+        ASSERT_EQUAL(1, propertyDeltas.m_registeredCount)
+
+        auto applied = propertyDeltas.apply(sight);
+        ASSERT_NOT_EQUAL(sight.get(), applied.get())
+        ASSERT_EQUAL("2", applied->getTo())
+        ASSERT_EQUAL(1, propertyDeltas.m_sentCount)
+        auto appliedSet = Atlas::Objects::smart_dynamic_cast<Operation>(applied->getArgs().front());
+        ASSERT_TRUE(appliedSet.isValid())
+        ASSERT_EQUAL("1", appliedSet->getFrom())
+        ASSERT_EQUAL(deltaArg.get(), appliedSet->getArgs().front().get())
+
+        //The original ops must be left untouched.
+        ASSERT_EQUAL(context.setOp.get(), sight->getArgs().front().get())
+        ASSERT_EQUAL(context.arg.get(), context.setOp->getArgs().front().get())
+
+        //An equal, but not the same, arg shouldn't match.
+        Set copiedSet = context.setOp.copy();
+        copiedSet->setArgs1(context.arg.copy());
+        Sight copiedSight;
+        copiedSight->setArgs1(copiedSet);
+        ASSERT_EQUAL(copiedSight.get(), propertyDeltas.apply(copiedSight).get())
+
+        //Only Sights of Sets are handled.
+        Atlas::Objects::Operation::Appearance otherType;
+        otherType->setArgs1(context.setOp);
+        ASSERT_EQUAL(otherType.get(), propertyDeltas.apply(otherType).get())
+    }
+
+    void test_expire(TestContext& context)
+    {
+        auto& propertyDeltas = context.propertyDeltas;
+        propertyDeltas.add(context.arg, Anonymous(), 10);
+
+        //Registering another delta a long time after should remove the first one.
+        Anonymous otherArg;
+        propertyDeltas.add(otherArg, Anonymous(), 20);
+
+        ASSERT_EQUAL(1u, propertyDeltas.size())
+        auto sight = context.createSight("2");
+        ASSERT_EQUAL(sight.get(), propertyDeltas.apply(sight).get())
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
@@ -105,6 +105,7 @@ using Atlas::Objects::Entity::RootEntity;
 
 #include "../stubs/common/stubRouter.h"
 #include "../stubs/common/stubLink.h"
+#include "../stubs/common/stubPropertyDeltas.h"
 #include "../stubs/modules/stubWeakEntityRef.h"
 #include "../stubs/rules/stubLocation.h"
 #include "../stubs/rules/simulation/stubBaseWorld.h"
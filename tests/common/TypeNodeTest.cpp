@@ -27,6 +27,18 @@
 
 #include "common/Property.h"
 #include "common/PropertyManager.h"
+#include "common/compose.hpp"
+
+#include <memory>
+#include <vector>
+
+struct TestPropertyManager : public PropertyManager
+{
+    std::unique_ptr<PropertyBase> addProperty(const std::string& name) const override
+    {
+        return std::make_unique<Property<double>>();
+    }
+};
 
 int main()
 {
@@ -43,8 +55,60 @@ int main()
 
     assert(!foo.isTypeOf(&bar));
     assert(bar.isTypeOf(&foo));
+    assert(bar.isTypeOf("thing"));
+    assert(!foo.isTypeOf("entity"));
+    assert(!foo.isTypeOf("unknown"));
+
+    {
+        //Add enough children to run out of room in the interval of the parent, which forces a renumbering.
+        std::vector<std::unique_ptr<TypeNode>> children;
+        for (size_t i = 0; i < 100; ++i) {
+            children.emplace_back(new TypeNode(String::compose("child%1", i)));
+            children.back()->setParent(&bar);
+        }
+        for (auto& child : children) {
+            assert(child->isTypeOf(&bar));
+            assert(child->isTypeOf("thing"));
+            assert(!bar.isTypeOf(child.get()));
+            assert(child == children.front() || !child->isTypeOf(children.front().get()));
+        }
+
+        //Moving a type with children moves the whole subtree.
+        TypeNode baz("baz");
+        bar.setParent(&baz);
+        assert(!bar.isTypeOf(&foo));
+        assert(!children.back()->isTypeOf("thing"));
+        assert(children.back()->isTypeOf("baz"));
+
+        children.front()->setParent(&foo);
+        assert(children.front()->isTypeOf(&foo));
+        assert(!children.front()->isTypeOf(&bar));
+
+        bar.setParent(&foo);
+        assert(children.back()->isTypeOf(&foo));
+    }
+    //The children are gone, and so are their names.
+    assert(bar.children().empty());
+    assert(!bar.isTypeOf("child0"));
 
     foo.defaults();
+
+    {
+        TestPropertyManager propertyManager;
+        auto id = PropertyIds::intern("test_default");
+        assert(foo.defaultProperty(id) == nullptr);
+
+        auto prop = new Property<double>();
+        foo.injectProperty("test_default", std::unique_ptr<PropertyBase>(prop));
+        assert(foo.defaultProperty(id) == prop);
+
+        foo.updateProperties({{"test_default", 2.0}}, propertyManager);
+        assert(foo.defaultProperty(id) == prop);
+
+        foo.updateProperties({{"test_other", 1.0}}, propertyManager);
+        assert(foo.defaultProperty(id) == nullptr);
+        assert(foo.defaultProperty(PropertyIds::intern("test_other")) == foo.defaults().find("test_other")->second.get());
+    }
     return 0;
 }
 
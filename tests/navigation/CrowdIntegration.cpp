@@ -0,0 +1,242 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <navigation/Crowd.h>
+#include <navigation/Awareness.h>
+#include <navigation/Steering.h>
+#include "navigation/IHeightProvider.h"
+#include "rules/MemEntity.h"
+#include "rules/ai/AwareMind.h"
+#include "rules/ai/AwarenessStoreProvider.h"
+#include "rules/ai/SharedTerrain.h"
+#include "client/ClientPropertyManager.h"
+#include "common/TypeNode.h"
+#include "../TestBase.h"
+
+namespace {
+    double epsilon = 0.00001;
+
+    int tileSize = 64;
+
+    struct FlatHeightProvider : public IHeightProvider
+    {
+        void blitHeights(int xMin, int xMax, int yMin, int yMax, std::vector<float>& heights) const override
+        {
+            heights.resize(tileSize * tileSize, 0);
+        }
+    };
+
+    /**
+     * Exposes the parts of the mind which handle the own entity and the awareness.
+     */
+    struct TestAwareMind : public AwareMind
+    {
+        using AwareMind::AwareMind;
+        using AwareMind::setOwnEntity;
+        using AwareMind::requestAwareness;
+    };
+}
+
+struct CrowdIntegration : public Cyphesis::TestBase
+{
+    WFMath::AxisBox<3> extent = {{-64, -64, -64},
+                                 {64,  64,  64}};
+
+    CrowdIntegration()
+    {
+        ADD_TEST(CrowdIntegration::test_agents);
+        ADD_TEST(CrowdIntegration::test_throttle);
+        ADD_TEST(CrowdIntegration::test_results);
+        ADD_TEST(CrowdIntegration::test_mind);
+    }
+
+    void setup()
+    {
+
+    }
+
+    void teardown()
+    {
+
+    }
+
+    void test_agents()
+    {
+        Ref<MemEntity> worldEntity(new MemEntity("0", 0));
+        Ref<MemEntity> avatarEntity(new MemEntity("1", 1));
+        avatarEntity->m_location.m_bBox = {{-1, 0, -1},
+                                           {1,  1, 1}};
+        FlatHeightProvider heightProvider;
+        Awareness awareness(*worldEntity, 1, 2, 0.5, heightProvider, extent, tileSize);
+        Crowd crowd(awareness);
+
+        Steering steering1(*avatarEntity);
+        Steering steering2(*avatarEntity);
+        crowd.addAgent(steering1);
+        crowd.addAgent(steering2);
+        ASSERT_EQUAL(2u, crowd.getAgentCount());
+
+        crowd.removeAgent(steering1);
+        ASSERT_EQUAL(1u, crowd.getAgentCount());
+        //Removing an unknown agent does nothing.
+        crowd.removeAgent(steering1);
+        ASSERT_EQUAL(1u, crowd.getAgentCount());
+
+        //There's never any result for an unknown agent.
+        ASSERT_FALSE(crowd.takeResult(steering1).timeToNextWaypoint);
+
+        crowd.removeAgent(steering2);
+        ASSERT_EQUAL(0u, crowd.getAgentCount());
+    }
+
+    void test_throttle()
+    {
+        Ref<MemEntity> worldEntity(new MemEntity("0", 0));
+        FlatHeightProvider heightProvider;
+        Awareness awareness(*worldEntity, 1, 2, 0.5, heightProvider, extent, tileSize);
+        Crowd crowd(awareness);
+
+        ASSERT_TRUE(crowd.update(0));
+        //Any other mind asking within the interval shouldn't step the crowd again.
+        ASSERT_FALSE(crowd.update(0));
+        ASSERT_FALSE(crowd.update(0.05));
+        ASSERT_FALSE(crowd.update(0.09));
+        ASSERT_TRUE(crowd.update(0.1));
+        ASSERT_FALSE(crowd.update(0.15));
+        //If the server time goes backwards the crowd should be stepped at once.
+        ASSERT_TRUE(crowd.update(0.05));
+
+        Crowd slowCrowd(awareness, 1.0);
+        ASSERT_TRUE(slowCrowd.update(0));
+        ASSERT_FALSE(slowCrowd.update(0.5));
+        ASSERT_TRUE(slowCrowd.update(1.0));
+    }
+
+    void test_results()
+    {
+        Ref<MemEntity> worldEntity(new MemEntity("0", 0));
+        Ref<MemEntity> avatarEntity(new MemEntity("1", 1));
+        avatarEntity->m_location.m_pos = {0, 0, 0};
+        avatarEntity->m_location.m_bBox = {{-1, 0, -1},
+                                           {1,  1, 1}};
+        avatarEntity->m_location.m_orientation = WFMath::Quaternion::IDENTITY();
+        worldEntity->addChild(*avatarEntity);
+        auto avatarHorizontalRadius = std::sqrt(boxSquareHorizontalBoundingRadius(avatarEntity->m_location.m_bBox));
+
+        FlatHeightProvider heightProvider;
+        Awareness awareness(*worldEntity, avatarHorizontalRadius, 2, 0.5, heightProvider, extent, tileSize);
+        Crowd crowd(awareness);
+
+        Steering steering(*avatarEntity);
+        steering.setAwareness(&awareness);
+        crowd.addAgent(steering);
+
+        steering.setDestination({{EntityLocation(worldEntity, {20, 0, 0})}, Steering::MeasureType::CENTER, Steering::MeasureType::CENTER, 0.5}, 0);
+        while (awareness.rebuildDirtyTile() != 0) {
+        }
+        steering.startSteering();
+
+        ASSERT_TRUE(crowd.update(0));
+
+        //Moving the avatar along the path won't make the steering ask for another movement, but the time to the waypoint changes.
+        avatarEntity->m_location.m_pos.x() = 10;
+        ASSERT_FALSE(crowd.update(0.05));
+        ASSERT_TRUE(crowd.update(0.1));
+
+        //The movement from the first step should be kept, since it hasn't been picked up yet.
+        auto result = crowd.takeResult(steering);
+        ASSERT_TRUE(result.direction.isValid());
+        ASSERT_GREATER(result.direction.x(), 0);
+        ASSERT_FUZZY_EQUAL(0.0, result.direction.z(), epsilon);
+        ASSERT_TRUE(result.timeToNextWaypoint);
+        ASSERT_FUZZY_EQUAL(10.0 / result.direction.mag(), *result.timeToNextWaypoint, epsilon);
+
+        //The movement is only handed out once, while the time to the next waypoint is kept.
+        auto secondResult = crowd.takeResult(steering);
+        ASSERT_FALSE(secondResult.direction.isValid());
+        ASSERT_FALSE(secondResult.destination.isValid());
+        ASSERT_TRUE(secondResult.timeToNextWaypoint);
+        ASSERT_FUZZY_EQUAL(*result.timeToNextWaypoint, *secondResult.timeToNextWaypoint, epsilon);
+
+        //Once removed the agent isn't stepped any more.
+        crowd.removeAgent(steering);
+        avatarEntity->m_location.m_pos.x() = 15;
+        ASSERT_TRUE(crowd.update(0.2));
+        ASSERT_FALSE(crowd.takeResult(steering).timeToNextWaypoint);
+    }
+
+    void test_mind()
+    {
+        ClientPropertyManager propertyManager;
+        SharedTerrain sharedTerrain;
+        AwarenessStoreProvider awarenessStoreProvider(sharedTerrain);
+        TypeNode type("character");
+
+        Ref<MemEntity> worldEntity(new MemEntity("0", 0));
+        worldEntity->m_location.m_bBox = extent;
+        Ref<MemEntity> avatarEntity(new MemEntity("1", 1));
+        avatarEntity->setType(&type);
+        avatarEntity->m_location.m_pos = {0, 0, 0};
+        avatarEntity->m_location.m_bBox = {{-1, 0, -1},
+                                           {1,  1, 1}};
+        avatarEntity->m_location.m_orientation = WFMath::Quaternion::IDENTITY();
+        worldEntity->addChild(*avatarEntity);
+
+        Ref<TestAwareMind> mind(new TestAwareMind("1", "1", propertyManager, sharedTerrain, awarenessStoreProvider));
+        OpVector res;
+        mind->setOwnEntity(res, avatarEntity);
+        mind->requestAwareness(*worldEntity);
+
+        std::shared_ptr<Awareness> awareness = mind->getAwareness();
+        ASSERT_NOT_NULL(awareness.get());
+        ASSERT_EQUAL(1u, awareness->getCrowd().getAgentCount());
+
+        //A new steering replaces the old one in the crowd.
+        mind->setOwnEntity(res, avatarEntity);
+        ASSERT_EQUAL(1u, awareness->getCrowd().getAgentCount());
+
+        //Another mind sharing the awareness gets its own agent.
+        Ref<MemEntity> otherEntity(new MemEntity("2", 2));
+        otherEntity->setType(&type);
+        otherEntity->m_location.m_pos = {10, 0, 0};
+        otherEntity->m_location.m_bBox = {{-1, 0, -1},
+                                          {1,  1, 1}};
+        otherEntity->m_location.m_orientation = WFMath::Quaternion::IDENTITY();
+        worldEntity->addChild(*otherEntity);
+
+        Ref<TestAwareMind> otherMind(new TestAwareMind("2", "2", propertyManager, sharedTerrain, awarenessStoreProvider));
+        otherMind->setOwnEntity(res, otherEntity);
+        otherMind->requestAwareness(*worldEntity);
+        ASSERT_TRUE(awareness == otherMind->getAwareness());
+        ASSERT_EQUAL(2u, awareness->getCrowd().getAgentCount());
+
+        //The crowd mustn't keep any steering of a destroyed mind.
+        otherMind = nullptr;
+        ASSERT_EQUAL(1u, awareness->getCrowd().getAgentCount());
+        mind = nullptr;
+        ASSERT_EQUAL(0u, awareness->getCrowd().getAgentCount());
+    }
+
+};
+
+int main()
+{
+    CrowdIntegration t;
+
+    return t.run();
+}
@@ -0,0 +1,116 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+
+#include "navigation/NeighbourGrid.h"
+
+#include <algorithm>
+
+struct TestContext
+{
+    NeighbourGrid grid{5};
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_query)
+        ADD_TEST(test_large_radius)
+        ADD_TEST(test_clear)
+        ADD_TEST(test_clear_drops_unused_cells)
+    }
+
+    void test_query(TestContext& context)
+    {
+        context.grid.add(1, WFMath::Point<2>(0, 0), WFMath::Vector<2>(1, 0), 0.5f);
+        context.grid.add(2, WFMath::Point<2>(3, 0), WFMath::Vector<2>(0, 1), 0.5f);
+        context.grid.add(3, WFMath::Point<2>(-20, 0), WFMath::Vector<2>(0, 0), 0.5f);
+        ASSERT_EQUAL(3u, context.grid.size())
+
+        std::vector<size_t> result;
+        context.grid.query(WFMath::Point<2>(1, 0), 4, result);
+        ASSERT_EQUAL(2u, result.size())
+        std::vector<long> ids;
+        for (auto index : result) {
+            ids.push_back(context.grid.getEntityId(index));
+        }
+        std::sort(ids.begin(), ids.end());
+        ASSERT_TRUE(ids == std::vector<long>({1, 2}))
+
+        auto gridIndex = context.grid.getEntityId(result[0]) == 2 ? result[0] : result[1];
+        ASSERT_EQUAL(3.f, context.grid.getPosition(gridIndex).x())
+        ASSERT_EQUAL(1.f, context.grid.getVelocity(gridIndex).y())
+        ASSERT_EQUAL(0.5f, context.grid.getRadius(gridIndex))
+    }
+
+    void test_large_radius(TestContext& context)
+    {
+        //A large entity a few cells away should still be found if it reaches the query.
+        context.grid.add(1, WFMath::Point<2>(20, 0), WFMath::Vector<2>(0, 0), 18);
+
+        std::vector<size_t> result;
+        context.grid.query(WFMath::Point<2>(0, 0), 3, result);
+        ASSERT_EQUAL(1u, result.size())
+
+        result.clear();
+        context.grid.query(WFMath::Point<2>(-5, 0), 3, result);
+        ASSERT_TRUE(result.empty())
+    }
+
+    void test_clear(TestContext& context)
+    {
+        context.grid.add(1, WFMath::Point<2>(0, 0), WFMath::Vector<2>(0, 0), 0.5f);
+        context.grid.clear();
+        ASSERT_EQUAL(0u, context.grid.size())
+
+        std::vector<size_t> result;
+        context.grid.query(WFMath::Point<2>(0, 0), 5, result);
+        ASSERT_TRUE(result.empty())
+    }
+
+    void test_clear_drops_unused_cells(TestContext& context)
+    {
+        //Cells used in the last step are kept, while those which have been left behind are dropped.
+        context.grid.add(1, WFMath::Point<2>(0, 0), WFMath::Vector<2>(0, 0), 0.5f);
+        context.grid.clear();
+        ASSERT_EQUAL(1u, context.grid.getCellCount())
+
+        context.grid.add(1, WFMath::Point<2>(100, 0), WFMath::Vector<2>(0, 0), 0.5f);
+        context.grid.clear();
+        ASSERT_EQUAL(1u, context.grid.getCellCount())
+
+        context.grid.clear();
+        ASSERT_EQUAL(0u, context.grid.getCellCount())
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
@@ -0,0 +1,92 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+
+#include "navigation/PathCache.h"
+
+struct TestContext
+{
+    PathCache cache{2};
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_get)
+        ADD_TEST(test_invalidate)
+        ADD_TEST(test_eviction)
+    }
+
+    void test_get(TestContext& context)
+    {
+        ASSERT_NULL(context.cache.get({1, 2, 0.5f}))
+        context.cache.put({1, 2, 0.5f}, {1, 3, 2}, {{0, 0}});
+
+        auto corridor = context.cache.get({1, 2, 0.5f});
+        ASSERT_NOT_NULL(corridor)
+        ASSERT_EQUAL(3u, corridor->size())
+        ASSERT_EQUAL(3u, (*corridor)[1])
+
+        //Both polygons and the radius are part of the key.
+        ASSERT_NULL(context.cache.get({2, 1, 0.5f}))
+        ASSERT_NULL(context.cache.get({1, 2, 1.0f}))
+        ASSERT_EQUAL(1, context.cache.m_hits)
+        ASSERT_EQUAL(3, context.cache.m_misses)
+    }
+
+    void test_invalidate(TestContext& context)
+    {
+        context.cache.put({1, 2, 0.5f}, {1, 2}, {{0, 0}, {1, 0}});
+        context.cache.put({3, 4, 0.5f}, {3, 4}, {{5, 5}});
+
+        context.cache.invalidateTile(1, 0);
+        ASSERT_NULL(context.cache.get({1, 2, 0.5f}))
+        ASSERT_NOT_NULL(context.cache.get({3, 4, 0.5f}))
+        ASSERT_EQUAL(1u, context.cache.size())
+    }
+
+    void test_eviction(TestContext& context)
+    {
+        context.cache.put({1, 2, 0.5f}, {1, 2}, {{0, 0}});
+        context.cache.put({3, 4, 0.5f}, {3, 4}, {{0, 0}});
+        //Use the first one, so that the second one is the least recently used.
+        context.cache.get({1, 2, 0.5f});
+        context.cache.put({5, 6, 0.5f}, {5, 6}, {{0, 0}});
+
+        ASSERT_EQUAL(2u, context.cache.size())
+        ASSERT_NOT_NULL(context.cache.get({1, 2, 0.5f}))
+        ASSERT_NULL(context.cache.get({3, 4, 0.5f}))
+        ASSERT_NOT_NULL(context.cache.get({5, 6, 0.5f}))
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
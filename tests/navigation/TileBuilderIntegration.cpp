@@ -0,0 +1,179 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <navigation/Awareness.h>
+#include <navigation/TileBuilder.h>
+#include "navigation/IHeightProvider.h"
+#include "rules/MemEntity.h"
+#include "../TestBase.h"
+
+#include <DetourTileCache.h>
+
+#include <chrono>
+#include <thread>
+
+namespace {
+    int tileSize = 64;
+
+    struct FlatHeightProvider : public IHeightProvider
+    {
+        void blitHeights(int xMin, int xMax, int yMin, int yMax, std::vector<float>& heights) const override
+        {
+            heights.resize(tileSize * tileSize, 0);
+        }
+    };
+
+    /**
+     * Exposes the tile building internals.
+     */
+    struct TestAwareness : public Awareness
+    {
+        using Awareness::Awareness;
+        using Awareness::dispatchTileBuilds;
+        using Awareness::installBuiltTiles;
+        using Awareness::mDirtyAwareTiles;
+        using Awareness::mDirtyUnwareTiles;
+        using Awareness::mTilesInProgress;
+
+        bool hasTile(const std::pair<int, int>& tileIndex) const
+        {
+            return mTileCache->getTileAt(tileIndex.first, tileIndex.second, 0) != nullptr;
+        }
+
+        /**
+         * Installs built tiles until there are no more builds in progress, or a deadline is reached.
+         */
+        bool waitForBuilds()
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+            while (getTileBuildsInProgress() > 0) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                installBuiltTiles();
+            }
+            return true;
+        }
+    };
+
+    WFMath::RotBox<2> centralArea()
+    {
+        WFMath::RotBox<2> area;
+        area.size() = WFMath::Vector<2>(20, 20);
+        area.corner0() = WFMath::Point<2>(-10, -10);
+        area.orientation() = WFMath::RotMatrix<2>().identity();
+        return area;
+    }
+}
+
+struct TileBuilderIntegration : public Cyphesis::TestBase
+{
+    WFMath::AxisBox<3> extent = {{-64, -64, -64},
+                                 {64,  64,  64}};
+
+    TileBuilderIntegration()
+    {
+        ADD_TEST(TileBuilderIntegration::test_build);
+        ADD_TEST(TileBuilderIntegration::test_unawareWhileBuilding);
+        ADD_TEST(TileBuilderIntegration::test_destroyWhileBuilding);
+    }
+
+    void setup()
+    {
+
+    }
+
+    void teardown()
+    {
+
+    }
+
+    void test_build()
+    {
+        Ref<MemEntity> worldEntity(new MemEntity("0", 0));
+        FlatHeightProvider heightProvider;
+        TileBuilder tileBuilder(2);
+        TestAwareness awareness(*worldEntity, 1, 2, 0.5, heightProvider, extent, tileSize);
+
+        awareness.setAwarenessArea("1", centralArea(), WFMath::Segment<2>());
+        auto dirtyTiles = awareness.mDirtyAwareTiles;
+        ASSERT_FALSE(dirtyTiles.empty());
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (!awareness.mDirtyAwareTiles.empty() || awareness.getTileBuildsInProgress() > 0) {
+            ASSERT_TRUE(std::chrono::steady_clock::now() < deadline);
+            awareness.installBuiltTiles();
+            awareness.dispatchTileBuilds(tileBuilder);
+            //Never more builds than the workers can handle.
+            ASSERT_TRUE(awareness.getTileBuildsInProgress() <= tileBuilder.getThreadCount() * 2);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        for (auto& tileIndex : dirtyTiles) {
+            ASSERT_TRUE(awareness.hasTile(tileIndex));
+        }
+        ASSERT_TRUE(awareness.mDirtyUnwareTiles.empty());
+    }
+
+    void test_unawareWhileBuilding()
+    {
+        Ref<MemEntity> worldEntity(new MemEntity("0", 0));
+        FlatHeightProvider heightProvider;
+        TileBuilder tileBuilder(2);
+        TestAwareness awareness(*worldEntity, 1, 2, 0.5, heightProvider, extent, tileSize);
+
+        awareness.setAwarenessArea("1", centralArea(), WFMath::Segment<2>());
+        awareness.dispatchTileBuilds(tileBuilder);
+        auto tilesInProgress = awareness.mTilesInProgress;
+        ASSERT_FALSE(tilesInProgress.empty());
+
+        //The tiles are no longer aware when the builds are done, so they shouldn't be installed, but rebuilt once they are aware again.
+        awareness.removeAwarenessArea("1");
+        ASSERT_TRUE(awareness.waitForBuilds());
+
+        for (auto& tileIndex : tilesInProgress) {
+            ASSERT_FALSE(awareness.hasTile(tileIndex));
+            ASSERT_TRUE(awareness.mDirtyUnwareTiles.find(tileIndex) != awareness.mDirtyUnwareTiles.end());
+        }
+    }
+
+    void test_destroyWhileBuilding()
+    {
+        Ref<MemEntity> worldEntity(new MemEntity("0", 0));
+        FlatHeightProvider heightProvider;
+        //A single worker, so that some builds are still queued when the awareness is destroyed.
+        TileBuilder tileBuilder(1);
+        {
+            TestAwareness awareness(*worldEntity, 1, 2, 0.5, heightProvider, extent, tileSize);
+            awareness.setAwarenessArea("1", centralArea(), WFMath::Segment<2>());
+            awareness.dispatchTileBuilds(tileBuilder);
+            ASSERT_TRUE(awareness.getTileBuildsInProgress() > 0);
+        }
+        //Let the builds run to completion with the awareness gone.
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+
+};
+
+int main()
+{
+    TileBuilderIntegration t;
+
+    return t.run();
+}
@@ -0,0 +1,129 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+
+#include "navigation/TileGraph.h"
+
+struct TestContext
+{
+    //Four by four tiles, each ten units wide, starting at origin.
+    TileGraph graph{WFMath::Point<2>(0, 0), 10, 4, 4};
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_unknown_tiles)
+        ADD_TEST(test_blocked_tile)
+        ADD_TEST(test_portals)
+        ADD_TEST(test_disconnected_regions)
+        ADD_TEST(test_out_of_bounds)
+    }
+
+    void test_unknown_tiles(TestContext& context)
+    {
+        std::vector<WFMath::Point<2>> waypoints;
+        ASSERT_TRUE(context.graph.findPath(WFMath::Point<2>(5, 5), WFMath::Point<2>(35, 5), waypoints))
+        //Unknown tiles are assumed to be walkable, so the route goes straight through them.
+        ASSERT_EQUAL(3u, waypoints.size())
+        ASSERT_TRUE(WFMath::Point<2>(35, 5) == waypoints.back())
+        for (auto& waypoint : waypoints) {
+            ASSERT_EQUAL(5.f, waypoint.y())
+        }
+    }
+
+    void test_blocked_tile(TestContext& context)
+    {
+        //A built tile without any portals can't be crossed.
+        context.graph.setTile(1, 0, {});
+        context.graph.setTile(1, 1, {});
+        context.graph.setTile(1, 2, {});
+
+        std::vector<WFMath::Point<2>> waypoints;
+        ASSERT_TRUE(context.graph.findPath(WFMath::Point<2>(5, 5), WFMath::Point<2>(35, 5), waypoints))
+        bool passedAbove = false;
+        for (auto& waypoint : waypoints) {
+            ASSERT_FALSE(waypoint.x() > 10 && waypoint.x() < 20 && waypoint.y() < 30)
+            if (waypoint.y() > 30) {
+                passedAbove = true;
+            }
+        }
+        ASSERT_TRUE(passedAbove)
+
+        context.graph.setTile(1, 3, {});
+        ASSERT_FALSE(context.graph.findPath(WFMath::Point<2>(5, 5), WFMath::Point<2>(35, 5), waypoints))
+    }
+
+    void test_portals(TestContext& context)
+    {
+        //A wall along the middle column, with an opening at the top of tile (1, 1).
+        context.graph.setTile(1, 0, {});
+        context.graph.setTile(1, 1, {{TileGraph::NEG_X, 17, 19, 0},
+                                     {TileGraph::POS_X, 17, 19, 0}});
+        context.graph.setTile(1, 2, {});
+        context.graph.setTile(1, 3, {});
+
+        std::vector<WFMath::Point<2>> waypoints;
+        ASSERT_TRUE(context.graph.findPath(WFMath::Point<2>(5, 5), WFMath::Point<2>(35, 5), waypoints))
+        bool passedPortal = false;
+        for (auto& waypoint : waypoints) {
+            if (waypoint == WFMath::Point<2>(10, 18)) {
+                passedPortal = true;
+            }
+        }
+        ASSERT_TRUE(passedPortal)
+        ASSERT_TRUE(context.graph.hasTile(1, 1))
+        ASSERT_FALSE(context.graph.hasTile(0, 0))
+    }
+
+    void test_disconnected_regions(TestContext& context)
+    {
+        //The openings on either side belong to different regions, so the tile can't be crossed.
+        context.graph.setTile(1, 0, {});
+        context.graph.setTile(1, 1, {{TileGraph::NEG_X, 17, 19, 0},
+                                     {TileGraph::POS_X, 17, 19, 1}});
+        context.graph.setTile(1, 2, {});
+        context.graph.setTile(1, 3, {});
+
+        std::vector<WFMath::Point<2>> waypoints;
+        ASSERT_FALSE(context.graph.findPath(WFMath::Point<2>(5, 5), WFMath::Point<2>(35, 5), waypoints))
+    }
+
+    void test_out_of_bounds(TestContext& context)
+    {
+        std::vector<WFMath::Point<2>> waypoints;
+        ASSERT_FALSE(context.graph.findPath(WFMath::Point<2>(5, 5), WFMath::Point<2>(45, 5), waypoints))
+        ASSERT_FALSE(context.graph.findPath(WFMath::Point<2>(-5, 5), WFMath::Point<2>(35, 5), waypoints))
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
@@ -0,0 +1,166 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+
+#include "navigation/TileStore.h"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+struct TestContext
+{
+    boost::filesystem::path directory;
+    std::string path;
+
+    std::vector<unsigned char> layer1{1, 2, 3, 4};
+    std::vector<unsigned char> layer2{5, 6, 7};
+
+    TestContext()
+    {
+        directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::create_directories(directory);
+        path = (directory / "navmesh.tiles").string();
+    }
+
+    ~TestContext()
+    {
+        boost::filesystem::remove_all(directory);
+    }
+
+    std::vector<TileStore::Layer> layers()
+    {
+        return {{layer1.data(), static_cast<int>(layer1.size())},
+                {layer2.data(), static_cast<int>(layer2.size())}};
+    }
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_reload)
+        ADD_TEST(test_corrupt)
+        ADD_TEST(test_truncated)
+        ADD_TEST(test_maxSize)
+    }
+
+    void test_reload(TestContext& context)
+    {
+        {
+            TileStore store(context.path, 1024 * 1024);
+            std::vector<TileStore::Layer> layers;
+            ASSERT_FALSE(store.get(1, layers))
+            store.put(1, context.layers());
+            store.put(2, {});
+            ASSERT_TRUE(store.get(1, layers))
+            ASSERT_EQUAL(2u, layers.size())
+            ASSERT_EQUAL(1, store.m_hits)
+            ASSERT_EQUAL(1, store.m_misses)
+        }
+
+        TileStore store(context.path, 1024 * 1024);
+        ASSERT_EQUAL(2u, store.size())
+        std::vector<TileStore::Layer> layers;
+        ASSERT_TRUE(store.get(1, layers))
+        ASSERT_EQUAL(2u, layers.size())
+        ASSERT_TRUE(context.layer1 == std::vector<unsigned char>(layers[0].data, layers[0].data + layers[0].dataSize))
+        ASSERT_TRUE(context.layer2 == std::vector<unsigned char>(layers[1].data, layers[1].data + layers[1].dataSize))
+        ASSERT_TRUE(store.get(2, layers))
+        ASSERT_TRUE(layers.empty())
+    }
+
+    void test_corrupt(TestContext& context)
+    {
+        {
+            TileStore store(context.path, 1024 * 1024);
+            store.put(1, context.layers());
+        }
+        auto validSize = boost::filesystem::file_size(context.path);
+        {
+            std::ofstream stream(context.path, std::ios::binary | std::ios::app);
+            stream << "garbage";
+        }
+        {
+            //Valid records are still read, and written to the recreated file.
+            TileStore store(context.path, 1024 * 1024);
+            std::vector<TileStore::Layer> layers;
+            ASSERT_TRUE(store.get(1, layers))
+            ASSERT_TRUE(context.layer1 == std::vector<unsigned char>(layers[0].data, layers[0].data + layers[0].dataSize))
+            ASSERT_EQUAL(validSize, boost::filesystem::file_size(context.path))
+            store.put(2, context.layers());
+        }
+        TileStore store(context.path, 1024 * 1024);
+        ASSERT_EQUAL(2u, store.size())
+        std::vector<TileStore::Layer> layers;
+        ASSERT_TRUE(store.get(1, layers))
+        ASSERT_TRUE(context.layer2 == std::vector<unsigned char>(layers[1].data, layers[1].data + layers[1].dataSize))
+    }
+
+    void test_truncated(TestContext& context)
+    {
+        {
+            TileStore store(context.path, 1024 * 1024);
+            store.put(1, context.layers());
+            store.put(2, context.layers());
+        }
+        //Cut the last record short, as if it was still being written by another process.
+        auto fileSize = boost::filesystem::file_size(context.path);
+        boost::filesystem::resize_file(context.path, fileSize - 2);
+        {
+            TileStore store(context.path, 1024 * 1024);
+            ASSERT_EQUAL(1u, store.size())
+            std::vector<TileStore::Layer> layers;
+            ASSERT_TRUE(store.get(1, layers))
+            ASSERT_FALSE(store.get(2, layers))
+            //The file should be left as it is.
+            ASSERT_EQUAL(fileSize - 2, boost::filesystem::file_size(context.path))
+        }
+        //Only part of the magic of the last record.
+        boost::filesystem::resize_file(context.path, fileSize / 2 + 2);
+        TileStore store(context.path, 1024 * 1024);
+        ASSERT_EQUAL(1u, store.size())
+        ASSERT_EQUAL(fileSize / 2 + 2, boost::filesystem::file_size(context.path))
+    }
+
+    void test_maxSize(TestContext& context)
+    {
+        {
+            TileStore store(context.path, 1024 * 1024);
+            store.put(1, context.layers());
+        }
+        TileStore store(context.path, 8);
+        ASSERT_EQUAL(0u, store.size())
+        ASSERT_EQUAL(0u, boost::filesystem::file_size(context.path))
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
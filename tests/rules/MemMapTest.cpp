@@ -111,6 +111,7 @@ class MemMaptest : public Cyphesis::TestBase
     void test_findByLoc_results();
     void test_findByLoc_invalid();
     void test_findByLoc_consistency_check();
+    void test_findByLoc_index();
 
     static void Script_hook_called(const std::string &, LocatedEntity *);
 
@@ -153,6 +154,7 @@ MemMaptest::MemMaptest()
     ADD_TEST(MemMaptest::test_findByLoc_results);
     ADD_TEST(MemMaptest::test_findByLoc_invalid);
     ADD_TEST(MemMaptest::test_findByLoc_consistency_check);
+    ADD_TEST(MemMaptest::test_findByLoc_index);
 }
 
 void MemMaptest::setup()
@@ -439,6 +441,65 @@ void MemMaptest::test_findByLoc_consistency_check()
     ASSERT_TRUE(res.empty());
 }
 
+void MemMaptest::test_findByLoc_index()
+{
+    Ref<MemEntity> tlve = new MemEntity("3", 3);
+    tlve->setVisible();
+    m_memMap->m_entities[3] = tlve;
+    tlve->m_contains.reset(new LocatedEntitySet);
+
+    Root other_type_desc;
+    other_type_desc->setId("other_type");
+    auto otherType = m_typeStore->addChild(other_type_desc);
+
+    //One entity close by, one of another type close by and some far away, in other parts of the index.
+    std::vector<Ref<MemEntity>> entities;
+    std::vector<std::pair<Point3D, const TypeNode*>> placements{{Point3D(1, 0, 1),          m_sampleType},
+                                                                 {Point3D(1000, 0, 1000),    m_sampleType},
+                                                                 {Point3D(2, 0, 2),          otherType},
+                                                                 {Point3D(-1000, 0, 1000),   m_sampleType},
+                                                                 {Point3D(1000, 0, -1000),   m_sampleType},
+                                                                 {Point3D(-1000, 0, -1000),  m_sampleType}};
+    for (auto& placement : placements) {
+        long id = 4 + (long)entities.size();
+        Ref<MemEntity> entity = new MemEntity(std::to_string(id), id);
+        entity->setVisible();
+        entity->setType(placement.second);
+        entity->m_location.m_parent = tlve;
+        entity->m_location.m_pos = placement.first;
+        tlve->m_contains->insert(entity);
+        m_memMap->m_entities[id] = entity;
+        m_memMap->m_locationIndex.update(*entity);
+        entities.push_back(entity);
+    }
+    ASSERT_EQUAL(m_memMap->m_locationIndex.getEntityCount(), 6u);
+
+    //The far away entities aren't even looked at, since they are in other parts of the index.
+    EntityLocation find_here(tlve, Point3D(0, 0, 0));
+    EntityVector res = m_memMap->findByLocation(find_here, 5.f, "sample_type");
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), entities[0].get());
+
+    res = m_memMap->findByLocation(find_here, 5.f);
+    ASSERT_EQUAL(res.size(), 2u);
+
+    //Moving an entity moves it in the index.
+    entities[1]->m_location.m_pos = Point3D(-1, 0, -1);
+    m_memMap->m_locationIndex.update(*entities[1]);
+    res = m_memMap->findByLocation(find_here, 5.f, "sample_type");
+    ASSERT_EQUAL(res.size(), 2u);
+
+    //Deleted entities are removed from the index.
+    m_memMap->del("4");
+    ASSERT_EQUAL(m_memMap->m_locationIndex.getEntityCount(), 5u);
+    res = m_memMap->findByLocation(find_here, 5.f, "sample_type");
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), entities[1].get());
+
+    m_memMap->flush();
+    ASSERT_EQUAL(m_memMap->m_locationIndex.getEntityCount(), 0u);
+}
+
 int main()
 {
     MemMaptest t;
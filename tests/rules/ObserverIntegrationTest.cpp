@@ -69,7 +69,7 @@ struct TestContext
 };
 
 namespace {
-    std::vector<OpQueEntry<LocatedEntity>> collectQueue(std::priority_queue<OpQueEntry<LocatedEntity>, std::vector<OpQueEntry<LocatedEntity>>, std::greater<OpQueEntry<LocatedEntity>>>& queue)
+    std::vector<OpQueEntry<LocatedEntity>> collectQueue(OpQueue<LocatedEntity>& queue)
     {
         std::vector<OpQueEntry<LocatedEntity>> list;
         list.reserve(queue.size());
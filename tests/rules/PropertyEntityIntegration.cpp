@@ -133,7 +133,7 @@ struct TestEntity : Entity
     explicit TestEntity(const std::string& id, long intId) : Entity(id, intId)
     {}
 
-    std::map<std::string, ModifiableProperty>& modProperties()
+    PropertyTable& modProperties()
     { return m_properties; }
 
     void sendWorld(Operation op) override
@@ -0,0 +1,198 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBaseWithContext.h"
+#include "../TestWorld.h"
+
+#include "rules/simulation/Entity.h"
+#include "rules/AtlasProperties.h"
+
+#include "common/Property.h"
+#include "common/PropertyManager.h"
+#include "common/TypeNode.h"
+#include "common/log.h"
+#include "common/compose.hpp"
+
+#include <chrono>
+
+using Atlas::Message::Element;
+using Atlas::Message::MapType;
+
+namespace {
+    const size_t lookupCount = 5000000;
+
+    /**
+     * Properties set on the type, in the same way as in PropertyEntityIntegration.
+     */
+    const char* const typeProperties[] = {"test_int", "test_float", "test_string", "test_map"};
+
+    /**
+     * Properties set on the instance, which mimics an entity as seen by the physical domain.
+     */
+    const char* const instanceProperties[] = {"friction", "friction_roll", "friction_spin", "mass", "speed_ground",
+                                              "speed_water", "speed_flight", "step_factor", "planted_offset"};
+}
+
+class TestPropertyManager : public PropertyManager
+{
+    public:
+        std::unique_ptr<PropertyBase> addProperty(const std::string& name) const override
+        {
+            if (name == "test_int") {
+                return std::make_unique<Property<long>>();
+            } else if (name == "test_string") {
+                return std::make_unique<Property<std::string>>();
+            } else if (name == "test_map") {
+                return std::make_unique<Property<MapType>>();
+            }
+            return std::make_unique<Property<double>>();
+        }
+};
+
+struct TestContext
+{
+    TestPropertyManager propertyManager{};
+    TypeNode type{"test_type"};
+    Ref<Entity> entity{new Entity("1", 1L)};
+
+    TestContext()
+    {
+        type.addProperties(MapType{
+                {"test_int",    42},
+                {"test_float",  69.5},
+                {"test_string", "string"},
+                {"test_map",    MapType{{"map_int", 23}}}
+        }, propertyManager);
+        entity->setType(&type);
+        for (auto name : instanceProperties) {
+            entity->setAttrValue(name, 1.0);
+        }
+    }
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_lookups)
+    }
+
+    template<typename LookupFn>
+    long measure(const std::string& description, LookupFn lookupFn)
+    {
+        size_t found = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < lookupCount; ++i) {
+            if (lookupFn(i)) {
+                found++;
+            }
+        }
+        long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+        ASSERT_EQUAL(lookupCount, found)
+        log(INFO, String::compose("%1 lookups %2 took %3 ms.", lookupCount, description, milliseconds));
+        return milliseconds;
+    }
+
+    void test_lookups(TestContext& context)
+    {
+        auto& entity = *context.entity;
+        const size_t instanceCount = sizeof(instanceProperties) / sizeof(instanceProperties[0]);
+        const size_t typeCount = sizeof(typeProperties) / sizeof(typeProperties[0]);
+
+        std::vector<std::string> instanceNames(std::begin(instanceProperties), std::end(instanceProperties));
+        std::vector<PropertyId> instanceIds;
+        for (auto& name : instanceNames) {
+            instanceIds.push_back(PropertyIds::intern(name));
+        }
+        std::vector<std::string> typeNames(std::begin(typeProperties), std::end(typeProperties));
+        std::vector<PropertyId> typeIds;
+        for (auto& name : typeNames) {
+            typeIds.push_back(PropertyIds::intern(name));
+        }
+
+        measure("of instance properties by name", [&](size_t i) {
+            return entity.getPropertyType<double>(instanceNames[i % instanceCount]) != nullptr;
+        });
+        measure("of instance properties by id", [&](size_t i) {
+            return entity.getPropertyType<double>(instanceIds[i % instanceCount]) != nullptr;
+        });
+
+        measure("of type properties by name", [&](size_t i) {
+            return entity.getProperty(typeNames[i % typeCount]) != nullptr;
+        });
+        measure("of type properties by id", [&](size_t i) {
+            return entity.getProperty(typeIds[i % typeCount]) != nullptr;
+        });
+
+        measure("of a property class by name", [&](size_t i) {
+            return entity.getPropertyClass<IdProperty>(IdProperty::property_name) != nullptr;
+        });
+        measure("of a property class by its trait", [&](size_t i) {
+            return entity.getPropertyClassFixed<IdProperty>() != nullptr;
+        });
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
+
+// stubs
+
+#include "rules/Domain.h"
+#include "rules/simulation/DomainProperty.h"
+#include "rules/Script.h"
+
+#include "common/id.h"
+
+
+#include "../stubs/common/stubVariable.h"
+#include "../stubs/common/stubMonitors.h"
+#include "../stubs/common/stubcustom.h"
+#include "../stubs/rules/stubDomain.h"
+#include "../stubs/rules/simulation/stubDomainProperty.h"
+
+void addToEntity(const Point3D& p, std::vector<double>& vd)
+{
+    vd.resize(3);
+    vd[0] = p[0];
+    vd[1] = p[1];
+    vd[2] = p[2];
+}
+
+#include "../stubs/rules/simulation/stubBaseWorld.h"
+
+#include "../stubs/rules/stubScript.h"
+
+#include "../stubs/rules/stubLocation.h"
+#include "../stubs/rules/stubAtlasProperties.h"
+#include "../stubs/common/stubPropertyManager.h"
+#include "../stubs/common/stubLink.h"
+#include "../stubs/common/stubRouter.h"
+#include "../stubs/common/stubid.h"
+#include "../stubs/common/stublog.h"
@@ -39,6 +39,7 @@
 
 #include "../stubs/common/stubcustom.h"
 #include "../stubs/common/stubRouter.h"
+#include "../stubs/common/stubPropertyDeltas.h"
 #include "../stubs/common/stubTypeNode.h"
 #include "../stubs/common/stubPropertyManager.h"
 #include "../stubs/rules/stubLocation.h"
@@ -132,6 +133,12 @@ void LocatedEntity::broadcast(const Atlas::Objects::Operation::RootOperation& op
     res.push_back(copy);
 }
 
+void LocatedEntity::broadcast(const Atlas::Objects::Operation::RootOperation& op, OpVector& res, Visibility visibility,
+                              const std::vector<const LocatedEntity*>& observers) const
+{
+    broadcast(op, res, visibility);
+}
+
 #include "../stubs/rules/stubLocatedEntity.h"
 
 
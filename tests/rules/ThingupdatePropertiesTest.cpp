@@ -157,6 +157,7 @@ int main()
 #include "../stubs/rules/simulation/stubEntity.h"
 #include "../stubs/rules/stubDomain.h"
 #include "../stubs/common/stubRouter.h"
+#include "../stubs/common/stubPropertyDeltas.h"
 #include "../stubs/rules/simulation/stubBaseWorld.h"
 #include "../stubs/rules/stubLocation.h"
 #include "../stubs/rules/simulation/stubPropelProperty.h"
@@ -203,6 +204,12 @@ void LocatedEntity::broadcast(const Atlas::Objects::Operation::RootOperation& op
     res.push_back(copy);
 }
 
+void LocatedEntity::broadcast(const Atlas::Objects::Operation::RootOperation& op, OpVector& res, Visibility visibility,
+                              const std::vector<const LocatedEntity*>& observers) const
+{
+    broadcast(op, res, visibility);
+}
+
 
 #include "../stubs/rules/stubLocatedEntity.h"
 
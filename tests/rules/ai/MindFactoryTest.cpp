@@ -43,6 +43,7 @@ int main()
 // stubs
 
 #include "../../stubs/rules/ai/stubMemMap.h"
+#include "../../stubs/rules/ai/stubLocationIndex.h"
 #include "../../stubs/rules/ai/stubBaseMind.h"
 #include "../../stubs/rules/stubMemEntity.h"
 #include "../../stubs/rules/stubLocatedEntity.h"
@@ -0,0 +1,239 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../../TestBaseWithContext.h"
+
+#include "rules/entityfilter/Filter.h"
+#include "rules/entityfilter/ProviderFactory.h"
+
+#include "rules/simulation/Entity.h"
+#include "rules/BBoxProperty.h"
+
+#include "common/Property.h"
+#include "common/Inheritance.h"
+#include "common/TypeNode.h"
+#include "common/log.h"
+#include "common/compose.hpp"
+
+#include <Atlas/Objects/Factories.h>
+
+#include <chrono>
+
+using Atlas::Message::Element;
+using Atlas::Message::ListType;
+using namespace EntityFilter;
+
+static std::map<std::string, TypeNode*> types;
+
+namespace {
+    const size_t matchCount = 200000;
+    /**
+     * The number of entities matched in one go when matching in batches.
+     */
+    const size_t batchSize = 1000;
+
+    /**
+     * Queries taken from EntityFilterTest, leaving out those which need a domain.
+     */
+    const char* const queries[] = {
+            "entity.type=types.barrel",
+            "entity instance_of types.thing",
+            "entity.burn_speed != none",
+            "entity.burn_speed>=0.3",
+            "entity.burn_speed<0.3",
+            "entity.isVisible = true",
+            "entity.id=1",
+            "entity.float_list includes 20.0",
+            "entity.mass in [25, 30]",
+            "entity.type=types.barrel&&entity.burn_speed=0.3",
+            "not entity.burn_speed = 0.3 && entity.type=types.barrel",
+            "(entity.type=types.barrel&&(entity.mass=25||entity.mass=30)||entity.type=types.boulder)",
+            "entity.type=types.barrel&&entity.bbox.height>0.0",
+            "contains(entity.contains, child.type=types.boulder)",
+            "describe('Should burn.', entity.burn_speed != none) and entity.mass > 20"
+    };
+}
+
+struct TestContext
+{
+    Atlas::Objects::Factories factories;
+    Inheritance inheritance{factories};
+    TypeNode thingType{"thing"};
+    TypeNode barrelType{"barrel"};
+    TypeNode boulderType{"boulder"};
+
+    Ref<Entity> barrel{new Entity("1", 1)};
+    Ref<Entity> boulder{new Entity("2", 2)};
+
+    TestContext()
+    {
+        barrelType.setParent(&thingType);
+        boulderType.setParent(&thingType);
+        types["thing"] = &thingType;
+        types["barrel"] = &barrelType;
+        types["boulder"] = &boulderType;
+
+        barrel->setType(&barrelType);
+        barrel->setProperty("mass", std::unique_ptr<PropertyBase>(new SoftProperty(Element(30))));
+        barrel->setProperty("burn_speed", std::unique_ptr<PropertyBase>(new SoftProperty(Element(0.3))));
+        barrel->setProperty("isVisible", std::unique_ptr<PropertyBase>(new SoftProperty(Element(1))));
+        barrel->setProperty("bbox", std::unique_ptr<PropertyBase>(new SoftProperty(Element(ListType{-1, -3, -2, 1, 3, 2}))));
+
+        boulder->setType(&boulderType);
+        boulder->setProperty("mass", std::unique_ptr<PropertyBase>(new SoftProperty(Element(25))));
+        boulder->setProperty("float_list", std::unique_ptr<PropertyBase>(new SoftProperty(Element(ListType{25.0, 20.0}))));
+
+        barrel->makeContainer();
+        barrel->addChild(*boulder);
+    }
+
+    ~TestContext()
+    {
+        types.clear();
+    }
+
+    QueryContext makeContext(LocatedEntity& entity)
+    {
+        QueryContext queryContext{entity};
+        queryContext.type_lookup_fn = [](const std::string& id) { return Inheritance::instance().getType(id); };
+        return queryContext;
+    }
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_queries)
+    }
+
+    template<typename MatchFn>
+    long measure(MatchFn matchFn, size_t count = matchCount)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            matchFn();
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    void test_queries(TestContext& context)
+    {
+        ProviderFactory factory;
+        std::vector<QueryContext> queryContexts{context.makeContext(*context.barrel), context.makeContext(*context.boulder)};
+
+        //Every other entity is a barrel, the rest boulders.
+        std::vector<LocatedEntity*> batch;
+        for (size_t i = 0; i < batchSize; ++i) {
+            batch.push_back(i % 2 ? context.boulder.get() : context.barrel.get());
+        }
+        std::vector<LocatedEntity*> matches;
+
+        long interpretedTotal = 0;
+        long compiledTotal = 0;
+        long batchedTotal = 0;
+        for (auto query : queries) {
+            Filter filter(query, factory);
+            for (auto& queryContext : queryContexts) {
+                ASSERT_EQUAL(filter.matchInterpreted(queryContext), filter.match(queryContext))
+            }
+
+            auto interpreted = measure([&]() {
+                for (auto& queryContext : queryContexts) {
+                    filter.matchInterpreted(queryContext);
+                }
+            });
+            auto compiled = measure([&]() {
+                for (auto& queryContext : queryContexts) {
+                    filter.match(queryContext);
+                }
+            });
+            auto batched = measure([&]() {
+                matches = batch;
+                filter.matchAll(matches, queryContexts.front());
+            }, matchCount * queryContexts.size() / batchSize);
+            ASSERT_EQUAL(batchSize / 2 * ((filter.match(queryContexts[0]) ? 1 : 0) + (filter.match(queryContexts[1]) ? 1 : 0)), matches.size())
+            log(INFO, String::compose("'%1': %2 matches took %3 us interpreted, %4 us compiled and %5 us batched.",
+                                      query, matchCount * queryContexts.size(), interpreted, compiled, batched));
+            interpretedTotal += interpreted;
+            compiledTotal += compiled;
+            batchedTotal += batched;
+        }
+        log(INFO, String::compose("All queries took %1 us interpreted, %2 us compiled and %3 us batched.", interpretedTotal, compiledTotal, batchedTotal));
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
+
+//Stubs
+
+#include "rules/Domain.h"
+#include "rules/Script.h"
+#include "rules/simulation/DomainProperty.h"
+
+#include "../../stubs/common/stubVariable.h"
+#include "../../stubs/common/stubMonitors.h"
+#include "../../stubs/common/stubLink.h"
+#include "../../stubs/rules/simulation/stubDomainProperty.h"
+#include "../../stubs/rules/stubAtlasProperties.h"
+#include "../../stubs/rules/simulation/stubDensityProperty.h"
+#include "../../stubs/rules/stubScaleProperty.h"
+#include "../../stubs/rules/simulation/stubModeProperty.h"
+
+#include "../../stubs/common/stubcustom.h"
+#include "../../stubs/common/stubRouter.h"
+
+#include "../../stubs/rules/simulation/stubBaseWorld.h"
+#include "../../stubs/rules/stubLocation.h"
+#include "../../stubs/rules/stubDomain.h"
+#include "../../stubs/rules/stubScript.h"
+
+#define STUB_Inheritance_getType
+
+const TypeNode* Inheritance::getType(const std::string& parent) const
+{
+    auto I = types.find(parent);
+    if (I == types.end()) {
+        return 0;
+    }
+    return I->second;
+}
+
+#include "../../stubs/common/stubInheritance.h"
+#include "../../stubs/common/stublog.h"
+#include "../../stubs/rules/stubModifier.h"
+
+void addToEntity(const Point3D& p, std::vector<double>& vd)
+{
+    vd.resize(3);
+    vd[0] = p[0];
+    vd[1] = p[1];
+    vd[2] = p[2];
+}
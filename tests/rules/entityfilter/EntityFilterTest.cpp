@@ -193,10 +193,29 @@ struct EntityFilterTest : public Cyphesis::TestBase
         for (const auto& entity : entitiesToPass) {
             QueryContext queryContext = makeContext(entity);
             assert(f.match(queryContext));
+            assert(f.matchInterpreted(queryContext));
         }
         for (const auto& entity : entitiesToFail) {
             QueryContext queryContext = makeContext(entity);
             assert(!f.match(queryContext));
+            assert(!f.matchInterpreted(queryContext));
+        }
+
+        //Matching all of the entities at once should leave the ones which pass, in the same order.
+        std::vector<LocatedEntity*> entities;
+        for (const auto& entity : entitiesToFail) {
+            entities.push_back(entity.get());
+        }
+        for (const auto& entity : entitiesToPass) {
+            entities.push_back(entity.get());
+        }
+        if (!entities.empty()) {
+            f.matchAll(entities, makeContext(entitiesToFail.size() ? *entitiesToFail.begin() : *entitiesToPass.begin()));
+            assert(entities.size() == entitiesToPass.size());
+            auto I = entities.begin();
+            for (const auto& entity : entitiesToPass) {
+                assert(*I++ == entity.get());
+            }
         }
     }
 
@@ -215,9 +234,11 @@ struct EntityFilterTest : public Cyphesis::TestBase
         EntityFilter::Filter f(query, factory);
         for (auto& context : contextsToPass) {
             assert(f.match(context));
+            assert(f.matchInterpreted(context));
         }
         for (auto& context : contextsToFail) {
             assert(!f.match(context));
+            assert(!f.matchInterpreted(context));
         }
     }
 
@@ -300,6 +321,17 @@ struct EntityFilterTest : public Cyphesis::TestBase
             ASSERT_FALSE(errors.empty());
             ASSERT_EQUAL("Should burn.", errors.front());
         }
+        {
+            //The right side is always false, but the left side should still be evaluated and report its failure.
+            EntityFilter::Filter f("describe('Should burn.', entity.burn_speed != none) and 1 = 2", EntityFilter::ProviderFactory());
+            QueryContext queryContext = makeContext(m_bl1);
+            std::vector<std::string> errors;
+            queryContext.report_error_fn = [&](const std::string& error) { errors.push_back(error); };
+            ASSERT_FALSE(f.match(queryContext));
+            ASSERT_EQUAL(1u, errors.size());
+            ASSERT_FALSE(f.matchInterpreted(queryContext));
+            ASSERT_EQUAL(2u, errors.size());
+        }
     }
 
     void test_Memory()
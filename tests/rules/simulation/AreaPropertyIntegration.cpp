@@ -153,6 +153,7 @@ TypeNode::~TypeNode()
 TypeNode::PropertiesUpdate TypeNode::injectProperty(const std::string& name,
                                                     std::unique_ptr<PropertyBase> p)
 {
+    indexDefault(name, p.get());
     m_defaults[name] = std::move(p);
     return {};
 }
@@ -0,0 +1,120 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../../TestBaseWithContext.h"
+
+#include "rules/simulation/CollisionShapeCache.h"
+
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+
+struct TestContext
+{
+    CollisionShapeCache cache;
+
+    WFMath::AxisBox<3> bbox{{-1, 0, -1}, {1, 2, 1}};
+
+    int createdCount = 0;
+
+    std::shared_ptr<btCollisionShape> getShape(std::uint64_t geometryId, const WFMath::AxisBox<3>& box, float mass, btVector3& centerOfMassOffset)
+    {
+        return cache.getShape(geometryId, box, mass, centerOfMassOffset, [&](btVector3& offset) {
+            createdCount++;
+            offset = btVector3(0, -1, 0);
+            return std::make_shared<btBoxShape>(btVector3(1, 1, 1));
+        });
+    }
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_share)
+        ADD_TEST(test_keys)
+        ADD_TEST(test_release)
+    }
+
+    void test_share(TestContext& context)
+    {
+        btVector3 offset1, offset2;
+        auto shape1 = context.getShape(1, context.bbox, 0, offset1);
+        auto shape2 = context.getShape(1, context.bbox, 0, offset2);
+
+        ASSERT_EQUAL(1, context.createdCount)
+        ASSERT_EQUAL(shape1.get(), shape2.get())
+        ASSERT_TRUE(offset1 == offset2)
+        ASSERT_EQUAL(1, context.cache.m_hits)
+        ASSERT_EQUAL(1, context.cache.m_misses)
+        ASSERT_GREATER(context.cache.m_bytesSaved, 0)
+        ASSERT_EQUAL(1u, context.cache.size())
+    }
+
+    void test_keys(TestContext& context)
+    {
+        btVector3 offset;
+        auto shape = context.getShape(1, context.bbox, 0, offset);
+
+        //Any difference in geometry, size or mass class should give a new shape.
+        auto otherGeometry = context.getShape(2, context.bbox, 0, offset);
+        auto otherBox = context.getShape(1, WFMath::AxisBox<3>({-1, 0, -1}, {1, 3, 1}), 0, offset);
+        auto otherMass = context.getShape(1, context.bbox, 10, offset);
+        ASSERT_EQUAL(4, context.createdCount)
+        ASSERT_NOT_EQUAL(shape.get(), otherGeometry.get())
+        ASSERT_NOT_EQUAL(shape.get(), otherBox.get())
+        ASSERT_NOT_EQUAL(shape.get(), otherMass.get())
+
+        //Different masses are shared as long as they are not static.
+        auto sameMassClass = context.getShape(1, context.bbox, 20, offset);
+        ASSERT_EQUAL(otherMass.get(), sameMassClass.get())
+
+        //Shapes for invalid boxes aren't cached.
+        context.getShape(1, WFMath::AxisBox<3>(), 0, offset);
+        context.getShape(1, WFMath::AxisBox<3>(), 0, offset);
+        ASSERT_EQUAL(6, context.createdCount)
+    }
+
+    void test_release(TestContext& context)
+    {
+        btVector3 offset;
+        auto shape = context.getShape(1, context.bbox, 0, offset);
+        std::weak_ptr<btCollisionShape> weakShape = shape;
+        shape.reset();
+
+        //The cache shouldn't keep the shape alive.
+        ASSERT_TRUE(weakShape.expired())
+        ASSERT_EQUAL(0u, context.cache.size())
+
+        shape = context.getShape(1, context.bbox, 0, offset);
+        ASSERT_EQUAL(2, context.createdCount)
+        ASSERT_NOT_NULL(shape.get())
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
@@ -0,0 +1,176 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../../TestBaseWithContext.h"
+
+#include "rules/simulation/VisibilityGrid.h"
+
+#include <map>
+
+struct TestContext
+{
+    VisibilityGrid grid{1.0f};
+    std::vector<VisibilityGrid::OverlapChange> changes;
+
+    /**
+     * Collects the changes into a map of user pointer to "added".
+     */
+    std::map<void*, bool> takeChanges()
+    {
+        std::map<void*, bool> result;
+        for (auto& change : changes) {
+            result[change.userPointer] = change.added;
+        }
+        changes.clear();
+        return result;
+    }
+};
+
+namespace {
+    const short GROUP_OBSERVER = 1;
+    const short GROUP_OBSERVABLE = 2;
+    int observer1;
+    int observer2;
+    int observable1;
+    int observable2;
+}
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_addAndMove)
+        ADD_TEST(test_mask)
+        ADD_TEST(test_largeSphere)
+        ADD_TEST(test_resizeAndRemove)
+    }
+
+    void test_addAndMove(TestContext& context)
+    {
+        context.grid.addSphere(&observable1, btVector3(0, 0, 0), 0.5f, GROUP_OBSERVER, GROUP_OBSERVABLE, context.changes);
+        ASSERT_TRUE(context.changes.empty())
+
+        auto observerHandle = context.grid.addSphere(&observer1, btVector3(0.2f, 0, 0.2f), 0.1f, GROUP_OBSERVABLE, GROUP_OBSERVER, context.changes);
+        auto changes = context.takeChanges();
+        ASSERT_EQUAL(1u, changes.size())
+        ASSERT_TRUE(changes[&observable1])
+
+        //Moving within range shouldn't report anything.
+        context.grid.updateSphere(observerHandle, btVector3(0.3f, 0, 0.3f), 0.1f, context.changes);
+        ASSERT_TRUE(context.changes.empty())
+
+        //Move across a cell border, but still within range.
+        context.grid.updateSphere(observerHandle, btVector3(-0.3f, 0, -0.3f), 0.1f, context.changes);
+        ASSERT_TRUE(context.changes.empty())
+
+        context.grid.updateSphere(observerHandle, btVector3(5, 0, 5), 0.1f, context.changes);
+        changes = context.takeChanges();
+        ASSERT_EQUAL(1u, changes.size())
+        ASSERT_FALSE(changes[&observable1])
+
+        //Height should also be considered.
+        context.grid.updateSphere(observerHandle, btVector3(0, 5, 0), 0.1f, context.changes);
+        ASSERT_TRUE(context.changes.empty())
+
+        context.grid.updateSphere(observerHandle, btVector3(0, 0.5f, 0), 0.1f, context.changes);
+        changes = context.takeChanges();
+        ASSERT_EQUAL(1u, changes.size())
+        ASSERT_TRUE(changes[&observable1])
+    }
+
+    void test_mask(TestContext& context)
+    {
+        context.grid.addSphere(&observable1, btVector3(0, 0, 0), 0.5f, GROUP_OBSERVER, GROUP_OBSERVABLE, context.changes);
+        context.grid.addSphere(&observable2, btVector3(0.1f, 0, 0), 0.5f, GROUP_OBSERVER, GROUP_OBSERVABLE, context.changes);
+        //Observables shouldn't see each other.
+        ASSERT_TRUE(context.changes.empty())
+
+        context.grid.addSphere(&observer1, btVector3(0, 0, 0), 0.1f, GROUP_OBSERVABLE, GROUP_OBSERVER, context.changes);
+        ASSERT_EQUAL(2u, context.takeChanges().size())
+
+        //Observers shouldn't see each other.
+        context.grid.addSphere(&observer2, btVector3(0, 0, 0), 0.1f, GROUP_OBSERVABLE, GROUP_OBSERVER, context.changes);
+        auto changes = context.takeChanges();
+        ASSERT_EQUAL(2u, changes.size())
+        ASSERT_TRUE(changes.find(&observer1) == changes.end())
+    }
+
+    void test_largeSphere(TestContext& context)
+    {
+        auto observerHandle = context.grid.addSphere(&observer1, btVector3(0, 0, 0), 0.01f, GROUP_OBSERVABLE, GROUP_OBSERVER, context.changes);
+        ASSERT_TRUE(context.changes.empty())
+
+        //This will be placed at a much coarser level than the observer.
+        auto observableHandle = context.grid.addSphere(&observable1, btVector3(90, 0, 0), 100.0f, GROUP_OBSERVER, GROUP_OBSERVABLE, context.changes);
+        auto changes = context.takeChanges();
+        ASSERT_EQUAL(1u, changes.size())
+        ASSERT_TRUE(changes[&observer1])
+
+        context.grid.updateSphere(observerHandle, btVector3(-20, 0, 0), 0.01f, context.changes);
+        changes = context.takeChanges();
+        ASSERT_EQUAL(1u, changes.size())
+        ASSERT_FALSE(changes[&observable1])
+
+        context.grid.updateSphere(observableHandle, btVector3(70, 0, 0), 100.0f, context.changes);
+        changes = context.takeChanges();
+        ASSERT_EQUAL(1u, changes.size())
+        ASSERT_TRUE(changes[&observer1])
+    }
+
+    void test_resizeAndRemove(TestContext& context)
+    {
+        context.grid.addSphere(&observer1, btVector3(3, 0, 0), 0.01f, GROUP_OBSERVABLE, GROUP_OBSERVER, context.changes);
+        auto observableHandle = context.grid.addSphere(&observable1, btVector3(0, 0, 0), 0.5f, GROUP_OBSERVER, GROUP_OBSERVABLE, context.changes);
+        ASSERT_TRUE(context.changes.empty())
+
+        //Growing the sphere should move it to a coarser level, and make it overlap.
+        context.grid.updateSphere(observableHandle, btVector3(0, 0, 0), 5.0f, context.changes);
+        auto changes = context.takeChanges();
+        ASSERT_EQUAL(1u, changes.size())
+        ASSERT_TRUE(changes[&observer1])
+
+        context.grid.updateSphere(observableHandle, btVector3(0, 0, 0), 0.5f, context.changes);
+        changes = context.takeChanges();
+        ASSERT_EQUAL(1u, changes.size())
+        ASSERT_FALSE(changes[&observer1])
+
+        ASSERT_EQUAL(2u, context.grid.size())
+        context.grid.removeSphere(observableHandle);
+        ASSERT_EQUAL(1u, context.grid.size())
+
+        //The handle should be reused.
+        ASSERT_EQUAL(observableHandle, context.grid.addSphere(&observable2, btVector3(3, 0, 0), 0.5f, GROUP_OBSERVER, GROUP_OBSERVABLE, context.changes))
+        changes = context.takeChanges();
+        ASSERT_EQUAL(1u, changes.size())
+        ASSERT_TRUE(changes[&observer1])
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
@@ -525,6 +525,7 @@ void installStandardObjects(TypeStore& i)
 TypeNode::PropertiesUpdate TypeNode::injectProperty(const std::string& name,
                                                     std::unique_ptr<PropertyBase> p)
 {
+    indexDefault(name, p.get());
     m_defaults[name] = std::move(p);
     return {};
 }
@@ -284,6 +284,12 @@ void Link::send(const Operation & op) const
 }
 
 
+#define STUB_Link_sendPerception
+void Link::sendPerception(const Operation & op)
+{
+    send(op);
+}
+
 #include "../stubs/common/stubLink.h"
 #include "../stubs/common/stubRouter.h"
 #include "../stubs/rules/simulation/stubBaseWorld.h"
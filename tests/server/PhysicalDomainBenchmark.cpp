@@ -49,6 +49,8 @@
 #include <rules/simulation/AngularFactorProperty.h>
 #include <chrono>
 #include <rules/simulation/VisibilityProperty.h>
+#include <rules/simulation/PhysicalDomainTickExecutor.h>
+#include <thread>
 
 #include "../stubs/common/stublog.h"
 
@@ -81,6 +83,10 @@ class PhysicalDomainBenchmark : public Cyphesis::TestBase
         void test_determinism();
 
         void test_visibilityPerformance();
+
+        void visibilityPerformance(PhysicalDomain::VisibilityEngine engine, const std::string& engineName);
+
+        void test_parallelDomains();
 };
 
 long PhysicalDomainBenchmark::m_id_counter = 0L;
@@ -90,6 +96,7 @@ PhysicalDomainBenchmark::PhysicalDomainBenchmark()
     ADD_TEST(PhysicalDomainBenchmark::test_static_entities_no_move);
     ADD_TEST(PhysicalDomainBenchmark::test_determinism);
     ADD_TEST(PhysicalDomainBenchmark::test_visibilityPerformance);
+    ADD_TEST(PhysicalDomainBenchmark::test_parallelDomains);
 
 }
 
@@ -228,6 +235,14 @@ void PhysicalDomainBenchmark::test_determinism()
 
 void PhysicalDomainBenchmark::test_visibilityPerformance()
 {
+    visibilityPerformance(PhysicalDomain::VisibilityEngine::Bullet, "Bullet");
+    visibilityPerformance(PhysicalDomain::VisibilityEngine::Grid, "grid");
+    PhysicalDomain::s_defaultVisibilityEngine = PhysicalDomain::VisibilityEngine::Bullet;
+}
+
+void PhysicalDomainBenchmark::visibilityPerformance(PhysicalDomain::VisibilityEngine engine, const std::string& engineName)
+{
+    PhysicalDomain::s_defaultVisibilityEngine = engine;
 
     double tickSize = 1.0 / 15.0;
 
@@ -312,10 +327,13 @@ void PhysicalDomainBenchmark::test_visibilityPerformance()
         }
         std::stringstream ss;
         long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
-        ss << "Average tick duration with " << numberOfObservers << " moving observers: " << milliseconds / (15. * 20.0) << " ms";
+        ss << "Average tick duration with " << numberOfObservers << " moving observers using " << engineName << " visibility: " << milliseconds / (15. * 20.0) << " ms";
+        log(INFO, ss.str());
+        ss = std::stringstream();
+        ss << "Physics per second with " << numberOfObservers << " moving observers using " << engineName << " visibility: " << (milliseconds / 20.0) / 10.0 << " %";
         log(INFO, ss.str());
         ss = std::stringstream();
-        ss << "Physics per second with " << numberOfObservers << " moving observers: " << (milliseconds / 20.0) / 10.0 << " %";
+        ss << "Operations generated using " << engineName << " visibility: " << res.size();
         log(INFO, ss.str());
     }
     std::set<LocatedEntity*> transformedEntities;
@@ -333,15 +351,88 @@ void PhysicalDomainBenchmark::test_visibilityPerformance()
         }
         std::stringstream ss;
         long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
-        ss << "Average tick duration without moving observer: " << milliseconds / 15. << " ms";
+        ss << "Average tick duration without moving observer using " << engineName << " visibility: " << milliseconds / 15. << " ms";
         log(INFO, ss.str());
         ss = std::stringstream();
-        ss << "Physics per second without moving observer: " << (milliseconds / 1.0) / 10.0 << " %";
+        ss << "Physics per second without moving observer using " << engineName << " visibility: " << (milliseconds / 1.0) / 10.0 << " %";
         log(INFO, ss.str());
     }
 }
 
 
+void PhysicalDomainBenchmark::test_parallelDomains()
+{
+    double tickSize = 1.0 / 15.0;
+
+    TypeNode* rockType = new TypeNode("rock");
+
+    Property<double>* massProp = new Property<double>();
+    massProp->data() = 100;
+
+    size_t threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    PhysicalDomainTickExecutor executor(threadCount);
+
+    for (size_t domainCount : {1, 2, 4, 8, 16}) {
+        std::vector<PhysicalDomain*> domains;
+
+        for (size_t domainIndex = 0; domainIndex < domainCount; ++domainIndex) {
+            Entity* rootEntity = new Entity(compose("root%1", domainIndex), newId());
+            TerrainProperty* terrainProperty = new TerrainProperty();
+            Mercator::Terrain& terrain = terrainProperty->getData();
+            terrain.setBasePoint(0, 0, Mercator::BasePoint(40));
+            terrain.setBasePoint(0, 1, Mercator::BasePoint(40));
+            terrain.setBasePoint(1, 0, Mercator::BasePoint(10));
+            terrain.setBasePoint(1, 1, Mercator::BasePoint(10));
+            rootEntity->setProperty("terrain", std::unique_ptr<PropertyBase>(terrainProperty));
+            rootEntity->m_location.m_pos = WFMath::Point<3>::ZERO();
+            rootEntity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(0, -64, 0), WFMath::Point<3>(64, 64, 64)));
+            PhysicalDomain* domain = new PhysicalDomain(*rootEntity);
+
+            //Add entities falling onto each other, so that there's something to simulate.
+            for (size_t i = 0; i < 10; ++i) {
+                for (size_t j = 0; j < 10; ++j) {
+                    long id = newId();
+                    Entity* freeEntity = new Entity(compose("free%1", id), id);
+                    freeEntity->setProperty("mass", std::unique_ptr<PropertyBase>(massProp));
+                    freeEntity->setType(rockType);
+                    freeEntity->m_location.m_pos = WFMath::Point<3>(i, j + 20, i + j);
+                    freeEntity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-0.25f, 0, -0.25f), WFMath::Point<3>(0.25f, 0.5f, 0.25f)));
+                    domain->addEntity(*freeEntity);
+                }
+            }
+            domains.push_back(domain);
+        }
+
+        OpVector res;
+        //First tick is setup, so we'll exclude that from time measurement
+        for (auto domain : domains) {
+            domain->tick(tickSize, res);
+        }
+
+        long serialMilliseconds;
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < 30; ++i) {
+                for (auto domain : domains) {
+                    domain->tick(tickSize, res);
+                }
+            }
+            serialMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+        long parallelMilliseconds;
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < 30; ++i) {
+                executor.tick(domains, tickSize, res);
+            }
+            parallelMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+        log(INFO, compose("Average tick duration for %1 domains: serial %2 ms, parallel with %3 worker threads %4 ms",
+                          domainCount, serialMilliseconds / 30.0, executor.getThreadCount(), parallelMilliseconds / 30.0));
+    }
+}
 
 int main()
 {
@@ -38,6 +38,7 @@
 #include <wfmath/atlasconv.h>
 
 #include <rules/simulation/PhysicalDomain.h>
+#include <rules/simulation/PhysicalDomainTickExecutor.h>
 #include "physics/Convert.h"
 #include <rules/simulation/TerrainProperty.h>
 #include <Mercator/BasePoint.h>
@@ -107,6 +108,11 @@ class TestPhysicalDomain : public PhysicalDomain
         {
             childEntityPropertyApplied(name, prop, m_entries.find(id)->second.get());
         }
+
+        double test_getLastStepSize() const
+        {
+            return m_lastStepSize;
+        }
 };
 
 double epsilon = 0.0001;
@@ -149,6 +155,7 @@ struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
         ADD_TEST(Tested::test_collision);
         ADD_TEST(Tested::test_mode);
         ADD_TEST(Tested::test_determinism);
+        ADD_TEST(Tested::test_tickExecutor);
         ADD_TEST(Tested::test_zoffset);
         ADD_TEST(Tested::test_zscaledoffset);
         ADD_TEST(Tested::test_visibility);
@@ -1655,6 +1662,81 @@ struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
     }
 
 
+    /**
+     * Checks that when a tick executor is used, changes made by ops processed in the same main loop iteration as the Tick op
+     * still are part of the step, just as when stepping serially.
+     */
+    void test_tickExecutor(TestContext& context)
+    {
+        PhysicalDomainTickExecutor executor(0);
+
+        Ref<Entity> rootEntity = new Entity("0", context.newId());
+        rootEntity->m_location.m_pos = WFMath::Point<3>::ZERO();
+        rootEntity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-64, -64, -64), WFMath::Point<3>(64, 64, 64)));
+        TestWorld testWorld(rootEntity);
+        std::unique_ptr<TestPhysicalDomain> domain(new TestPhysicalDomain(*rootEntity));
+
+        Property<double>* massProp = new Property<double>();
+        massProp->data() = 100;
+
+        TypeNode* rockType = new TypeNode("rock");
+
+        Ref<Entity> freeEntity = new Entity("1", context.newId());
+        freeEntity->setProperty("mass", std::unique_ptr<PropertyBase>(massProp));
+        freeEntity->setType(rockType);
+        freeEntity->m_location.m_pos = WFMath::Point<3>::ZERO();
+        freeEntity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-1, 0, -1), WFMath::Point<3>(1, 1, 1)));
+        domain->addEntity(*freeEntity);
+
+        Atlas::Objects::Entity::Anonymous tickArg;
+        tickArg->setName("domain");
+        Atlas::Objects::Operation::Tick tickOp;
+        tickOp->setArgs1(tickArg);
+        tickOp->setSeconds(1);
+        tickOp->setAttr("lastTick", 0.9);
+
+        OpVector res;
+        domain->operation(rootEntity.get(), tickOp, res);
+        //The step should be queued, while the next Tick op still is scheduled.
+        ASSERT_EQUAL(1u, res.size())
+        ASSERT_EQUAL(Atlas::Objects::Operation::TICK_NO, res.front()->getClassNo())
+        ASSERT_EQUAL(freeEntity->m_location.m_pos, WFMath::Point<3>::ZERO())
+
+        //Move the entity after the Tick op has been processed, but in the same iteration.
+        std::set<LocatedEntity*> transformedEntities;
+        domain->applyTransform(*freeEntity, Domain::TransformData{WFMath::Quaternion::IDENTITY(), WFMath::Point<3>(10, 20, 10), nullptr, {}}, transformedEntities);
+
+        ASSERT_TRUE(executor.runQueuedTicks())
+        //The entity should have fallen from where it was moved to.
+        ASSERT_FUZZY_EQUAL(freeEntity->m_location.m_pos.x(), 10, 0.1);
+        ASSERT_FUZZY_EQUAL(freeEntity->m_location.m_pos.z(), 10, 0.1);
+        ASSERT_TRUE(freeEntity->m_location.m_pos.y() < 20)
+
+        //Nothing more is queued.
+        ASSERT_FALSE(executor.runQueuedTicks())
+
+        //If Tick ops back up the steps should be merged, rather than any being made out of order.
+        res.clear();
+        tickOp->setSeconds(1.1);
+        tickOp->setAttr("lastTick", 1.0);
+        domain->operation(rootEntity.get(), tickOp, res);
+        tickOp->setSeconds(1.3);
+        tickOp->setAttr("lastTick", 1.1);
+        domain->operation(rootEntity.get(), tickOp, res);
+        ASSERT_EQUAL(2u, res.size())
+        ASSERT_TRUE(executor.runQueuedTicks())
+        ASSERT_FUZZY_EQUAL(domain->test_getLastStepSize(), 0.3, 0.0001);
+        ASSERT_FALSE(executor.runQueuedTicks())
+
+        //A domain being destroyed should remove any queued step.
+        res.clear();
+        tickOp->setSeconds(1.4);
+        tickOp->setAttr("lastTick", 1.3);
+        domain->operation(rootEntity.get(), tickOp, res);
+        domain.reset();
+        ASSERT_FALSE(executor.runQueuedTicks())
+    }
+
     void test_zoffset(TestContext& context)
     {
 
@@ -35,15 +35,21 @@
 #include "common/Property_impl.h"
 #include "../DatabaseNull.h"
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <server/EntityBuilder.h>
 
 using Atlas::Message::Element;
+using Atlas::Message::MapType;
 
 class TestStorageManager : public StorageManager
 {
   public:
-    TestStorageManager(WorldRouter&w, Database& db, EntityBuilder& eb) : StorageManager(w, db, eb) { }
+    TestStorageManager(WorldRouter&w, Database& db, EntityBuilder& eb,
+                       std::chrono::steady_clock::duration writeBehind = std::chrono::steady_clock::duration::zero(),
+                       std::chrono::steady_clock::duration locationWriteInterval = std::chrono::steady_clock::duration::zero())
+        : StorageManager(w, db, eb, writeBehind, locationWriteInterval) { }
 
     
     void test_entityInserted(LocatedEntity * e) {
@@ -70,9 +76,245 @@ class TestStorageManager : public StorageManager
         restoreChildren(e);
     }
 
+    int test_coalescedUpdateCount() const {
+        return m_coalescedUpdateCount;
+    }
+    int test_unchangedPropertyCount() const {
+        return m_unchangedPropertyCount;
+    }
+    int test_unchangedLocationCount() const {
+        return m_unchangedLocationCount;
+    }
+    int test_deferredLocationCount() const {
+        return m_deferredLocationCount;
+    }
+    size_t test_writtenStateCount() const {
+        return m_writtenStates.size();
+    }
+
+};
+
+/**
+ * Encodes objects into strings, so that changes in values can be detected, and records all writes.
+ */
+class TestDatabase : public DatabaseNull
+{
+    public:
+        int locationWrites = 0;
+        int propertyWrites = 0;
+
+        static void encode(const Element& element, std::string& store)
+        {
+            if (element.isInt()) {
+                store += std::to_string(element.Int());
+            } else if (element.isFloat()) {
+                store += std::to_string(element.Float());
+            } else if (element.isString()) {
+                store += "\"" + element.String() + "\"";
+            } else if (element.isList()) {
+                store += "[";
+                for (auto& entry : element.List()) {
+                    encode(entry, store);
+                    store += ",";
+                }
+                store += "]";
+            } else if (element.isMap()) {
+                store += "{";
+                for (auto& entry : element.Map()) {
+                    store += entry.first + ":";
+                    encode(entry.second, store);
+                    store += ",";
+                }
+                store += "}";
+            }
+        }
+
+        int encodeObject(const MapType& map, std::string& store) override
+        {
+            encode(map, store);
+            return 0;
+        }
+
+        int updateEntity(const std::string& id, int seq, const std::string& location_data, const std::string& location_entity_id) override
+        {
+            ++locationWrites;
+            return 0;
+        }
+
+        int updateEntityWithoutLoc(const std::string& id, int seq, const std::string& location_data) override
+        {
+            ++locationWrites;
+            return 0;
+        }
+
+        int insertProperties(const std::string& id, const KeyValues& tuples) override
+        {
+            propertyWrites += tuples.size();
+            return 0;
+        }
+
+        int updateProperties(const std::string& id, const KeyValues& tuples) override
+        {
+            propertyWrites += tuples.size();
+            return 0;
+        }
+};
 
+/**
+ * An entity which already has been stored, with a single persisted property.
+ */
+class TestEntity : public Entity
+{
+    public:
+        Property<MapType>* prop;
+
+        explicit TestEntity(const std::string& id, long intId) : Entity(id, intId), prop(new Property<MapType>())
+        {
+            m_properties["test"].property.reset(prop);
+            prop->addFlags(prop_flag_persistence_clean | prop_flag_persistence_seen);
+            m_location.m_pos = WFMath::Point<3>::ZERO();
+            addFlags(entity_clean_mask);
+        }
+
+        void move(double x)
+        {
+            m_location.m_pos.x() = x;
+            removeFlags(entity_pos_clean);
+        }
+
+        void changeProperty(int value)
+        {
+            prop->data()["value"] = value;
+            prop->removeFlags(prop_flag_persistence_clean);
+            removeFlags(entity_clean);
+        }
 };
 
+/// Rows returned by the stubbed entity selects, as "id", "loc", "type" and "location".
+std::vector<std::vector<std::string>> entityRows;
+/// Rows returned by the stubbed property selects, as "id", "name" and "value".
+std::vector<std::vector<std::string>> propertyRows;
+/// Ids of restored entities, in the order they were added to the world.
+std::vector<std::string> addedEntities;
+
+struct TestResultIteratorWorker : public DatabaseResult::const_iterator_worker
+{
+    const std::vector<std::string>& names;
+    const std::vector<std::vector<std::string>>& rows;
+    size_t index;
+
+    TestResultIteratorWorker(const std::vector<std::string>& names_, const std::vector<std::vector<std::string>>& rows_, size_t index_)
+        : names(names_), rows(rows_), index(index_)
+    {}
+
+    const char* column(int column) const override
+    {
+        if (index >= rows.size() || column < 0 || static_cast<size_t>(column) >= rows[index].size()) {
+            return nullptr;
+        }
+        return rows[index][column].c_str();
+    }
+
+    const char* column(const char* column) const override
+    {
+        auto I = std::find(names.begin(), names.end(), column);
+        if (I == names.end()) {
+            return nullptr;
+        }
+        return this->column(static_cast<int>(std::distance(names.begin(), I)));
+    }
+
+    DatabaseResult::const_iterator_worker& operator++() override
+    {
+        ++index;
+        return *this;
+    }
+
+    bool operator==(const const_iterator_worker& other) const override
+    {
+        return index == static_cast<const TestResultIteratorWorker&>(other).index;
+    }
+};
+
+/**
+ * A result with predefined rows.
+ */
+class TestResultWorker : public DatabaseResult::DatabaseResultWorker
+{
+    public:
+        std::vector<std::string> names;
+        std::vector<std::vector<std::string>> rows;
+
+        TestResultWorker(std::vector<std::string> names_, std::vector<std::vector<std::string>> rows_)
+            : names(std::move(names_)), rows(std::move(rows_))
+        {}
+
+        int size() const override
+        {
+            return static_cast<int>(rows.size());
+        }
+
+        int columns() const override
+        {
+            return static_cast<int>(names.size());
+        }
+
+        bool error() const override
+        {
+            return false;
+        }
+
+        DatabaseResult::const_iterator begin() const override
+        {
+            return DatabaseResult::const_iterator(std::unique_ptr<DatabaseResult::const_iterator_worker>(new TestResultIteratorWorker(names, rows, 0)), *this);
+        }
+
+        DatabaseResult::const_iterator end() const override
+        {
+            return DatabaseResult::const_iterator(std::unique_ptr<DatabaseResult::const_iterator_worker>(new TestResultIteratorWorker(names, rows, rows.size())), *this);
+        }
+};
+
+DatabaseResult selectRows(std::vector<std::string> names, const std::vector<std::vector<std::string>>& rows, size_t column, const std::string& value)
+{
+    std::vector<std::vector<std::string>> selected;
+    std::copy_if(rows.begin(), rows.end(), std::back_inserter(selected), [&](const std::vector<std::string>& row) { return row[column] == value; });
+    return DatabaseResult(std::unique_ptr<TestResultWorker>(new TestResultWorker(std::move(names), std::move(selected))));
+}
+
+class TestPropertyManager : public PropertyManager
+{
+    public:
+        std::unique_ptr<PropertyBase> addProperty(const std::string& name) const override
+        {
+            return std::unique_ptr<PropertyBase>(new Property<MapType>());
+        }
+};
+
+/**
+ * Describes the parent and the properties of all entities contained in the entity, keyed by entity id.
+ */
+void describeRestored(LocatedEntity* ent, std::map<std::string, std::string>& result)
+{
+    if (!ent->m_contains) {
+        return;
+    }
+    for (auto& child : *ent->m_contains) {
+        std::map<std::string, std::string> properties;
+        for (auto& entry : child->getProperties()) {
+            Element value;
+            entry.second.property->get(value);
+            TestDatabase::encode(value, properties[entry.first]);
+        }
+        auto& description = result[child->getId()];
+        description = "parent:" + ent->getId();
+        for (auto& entry : properties) {
+            description += " " + entry.first + ":" + entry.second;
+        }
+        describeRestored(child.get(), result);
+    }
+}
+
 int main()
 {
     EntityBuilder eb;
@@ -108,7 +350,184 @@ int main()
 
         StorageManager store(world, database, eb);
 
+        store.restoreWorld(le, false);
+    }
+
+    {
+        WorldRouter world(le, eb, {});
+
+        StorageManager store(world, database, eb);
+
+        store.tick();
+    }
+
+    // Updates of an already queued entity are written together.
+    {
+        WorldRouter world(le, eb, {});
+        TestDatabase testDatabase;
+
+        TestStorageManager store(world, testDatabase, eb, std::chrono::hours(1));
+
+        Ref<TestEntity> ent = new TestEntity("1", 1);
+        ent->move(1);
+        store.test_entityUpdated(ent.get());
+        ent->changeProperty(1);
+        store.test_entityUpdated(ent.get());
+        ent->move(2);
+        store.test_entityUpdated(ent.get());
+        assert(store.test_coalescedUpdateCount() == 2);
+
+        // Not due yet.
+        store.tick();
+        assert(testDatabase.locationWrites == 0);
+        assert(testDatabase.propertyWrites == 0);
+
+        store.tick(true);
+        assert(testDatabase.locationWrites == 1);
+        assert(testDatabase.propertyWrites == 1);
+        assert(!ent->hasFlags(entity_queued));
+    }
+
+    // Writes are skipped if the encoded data hasn't changed since it was last written.
+    {
+        WorldRouter world(le, eb, {});
+        TestDatabase testDatabase;
+
+        TestStorageManager store(world, testDatabase, eb);
+
+        Ref<TestEntity> ent = new TestEntity("1", 1);
+        ent->move(1);
+        ent->changeProperty(1);
+        store.test_entityUpdated(ent.get());
+        store.tick();
+        assert(testDatabase.locationWrites == 1);
+        assert(testDatabase.propertyWrites == 1);
+
+        // Marked as dirty, but with the same values.
+        ent->move(1);
+        ent->changeProperty(1);
+        store.test_entityUpdated(ent.get());
+        store.tick();
+        assert(testDatabase.locationWrites == 1);
+        assert(testDatabase.propertyWrites == 1);
+        assert(store.test_unchangedLocationCount() == 1);
+        assert(store.test_unchangedPropertyCount() == 1);
+
+        ent->changeProperty(2);
+        store.test_entityUpdated(ent.get());
         store.tick();
+        assert(testDatabase.locationWrites == 1);
+        assert(testDatabase.propertyWrites == 2);
+    }
+
+    // Location only writes are rate limited, but property writes aren't held back by them.
+    {
+        WorldRouter world(le, eb, {});
+        TestDatabase testDatabase;
+
+        TestStorageManager store(world, testDatabase, eb, std::chrono::steady_clock::duration::zero(), std::chrono::hours(1));
+
+        Ref<TestEntity> ent = new TestEntity("1", 1);
+        ent->move(1);
+        store.test_entityUpdated(ent.get());
+        store.tick(true);
+        assert(testDatabase.locationWrites == 1);
+
+        ent->move(2);
+        store.test_entityUpdated(ent.get());
+        store.tick();
+        assert(testDatabase.locationWrites == 1);
+        assert(store.test_deferredLocationCount() == 1);
+        assert(ent->hasFlags(entity_queued));
+
+        // The entity is still queued for the postponed location write, which shouldn't delay the property.
+        ent->changeProperty(1);
+        store.test_entityUpdated(ent.get());
+        store.tick();
+        assert(testDatabase.propertyWrites == 1);
+        assert(testDatabase.locationWrites == 2);
+        assert(!ent->hasFlags(entity_queued));
+
+        // Nothing should be left in the queue.
+        store.tick(true);
+        assert(testDatabase.locationWrites == 2);
+        assert(testDatabase.propertyWrites == 1);
+    }
+
+    // Entities destroyed while waiting to be written aren't written again.
+    {
+        WorldRouter world(le, eb, {});
+        TestDatabase testDatabase;
+
+        TestStorageManager store(world, testDatabase, eb, std::chrono::hours(1));
+
+        Ref<TestEntity> ent = new TestEntity("1", 1);
+        ent->move(1);
+        ent->changeProperty(1);
+        store.test_entityUpdated(ent.get());
+        assert(ent->hasFlags(entity_queued));
+
+        ent->addFlags(entity_destroyed);
+        store.test_entityUpdated(ent.get());
+
+        store.tick(true);
+        assert(testDatabase.locationWrites == 0);
+        assert(testDatabase.propertyWrites == 0);
+        assert(!ent->hasFlags(entity_queued));
+        assert(store.test_writtenStateCount() == 0);
+    }
+
+    // Restoring from the whole tables should give the same result as restoring each entity separately.
+    {
+        TestPropertyManager propertyManager;
+
+        // Rows in the order they are selected by the database. Entity 2 is listed before its parent 5.
+        entityRows = {{"1", "0", "thing", "l1"},
+                      {"7", "0", "thing", "l7"},
+                      {"3", "1", "thing", "l3"},
+                      {"2", "5", "thing", "l2"},
+                      {"5", "7", "thing", "l5"}};
+        propertyRows = {{"1", "name", "one"},
+                        {"2", "mass", "2"},
+                        {"2", "name", "two"},
+                        {"5", "name", "five"},
+                        {"7", "name", "seven"}};
+
+        std::map<std::string, std::string> bulkResult;
+        {
+            Ref<LocatedEntity> world = new Entity("0", 0);
+            WorldRouter worldRouter(world, eb, {});
+            StorageManager store(worldRouter, database, eb);
+
+            addedEntities.clear();
+            store.restoreWorld(world, true);
+            assert((addedEntities == std::vector<std::string>{"1", "3", "7", "5", "2"}));
+            describeRestored(world.get(), bulkResult);
+        }
+
+        assert(bulkResult.size() == 5);
+        assert(bulkResult["1"] == "parent:0 name:{value:\"one\",}");
+        assert(bulkResult["2"] == "parent:5 mass:{value:\"2\",} name:{value:\"two\",}");
+        assert(bulkResult["3"] == "parent:1");
+        assert(bulkResult["5"] == "parent:7 name:{value:\"five\",}");
+        assert(bulkResult["7"] == "parent:0 name:{value:\"seven\",}");
+
+        std::map<std::string, std::string> perEntityResult;
+        {
+            Ref<LocatedEntity> world = new Entity("0", 0);
+            WorldRouter worldRouter(world, eb, {});
+            StorageManager store(worldRouter, database, eb);
+
+            addedEntities.clear();
+            store.restoreWorld(world, false);
+            assert((addedEntities == std::vector<std::string>{"1", "3", "7", "5", "2"}));
+            describeRestored(world.get(), perEntityResult);
+        }
+
+        assert(bulkResult == perEntityResult);
+
+        entityRows.clear();
+        propertyRows.clear();
     }
 
     {
@@ -191,8 +610,22 @@ int main()
 #include "common/Monitors.h"
 #include "common/PropertyManager.h"
 #include "common/SystemTime.h"
+#include "common/TypeNode.h"
 #include "common/Variable.h"
 
+#define STUB_WorldRouter_addEntity
+void WorldRouter::addEntity(const Ref<LocatedEntity>& obj, const Ref<LocatedEntity>& parent)
+{
+    //Parents must be restored before their children.
+    assert(parent->getId() == "0" || std::find(addedEntities.begin(), addedEntities.end(), parent->getId()) != addedEntities.end());
+    addedEntities.push_back(obj->getId());
+    obj->m_location.m_parent = parent;
+    if (!parent->m_contains) {
+        parent->m_contains.reset(new LocatedEntitySet);
+    }
+    parent->m_contains->insert(obj);
+}
+
 #include "../stubs/rules/simulation/stubWorldRouter.h"
 #include "../stubs/rules/stubLocation.h"
 #include "../stubs/rules/simulation/stubEntity.h"
@@ -209,6 +642,23 @@ int main()
 using Atlas::Message::MapType;
 using Atlas::Objects::Entity::RootEntity;
 
+#define STUB_EntityBuilder_newEntity
+Ref<Entity> EntityBuilder::newEntity(const std::string & id, long intId, const std::string & type, const Atlas::Objects::Entity::RootEntity & attrs) const
+{
+    static TypeNode thingType("thing");
+    Ref<Entity> entity = new Entity(id, intId);
+    entity->setType(&thingType);
+    return entity;
+}
+
+#define STUB_LocatedEntity_setProperty
+PropertyBase* LocatedEntity::setProperty(const std::string& name, std::unique_ptr<PropertyBase> prop)
+{
+    auto propPtr = prop.get();
+    m_properties[name].property = std::move(prop);
+    return propPtr;
+}
+
 #include "../stubs/server/stubEntityBuilder.h"
 #include "../stubs/rules/stubLocatedEntity.h"
 #include "../stubs/common/stubRouter.h"
@@ -216,13 +666,32 @@ using Atlas::Objects::Entity::RootEntity;
 #define STUB_Database_selectEntities
 DatabaseResult Database::selectEntities(const std::string & loc)
 {
-    return DatabaseResult(std::unique_ptr<DatabaseNullResultWorker>(new DatabaseNullResultWorker()));
+    return selectRows({"id", "loc", "type", "location"}, entityRows, 1, loc);
 }
 
 #define STUB_Database_selectProperties
 DatabaseResult Database::selectProperties(const std::string& loc)
 {
-    return DatabaseResult(std::unique_ptr<DatabaseNullResultWorker>(new DatabaseNullResultWorker()));
+    return selectRows({"id", "name", "value"}, propertyRows, 0, loc);
+}
+
+#define STUB_Database_selectAllEntities
+DatabaseResult Database::selectAllEntities()
+{
+    return DatabaseResult(std::unique_ptr<TestResultWorker>(new TestResultWorker({"id", "loc", "type", "location"}, entityRows)));
+}
+
+#define STUB_Database_selectAllProperties
+DatabaseResult Database::selectAllProperties()
+{
+    return DatabaseResult(std::unique_ptr<TestResultWorker>(new TestResultWorker({"id", "name", "value"}, propertyRows)));
+}
+
+#define STUB_Database_decodeMessage
+int Database::decodeMessage(const std::string& data, Atlas::Message::MapType& map)
+{
+    map["val"] = MapType{{"value", data}};
+    return 0;
 }
 
 #define STUB_Database_selectThoughts
@@ -235,6 +704,7 @@ DatabaseResult Database::selectThoughts(const std::string& loc)
 #include "../stubs/server/stubPersistence.h"
 
 #include "../stubs/common/stubPropertyManager.h"
+#include "../stubs/common/stubTypeNode.h"
 
 #include "../stubs/rules/stubScript.h"
 #include "../stubs/modules/stubWeakEntityRef.h"
@@ -276,6 +746,9 @@ template class Variable<std::string>;
 template <typename T>
 void Property<T>::set(const Atlas::Message::Element & e)
 {
+    if (e.isMap()) {
+        this->m_data = e.Map();
+    }
 }
 
 template class Property<MapType>;
@@ -291,6 +764,16 @@ long forceIntegerId(const std::string & id)
 
     return intId;
 }
+
+long integerId(const std::string & id)
+{
+    long intId = strtol(id.c_str(), 0, 10);
+    if (intId == 0 && id != "0") {
+        intId = -1L;
+    }
+
+    return intId;
+}
 #include "../stubs/common/stublog.h"
 
 bool database_flag = true;
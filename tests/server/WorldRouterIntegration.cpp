@@ -278,6 +278,7 @@ int PythonScriptFactory<LocatedEntity>::setup()
 #include "../stubs/rules/ai/stubBaseMind.h"
 #include "../stubs/rules/stubMemEntity.h"
 #include "../stubs/rules/ai/stubMemMap.h"
+#include "../stubs/rules/ai/stubLocationIndex.h"
 #include "../stubs/rules/simulation/stubPropelProperty.h"
 #include "../stubs/rules/python/stubPythonClass.h"
 #include "../stubs/rules/simulation/stubPedestrian.h"
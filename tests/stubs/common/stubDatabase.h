@@ -225,6 +225,14 @@
   }
 #endif //STUB_Database_selectEntities
 
+#ifndef STUB_Database_selectAllEntities
+//#define STUB_Database_selectAllEntities
+  DatabaseResult Database::selectAllEntities()
+  {
+    return *static_cast<DatabaseResult*>(nullptr);
+  }
+#endif //STUB_Database_selectAllEntities
+
 #ifndef STUB_Database_dropEntity
 //#define STUB_Database_dropEntity
   int Database::dropEntity(long id)
@@ -257,6 +265,14 @@
   }
 #endif //STUB_Database_selectProperties
 
+#ifndef STUB_Database_selectAllProperties
+//#define STUB_Database_selectAllProperties
+  DatabaseResult Database::selectAllProperties()
+  {
+    return *static_cast<DatabaseResult*>(nullptr);
+  }
+#endif //STUB_Database_selectAllProperties
+
 #ifndef STUB_Database_updateProperties
 //#define STUB_Database_updateProperties
   int Database::updateProperties(const std::string& id, const KeyValues& tuples)
@@ -58,6 +58,7 @@ DatabaseResult::DatabaseResult(DatabaseResult&& dr) noexcept
 
 DatabaseResult::const_iterator& DatabaseResult::const_iterator::operator++()
 {
+    ++(*m_worker);
     return *this;
 }
 
@@ -41,6 +41,30 @@
   }
 #endif //STUB_Link_send
 
+#ifndef STUB_Link_sendPerception
+//#define STUB_Link_sendPerception
+  void Link::sendPerception(const Operation & op)
+  {
+    
+  }
+#endif //STUB_Link_sendPerception
+
+#ifndef STUB_Link_sendPerceptionOp
+//#define STUB_Link_sendPerceptionOp
+  void Link::sendPerceptionOp(const Operation & op)
+  {
+    
+  }
+#endif //STUB_Link_sendPerceptionOp
+
+#ifndef STUB_Link_flushPerceptions
+//#define STUB_Link_flushPerceptions
+  void Link::flushPerceptions() const
+  {
+    
+  }
+#endif //STUB_Link_flushPerceptions
+
 #ifndef STUB_Link_sendError
 //#define STUB_Link_sendError
   void Link::sendError(const Operation & op, const std::string &, const std::string &) const
@@ -4,6 +4,9 @@
 Link::Link(CommSocket & commSocket, const std::string & id, long iid)
     : Router(id, iid)
     , m_encoder(nullptr)
+    , m_perceptionBundling(false)
+    , m_propertyDeltas(false)
+    , m_perceptionsDeferred(false)
     ,m_commSocket(commSocket)
 {
 
@@ -0,0 +1,52 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubPropertyDeltas_custom.h file.
+
+#ifndef STUB_COMMON_PROPERTYDELTAS_H
+#define STUB_COMMON_PROPERTYDELTAS_H
+
+#include "common/PropertyDeltas.h"
+#include "stubPropertyDeltas_custom.h"
+
+#ifndef STUB_PropertyDeltas_PropertyDeltas
+//#define STUB_PropertyDeltas_PropertyDeltas
+   PropertyDeltas::PropertyDeltas()
+    : Singleton()
+  {
+    
+  }
+#endif //STUB_PropertyDeltas_PropertyDeltas
+
+#ifndef STUB_PropertyDeltas_PropertyDeltas_DTOR
+//#define STUB_PropertyDeltas_PropertyDeltas_DTOR
+   PropertyDeltas::~PropertyDeltas()
+  {
+    
+  }
+#endif //STUB_PropertyDeltas_PropertyDeltas_DTOR
+
+#ifndef STUB_PropertyDeltas_createDelta
+//#define STUB_PropertyDeltas_createDelta
+  bool PropertyDeltas::createDelta(const std::string& name, const Atlas::Message::Element& previous, const Atlas::Message::Element& current, Atlas::Message::MapType& delta)
+  {
+    return false;
+  }
+#endif //STUB_PropertyDeltas_createDelta
+
+#ifndef STUB_PropertyDeltas_add
+//#define STUB_PropertyDeltas_add
+  void PropertyDeltas::add(const Atlas::Objects::Root& arg, Atlas::Objects::Root deltaArg, double seconds)
+  {
+    
+  }
+#endif //STUB_PropertyDeltas_add
+
+#ifndef STUB_PropertyDeltas_apply
+//#define STUB_PropertyDeltas_apply
+  Operation PropertyDeltas::apply(const Operation& op)
+  {
+    return *static_cast<Operation*>(nullptr);
+  }
+#endif //STUB_PropertyDeltas_apply
+
+
+#endif
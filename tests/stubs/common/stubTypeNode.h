@@ -73,6 +73,30 @@
   }
 #endif //STUB_TypeNode_isTypeOf
 
+#ifndef STUB_TypeNode_setParent
+//#define STUB_TypeNode_setParent
+  void TypeNode::setParent(TypeNode* parent)
+  {
+    
+  }
+#endif //STUB_TypeNode_setParent
+
+#ifndef STUB_TypeNode_renumber
+//#define STUB_TypeNode_renumber
+  void TypeNode::renumber()
+  {
+    
+  }
+#endif //STUB_TypeNode_renumber
+
+#ifndef STUB_TypeNode_detach
+//#define STUB_TypeNode_detach
+  void TypeNode::detach()
+  {
+    
+  }
+#endif //STUB_TypeNode_detach
+
 #ifndef STUB_TypeNode_setDescription
 //#define STUB_TypeNode_setDescription
   void TypeNode::setDescription(const Atlas::Objects::Root& description)
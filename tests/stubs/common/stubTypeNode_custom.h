@@ -21,6 +21,14 @@
   }
 #endif //STUB_TypeNode_TypeNode
 
+#ifndef STUB_TypeNode_setParent
+#define STUB_TypeNode_setParent
+void TypeNode::setParent(TypeNode* parent)
+{
+    m_parent = parent;
+}
+#endif //STUB_TypeNode_setParent
+
 #ifndef STUB_TypeNode_updateProperties
 #define STUB_TypeNode_updateProperties
 TypeNode::PropertiesUpdate TypeNode::updateProperties(const Atlas::Message::MapType& attributes, const PropertyManager& propertyManager)
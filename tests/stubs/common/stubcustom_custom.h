@@ -14,5 +14,6 @@ namespace Atlas { namespace Objects { namespace Operation {
             int PICKUP_NO = -1;
             int POSSESS_NO = -1;
             int CLOSE_CONTAINER_NO = -1;
+            int BUNDLE_NO = -1;
 
         } } }
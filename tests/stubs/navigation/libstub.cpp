@@ -18,3 +18,9 @@
 
 #include "stubAwareness.h"
 #include "stubSteering.h"
+#include "stubTileBuilder.h"
+#include "stubTileStore.h"
+#include "stubPathCache.h"
+#include "stubTileGraph.h"
+#include "stubNeighbourGrid.h"
+#include "stubCrowd.h"
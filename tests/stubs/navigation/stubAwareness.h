@@ -58,6 +58,14 @@
   }
 #endif //STUB_Awareness_rebuildDirtyTile
 
+#ifndef STUB_Awareness_getTileBuildsInProgress
+//#define STUB_Awareness_getTileBuildsInProgress
+  size_t Awareness::getTileBuildsInProgress() const
+  {
+    return 0;
+  }
+#endif //STUB_Awareness_getTileBuildsInProgress
+
 #ifndef STUB_Awareness_findPath
 //#define STUB_Awareness_findPath
   int Awareness::findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, float radius, std::vector<WFMath::Point<3>>& path) const
@@ -66,6 +74,54 @@
   }
 #endif //STUB_Awareness_findPath
 
+#ifndef STUB_Awareness_queuePathRequest
+//#define STUB_Awareness_queuePathRequest
+  void Awareness::queuePathRequest(const std::shared_ptr<PathRequest>& request)
+  {
+    
+  }
+#endif //STUB_Awareness_queuePathRequest
+
+#ifndef STUB_Awareness_processPathRequests
+//#define STUB_Awareness_processPathRequests
+  size_t Awareness::processPathRequests(size_t maxSearches)
+  {
+    return 0;
+  }
+#endif //STUB_Awareness_processPathRequests
+
+#ifndef STUB_Awareness_findCoarsePath
+//#define STUB_Awareness_findCoarsePath
+  bool Awareness::findCoarsePath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, std::vector<WFMath::Point<2>>& waypoints) const
+  {
+    return false;
+  }
+#endif //STUB_Awareness_findCoarsePath
+
+#ifndef STUB_Awareness_findPath
+//#define STUB_Awareness_findPath
+  int Awareness::findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, float radius, std::vector<WFMath::Point<3>>& path, bool& searched) const
+  {
+    return 0;
+  }
+#endif //STUB_Awareness_findPath
+
+#ifndef STUB_Awareness_invalidatePaths
+//#define STUB_Awareness_invalidatePaths
+  void Awareness::invalidatePaths(int tx, int ty)
+  {
+    
+  }
+#endif //STUB_Awareness_invalidatePaths
+
+#ifndef STUB_Awareness_updateTileGraph
+//#define STUB_Awareness_updateTileGraph
+  void Awareness::updateTileGraph(int tx, int ty)
+  {
+    
+  }
+#endif //STUB_Awareness_updateTileGraph
+
 #ifndef STUB_Awareness_processTile
 //#define STUB_Awareness_processTile
   void Awareness::processTile(int tx, int ty, const TileProcessor& processor) const
@@ -98,6 +154,22 @@
   }
 #endif //STUB_Awareness_avoidObstacles
 
+#ifndef STUB_Awareness_updateNeighbourGrid
+//#define STUB_Awareness_updateNeighbourGrid
+  void Awareness::updateNeighbourGrid(double currentTimestamp)
+  {
+    
+  }
+#endif //STUB_Awareness_updateNeighbourGrid
+
+#ifndef STUB_Awareness_getCrowd
+//#define STUB_Awareness_getCrowd
+  Crowd& Awareness::getCrowd()
+  {
+    return *static_cast<Crowd*>(nullptr);
+  }
+#endif //STUB_Awareness_getCrowd
+
 #ifndef STUB_Awareness_pruneTiles
 //#define STUB_Awareness_pruneTiles
   void Awareness::pruneTiles()
@@ -204,12 +276,60 @@
 
 #ifndef STUB_Awareness_rebuildTile
 //#define STUB_Awareness_rebuildTile
-  void Awareness::rebuildTile(int tx, int ty, const std::vector<WFMath::RotBox<2>>& entityAreas)
+  void Awareness::rebuildTile(int tx, int ty)
   {
     
   }
 #endif //STUB_Awareness_rebuildTile
 
+#ifndef STUB_Awareness_installTile
+//#define STUB_Awareness_installTile
+  void Awareness::installTile(int tx, int ty, TileCacheData* tiles, int ntiles)
+  {
+    
+  }
+#endif //STUB_Awareness_installTile
+
+#ifndef STUB_Awareness_installStoredTile
+//#define STUB_Awareness_installStoredTile
+  bool Awareness::installStoredTile(const TileSnapshot& snapshot)
+  {
+    return false;
+  }
+#endif //STUB_Awareness_installStoredTile
+
+#ifndef STUB_Awareness_storeTile
+//#define STUB_Awareness_storeTile
+  void Awareness::storeTile(std::uint64_t hash, const TileCacheData* tiles, int ntiles)
+  {
+    
+  }
+#endif //STUB_Awareness_storeTile
+
+#ifndef STUB_Awareness_dispatchTileBuilds
+//#define STUB_Awareness_dispatchTileBuilds
+  void Awareness::dispatchTileBuilds(TileBuilder& tileBuilder)
+  {
+    
+  }
+#endif //STUB_Awareness_dispatchTileBuilds
+
+#ifndef STUB_Awareness_installBuiltTiles
+//#define STUB_Awareness_installBuiltTiles
+  void Awareness::installBuiltTiles()
+  {
+    
+  }
+#endif //STUB_Awareness_installBuiltTiles
+
+#ifndef STUB_Awareness_snapshotTile
+//#define STUB_Awareness_snapshotTile
+  void Awareness::snapshotTile(int tx, int ty, TileSnapshot& snapshot)
+  {
+    
+  }
+#endif //STUB_Awareness_snapshotTile
+
 #ifndef STUB_Awareness_buildEntityAreas
 //#define STUB_Awareness_buildEntityAreas
   WFMath::RotBox<2> Awareness::buildEntityAreas(const EntityEntry& entity)
@@ -228,7 +348,7 @@
 
 #ifndef STUB_Awareness_rasterizeTileLayers
 //#define STUB_Awareness_rasterizeTileLayers
-  int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityAreas, int tx, int ty, TileCacheData* tiles, int maxTiles)
+  int Awareness::rasterizeTileLayers(rcContext& ctx, const TileSnapshot& snapshot, TileCacheData* tiles, int maxTiles)
   {
     return 0;
   }
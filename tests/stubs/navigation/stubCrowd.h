@@ -0,0 +1,52 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubCrowd_custom.h file.
+
+#ifndef STUB_NAVIGATION_CROWD_H
+#define STUB_NAVIGATION_CROWD_H
+
+#include "navigation/Crowd.h"
+#include "stubCrowd_custom.h"
+
+#ifndef STUB_Crowd_Crowd
+//#define STUB_Crowd_Crowd
+   Crowd::Crowd(Awareness& awareness, double updateInterval)
+    : mAwareness(awareness)
+  {
+    
+  }
+#endif //STUB_Crowd_Crowd
+
+#ifndef STUB_Crowd_addAgent
+//#define STUB_Crowd_addAgent
+  void Crowd::addAgent(Steering& steering)
+  {
+    
+  }
+#endif //STUB_Crowd_addAgent
+
+#ifndef STUB_Crowd_removeAgent
+//#define STUB_Crowd_removeAgent
+  void Crowd::removeAgent(Steering& steering)
+  {
+    
+  }
+#endif //STUB_Crowd_removeAgent
+
+#ifndef STUB_Crowd_update
+//#define STUB_Crowd_update
+  bool Crowd::update(double currentTimestamp)
+  {
+    return false;
+  }
+#endif //STUB_Crowd_update
+
+#ifndef STUB_Crowd_takeResult
+//#define STUB_Crowd_takeResult
+  SteeringResult Crowd::takeResult(Steering& steering)
+  {
+    return *static_cast<SteeringResult*>(nullptr);
+  }
+#endif //STUB_Crowd_takeResult
+
+
+#endif
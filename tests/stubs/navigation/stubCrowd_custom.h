@@ -0,0 +1 @@
+//Add custom implementations of stubbed functions here; this file won't be rewritten when re-generating stubs.
@@ -0,0 +1,59 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubNeighbourGrid_custom.h file.
+
+#ifndef STUB_NAVIGATION_NEIGHBOURGRID_H
+#define STUB_NAVIGATION_NEIGHBOURGRID_H
+
+#include "navigation/NeighbourGrid.h"
+#include "stubNeighbourGrid_custom.h"
+
+#ifndef STUB_NeighbourGrid_NeighbourGrid
+//#define STUB_NeighbourGrid_NeighbourGrid
+   NeighbourGrid::NeighbourGrid(float cellSize)
+  {
+    
+  }
+#endif //STUB_NeighbourGrid_NeighbourGrid
+
+#ifndef STUB_NeighbourGrid_clear
+//#define STUB_NeighbourGrid_clear
+  void NeighbourGrid::clear()
+  {
+    
+  }
+#endif //STUB_NeighbourGrid_clear
+
+#ifndef STUB_NeighbourGrid_add
+//#define STUB_NeighbourGrid_add
+  void NeighbourGrid::add(long entityId, const WFMath::Point<2>& position, const WFMath::Vector<2>& velocity, float radius)
+  {
+    
+  }
+#endif //STUB_NeighbourGrid_add
+
+#ifndef STUB_NeighbourGrid_query
+//#define STUB_NeighbourGrid_query
+  void NeighbourGrid::query(const WFMath::Point<2>& position, float range, std::vector<size_t>& result) const
+  {
+    
+  }
+#endif //STUB_NeighbourGrid_query
+
+#ifndef STUB_NeighbourGrid_cellIndex
+//#define STUB_NeighbourGrid_cellIndex
+  int NeighbourGrid::cellIndex(float coord) const
+  {
+    return 0;
+  }
+#endif //STUB_NeighbourGrid_cellIndex
+
+#ifndef STUB_NeighbourGrid_cellKey
+//#define STUB_NeighbourGrid_cellKey
+  int64_t NeighbourGrid::cellKey(int x, int y)
+  {
+    return 0;
+  }
+#endif //STUB_NeighbourGrid_cellKey
+
+
+#endif
@@ -0,0 +1,43 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubPathCache_custom.h file.
+
+#ifndef STUB_NAVIGATION_PATHCACHE_H
+#define STUB_NAVIGATION_PATHCACHE_H
+
+#include "navigation/PathCache.h"
+#include "stubPathCache_custom.h"
+
+#ifndef STUB_PathCache_PathCache
+//#define STUB_PathCache_PathCache
+   PathCache::PathCache(size_t maxEntries)
+  {
+    
+  }
+#endif //STUB_PathCache_PathCache
+
+#ifndef STUB_PathCache_get
+//#define STUB_PathCache_get
+  const std::vector<dtPolyRef>* PathCache::get(const Key& key)
+  {
+    return nullptr;
+  }
+#endif //STUB_PathCache_get
+
+#ifndef STUB_PathCache_put
+//#define STUB_PathCache_put
+  void PathCache::put(const Key& key, std::vector<dtPolyRef> corridor, std::vector<std::pair<int, int>> tiles)
+  {
+    
+  }
+#endif //STUB_PathCache_put
+
+#ifndef STUB_PathCache_invalidateTile
+//#define STUB_PathCache_invalidateTile
+  void PathCache::invalidateTile(int tx, int ty)
+  {
+    
+  }
+#endif //STUB_PathCache_invalidateTile
+
+
+#endif
@@ -66,6 +66,22 @@
   }
 #endif //STUB_Steering_requestUpdate
 
+#ifndef STUB_Steering_setBatchPathRequests
+//#define STUB_Steering_setBatchPathRequests
+  void Steering::setBatchPathRequests(bool batch)
+  {
+    
+  }
+#endif //STUB_Steering_setBatchPathRequests
+
+#ifndef STUB_Steering_isPathRequestPending
+//#define STUB_Steering_isPathRequestPending
+  bool Steering::isPathRequestPending() const
+  {
+    return false;
+  }
+#endif //STUB_Steering_isPathRequestPending
+
 #ifndef STUB_Steering_startSteering
 //#define STUB_Steering_startSteering
   void Steering::startSteering()
@@ -218,6 +234,38 @@
   }
 #endif //STUB_Steering_Awareness_TileUpdated
 
+#ifndef STUB_Steering_updateRouteTarget
+//#define STUB_Steering_updateRouteTarget
+  WFMath::Point<3> Steering::updateRouteTarget(const WFMath::Point<3>& avatarPosition, const WFMath::Point<3>& destination)
+  {
+    return *static_cast<WFMath::Point<3>*>(nullptr);
+  }
+#endif //STUB_Steering_updateRouteTarget
+
+#ifndef STUB_Steering_getPathTarget
+//#define STUB_Steering_getPathTarget
+  WFMath::Point<3> Steering::getPathTarget(const WFMath::Point<3>& destination) const
+  {
+    return *static_cast<WFMath::Point<3>*>(nullptr);
+  }
+#endif //STUB_Steering_getPathTarget
+
+#ifndef STUB_Steering_requestPath
+//#define STUB_Steering_requestPath
+  void Steering::requestPath(double currentTimestamp, const WFMath::Point<3>& currentAvatarPosition)
+  {
+    
+  }
+#endif //STUB_Steering_requestPath
+
+#ifndef STUB_Steering_handlePathResult
+//#define STUB_Steering_handlePathResult
+  void Steering::handlePathResult(const WFMath::Point<3>& start, const WFMath::Point<3>& end)
+  {
+    
+  }
+#endif //STUB_Steering_handlePathResult
+
 #ifndef STUB_Steering_moveInDirection
 //#define STUB_Steering_moveInDirection
   void Steering::moveInDirection(const WFMath::Vector<2>& direction)
@@ -0,0 +1,44 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubTileBuilder_custom.h file.
+
+#ifndef STUB_NAVIGATION_TILEBUILDER_H
+#define STUB_NAVIGATION_TILEBUILDER_H
+
+#include "navigation/TileBuilder.h"
+#include "stubTileBuilder_custom.h"
+
+#ifndef STUB_TileBuilder_TileBuilder
+//#define STUB_TileBuilder_TileBuilder
+   TileBuilder::TileBuilder(size_t threadCount)
+    : Singleton()
+  {
+    
+  }
+#endif //STUB_TileBuilder_TileBuilder
+
+#ifndef STUB_TileBuilder_TileBuilder_DTOR
+//#define STUB_TileBuilder_TileBuilder_DTOR
+   TileBuilder::~TileBuilder()
+  {
+    
+  }
+#endif //STUB_TileBuilder_TileBuilder_DTOR
+
+#ifndef STUB_TileBuilder_post
+//#define STUB_TileBuilder_post
+  void TileBuilder::post(std::function<void()> job)
+  {
+    
+  }
+#endif //STUB_TileBuilder_post
+
+#ifndef STUB_TileBuilder_workerLoop
+//#define STUB_TileBuilder_workerLoop
+  void TileBuilder::workerLoop()
+  {
+    
+  }
+#endif //STUB_TileBuilder_workerLoop
+
+
+#endif
@@ -0,0 +1,91 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubTileGraph_custom.h file.
+
+#ifndef STUB_NAVIGATION_TILEGRAPH_H
+#define STUB_NAVIGATION_TILEGRAPH_H
+
+#include "navigation/TileGraph.h"
+#include "stubTileGraph_custom.h"
+
+#ifndef STUB_TileGraph_TileGraph
+//#define STUB_TileGraph_TileGraph
+   TileGraph::TileGraph(const WFMath::Point<2>& origin, float tileSize, int tilesX, int tilesY)
+  {
+    
+  }
+#endif //STUB_TileGraph_TileGraph
+
+#ifndef STUB_TileGraph_setTile
+//#define STUB_TileGraph_setTile
+  void TileGraph::setTile(int tx, int ty, std::vector<Portal> portals)
+  {
+    
+  }
+#endif //STUB_TileGraph_setTile
+
+#ifndef STUB_TileGraph_hasTile
+//#define STUB_TileGraph_hasTile
+  bool TileGraph::hasTile(int tx, int ty) const
+  {
+    return false;
+  }
+#endif //STUB_TileGraph_hasTile
+
+#ifndef STUB_TileGraph_findPath
+//#define STUB_TileGraph_findPath
+  bool TileGraph::findPath(const WFMath::Point<2>& start, const WFMath::Point<2>& end, std::vector<WFMath::Point<2>>& waypoints) const
+  {
+    return false;
+  }
+#endif //STUB_TileGraph_findPath
+
+#ifndef STUB_TileGraph_isWithinBounds
+//#define STUB_TileGraph_isWithinBounds
+  bool TileGraph::isWithinBounds(int tx, int ty) const
+  {
+    return false;
+  }
+#endif //STUB_TileGraph_isWithinBounds
+
+#ifndef STUB_TileGraph_tileAt
+//#define STUB_TileGraph_tileAt
+  std::pair<int, int> TileGraph::tileAt(const WFMath::Point<2>& position) const
+  {
+    return *static_cast<std::pair<int, int>*>(nullptr);
+  }
+#endif //STUB_TileGraph_tileAt
+
+#ifndef STUB_TileGraph_portalPosition
+//#define STUB_TileGraph_portalPosition
+  WFMath::Point<2> TileGraph::portalPosition(int tx, int ty, const Portal& portal) const
+  {
+    return *static_cast<WFMath::Point<2>*>(nullptr);
+  }
+#endif //STUB_TileGraph_portalPosition
+
+#ifndef STUB_TileGraph_tileCenter
+//#define STUB_TileGraph_tileCenter
+  WFMath::Point<2> TileGraph::tileCenter(int tx, int ty) const
+  {
+    return *static_cast<WFMath::Point<2>*>(nullptr);
+  }
+#endif //STUB_TileGraph_tileCenter
+
+#ifndef STUB_TileGraph_addTileSuccessors
+//#define STUB_TileGraph_addTileSuccessors
+  void TileGraph::addTileSuccessors(int tx, int ty, int region, const Node& endNode, const WFMath::Point<2>& end, std::vector<std::pair<Node, WFMath::Point<2>>>& successors) const
+  {
+    
+  }
+#endif //STUB_TileGraph_addTileSuccessors
+
+#ifndef STUB_TileGraph_addNeighbourSuccessors
+//#define STUB_TileGraph_addNeighbourSuccessors
+  void TileGraph::addNeighbourSuccessors(int tx, int ty, Side side, const Portal* portal, std::vector<std::pair<Node, WFMath::Point<2>>>& successors) const
+  {
+    
+  }
+#endif //STUB_TileGraph_addNeighbourSuccessors
+
+
+#endif
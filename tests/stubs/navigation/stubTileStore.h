@@ -0,0 +1,60 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubTileStore_custom.h file.
+
+#ifndef STUB_NAVIGATION_TILESTORE_H
+#define STUB_NAVIGATION_TILESTORE_H
+
+#include "navigation/TileStore.h"
+#include "stubTileStore_custom.h"
+
+#ifndef STUB_TileStore_TileStore
+//#define STUB_TileStore_TileStore
+   TileStore::TileStore(std::string path, size_t maxFileSize)
+    : Singleton()
+  {
+    
+  }
+#endif //STUB_TileStore_TileStore
+
+#ifndef STUB_TileStore_TileStore_DTOR
+//#define STUB_TileStore_TileStore_DTOR
+   TileStore::~TileStore()
+  {
+    
+  }
+#endif //STUB_TileStore_TileStore_DTOR
+
+#ifndef STUB_TileStore_get
+//#define STUB_TileStore_get
+  bool TileStore::get(std::uint64_t hash, std::vector<Layer>& layers)
+  {
+    return false;
+  }
+#endif //STUB_TileStore_get
+
+#ifndef STUB_TileStore_put
+//#define STUB_TileStore_put
+  void TileStore::put(std::uint64_t hash, const std::vector<Layer>& layers)
+  {
+    
+  }
+#endif //STUB_TileStore_put
+
+#ifndef STUB_TileStore_load
+//#define STUB_TileStore_load
+  void TileStore::load(size_t maxFileSize)
+  {
+    
+  }
+#endif //STUB_TileStore_load
+
+#ifndef STUB_TileStore_parse
+//#define STUB_TileStore_parse
+  size_t TileStore::parse()
+  {
+    return 0;
+  }
+#endif //STUB_TileStore_parse
+
+
+#endif
@@ -0,0 +1,75 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubLocationIndex_custom.h file.
+
+#ifndef STUB_RULES_AI_LOCATIONINDEX_H
+#define STUB_RULES_AI_LOCATIONINDEX_H
+
+#include "rules/ai/LocationIndex.h"
+#include "stubLocationIndex_custom.h"
+
+#ifndef STUB_LocationIndex_LocationIndex
+//#define STUB_LocationIndex_LocationIndex
+   LocationIndex::LocationIndex(WFMath::CoordType cellSize)
+  {
+    
+  }
+#endif //STUB_LocationIndex_LocationIndex
+
+#ifndef STUB_LocationIndex_update
+//#define STUB_LocationIndex_update
+  void LocationIndex::update(LocatedEntity& entity)
+  {
+    
+  }
+#endif //STUB_LocationIndex_update
+
+#ifndef STUB_LocationIndex_remove
+//#define STUB_LocationIndex_remove
+  void LocationIndex::remove(LocatedEntity& entity)
+  {
+    
+  }
+#endif //STUB_LocationIndex_remove
+
+#ifndef STUB_LocationIndex_clear
+//#define STUB_LocationIndex_clear
+  void LocationIndex::clear()
+  {
+    
+  }
+#endif //STUB_LocationIndex_clear
+
+#ifndef STUB_LocationIndex_findCandidates
+//#define STUB_LocationIndex_findCandidates
+  void LocationIndex::findCandidates(const LocatedEntity& parent, const WFMath::Point<3>& pos, WFMath::CoordType radius, std::vector<LocatedEntity*>& candidates) const
+  {
+    
+  }
+#endif //STUB_LocationIndex_findCandidates
+
+#ifndef STUB_LocationIndex_cellCoord
+//#define STUB_LocationIndex_cellCoord
+  std::int32_t LocationIndex::cellCoord(WFMath::CoordType coord) const
+  {
+    return 0;
+  }
+#endif //STUB_LocationIndex_cellCoord
+
+#ifndef STUB_LocationIndex_cellKey
+//#define STUB_LocationIndex_cellKey
+  LocationIndex::CellKey LocationIndex::cellKey(std::int32_t x, std::int32_t z)
+  {
+    return 0;
+  }
+#endif //STUB_LocationIndex_cellKey
+
+#ifndef STUB_LocationIndex_removePlacement
+//#define STUB_LocationIndex_removePlacement
+  void LocationIndex::removePlacement(LocatedEntity& entity, const Placement& placement)
+  {
+    
+  }
+#endif //STUB_LocationIndex_removePlacement
+
+
+#endif
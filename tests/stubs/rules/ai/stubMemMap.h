@@ -176,6 +176,14 @@
   }
 #endif //STUB_MemMap_findByLocation
 
+#ifndef STUB_MemMap_findByLocation
+//#define STUB_MemMap_findByLocation
+  EntityVector MemMap::findByLocation(const EntityLocation& where, WFMath::CoordType radius) const
+  {
+    return *static_cast<EntityVector*>(nullptr);
+  }
+#endif //STUB_MemMap_findByLocation
+
 #ifndef STUB_MemMap_check
 //#define STUB_MemMap_check
   void MemMap::check(const double&)
@@ -33,6 +33,22 @@ namespace EntityFilter {
   }
 #endif //STUB_Filter_match
 
+#ifndef STUB_Filter_matchInterpreted
+//#define STUB_Filter_matchInterpreted
+  bool Filter::matchInterpreted(const QueryContext& context) const
+  {
+    return false;
+  }
+#endif //STUB_Filter_matchInterpreted
+
+#ifndef STUB_Filter_matchAll
+//#define STUB_Filter_matchAll
+  void Filter::matchAll(std::vector<LocatedEntity*>& entities, const QueryContext& context) const
+  {
+    
+  }
+#endif //STUB_Filter_matchAll
+
 #ifndef STUB_Filter_getDeclaration
 //#define STUB_Filter_getDeclaration
   const std::string& Filter::getDeclaration() const
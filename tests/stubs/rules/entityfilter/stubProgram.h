@@ -0,0 +1,159 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubProgram_custom.h file.
+
+#ifndef STUB_RULES_ENTITYFILTER_PROGRAM_H
+#define STUB_RULES_ENTITYFILTER_PROGRAM_H
+
+#include "rules/entityfilter/Program.h"
+#include "stubProgram_custom.h"
+
+namespace EntityFilter {
+
+#ifndef STUB_Program_Program
+//#define STUB_Program_Program
+   Program::Program(const Predicate& predicate)
+  {
+    
+  }
+#endif //STUB_Program_Program
+
+#ifndef STUB_Program_run
+//#define STUB_Program_run
+  bool Program::run(const QueryContext& context) const
+  {
+    return false;
+  }
+#endif //STUB_Program_run
+
+#ifndef STUB_Program_runAll
+//#define STUB_Program_runAll
+  void Program::runAll(std::vector<LocatedEntity*>& entities, const QueryContext& context) const
+  {
+    
+  }
+#endif //STUB_Program_runAll
+
+#ifndef STUB_Program_compile
+//#define STUB_Program_compile
+  Program::Folded Program::compile(const Predicate& predicate)
+  {
+    return *static_cast<Program::Folded*>(nullptr);
+  }
+#endif //STUB_Program_compile
+
+#ifndef STUB_Program_compileLogical
+//#define STUB_Program_compileLogical
+  Program::Folded Program::compileLogical(const Predicate& lhs, const Predicate& rhs, bool isAnd)
+  {
+    return *static_cast<Program::Folded*>(nullptr);
+  }
+#endif //STUB_Program_compileLogical
+
+#ifndef STUB_Program_compileCompare
+//#define STUB_Program_compileCompare
+  Program::Folded Program::compileCompare(const ComparePredicate& predicate)
+  {
+    return *static_cast<Program::Folded*>(nullptr);
+  }
+#endif //STUB_Program_compileCompare
+
+#ifndef STUB_Program_interpret
+//#define STUB_Program_interpret
+  Program::Folded Program::interpret(const Predicate& predicate)
+  {
+    return *static_cast<Program::Folded*>(nullptr);
+  }
+#endif //STUB_Program_interpret
+
+#ifndef STUB_Program_compileOperand
+//#define STUB_Program_compileOperand
+  std::uint32_t Program::compileOperand(const Consumer<QueryContext>& consumer)
+  {
+    return 0;
+  }
+#endif //STUB_Program_compileOperand
+
+#ifndef STUB_Program_emit
+//#define STUB_Program_emit
+  std::uint32_t Program::emit(OpCode opCode, std::uint32_t arg1, std::uint32_t arg2, ComparePredicate::Comparator comparator)
+  {
+    return 0;
+  }
+#endif //STUB_Program_emit
+
+#ifndef STUB_Program_emitFolded
+//#define STUB_Program_emitFolded
+  void Program::emitFolded(Folded folded)
+  {
+    
+  }
+#endif //STUB_Program_emitFolded
+
+#ifndef STUB_Program_findGuards
+//#define STUB_Program_findGuards
+  void Program::findGuards()
+  {
+    
+  }
+#endif //STUB_Program_findGuards
+
+#ifndef STUB_Program_isFixed
+//#define STUB_Program_isFixed
+  bool Program::isFixed(const Operand& operand) const
+  {
+    return false;
+  }
+#endif //STUB_Program_isFixed
+
+#ifndef STUB_Program_execute
+//#define STUB_Program_execute
+  bool Program::execute(std::uint32_t position, bool result, const LocatedEntity& entity, const QueryContext& context) const
+  {
+    return false;
+  }
+#endif //STUB_Program_execute
+
+#ifndef STUB_Program_evaluate
+//#define STUB_Program_evaluate
+  bool Program::evaluate(const Instruction& instruction, const LocatedEntity& entity, const QueryContext& context, Atlas::Message::Element& left, Atlas::Message::Element& right) const
+  {
+    return false;
+  }
+#endif //STUB_Program_evaluate
+
+#ifndef STUB_Program_sourceEntity
+//#define STUB_Program_sourceEntity
+  const LocatedEntity* Program::sourceEntity(const Operand& operand, const LocatedEntity& matched, const QueryContext& context) const
+  {
+    return nullptr;
+  }
+#endif //STUB_Program_sourceEntity
+
+#ifndef STUB_Program_load
+//#define STUB_Program_load
+  const Atlas::Message::Element& Program::load(const Operand& operand, const LocatedEntity& matched, const QueryContext& context, Atlas::Message::Element& scratch) const
+  {
+    return *static_cast<const Atlas::Message::Element*>(nullptr);
+  }
+#endif //STUB_Program_load
+
+#ifndef STUB_Program_loadNumber
+//#define STUB_Program_loadNumber
+  bool Program::loadNumber(const Operand& operand, const LocatedEntity& matched, const QueryContext& context, Atlas::Message::Element& scratch, double& number) const
+  {
+    return false;
+  }
+#endif //STUB_Program_loadNumber
+
+#ifndef STUB_Program_compare
+//#define STUB_Program_compare
+  bool Program::compare(ComparePredicate::Comparator comparator, const Atlas::Message::Element& left, const Atlas::Message::Element& right)
+  {
+    return false;
+  }
+#endif //STUB_Program_compare
+
+
+}  // namespace EntityFilter
+
+#endif
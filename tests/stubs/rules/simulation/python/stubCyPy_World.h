@@ -57,5 +57,13 @@
   }
 #endif //STUB_CyPy_World_match_entity
 
+#ifndef STUB_CyPy_World_match_entities
+//#define STUB_CyPy_World_match_entities
+  Py::Object CyPy_World::match_entities(const Py::Tuple& args)
+  {
+    return *static_cast<Py::Object*>(nullptr);
+  }
+#endif //STUB_CyPy_World_match_entities
+
 
 #endif
\ No newline at end of file
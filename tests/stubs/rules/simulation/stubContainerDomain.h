@@ -35,9 +35,9 @@
 
 #ifndef STUB_ContainerDomain_getObservingEntitiesFor
 //#define STUB_ContainerDomain_getObservingEntitiesFor
-  std::vector<LocatedEntity*> ContainerDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+  void ContainerDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
   {
-    return std::vector<LocatedEntity*>();
+    
   }
 #endif //STUB_ContainerDomain_getObservingEntitiesFor
 
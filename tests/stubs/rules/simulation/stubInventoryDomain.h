@@ -34,9 +34,9 @@
 
 #ifndef STUB_InventoryDomain_getObservingEntitiesFor
 //#define STUB_InventoryDomain_getObservingEntitiesFor
-  std::vector<LocatedEntity*> InventoryDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+  void InventoryDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
   {
-    return std::vector<LocatedEntity*>();
+    
   }
 #endif //STUB_InventoryDomain_getObservingEntitiesFor
 
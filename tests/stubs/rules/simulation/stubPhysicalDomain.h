@@ -43,9 +43,9 @@
 
 #ifndef STUB_PhysicalDomain_getObservingEntitiesFor
 //#define STUB_PhysicalDomain_getObservingEntitiesFor
-  std::vector<LocatedEntity*> PhysicalDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+  void PhysicalDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
   {
-    return std::vector<LocatedEntity*>();
+    
   }
 #endif //STUB_PhysicalDomain_getObservingEntitiesFor
 
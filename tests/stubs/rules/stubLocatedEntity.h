@@ -18,7 +18,7 @@
 
 #ifndef STUB_LocatedEntity_collectObserversForChild
 //#define STUB_LocatedEntity_collectObserversForChild
-  void LocatedEntity::collectObserversForChild(const LocatedEntity& child, std::set<const LocatedEntity*>& receivers) const
+  void LocatedEntity::collectObserversForChild(const LocatedEntity& child, std::vector<const LocatedEntity*>& receivers) const
   {
     
   }
@@ -122,6 +122,14 @@
   }
 #endif //STUB_LocatedEntity_getProperty
 
+#ifndef STUB_LocatedEntity_getProperty
+//#define STUB_LocatedEntity_getProperty
+  const PropertyBase* LocatedEntity::getProperty(PropertyId id) const
+  {
+    return nullptr;
+  }
+#endif //STUB_LocatedEntity_getProperty
+
 #ifndef STUB_LocatedEntity_modProperty
 //#define STUB_LocatedEntity_modProperty
   PropertyBase* LocatedEntity::modProperty(const std::string& name, const Atlas::Message::Element& def_val )
@@ -290,6 +298,14 @@
   }
 #endif //STUB_LocatedEntity_collectObservers
 
+#ifndef STUB_LocatedEntity_collectObservers
+//#define STUB_LocatedEntity_collectObservers
+  void LocatedEntity::collectObservers(std::vector<const LocatedEntity*>& observers) const
+  {
+    
+  }
+#endif //STUB_LocatedEntity_collectObservers
+
 #ifndef STUB_LocatedEntity_collectObserved
 //#define STUB_LocatedEntity_collectObserved
   void LocatedEntity::collectObserved(std::set<const LocatedEntity*>& observed) const
@@ -306,6 +322,14 @@
   }
 #endif //STUB_LocatedEntity_broadcast
 
+#ifndef STUB_LocatedEntity_broadcast
+//#define STUB_LocatedEntity_broadcast
+  void LocatedEntity::broadcast(const Atlas::Objects::Operation::RootOperation& op, OpVector& res, Visibility visibility, const std::vector<const LocatedEntity*>& observers) const
+  {
+    
+  }
+#endif //STUB_LocatedEntity_broadcast
+
 #ifndef STUB_LocatedEntity_processAppearDisappear
 //#define STUB_LocatedEntity_processAppearDisappear
   void LocatedEntity::processAppearDisappear(std::set<const LocatedEntity*> previousObserving, OpVector& res) const
@@ -34,6 +34,15 @@ const PropertyBase* LocatedEntity::getProperty(const std::string& name) const
     }
     return nullptr;
 }
+
+const PropertyBase* LocatedEntity::getProperty(PropertyId id) const
+{
+    auto modifiableProperty = m_properties.find(id);
+    if (modifiableProperty) {
+        return modifiableProperty->property.get();
+    }
+    return nullptr;
+}
 #endif //STUB_LocatedEntity_getProperty
 
 #ifndef STUB_LocatedEntity_setType